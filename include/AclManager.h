@@ -21,6 +21,7 @@
 #include "AuthRequest.h"
 #include "PoolObjectSQL.h"
 #include "AclRule.h"
+#include "AclRuleIndex.h"
 #include "NebulaLog.h"
 
 #include "SqlDB.h"
@@ -43,8 +44,11 @@ public:
      *  @param is_federation_slave true is this oned is a federation slave. If
      *  it is true, it will reload periodically rules from the DB
      *  @param timer_period period to reload the rules
+     *  @param index_enabled authorize requests with the compiled rule index,
+     *  if false every rule is evaluated (and logged at DDEBUG level)
      */
-    AclManager(SqlDB * _db, int zone_id, bool is_federation_slave, time_t timer);
+    AclManager(SqlDB * _db, int zone_id, bool is_federation_slave, time_t timer,
+            bool index_enabled);
 
     virtual ~AclManager();
 
@@ -178,6 +182,8 @@ public:
      *    @param oids Set of object IDs over which the user can operate
      *    @param gids Set of object group IDs over which the user can operate
      *    @param cids Set of object cluster IDs over which the user can operate
+     *
+     *  Results are cached until the ACL rule set changes
      */
     void reverse_search(int                       uid,
                         const set<int>&           user_groups,
@@ -227,7 +233,8 @@ protected:
      *  from DB)
      */
     AclManager(int _zone_id)
-        :zone_id(_zone_id), db(0), is_federation_slave(false)
+        :acl_index(_zone_id), index_enabled(true), zone_id(_zone_id), db(0),
+         is_federation_slave(false)
     {
        pthread_mutex_init(&mutex, 0);
     };
@@ -246,6 +253,17 @@ protected:
      */
     map<int, AclRule *> acl_rules_oids;
 
+    /**
+     *  Compiled index of the rules used to authorize requests, it MUST be
+     *  updated when acl_rules changes
+     */
+    AclRuleIndex acl_index;
+
+    /**
+     *  Use acl_index to authorize the requests that can be indexed
+     */
+    bool index_enabled;
+
 private:
 
     /**
@@ -304,6 +322,59 @@ private:
             long long             group_obj_type,
             long long             cluster_obj_type,
             const multimap<long long, AclRule*> &tmp_rules);
+    /**
+     *  Searches the rules for reverse_search, without using the cache
+     */
+    void reverse_search_rules(int                       uid,
+                              const set<int>&           user_groups,
+                              PoolObjectSQL::ObjectType obj_type,
+                              AuthRequest::Operation    op,
+                              bool                      disable_all_acl,
+                              bool                      disable_cluster_acl,
+                              bool                      disable_group_acl,
+                              bool&                     all,
+                              vector<int>&              oids,
+                              vector<int>&              gids,
+                              vector<int>&              cids);
+
+    // -------------------------------------------------------------------------
+    // Reverse search cache
+    // -------------------------------------------------------------------------
+
+    /**
+     *  Arguments of a reverse search
+     */
+    struct ReverseSearchKey
+    {
+        int                       uid;
+        set<int>                  user_groups;
+        PoolObjectSQL::ObjectType obj_type;
+        AuthRequest::Operation    op;
+        int                       disable_flags;
+
+        bool operator<(const ReverseSearchKey& other) const;
+    };
+
+    /**
+     *  Result of a reverse search and the version of the rule set (see
+     *  AclRuleIndex::generation) used to compute it
+     */
+    struct ReverseSearchResult
+    {
+        unsigned long long generation;
+        bool               all;
+        vector<int>        oids;
+        vector<int>        gids;
+        vector<int>        cids;
+    };
+
+    /**
+     *  Max number of cached searches, the cache is flushed when it is full
+     */
+    static const size_t REVERSE_SEARCH_CACHE_SIZE = 4096;
+
+    map<ReverseSearchKey, ReverseSearchResult> reverse_search_cache;
+
     /**
      * Deletes all rules that match the user mask
      *
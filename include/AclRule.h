@@ -199,6 +199,8 @@ private:
 
     friend class AclManager;
 
+    friend class AclRuleIndex;
+
     /**
      *  Rule unique identifier
      */
@@ -0,0 +1,164 @@
+/* -------------------------------------------------------------------------- */
+/* Copyright 2002-2017, OpenNebula Project, OpenNebula Systems                */
+/*                                                                            */
+/* Licensed under the Apache License, Version 2.0 (the "License"); you may    */
+/* not use this file except in compliance with the License. You may obtain    */
+/* a copy of the License at                                                   */
+/*                                                                            */
+/* http://www.apache.org/licenses/LICENSE-2.0                                 */
+/*                                                                            */
+/* Unless required by applicable law or agreed to in writing, software        */
+/* distributed under the License is distributed on an "AS IS" BASIS,          */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   */
+/* See the License for the specific language governing permissions and        */
+/* limitations under the License.                                             */
+/* -------------------------------------------------------------------------- */
+
+#ifndef ACL_RULE_INDEX_H_
+#define ACL_RULE_INDEX_H_
+
+#include <pthread.h>
+
+#include <map>
+#include <set>
+#include <vector>
+
+#include "AclRule.h"
+
+using namespace std;
+
+/**
+ *  Compiled form of the ACL rule set used to authorize requests. The rules
+ *  that apply in the local zone are indexed by user selector (#uid, @gid or
+ *  *), object type and operation. Each entry holds the objects granted by
+ *  the rules:
+ *    - all, number of rules that grant every object of the type
+ *    - oids, gids, cids: objects granted individually, by group or by cluster
+ *
+ *  A request is then authorized with a lookup for each selector of the user
+ *  instead of evaluating every rule. The index is updated incrementally as
+ *  rules are added or removed. Lookups use a shared lock.
+ */
+class AclRuleIndex
+{
+public:
+    AclRuleIndex(int _zone_id):_generation(0), zone_id(_zone_id)
+    {
+        pthread_rwlock_init(&rwlock, 0);
+    };
+
+    ~AclRuleIndex()
+    {
+        pthread_rwlock_destroy(&rwlock);
+    };
+
+    /**
+     *  Adds a rule to the index
+     */
+    void add(const AclRule * rule);
+
+    /**
+     *  Removes a rule from the index, it must have been added before
+     */
+    void del(const AclRule * rule);
+
+    /**
+     *  Removes all the rules from the index
+     */
+    void clear();
+
+    /**
+     *  Replaces the indexed rules with a new rule set. The new index is built
+     *  aside and swapped in, lookups see either the old or the new rule set.
+     *    @param rules the new rule set
+     */
+    void replace(const multimap<long long, AclRule *>& rules);
+
+    /**
+     *  @return the version of the rule set, it changes every time a rule is
+     *  added or removed
+     */
+    unsigned long long generation() const
+    {
+        return __atomic_load_n(&_generation, __ATOMIC_ACQUIRE);
+    };
+
+    /**
+     *  @return true if a request for the object type and operation can be
+     *  resolved with the index, i.e. both are single flags
+     */
+    static bool indexed(long long obj_type, long long op)
+    {
+        return obj_type != 0 && (obj_type & (obj_type - 1)) == 0 &&
+               op != 0 && (op & (op - 1)) == 0 && op < (1LL << OPERATIONS);
+    };
+
+    /**
+     *  Checks if any rule grants an operation over an object
+     *    @param user_reqs the user selectors (#uid, @gid, *)
+     *    @param obj_type of the object
+     *    @param op the operation
+     *    @param all check the rules granting all the objects of the type
+     *    @param oid of the object, -1 to skip individual rules
+     *    @param gid of the object, -1 to skip group rules
+     *    @param cids clusters of the object
+     *    @return true if any rule grants the operation
+     */
+    bool match(const vector<long long>& user_reqs, long long obj_type,
+            long long op, bool all, int oid, int gid, const set<int>& cids);
+
+private:
+    /**
+     *  Number of operations (USE, MANAGE, ADMIN, CREATE) in the rights mask
+     */
+    static const int OPERATIONS = 4;
+
+    /**
+     *  Objects granted by the rules of a selector, object type and operation
+     */
+    struct Grants
+    {
+        Grants():all(0){};
+
+        unsigned int all;
+
+        multiset<int> oids;
+
+        multiset<int> gids;
+
+        multiset<int> cids;
+
+        bool empty() const
+        {
+            return all == 0 && oids.empty() && gids.empty() && cids.empty();
+        };
+    };
+
+    /**
+     *  Index key: user selector and object type bit * OPERATIONS + operation
+     *  bit
+     */
+    typedef pair<long long, int> IndexKey;
+
+    map<IndexKey, Grants> index;
+
+    unsigned long long _generation;
+
+    int zone_id;
+
+    pthread_rwlock_t rwlock;
+
+    /**
+     *  @return true if the rule applies in the local zone
+     */
+    bool local_zone(const AclRule * rule) const;
+
+    /**
+     *  Adds (or removes) the objects granted by a rule to the index
+     *    @param rule the ACL rule
+     *    @param inc 1 to add the rule, -1 to remove it
+     */
+    void update(const AclRule * rule, int inc);
+};
+
+#endif /*ACL_RULE_INDEX_H_*/
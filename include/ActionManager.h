@@ -17,11 +17,16 @@
 #ifndef ACTION_MANAGER_H_
 #define ACTION_MANAGER_H_
 
-#include <queue>
+#include <set>
+#include <vector>
+#include <new>
+#include <typeinfo>
 #include <pthread.h>
 #include <ctime>
 #include <string>
 
+#include "ActionQueue.h"
+
 /**
  *  Represents a generic request, pending actions are stored in a queue.
  *  Each element stores the base action type, additional data is added by each
@@ -40,6 +45,17 @@ public:
         USER
     };
 
+    /**
+     *  Priority of the action. High priority actions (e.g. user requests) are
+     *  processed ahead of low priority ones (e.g. monitoring) of other objects,
+     *  the actions of an object are always processed in order
+     */
+    enum Priority
+    {
+        HIGH = 0,
+        LOW  = 1
+    };
+
     Type type() const
     {
         return _type;
@@ -54,8 +70,78 @@ public:
         return new ActionRequest(_type);
     }
 
+    /**
+     *  Copies the action in the given buffer, used to queue actions without
+     *  allocating memory. Derived classes should implement it with clone_in.
+     *    @param buffer to store the action
+     *    @param size of the buffer
+     *    @return the copy, 0 if it cannot be copied in the buffer
+     */
+    virtual ActionRequest * clone(void * buffer, size_t size) const
+    {
+        return clone_in(*this, buffer, size);
+    }
+
+    /**
+     *  Object the action applies to (e.g. the VM). When the manager runs
+     *  several workers, the actions of the same object are processed in order
+     *  by the same worker.
+     *    @return the object id, -1 if the action is not bound to an object
+     */
+    virtual int object_id() const
+    {
+        return -1;
+    }
+
+    /**
+     *  Idempotent actions can be coalesced: when the manager is in coalescing
+     *  mode, an action is discarded if another one with the same key and
+     *  object id is pending.
+     *    @return the action key (e.g. the action code), -1 if the action
+     *    cannot be coalesced
+     */
+    virtual int coalesce_key() const
+    {
+        return -1;
+    }
+
+    /**
+     *  @return the priority of the action. By default user actions are HIGH
+     *  priority, and timer and finalize actions LOW
+     */
+    virtual Priority priority() const
+    {
+        return _type == USER ? HIGH : LOW;
+    }
+
+    /**
+     *  Name of the action in the operation traces (see Tracer). Only the
+     *  actions bound to a VM (object_id) can be traced.
+     *    @return the name, 0 if the action is not traced
+     */
+    virtual const char * trace_name() const
+    {
+        return 0;
+    }
+
 protected:
     Type _type;
+
+    /**
+     *  Copies an action in a buffer. Derived classes that do not implement
+     *  clone(buffer, size) are not copied, as they would be sliced
+     *    @return the copy, 0 if the type does not match or does not fit
+     */
+    template<typename T>
+    static ActionRequest * clone_in(const T& ar, void * buffer, size_t size)
+    {
+        if ( typeid(ar) != typeid(T) || sizeof(T) > size )
+        {
+            return 0;
+        }
+
+        return new (buffer) T(ar);
+    }
 };
 
 /**
@@ -117,15 +203,29 @@ private:
 };
 
 
+/**
+ *  Main function for the worker threads of an ActionManager
+ */
+extern "C" void * action_worker(void *arg);
+
 /**
  *  ActionManager. Provides action support for a class implementing
- *  the ActionListener interface.
+ *  the ActionListener interface. By default actions are processed by the
+ *  thread running the loop. The manager can also run several worker threads,
+ *  actions are then distributed among the workers by its object id. Timer,
+ *  finalize and actions not bound to an object are processed by the loop.
  */
 class ActionManager
 {
 public:
 
-    ActionManager();
+    /**
+     *  @param num_workers threads to process the actions, 1 to process
+     *  them in the loop thread
+     *  @param coalesce if true, duplicate pending actions are discarded (see
+     *  ActionRequest::coalesce_key)
+     */
+    ActionManager(unsigned int num_workers = 1, bool coalesce = false);
 
     virtual ~ActionManager();
 
@@ -211,18 +311,52 @@ public:
         this->listener = listener;
     };
 
+    /**
+     *  Records the actions of this manager in the operation traces
+     *    @param component name of the manager in the traces (e.g. "LCM"), it
+     *    MUST be a string literal
+     */
+    void trace(const char * component)
+    {
+        trace_component = component;
+    };
+
 private:
+    friend void * action_worker(void *arg);
+
     /**
      *  Queue of pending actions, processed in a FIFO manner
      */
-    std::queue<ActionRequest *> actions;
+    ActionQueue actions;
+
+    /**
+     *  A worker thread, with its own queue of actions
+     */
+    struct Worker
+    {
+        ActionManager * am;
+
+        ActionQueue     actions;
+
+        pthread_t       thread_id;
+    };
+
+    std::vector<Worker *> workers;
 
     /**
-     *  Action synchronization is implemented using the pthread library,
-     *  with condition variable and its associated mutex
+     *  Process the actions of a worker until a FINALIZE action is received
      */
-    pthread_mutex_t mutex;
-    pthread_cond_t  cond;
+    void worker_loop(Worker * worker);
+
+    /**
+     *  Starts the worker threads (if any)
+     */
+    void start_workers();
+
+    /**
+     *  Stops the worker threads (if any), pending actions are processed
+     */
+    void stop_workers();
 
     /**
      *  The listener notified by this manager
@@ -230,21 +364,36 @@ private:
     ActionListener * listener;
 
     /**
-     *  Function to lock the Manager mutex
+     *  Pending actions that can be coalesced <key, object id>
      */
-    void lock()
-    {
-        pthread_mutex_lock(&mutex);
-    };
+    bool coalesce;
+
+    std::set<std::pair<int, int> > pending;
+
+    pthread_mutex_t pending_mutex;
 
     /**
-     *  Function to unlock the Manager mutex
+     *  Adds the action to the pending set
+     *    @return false if an equivalent action is already pending
      */
-    void unlock()
-    {
-        pthread_mutex_unlock(&mutex);
-    };
+    bool add_pending(const ActionRequest& ar);
 
+    /**
+     *  Removes the action from the pending set, a new equivalent action can
+     *  be queued after this
+     */
+    void del_pending(const ActionRequest& ar);
+
+    /**
+     *  Name of the manager in the operation traces, 0 if not traced
+     */
+    const char * trace_component;
+
+    /**
+     *  Invokes the listener for an action, recording it in the operation
+     *  traces if needed
+     */
+    void do_action(const ActionRequest& ar);
 };
 
 #endif /*ACTION_MANAGER_H_*/
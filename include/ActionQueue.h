@@ -0,0 +1,260 @@
+/* -------------------------------------------------------------------------- */
+/* Copyright 2002-2017, OpenNebula Project, OpenNebula Systems                */
+/*                                                                            */
+/* Licensed under the Apache License, Version 2.0 (the "License"); you may    */
+/* not use this file except in compliance with the License. You may obtain    */
+/* a copy of the License at                                                   */
+/*                                                                            */
+/* http://www.apache.org/licenses/LICENSE-2.0                                 */
+/*                                                                            */
+/* Unless required by applicable law or agreed to in writing, software        */
+/* distributed under the License is distributed on an "AS IS" BASIS,          */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   */
+/* See the License for the specific language governing permissions and        */
+/* limitations under the License.                                             */
+/* -------------------------------------------------------------------------- */
+
+#ifndef ACTION_QUEUE_H_
+#define ACTION_QUEUE_H_
+
+#include <queue>
+#include <pthread.h>
+#include <stdint.h>
+#include <time.h>
+
+class ActionRequest;
+
+/**
+ *  Multiple producer, single consumer queue of actions. Actions are stored in
+ *  a bounded ring buffer, producers reserve the cells with an atomic
+ *  operation and the actions are copied in place (see ActionRequest::clone),
+ *  so no lock or memory allocation is needed to queue an action.
+ *
+ *  When the ring is full producers yield for a while, and then actions are
+ *  stored in an overflow list protected by a mutex, so actions are never
+ *  dropped. The mutex and condition variable are also used by the consumer
+ *  to wait for new actions.
+ *
+ *  The queue has a lane (ring and overflow list) for each action priority
+ *  (see ActionRequest::priority). Lanes are served in weighted round robin,
+ *  so low priority actions are delayed but not starved by high priority
+ *  ones. Actions are processed in FIFO order within a lane. A FINALIZE
+ *  action is returned once the other lanes are empty.
+ *
+ *  Actions of the same object (see ActionRequest::object_id) are never
+ *  reordered: while an object has pending actions, new ones go to the same
+ *  lane whatever their priority. Priorities only reorder actions of
+ *  different objects.
+ */
+class ActionQueue
+{
+public:
+    /**
+     *  @param capacity of the ring of each lane, rounded up to a power of 2
+     */
+    ActionQueue(unsigned int capacity = DEFAULT_CAPACITY);
+
+    ~ActionQueue();
+
+    /**
+     *  Adds an action to the queue. Can be called by any thread
+     *    @param ar the action, it is copied in the queue
+     */
+    void push(const ActionRequest& ar);
+
+    /**
+     *  Gets the next action in the queue. The action is owned by the queue
+     *  until pop() is called. Only the consumer thread can call this method.
+     *    @return the action, 0 if the queue is empty
+     */
+    ActionRequest * front();
+
+    /**
+     *  Frees the action returned by the last call to front(). Only the
+     *  consumer thread can call this method.
+     */
+    void pop();
+
+    /**
+     *  Waits for new actions. Only the consumer thread can call this method.
+     *    @param timeout absolute time to stop waiting, 0 to wait forever
+     *    @return 0 if an action can be available, ETIMEDOUT if the timeout
+     *    expired
+     */
+    int wait(const struct timespec * timeout);
+
+    /**
+     *  Sets the number of consecutive actions served from each lane when the
+     *  others have pending actions. It SHOULD be called before any queue is
+     *  used.
+     *    @param high weight of the HIGH priority lane
+     *    @param low weight of the LOW priority lane
+     */
+    static void set_weights(unsigned int high, unsigned int low);
+
+    /**
+     *  Default capacity of the queues
+     */
+    static const unsigned int DEFAULT_CAPACITY = 4096;
+
+    /**
+     *  Size of the buffer to copy the actions in place
+     */
+    static const size_t ACTION_SIZE = 64;
+
+private:
+    /**
+     *  Number of lanes, one for each ActionRequest::Priority
+     */
+    static const unsigned int LANES = 2;
+
+    /**
+     *  Cell of the ring. The sequence number synchronizes producers and the
+     *  consumer: a cell is free for position pos when sequence == pos, and it
+     *  holds the action of position pos when sequence == pos + 1
+     */
+    struct Cell
+    {
+        size_t          sequence;
+
+        ActionRequest * action;
+
+        bool            in_place;
+
+        union
+        {
+            char        buffer[ACTION_SIZE];
+            long double align;
+            void *      align_ptr;
+        } storage;
+    };
+
+    /**
+     *  Ring and overflow list of a priority
+     */
+    struct Lane
+    {
+        Cell * cells;
+
+        size_t mask;
+
+        /**
+         *  Next position to be reserved by a producer
+         */
+        size_t enqueue_pos;
+
+        /**
+         *  Next position to be consumed (consumer thread only)
+         */
+        size_t dequeue_pos;
+
+        /**
+         *  Actions that did not fit in the ring
+         */
+        std::queue<ActionRequest *> overflow;
+
+        size_t overflow_size;
+    };
+
+    Lane lanes[LANES];
+
+    /**
+     *  Action returned by front(), its lane and whether it is in the overflow
+     *  list
+     */
+    ActionRequest * current;
+
+    unsigned int current_lane;
+
+    bool current_overflow;
+
+    /**
+     *  Lane being served and number of actions served in this turn
+     */
+    unsigned int lane;
+
+    unsigned int served;
+
+    /**
+     *  Set by the consumer when it is waiting for new actions
+     */
+    bool waiting;
+
+    /**
+     *  Number of slots to track the lane of the objects with pending actions
+     */
+    static const unsigned int OBJECT_SLOTS = 1024;
+
+    /**
+     *  Pending actions of the objects mapped to each slot (oid % OBJECT_SLOTS)
+     *  and their lane, stored as count * LANES + lane. Objects sharing a slot
+     *  also share the lane while any of them has pending actions.
+     */
+    unsigned int object_lanes[OBJECT_SLOTS];
+
+    pthread_mutex_t mutex;
+    pthread_cond_t  cond;
+
+    /**
+     *  Actions served from each lane in a turn
+     */
+    static unsigned int weights[LANES];
+
+    /**
+     *  Times a producer retries to add an action to a full ring before using
+     *  the overflow list
+     */
+    static const int MAX_RETRIES = 16;
+
+    /**
+     *  Selects the lane of an action, the priority lane unless the object has
+     *  pending actions in other lane. The action is counted as pending until
+     *  release_lane is called.
+     *    @param ar the action
+     *    @return the lane
+     */
+    unsigned int acquire_lane(const ActionRequest& ar);
+
+    /**
+     *  Counts an action of the object as processed
+     *    @param oid of the object, -1 if the action is not bound to an object
+     */
+    void release_lane(int oid);
+
+    /**
+     *  Adds the action to the ring of a lane
+     *    @return false if the ring is full
+     */
+    static bool push_ring(Lane& l, const ActionRequest& ar);
+
+    /**
+     *  @return true if there are no actions in the lane, does not lock the
+     *  queue
+     */
+    static bool empty(Lane& l);
+
+    /**
+     *  @return true if there are no actions, does not lock the queue
+     */
+    bool empty();
+
+    /**
+     *  Gets the first action of a lane, without removing it
+     *    @param l the lane
+     *    @param in_overflow true if the action is in the overflow list
+     *    @return the action, 0 if the lane is empty
+     */
+    ActionRequest * front(unsigned int l, bool& in_overflow);
+
+    /**
+     *  Wakes up the consumer if it is waiting
+     */
+    void notify();
+
+    /**
+     *  Frees the action of a cell
+     */
+    static void free_action(Cell * cell);
+};
+
+#endif /*ACTION_QUEUE_H_*/
@@ -0,0 +1,122 @@
+/* -------------------------------------------------------------------------- */
+/* Copyright 2002-2017, OpenNebula Project, OpenNebula Systems                */
+/*                                                                            */
+/* Licensed under the Apache License, Version 2.0 (the "License"); you may    */
+/* not use this file except in compliance with the License. You may obtain    */
+/* a copy of the License at                                                   */
+/*                                                                            */
+/* http://www.apache.org/licenses/LICENSE-2.0                                 */
+/*                                                                            */
+/* Unless required by applicable law or agreed to in writing, software        */
+/* distributed under the License is distributed on an "AS IS" BASIS,          */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   */
+/* See the License for the specific language governing permissions and        */
+/* limitations under the License.                                             */
+/* -------------------------------------------------------------------------- */
+
+
+#ifndef ATTRIBUTE_TABLE_H_
+#define ATTRIBUTE_TABLE_H_
+
+#include <string>
+#include <vector>
+#include <map>
+
+class ObjectXML;
+
+/**
+ *  Columnar representation of the attributes of a set of objects (e.g. the
+ *  hosts in the scheduler pool). A column holds the values of one attribute
+ *  for all the objects: numbers are stored in contiguous arrays and strings
+ *  are dictionary encoded. Columns are built the first time they are used,
+ *  with the same ObjectXML::search functions used to evaluate expressions on
+ *  a single object. The objects must not change while the table is in use.
+ *
+ *  Pseudo-attributes whose search result depends on the value looked for
+ *  (e.g. CURRENT_VMS in the scheduler HostXML) cannot be represented in a
+ *  column, expressions using them must be evaluated on each object.
+ *
+ *  The table is not thread-safe.
+ */
+class AttributeTable
+{
+public:
+    /**
+     *  Value of an attribute for each object. When an object has more than
+     *  one value the first one is used, as ObjectXML::search does.
+     */
+    template<typename T>
+    struct Column
+    {
+        std::vector<T>             values;
+        std::vector<unsigned char> found; /**< 1 if the object has a value */
+    };
+
+    /**
+     *  All the values of an attribute for each object, the values of object i
+     *  are values[offsets[i]] to values[offsets[i+1]-1]
+     */
+    template<typename T>
+    struct ListColumn
+    {
+        std::vector<size_t> offsets;
+        std::vector<T>      values;
+    };
+
+    /**
+     *  Dictionary encoded string attribute, codes are positions in the
+     *  dictionary and -1 for objects without the attribute
+     */
+    struct StringColumn
+    {
+        std::vector<std::string> dictionary;
+        std::vector<int>         codes;
+    };
+
+    /**
+     *  Dictionary encoded list of strings, see ListColumn
+     */
+    struct StringListColumn
+    {
+        std::vector<std::string> dictionary;
+        std::vector<size_t>      offsets;
+        std::vector<int>         codes;
+    };
+
+    AttributeTable(const std::vector<ObjectXML *>& _objects):objects(_objects){};
+
+    ~AttributeTable(){};
+
+    /**
+     *  @return number of objects (rows) in the table
+     */
+    size_t size() const
+    {
+        return objects.size();
+    };
+
+    const Column<int>& int_column(const std::string& name);
+
+    const Column<float>& float_column(const std::string& name);
+
+    const StringColumn& string_column(const std::string& name);
+
+    const ListColumn<int>& int_list_column(const std::string& name);
+
+    const ListColumn<float>& float_list_column(const std::string& name);
+
+    const StringListColumn& string_list_column(const std::string& name);
+
+private:
+    std::vector<ObjectXML *> objects;
+
+    std::map<std::string, Column<int> >     int_columns;
+    std::map<std::string, Column<float> >   float_columns;
+    std::map<std::string, StringColumn>     string_columns;
+
+    std::map<std::string, ListColumn<int> >   int_list_columns;
+    std::map<std::string, ListColumn<float> > float_list_columns;
+    std::map<std::string, StringListColumn>   string_list_columns;
+};
+
+#endif /*ATTRIBUTE_TABLE_H_*/
@@ -19,11 +19,15 @@
 
 #include <time.h>
 
+#include <map>
+#include <vector>
+
 #include "MadManager.h"
 #include "NebulaLog.h"
 #include "ActionManager.h"
 #include "AuthManagerDriver.h"
 #include "PoolObjectSQL.h"
+#include "LatencyHistogram.h"
 
 using namespace std;
 
@@ -64,6 +68,11 @@ public:
         return new AMAction(*this);
     }
 
+    ActionRequest * clone(void * buffer, size_t size) const
+    {
+        return clone_in(*this, buffer, size);
+    }
+
 private:
     Actions       _action;
 
@@ -75,32 +84,41 @@ private:
 
 extern "C" void * authm_action_loop(void *arg);
 
+/**
+ *  The AuthManager sends the authentication and authorization requests to
+ *  the auth driver. Requests are pipelined, the driver processes them
+ *  concurrently and they are matched with the answers by request id. The
+ *  AUTH_MAD configuration supports:
+ *    - INSTANCES, number of driver processes, requests are sent round-robin
+ *    - THREADS, concurrent requests per driver process
+ *    - REQUEST_TIMEOUT, seconds to wait for the driver answer
+ *    - NEGATIVE_CACHE_TIME, seconds to remember failed authentications, so
+ *      repeated bad credentials are rejected without calling the driver
+ */
 class AuthManager : public MadManager, public ActionListener
 {
 public:
 
     AuthManager(
         time_t                    timer,
-        vector<const VectorAttribute*>& _mads):
-            MadManager(_mads), timer_period(timer)
-    {
-        am.addListener(this);
-    };
+        vector<const VectorAttribute*>& _mads);
 
-    ~AuthManager(){};
+    ~AuthManager();
 
     /**
      *  Triggers specific actions to the Auth Manager. This function
-     *  wraps the ActionManager trigger function.
+     *  wraps the ActionManager trigger function. Authentications rejected
+     *  recently with the same credentials are failed right away.
      *    @param action the Auth Manager action
      *    @param request an auth request
      */
-    void trigger(AMAction::Actions action, AuthRequest*  request)
-    {
-        AMAction auth_ar(action, request);
+    void trigger(AMAction::Actions action, AuthRequest*  request);
 
-        am.trigger(auth_ar);
-    }
+    /**
+     *  Notify the result of an auth request, records the driver latency
+     *  and caches failed authentications
+     */
+    void notify_request(int id, bool result, const string& message);
 
     /**
      *  This functions starts the associated listener thread, and creates a
@@ -137,6 +155,18 @@ public:
         return authz_enabled;
     };
 
+    /**
+     *  Dumps the auth driver metrics in XML format
+     *    @param oss the output stream
+     */
+    void to_xml(ostringstream& oss);
+
+    /**
+     *  Dumps the auth driver metrics in the Prometheus text format
+     *    @param oss the output stream
+     */
+    void to_prometheus(ostringstream& oss);
+
 private:
     /**
      *  Thread id for the Transfer Manager
@@ -149,10 +179,27 @@ private:
     ActionManager           am;
 
     /**
-     *  Timer for the Manager (periocally triggers timer action)
+     *  Timer for the Manager (periocally triggers timer action). Request
+     *  time outs are checked every second
      */
     time_t                  timer_period;
 
+    /**
+     *  Seconds to wait for the driver to answer a request
+     */
+    time_t                  request_timeout;
+
+    /**
+     *  Seconds to keep a failed authentication in the negative cache, 0
+     *  disables the cache
+     */
+    time_t                  negative_cache_time;
+
+    /**
+     *  Max number of entries in the negative cache
+     */
+    static const size_t     NEGATIVE_CACHE_SIZE;
+
     /**
      *  Generic name for the Auth driver
      */
@@ -163,6 +210,89 @@ private:
       */
      bool                   authz_enabled;
 
+    /**
+     *  Driver instances, requests are sent round-robin
+     */
+    vector<const AuthManagerDriver *> drivers;
+
+    /**
+     *  Counter to select the next driver instance
+     */
+    unsigned int            next_driver;
+
+    /**
+     *  Request sent to the driver and waiting for the answer
+     */
+    struct PendingRequest
+    {
+        AMAction::Actions action;
+
+        struct timespec   start;
+
+        time_t            time_out;
+
+        /**
+         *  Negative cache key of authentications
+         */
+        string            cache_key;
+    };
+
+    /**
+     *  Metrics of an action
+     */
+    struct ActionMetrics
+    {
+        ActionMetrics():success(0), failure(0), timeout(0){};
+
+        LatencyHistogram latency;
+
+        unsigned long long success;
+
+        unsigned long long failure;
+
+        unsigned long long timeout;
+    };
+
+    /**
+     *  Pending requests by request id
+     */
+    map<int, PendingRequest> pending;
+
+    /**
+     *  Failed authentications, cache key to expiration time and driver
+     *  message
+     */
+    map<string, pair<time_t, string> > negative_cache;
+
+    unsigned long long      negative_cache_hits;
+
+    /**
+     *  Metrics by action (AUTHENTICATE, AUTHORIZE)
+     */
+    ActionMetrics           metrics[2];
+
+    /**
+     *  Protects the pending requests and the negative cache
+     */
+    pthread_mutex_t         mutex;
+
+    /**
+     *  @return the negative cache key of an authentication request
+     */
+    static string negative_cache_key(AuthRequest * ar);
+
+    /**
+     *  Adds a request to the pending list, it MUST be called before
+     *  sending the request to the driver
+     */
+    void add_pending(AMAction::Actions action, AuthRequest * ar);
+
+    /**
+     *  Fails the requests not answered in time, and removes the expired
+     *  entries of the negative cache
+     */
+    void check_time_outs();
+
     /**
      *  Returns a pointer to a Auth Manager driver.
      *    @param name of an attribute of the driver (e.g. its type)
@@ -179,18 +309,20 @@ private:
     };
 
     /**
-     *  Returns a pointer to a Auth Manager driver. The driver is
-     *  searched by its name.
-     *    @param name the name of the driver
-     *    @return the TM driver owned by uid with attribute name equal to value
-     *    or 0 in not found
+     *  Returns a pointer to a Auth Manager driver. Driver instances are
+     *  used round-robin.
+     *    @return the Auth driver or 0 in not found
      */
     const AuthManagerDriver * get()
     {
-        string name("NAME");
+        if ( drivers.empty() )
+        {
+            return 0;
+        }
 
-        return static_cast<const AuthManagerDriver *>
-               (MadManager::get(0,name,auth_driver_name));
+        unsigned int i = __atomic_fetch_add(&next_driver, 1, __ATOMIC_RELAXED);
+
+        return drivers[i % drivers.size()];
     };
 
     /**
@@ -214,7 +346,7 @@ private:
     // -------------------------------------------------------------------------
     void timer_action(const ActionRequest& ar)
     {
-        check_time_outs_action();
+        check_time_outs();
     };
 
     void finalize_action(const ActionRequest& ar)
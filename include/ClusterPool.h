@@ -28,7 +28,10 @@ class ClusterPool : public PoolSQL
 public:
     ClusterPool(SqlDB * db, const VectorAttribute * vnc_conf);
 
-    ~ClusterPool(){};
+    ~ClusterPool()
+    {
+        pthread_mutex_destroy(&cache_mutex);
+    };
 
     /* ---------------------------------------------------------------------- */
     /* Constants for DB management                                            */
@@ -125,6 +128,34 @@ public:
         return rc;
     }
 
+    /* ---------------------------------------------------------------------- */
+    /* Cluster metadata cache                                                 */
+    /* ---------------------------------------------------------------------- */
+    /**
+     *  Gets the reserved capacity of a cluster. The values are served from an
+     *  in-memory cache, the cluster is only loaded from the DB on a miss. The
+     *  cache entry is refreshed each time the cluster is updated or dropped.
+     *    @param oid of the cluster
+     *    @param cpu reserved cpu (RESERVED_CPU attribute)
+     *    @param mem reserved memory (RESERVED_MEM attribute)
+     *
+     *    @return 0 on success, -1 if the cluster does not exist
+     */
+    int get_reserved_capacity(int oid, string& cpu, string& mem);
+
+    /**
+     *  Removes all the entries from the metadata cache, e.g. when the DB may
+     *  have been modified without going through the pool (HA followers)
+     */
+    void clean_cache()
+    {
+        pthread_mutex_lock(&cache_mutex);
+
+        reserved_cache.clear();
+
+        pthread_mutex_unlock(&cache_mutex);
+    };
+
     /* ---------------------------------------------------------------------- */
     /* Methods for DB management                                              */
     /* ---------------------------------------------------------------------- */
@@ -191,6 +222,15 @@ public:
      */
     int drop(PoolObjectSQL * objsql, string& error_msg);
 
+    /**
+     *  Updates the cluster in the DB and refreshes its metadata cache entry.
+     *  The object mutex SHOULD be locked.
+     *    @param objsql a pointer to the Cluster object
+     *
+     *    @return 0 on success
+     */
+    int update(PoolObjectSQL * objsql);
+
     /**
      *  Bootstraps the database table(s) associated to the Cluster pool
      *    @return 0 on success
@@ -254,6 +294,31 @@ private:
      */
     const VectorAttribute vnc_conf;
 
+    /**
+     *  Reserved capacity (cpu, mem) of each cluster, indexed by cluster id
+     */
+    map<int, pair<string, string> > reserved_cache;
+
+    pthread_mutex_t cache_mutex;
+
+    /**
+     *  Sets the cache entry for the given cluster. The object mutex SHOULD be
+     *  locked.
+     */
+    void set_cache(Cluster * cluster)
+    {
+        string cpu;
+        string mem;
+
+        cluster->get_reserved_capacity(cpu, mem);
+
+        pthread_mutex_lock(&cache_mutex);
+
+        reserved_cache[cluster->get_oid()] = make_pair(cpu, mem);
+
+        pthread_mutex_unlock(&cache_mutex);
+    };
+
     /**
      *  Factory method to produce objects
      *    @return a pointer to the new object
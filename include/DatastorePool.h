@@ -28,7 +28,10 @@ class DatastorePool : public PoolSQL
 public:
     DatastorePool(SqlDB * db, const vector<const SingleAttribute *>& _inherit_attrs);
 
-    ~DatastorePool(){};
+    ~DatastorePool()
+    {
+        pthread_mutex_destroy(&cache_mutex);
+    };
 
     /* ---------------------------------------------------------------------- */
     /* Constants for DB management                                            */
@@ -64,6 +67,35 @@ public:
      */
     static const int FILE_DS_ID;
 
+    /* ---------------------------------------------------------------------- */
+    /* Datastore metadata cache                                               */
+    /* ---------------------------------------------------------------------- */
+    /**
+     *  Gets the type of a datastore and whether it is shared. The values are
+     *  served from an in-memory cache, the datastore is only loaded from the
+     *  DB on a miss. The cache entry is refreshed each time the datastore is
+     *  updated or dropped.
+     *    @param oid of the datastore
+     *    @param type of the datastore
+     *    @param shared true if the datastore is shared (SHARED attribute)
+     *
+     *    @return 0 on success, -1 if the datastore does not exist
+     */
+    int get_ds_type(int oid, Datastore::DatastoreType& type, bool& shared);
+
+    /**
+     *  Removes all the entries from the metadata cache, e.g. when the DB may
+     *  have been modified without going through the pool (HA followers)
+     */
+    void clean_cache()
+    {
+        pthread_mutex_lock(&cache_mutex);
+
+        type_cache.clear();
+
+        pthread_mutex_unlock(&cache_mutex);
+    };
+
     /* ---------------------------------------------------------------------- */
     /* Methods for DB management                                              */
     /* ---------------------------------------------------------------------- */
@@ -143,6 +175,15 @@ public:
      */
     int drop(PoolObjectSQL * objsql, string& error_msg);
 
+    /**
+     *  Updates the Datastore in the DB and refreshes its metadata cache entry.
+     *  The object mutex SHOULD be locked.
+     *    @param objsql a pointer to the Datastore object
+     *
+     *    @return 0 on success
+     */
+    int update(PoolObjectSQL * objsql);
+
     /**
      *  Bootstraps the database table(s) associated to the Datastore pool
      *    @return 0 on success
@@ -193,6 +234,29 @@ private:
      */
     vector<string> inherit_attrs;
 
+    /**
+     *  Type and shared flag of each datastore, indexed by datastore id
+     */
+    map<int, pair<Datastore::DatastoreType, bool> > type_cache;
+
+    pthread_mutex_t cache_mutex;
+
+    /**
+     *  Sets the cache entry for the given datastore. The object mutex SHOULD
+     *  be locked.
+     */
+    void set_cache(Datastore * ds)
+    {
+        pair<Datastore::DatastoreType, bool> entry(ds->get_type(),
+                ds->is_shared());
+
+        pthread_mutex_lock(&cache_mutex);
+
+        type_cache[ds->get_oid()] = entry;
+
+        pthread_mutex_unlock(&cache_mutex);
+    };
+
     /**
      *  Factory method to produce objects
      *    @return a pointer to the new object
@@ -71,6 +71,21 @@ public:
         return new DMAction(*this);
     }
 
+    ActionRequest * clone(void * buffer, size_t size) const
+    {
+        return clone_in(*this, buffer, size);
+    }
+
+    int object_id() const
+    {
+        return _vm_id;
+    }
+
+    /**
+     *  @return the name of the action in the operation traces
+     */
+    const char * trace_name() const;
+
 private:
     Actions _action;
 
@@ -81,10 +96,16 @@ class DispatchManager : public ActionListener
 {
 public:
 
-    DispatchManager():
-            hpool(0), vmpool(0), vrouterpool(0), tm(0), vmm(0), lcm(0), imagem(0)
+    /**
+     *  @param workers number of threads to process the DM actions
+     */
+    DispatchManager(unsigned int workers):
+            hpool(0), vmpool(0), vrouterpool(0), tm(0), vmm(0), lcm(0),
+            imagem(0), am(workers)
     {
         am.addListener(this);
+
+        am.trace("DM");
     };
 
     ~DispatchManager(){};
@@ -0,0 +1,258 @@
+/* -------------------------------------------------------------------------- */
+/* Copyright 2002-2017, OpenNebula Project, OpenNebula Systems                */
+/*                                                                            */
+/* Licensed under the Apache License, Version 2.0 (the "License"); you may    */
+/* not use this file except in compliance with the License. You may obtain    */
+/* a copy of the License at                                                   */
+/*                                                                            */
+/* http://www.apache.org/licenses/LICENSE-2.0                                 */
+/*                                                                            */
+/* Unless required by applicable law or agreed to in writing, software        */
+/* distributed under the License is distributed on an "AS IS" BASIS,          */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   */
+/* See the License for the specific language governing permissions and        */
+/* limitations under the License.                                             */
+/* -------------------------------------------------------------------------- */
+
+
+#ifndef EXPRESSION_PROGRAM_H_
+#define EXPRESSION_PROGRAM_H_
+
+#include <string>
+#include <vector>
+#include <map>
+#include <stdint.h>
+#include <pthread.h>
+
+class ObjectXML;
+class AttributeTable;
+
+/**
+ *  An ExpressionProgram is a requirement (boolean) or rank (arithmetic)
+ *  expression compiled by the expression parsers. The program is stored as a
+ *  vector of nodes, operands refer to other nodes by its position. Attributes
+ *  are resolved on each evaluation, so the same program can be evaluated over
+ *  any number of objects without parsing the expression again.
+ */
+class ExpressionProgram
+{
+public:
+    enum ProgramType
+    {
+        BOOL  = 0, /**< Requirement expression, evaluates to true or false */
+        ARITH = 1  /**< Rank expression, evaluates to an integer */
+    };
+
+    enum Operation
+    {
+        AND       = 0,  /**< left & right */
+        OR        = 1,  /**< left | right */
+        NOT       = 2,  /**< ! left */
+        EQ        = 3,  /**< ATTR = value, value can be a pattern */
+        NE        = 4,  /**< ATTR != value, value can be a pattern */
+        GT        = 5,  /**< ATTR > value */
+        LT        = 6,  /**< ATTR < value */
+        CONTAINS  = 7,  /**< ATTR @> value */
+        ATTRIBUTE = 8,  /**< Value of ATTR */
+        CONSTANT  = 9,  /**< fvalue */
+        ADD       = 10, /**< left + right */
+        SUB       = 11, /**< left - right */
+        MUL       = 12, /**< left * right */
+        DIV       = 13, /**< left / right */
+        NEG       = 14  /**< - left */
+    };
+
+    enum ValueType
+    {
+        INTEGER = 0,
+        FLOAT   = 1,
+        STRING  = 2
+    };
+
+    ExpressionProgram():type(BOOL), root(-1), parse_rc(0){};
+
+    ~ExpressionProgram(){};
+
+    /**
+     *  Returns the compiled program for an expression from the program
+     *  cache, the expression is compiled the first time it is used. Cached
+     *  programs are freed by purge_cache().
+     *    @param expr the expression
+     *    @param type of the expression
+     *    @param tmp program to compile the expression when the cache is full
+     *    @return the cached program or tmp
+     */
+    static const ExpressionProgram * get(const std::string& expr,
+            ProgramType type, ExpressionProgram& tmp);
+
+    /**
+     *  Frees the cached programs not used since the last call, and starts a
+     *  new cache period (e.g. a scheduling cycle). It MUST be called when no
+     *  program returned by get() is in use.
+     */
+    static void purge_cache();
+
+    /**
+     *  Compiles an expression into this program
+     *    @param expr the expression
+     *    @param type of the expression
+     *    @return 0 on success, -1 on syntax error (see error())
+     */
+    int compile(const std::string& expr, ProgramType type);
+
+    /**
+     *  Evaluates a requirement program for the given object
+     *    @param oxml object to get the attribute values from
+     *    @param result true if the object matches the requirements
+     *    @param errmsg string describing the error, must be freed by the
+     *    calling function
+     *    @return 0 on success
+     */
+    int eval_bool(ObjectXML * oxml, bool& result, char **errmsg) const;
+
+    /**
+     *  Evaluates a rank program for the given object
+     *    @param oxml object to get the attribute values from
+     *    @param result of the rank evaluation
+     *    @param errmsg string describing the error, must be freed by the
+     *    calling function
+     *    @return 0 on success
+     */
+    int eval_arith(ObjectXML * oxml, int& result, char **errmsg) const;
+
+    /**
+     *  Evaluates a requirement program for all the objects of a table. Each
+     *  node is evaluated over whole columns into a bitmap, and bitmaps are
+     *  combined a 64-bit word at a time.
+     *    @param table with the attributes of the objects
+     *    @param bitmap bit i is set if the object i of the table matches the
+     *    requirements, see test()
+     *    @param errmsg string describing the error, must be freed by the
+     *    calling function
+     *    @return 0 on success
+     */
+    int eval_bool(AttributeTable& table, std::vector<uint64_t>& bitmap,
+            char **errmsg) const;
+
+    /**
+     *  @return true if the bit i of the bitmap is set
+     */
+    static bool test(const std::vector<uint64_t>& bitmap, size_t i)
+    {
+        return ((bitmap[i >> 6] >> (i & 63)) & 1) != 0;
+    };
+
+    /**
+     *  @return the syntax error of the expression, empty if it is valid
+     */
+    const std::string& error() const
+    {
+        return error_str;
+    };
+
+    /**
+     *  @param attr name of the attribute
+     *  @return true if the program uses the attribute
+     */
+    bool references(const std::string& attr) const;
+
+    // -------------------------------------------------------------------------
+    // Functions used by the parsers to build the program, they return the
+    // position of the new node
+    // -------------------------------------------------------------------------
+
+    int add_compare(Operation op, const char * attr, int value);
+
+    int add_compare(Operation op, const char * attr, float value);
+
+    /**
+     *  @param value the pattern, 0 for the empty string ("")
+     */
+    int add_compare(Operation op, const char * attr, const char * value);
+
+    int add_attribute(const char * attr);
+
+    int add_constant(float value);
+
+    int add_operation(Operation op, int left, int right = -1);
+
+    void set_root(int node)
+    {
+        root = node;
+    };
+
+private:
+    struct Node
+    {
+        Node():op(AND), vtype(INTEGER), left(-1), right(-1), ivalue(0),
+            fvalue(0), null_svalue(false){};
+
+        Operation op;
+
+        ValueType vtype;
+
+        int left;
+
+        int right;
+
+        std::string attr;
+
+        int         ivalue;
+        float       fvalue;
+        std::string svalue;
+        bool        null_svalue;
+    };
+
+    ProgramType type;
+
+    std::vector<Node> nodes;
+
+    /**
+     *  Position of the top node, -1 for empty expressions
+     */
+    int root;
+
+    std::string error_str;
+
+    /**
+     *  Return code of the parser, returned by the eval functions for invalid
+     *  expressions
+     */
+    int parse_rc;
+
+    bool eval_bool_node(int i, ObjectXML * oxml) const;
+
+    float eval_arith_node(int i, ObjectXML * oxml) const;
+
+    void eval_bitmap_node(int i, AttributeTable& table,
+            std::vector<uint64_t>& bitmap) const;
+
+    // -------------------------------------------------------------------------
+    // Program cache, and mutex to parse one expression at a time (the
+    // expression scanner is not reentrant)
+    // -------------------------------------------------------------------------
+
+    /**
+     *  Maximum number of programs kept in the cache
+     */
+    static const size_t MAX_CACHED_PROGRAMS;
+
+    /**
+     *  Cached program and the cache period it was last used
+     */
+    struct CacheEntry
+    {
+        ExpressionProgram * program;
+        unsigned int        period;
+    };
+
+    static std::map<std::string, CacheEntry> programs[2];
+
+    static unsigned int cache_period;
+
+    static pthread_mutex_t cache_mutex;
+
+    static pthread_mutex_t lex_mutex;
+};
+
+#endif /*EXPRESSION_PROGRAM_H_*/
@@ -107,16 +107,6 @@ public:
      */
     GroupQuotas quota;
 
-    /**
-     *  Writes/updates the Group quotas fields in the database.
-     *    @param db pointer to the db
-     *    @return 0 on success
-     */
-    int update_quotas(SqlDB *db)
-    {
-        return quota.update(oid, db);
-    };
-
     /**
      *  Factory method for Group templates
      */
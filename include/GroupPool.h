@@ -19,6 +19,7 @@
 
 #include "Group.h"
 #include "SqlDB.h"
+#include "QuotaLedger.h"
 
 using namespace std;
 
@@ -27,9 +28,13 @@ class GroupPool : public PoolSQL
 {
 public:
     GroupPool(SqlDB * db, vector<const VectorAttribute *> hook_mads,
-          const string& remotes_location, bool is_federation_slave);
+          const string& remotes_location, bool is_federation_slave,
+          time_t quota_flush_period);
 
-    ~GroupPool(){};
+    ~GroupPool()
+    {
+        delete quota_ledger;
+    };
 
     /* ---------------------------------------------------------------------- */
     /* Constants for DB management                                            */
@@ -81,6 +86,8 @@ public:
      */
     Group * get(int oid, bool lock)
     {
+        quota_ledger->flush(oid);
+
         return static_cast<Group *>(PoolSQL::get(oid,lock));
     };
 
@@ -95,7 +102,14 @@ public:
     Group * get(const string& name, bool lock)
     {
         // The owner is set to -1, because it is not used in the key() method
-        return static_cast<Group *>(PoolSQL::get(name,-1,lock));
+        Group * group = static_cast<Group *>(PoolSQL::get(name,-1,lock));
+
+        if ( group != 0 && quota_ledger->flush(group->get_oid()) )
+        {
+            group->quota.select(group->get_oid(), db);
+        }
+
+        return group;
     };
 
     /**
@@ -142,11 +156,31 @@ public:
     int update(PoolObjectSQL * objsql);
 
     /**
-     * Update a particular Group's Quotas
-     *    @param group pointer to Group
-     *    @return 0 on success
+     *  Returns the ledger of the group quotas. Quota usage and limits MUST be
+     *  changed through the ledger
+     *    @return the quota ledger
      */
-    int update_quotas(Group * group);
+    QuotaLedger * get_quota_ledger()
+    {
+        return quota_ledger;
+    };
+
+    /**
+     *  Drops the group quotas cached in memory, they are loaded again from
+     *  the DB when needed
+     */
+    void clean_quotas()
+    {
+        quota_ledger->clear();
+    };
+
+    /**
+     *  Writes the pending changes of the group quotas and stops the ledger
+     */
+    void finalize_quotas()
+    {
+        quota_ledger->finalize();
+    };
 
     /**
      *  Drops the Group from the data base. The object mutex SHOULD be
@@ -171,7 +205,7 @@ public:
 
     /**
      *  Dumps the Group pool in XML format. A filter can be also added to the
-     *  query
+     *  query. The quota changes pending in the ledger are written first
      *  @param oss the output stream to dump the pool contents
      *  @param where filter for the objects, defaults to all
      *  @param limit parameters used for pagination
@@ -182,6 +216,11 @@ public:
 
 private:
 
+    /**
+     *  Quotas of the groups
+     */
+    QuotaLedger * quota_ledger;
+
     /**
      *  Factory method to produce objects
      *    @return a pointer to the new object
@@ -19,6 +19,9 @@
 
 #include "PoolSQL.h"
 #include "Host.h"
+#include "MonitorWriter.h"
+#include "MonitorStore.h"
+#include "TimerWheel.h"
 
 #include <time.h>
 #include <sstream>
@@ -37,9 +40,14 @@ class HostPool : public PoolSQL
 public:
     HostPool(SqlDB * db, vector<const VectorAttribute *> hook_mads,
         const string& hook_location, const string& remotes_location,
-        time_t expire_time);
+        time_t expire_time, time_t flush_period);
 
-    ~HostPool(){};
+    ~HostPool()
+    {
+        delete monitor_writer;
+
+        delete monitor_store;
+    };
 
     /**
      *  Function to allocate a new Host object
@@ -170,6 +178,25 @@ public:
         }
     };
 
+    /**
+     *  Updates the host in the DB and its monitoring schedule
+     *    @param objsql a pointer to the Host
+     *    @return 0 on success
+     */
+    int update(PoolObjectSQL * objsql)
+    {
+        Host * host = static_cast<Host *>(objsql);
+
+        int rc = PoolSQL::update(objsql);
+
+        if ( rc == 0 )
+        {
+            monitor_wheel.schedule(host->get_oid(), host->get_last_monitored());
+        }
+
+        return rc;
+    };
+
     int drop(PoolObjectSQL * objsql, string& error_msg)
     {
         Host * host = static_cast<Host *>(objsql);
@@ -180,7 +207,36 @@ public:
             return -1;
         }
 
-        return PoolSQL::drop(objsql, error_msg);
+        if ( monitor_writer != 0 )
+        {
+            monitor_writer->drop(host->get_oid());
+        }
+
+        int rc = PoolSQL::drop(objsql, error_msg);
+
+        if ( rc == 0 )
+        {
+            monitor_wheel.cancel(host->get_oid());
+
+            if ( monitor_store != 0 )
+            {
+                monitor_store->drop(host->get_oid());
+            }
+        }
+
+        return rc;
+    };
+
+    /**
+     *  Removes the monitoring schedule, it is loaded again from the DB by the
+     *  next call to discover (e.g. when the DB has been modified by the
+     *  leader of the zone)
+     */
+    void clean_cache()
+    {
+        monitor_wheel.clear();
+
+        monitor_wheel_loaded = false;
     };
 
     /**
@@ -216,28 +272,33 @@ public:
      *
      *  @param oss the output stream to dump the pool contents
      *  @param where filter for the objects, defaults to all
+     *  @param resolution in seconds of the samples, 0 for the raw samples.
+     *  Only used by the time series store, see MonitorStore::range
      *
      *  @return 0 on success
      */
     int dump_monitoring(ostringstream& oss,
-                        const string&  where);
+                        const string&  where,
+                        unsigned int   resolution = 0);
 
     /**
      *  Dumps the HOST monitoring information for a single HOST
      *
      *  @param oss the output stream to dump the pool contents
      *  @param hostid id of the target HOST
+     *  @param resolution in seconds of the samples, 0 for the raw samples
      *
      *  @return 0 on success
      */
     int dump_monitoring(ostringstream& oss,
-                        int            hostid)
+                        int            hostid,
+                        unsigned int   resolution = 0)
     {
         ostringstream filter;
 
         filter << "oid = " << hostid;
 
-        return dump_monitoring(oss, filter.str());
+        return dump_monitoring(oss, filter.str(), resolution);
     }
 
     /**
@@ -247,14 +308,31 @@ public:
      * @param host pointer to the host object
      * @return 0 on success
      */
-    int update_monitoring(Host * host)
+    int update_monitoring(Host * host);
+
+    /**
+     *  Stores the host monitoring metrics in a time series store instead of
+     *  the host_monitoring table
+     *    @param file path of the store
+     *    @param samples number of samples kept for each host
+     *    @param rollups <interval, samples> of the rollup series
+     *    @param error_str describing the error
+     *    @return 0 on success
+     */
+    int init_monitor_store(const string& file, unsigned int samples,
+            const vector<pair<unsigned int, unsigned int> >& rollups,
+            string& error_str);
+
+    /**
+     *  Stops the monitoring writer (if any), pending monitoring records are
+     *  written to the DB
+     */
+    void finalize_monitoring()
     {
-        if ( _monitor_expiration <= 0 )
+        if ( monitor_writer != 0 )
         {
-            return 0;
+            monitor_writer->finalize();
         }
-
-        return host->update_monitoring(db);
     };
 
     /**
@@ -288,6 +366,24 @@ private:
      */
     int discover_cb(void * _set, int num, char **values, char **names);
 
+    /**
+     *  Callback function to load the monitoring schedule (last_mon_time of
+     *  each host)
+     *
+     *    @param num the number of columns read from the DB
+     *    @param values the column values
+     *    @param names the column names
+     *
+     *    @return 0 on success
+     */
+    int load_wheel_cb(void * _null, int num, char **values, char **names);
+
+    /**
+     *  Loads the monitoring schedule from the DB
+     *    @return 0 on success
+     */
+    int load_monitor_wheel();
+
     /**
      * Deletes all monitoring entries for all hosts
      *
@@ -299,6 +395,30 @@ private:
      * Size, in seconds, of the historical monitoring information
      */
     static time_t _monitor_expiration;
+
+    /**
+     * Writer for the monitoring records, 0 if records are written directly
+     */
+    MonitorWriter * monitor_writer;
+
+    /**
+     * Time series store for the monitoring metrics, 0 if the host_monitoring
+     * table is used
+     */
+    MonitorStore * monitor_store;
+
+    /**
+     * Host metrics kept in the monitoring store
+     */
+    static const char * monitor_metrics[];
+
+    /**
+     * Monitoring schedule, the deadline of each host is its last_mon_time so
+     * hosts are discovered without querying the DB
+     */
+    TimerWheel monitor_wheel;
+
+    bool monitor_wheel_loaded;
 };
 
 #endif /*HOST_POOL_H_*/
@@ -306,6 +306,15 @@ public:
      */
     string& to_xml(string& xml) const;
 
+    /**
+     *  Gets a capacity or usage counter of the share
+     *    @param name of the counter, as in the XML representation (e.g.
+     *    CPU_USAGE, FREE_MEM...)
+     *    @param value of the counter
+     *    @return false if the counter does not exist
+     */
+    bool get_counter(const string& name, long long& value) const;
+
     void set_ds_monitorization(const vector<VectorAttribute*> &ds_att);
 
     void set_pci_monitorization(vector<VectorAttribute*> &pci_att)
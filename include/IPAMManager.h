@@ -63,6 +63,11 @@ public:
         return new IPMAction(*this);
     }
 
+    ActionRequest * clone(void * buffer, size_t size) const
+    {
+        return clone_in(*this, buffer, size);
+    }
+
 private:
     Actions       _action;
 
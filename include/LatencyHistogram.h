@@ -0,0 +1,110 @@
+/* -------------------------------------------------------------------------- */
+/* Copyright 2002-2017, OpenNebula Project, OpenNebula Systems                */
+/*                                                                            */
+/* Licensed under the Apache License, Version 2.0 (the "License"); you may    */
+/* not use this file except in compliance with the License. You may obtain    */
+/* a copy of the License at                                                   */
+/*                                                                            */
+/* http://www.apache.org/licenses/LICENSE-2.0                                 */
+/*                                                                            */
+/* Unless required by applicable law or agreed to in writing, software        */
+/* distributed under the License is distributed on an "AS IS" BASIS,          */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   */
+/* See the License for the specific language governing permissions and        */
+/* limitations under the License.                                             */
+/* -------------------------------------------------------------------------- */
+
+#ifndef LATENCY_HISTOGRAM_H_
+#define LATENCY_HISTOGRAM_H_
+
+#include <sstream>
+#include <string>
+#include <time.h>
+
+/**
+ *  Histogram of latencies in microseconds. Bucket i counts the samples
+ *  lower or equal than 2^i us, the last bucket counts the larger ones.
+ *  Samples are added with atomic operations so the histogram can be updated
+ *  by any number of threads without locks. Readers get an approximate
+ *  snapshot (counters are not read atomically as a whole).
+ */
+class LatencyHistogram
+{
+public:
+    /**
+     *  Number of buckets, the last one (2^25 us ~ 33s) is the overflow bucket
+     */
+    static const unsigned int BUCKETS = 26;
+
+    LatencyHistogram();
+
+    ~LatencyHistogram(){};
+
+    /**
+     *  Adds a sample
+     *    @param usec latency in microseconds
+     */
+    void add(unsigned long long usec);
+
+    /**
+     *  @return the number of samples
+     */
+    unsigned long long count() const
+    {
+        return __atomic_load_n(&_count, __ATOMIC_RELAXED);
+    };
+
+    /**
+     *  @return the sum of the samples in microseconds
+     */
+    unsigned long long sum() const
+    {
+        return __atomic_load_n(&_sum, __ATOMIC_RELAXED);
+    };
+
+    /**
+     *  Estimates a percentile as the upper bound of the bucket that holds it
+     *    @param p the percentile (0-100)
+     *    @return the latency in microseconds, 0 if there are no samples
+     */
+    unsigned long long percentile(double p) const;
+
+    /**
+     *  Dumps the histogram in XML format
+     *    @param oss the output stream
+     *    @param name of the XML element
+     */
+    void to_xml(std::ostringstream& oss, const std::string& name) const;
+
+    /**
+     *  Dumps the histogram in the Prometheus text format. Buckets are
+     *  cumulative and expressed in seconds.
+     *    @param oss the output stream
+     *    @param metric name of the metric
+     *    @param labels for the samples, e.g. method="one.vm.info"
+     */
+    void to_prometheus(std::ostringstream& oss, const std::string& metric,
+            const std::string& labels) const;
+
+    /**
+     *  @return microseconds elapsed since start (CLOCK_MONOTONIC)
+     */
+    static unsigned long long elapsed(const struct timespec& start);
+
+private:
+    unsigned long long buckets[BUCKETS];
+
+    unsigned long long _count;
+
+    unsigned long long _sum;
+
+    /**
+     *  @return upper bound of a bucket in microseconds
+     */
+    static unsigned long long bound(unsigned int bucket)
+    {
+        return 1ULL << bucket;
+    };
+};
+
+#endif /*LATENCY_HISTOGRAM_H_*/
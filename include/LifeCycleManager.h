@@ -140,6 +140,50 @@ public:
         return new LCMAction(*this);
     }
 
+    ActionRequest * clone(void * buffer, size_t size) const
+    {
+        return clone_in(*this, buffer, size);
+    }
+
+    int object_id() const
+    {
+        return _vm_id;
+    }
+
+    /**
+     *  @return the name of the action in the operation traces
+     */
+    const char * trace_name() const;
+
+    /**
+     *  Security group updates (the object id is the security group) are
+     *  idempotent, pending duplicates are coalesced
+     */
+    int coalesce_key() const
+    {
+        return _action == UPDATESG ? _action : -1;
+    }
+
+    /**
+     *  Monitoring-driven actions and security group updates are background
+     *  work, processed after user and driver actions
+     */
+    Priority priority() const
+    {
+        switch (_action)
+        {
+            case MONITOR_SUSPEND:
+            case MONITOR_DONE:
+            case MONITOR_POWEROFF:
+            case MONITOR_POWERON:
+            case UPDATESG:
+                return LOW;
+
+            default:
+                return HIGH;
+        }
+    }
+
 private:
     Actions _action;
 
@@ -159,11 +203,16 @@ class LifeCycleManager : public ActionListener
 {
 public:
 
-    LifeCycleManager():
+    /**
+     *  @param workers number of threads to process the LCM actions
+     */
+    LifeCycleManager(unsigned int workers):
         vmpool(0), hpool(0), ipool(0), sgpool(0), clpool(0), tm(0), vmm(0),
-        dm(0), imagem(0)
+        dm(0), am(workers, true), imagem(0)
     {
         am.addListener(this);
+
+        am.trace("LCM");
     };
 
     ~LifeCycleManager(){};
@@ -19,6 +19,7 @@
 
 #include <string>
 #include <time.h>
+#include <pthread.h>
 #include <libxml/tree.h>
 
 #include <map>
@@ -228,4 +229,85 @@ private:
 
 };
 
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+/**
+ *  Process-wide cache of authentication sessions. Users are reloaded from the
+ *  DB on each request, so their SessionToken does not persist across calls.
+ *  This cache keeps the sessions validated by the auth drivers, indexed by
+ *  user and token hash. Each session stores a fingerprint of the user auth
+ *  attributes (password, driver, groups...) so it is invalidated when they
+ *  change. The cache is split in stripes, each one with its own lock.
+ */
+class SessionCache
+{
+public:
+
+    SessionCache();
+
+    ~SessionCache();
+
+    /**
+     *  Check if the token has a valid session for the user
+     *    @param uid of the user
+     *    @param utk provided by the user
+     *    @param fingerprint of the current user auth attributes
+     *
+     *    @return true if the session is valid
+     */
+    bool is_valid(int uid, const std::string& utk,
+            const std::string& fingerprint);
+
+    /**
+     *  Register a new session for the user
+     *    @param uid of the user
+     *    @param utk provided by the user
+     *    @param fingerprint of the user auth attributes
+     *    @param valid time in seconds that the session will be considered
+     *    valid, -1 for no expiration and 0 to not cache the session
+     */
+    void set(int uid, const std::string& utk, const std::string& fingerprint,
+            time_t valid);
+
+    /**
+     *  Removes the sessions of a user
+     *    @param uid of the user
+     */
+    void reset(int uid);
+
+private:
+
+    /**
+     *  Number of stripes of the cache
+     */
+    static const unsigned int NUM_STRIPES = 16;
+
+    /**
+     *  Max number of sessions per stripe before purging expired ones
+     */
+    static const size_t MAX_SESSIONS;
+
+    struct Session
+    {
+        time_t      expiration_time;
+
+        std::string fingerprint;
+    };
+
+    struct Stripe
+    {
+        pthread_mutex_t mutex;
+
+        std::map<std::pair<int, std::string>, Session> sessions;
+    };
+
+    Stripe stripes[NUM_STRIPES];
+
+    Stripe& stripe(int uid)
+    {
+        return stripes[static_cast<unsigned int>(uid) % NUM_STRIPES];
+    };
+};
+
 #endif /*LOGIN_TOKEN_H_*/
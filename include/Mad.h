@@ -52,7 +52,9 @@ protected:
             attributes(attrs),
             sudo_execution(sudo),
             pid(-1)
-    {};
+    {
+        pthread_mutex_init(&write_mutex, 0);
+    };
 
     /**
      *  The destructor of the class finalizes the driver process, and all its
@@ -74,7 +76,13 @@ protected:
         str  = os.str();
         cstr = str.c_str();
 
+        // Messages can be sent by several manager threads, they are
+        // serialized so they are not interleaved in the pipe
+        pthread_mutex_lock(&write_mutex);
+
         ::write(nebula_mad_pipe, cstr, str.size());
+
+        pthread_mutex_unlock(&write_mutex);
     };
 
     /**
@@ -154,6 +162,11 @@ private:
      */
     pid_t               pid;
 
+    /**
+     *  Mutex to serialize the writes to the driver pipe
+     */
+    mutable pthread_mutex_t write_mutex;
+
     /**
      *  Starts the MAD. This function creates a new process, sets up the
      *  communication pipes and sends the initialization command to the driver.
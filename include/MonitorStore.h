@@ -0,0 +1,320 @@
+/* -------------------------------------------------------------------------- */
+/* Copyright 2002-2017, OpenNebula Project, OpenNebula Systems                */
+/*                                                                            */
+/* Licensed under the Apache License, Version 2.0 (the "License"); you may    */
+/* not use this file except in compliance with the License. You may obtain    */
+/* a copy of the License at                                                   */
+/*                                                                            */
+/* http://www.apache.org/licenses/LICENSE-2.0                                 */
+/*                                                                            */
+/* Unless required by applicable law or agreed to in writing, software        */
+/* distributed under the License is distributed on an "AS IS" BASIS,          */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   */
+/* See the License for the specific language governing permissions and        */
+/* limitations under the License.                                             */
+/* -------------------------------------------------------------------------- */
+
+#ifndef MONITOR_STORE_H_
+#define MONITOR_STORE_H_
+
+#include <pthread.h>
+#include <stdint.h>
+#include <time.h>
+
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "TimerWheel.h"
+
+// -----------------------------------------------------------------------------
+// -----------------------------------------------------------------------------
+// Monitor store class. Time series store for the numeric monitoring metrics of
+// a pool (hosts or VMs). Samples are stored in a memory-mapped file, each
+// object has a fixed-size ring buffer with a timestamp column and a column per
+// metric. The ring is sized to hold the monitoring expiration window, so old
+// samples are overwritten as new ones arrive.
+//
+// Optionally each object keeps a set of rollup series. A rollup series stores
+// the average of the samples in fixed time buckets (e.g. 5 minutes), it is
+// updated incrementally as samples are inserted.
+//
+// File layout:
+//   Header | Slot 0 | Slot 1 | ... | Slot N
+//   Slot:   oid | Series 0 (raw) | Series 1 (rollup) | ...
+//   Series: next | count | time[n] | weight[n] | metric_0[n] | ...
+// -----------------------------------------------------------------------------
+// -----------------------------------------------------------------------------
+class MonitorStore
+{
+public:
+    /**
+     *  @param _file path of the store file
+     *  @param _metrics names of the metrics, in the form SECTION/NAME. The
+     *  metric is rendered as <SECTION><NAME>value</NAME></SECTION>
+     *  @param _samples number of samples kept for each object
+     *  @param rollups <interval, samples> of each rollup series
+     */
+    MonitorStore(const std::string& _file,
+            const std::vector<std::string>& _metrics, unsigned int _samples,
+            const std::vector<std::pair<unsigned int, unsigned int> >& rollups);
+
+    ~MonitorStore();
+
+    /**
+     *  Maps the store file in memory. If the file exists and it was created
+     *  with the same metrics and series it is reused, otherwise it is
+     *  initialized.
+     *    @param error_str describing the error
+     *    @return 0 on success
+     */
+    int init(std::string& error_str);
+
+    /**
+     *  Adds a sample for an object and updates its rollup series. Samples must
+     *  be added in time order, a sample with the same timestamp than the last
+     *  one replaces it.
+     *    @param oid of the object
+     *    @param timestamp of the sample
+     *    @param values of the metrics, in the order given in the constructor
+     *    @return 0 on success
+     */
+    int insert(int oid, time_t timestamp, const std::vector<double>& values);
+
+    /**
+     *  Gets the samples of an object in the interval [start, end]
+     *    @param oid of the object
+     *    @param resolution in seconds, the samples are taken from the series
+     *    with the largest interval not greater than it (0 for raw samples)
+     *    @param start of the interval
+     *    @param end of the interval, 0 means up to the last sample
+     *    @param times of the samples
+     *    @param values of the samples, a vector for each metric
+     *    @return number of samples
+     */
+    int range(int oid, unsigned int resolution, time_t start, time_t end,
+            std::vector<time_t>& times, std::vector<std::vector<double> >& values);
+
+    /**
+     *  Renders the samples of an object in XML format (one element for each
+     *  sample)
+     *    @param oss stream to write the XML
+     *    @param oid of the object
+     *    @param resolution in seconds of the samples (0 for raw samples)
+     *    @param start first sample to include
+     *    @param elem_name name of the element for each sample (e.g. VM)
+     *    @param time_name name of the timestamp element (e.g. LAST_POLL)
+     */
+    void to_xml(std::ostringstream& oss, int oid, unsigned int resolution,
+            time_t start, const std::string& elem_name,
+            const std::string& time_name);
+
+    /**
+     *  Selects the series used for a given resolution
+     *    @param resolution in seconds
+     *    @return the interval of the series, 0 for the raw samples
+     */
+    unsigned int get_interval(unsigned int resolution) const;
+
+    /**
+     *  Frees the slot of the objects with no samples after max_time, and
+     *  whose rollup series have expired. Only the expired objects are visited.
+     *    @param max_time for the last sample of the object
+     */
+    void expire(time_t max_time);
+
+    /**
+     *  Frees the slot of the given object
+     */
+    void drop(int oid);
+
+    /**
+     *  @return the names of the metrics
+     */
+    const std::vector<std::string>& get_metrics() const
+    {
+        return metrics;
+    };
+
+private:
+    /**
+     *  Max. number of series (raw + rollups) of each object
+     */
+    static const unsigned int max_series = 8;
+
+    /**
+     *  Header of the store file
+     */
+    struct Header
+    {
+        char     magic[8];
+        uint32_t num_metrics;
+        uint32_t num_series;
+        uint32_t capacity;
+        uint32_t reserved;
+        uint32_t interval[max_series];
+        uint32_t samples[max_series];
+    };
+
+    /**
+     *  Header of each object slot, followed by the series
+     */
+    struct Slot
+    {
+        int32_t  oid;
+        uint32_t reserved;
+    };
+
+    /**
+     *  Header of each series, followed by the sample columns
+     */
+    struct Ring
+    {
+        uint32_t next;
+        uint32_t count;
+    };
+
+    /**
+     *  Layout of a series in a slot
+     */
+    struct Series
+    {
+        unsigned int interval;
+        unsigned int samples;
+        size_t       offset;
+    };
+
+    /**
+     *  Path of the store file
+     */
+    std::string file;
+
+    /**
+     *  Metric names and the section/name split used to render them
+     */
+    std::vector<std::string> metrics;
+
+    std::vector<std::pair<std::string, std::string> > metric_xml;
+
+    /**
+     *  Series of each object, the first one holds the raw samples
+     */
+    std::vector<Series> series;
+
+    /**
+     *  Size in bytes of each slot
+     */
+    size_t slot_size;
+
+    /**
+     *  Time covered by the longest rollup series
+     */
+    time_t rollup_window;
+
+    /**
+     *  File descriptor and mapped region
+     */
+    int fd;
+
+    char * base;
+
+    size_t map_size;
+
+    /**
+     *  Index of the slot of each object, and free slots
+     */
+    std::map<int, uint32_t> index;
+
+    std::vector<uint32_t> free_slots;
+
+    /**
+     *  Expiration time of each object (last sample + rollup_window)
+     */
+    TimerWheel expiration;
+
+    pthread_rwlock_t rwlock;
+
+    /**
+     *  Initial number of slots of the store
+     */
+    static const uint32_t initial_capacity;
+
+    static const char magic[8];
+
+    Header * header()
+    {
+        return reinterpret_cast<Header *>(base);
+    };
+
+    Slot * slot(uint32_t i)
+    {
+        return reinterpret_cast<Slot *>(base + sizeof(Header) + i * slot_size);
+    };
+
+    Ring * ring(Slot * s, unsigned int k)
+    {
+        return reinterpret_cast<Ring *>(reinterpret_cast<char *>(s) +
+                series[k].offset);
+    };
+
+    int64_t * times(Slot * s, unsigned int k)
+    {
+        return reinterpret_cast<int64_t *>(reinterpret_cast<char *>(s) +
+                series[k].offset + sizeof(Ring));
+    };
+
+    /**
+     *  Number of samples averaged in each bucket of the series
+     */
+    double * weights(Slot * s, unsigned int k)
+    {
+        return reinterpret_cast<double *>(times(s, k) + series[k].samples);
+    };
+
+    double * column(Slot * s, unsigned int k, unsigned int metric)
+    {
+        return weights(s, k) + (metric + 1) * series[k].samples;
+    };
+
+    /**
+     *  Resets the series of a slot
+     */
+    void clear_slot(Slot * s, int32_t oid);
+
+    /**
+     *  Adds a sample to a series of the slot. Rollup series average the
+     *  values of the samples in the same bucket.
+     *    @param s the slot
+     *    @param k the series
+     *    @param timestamp of the sample
+     *    @param values of the sample
+     *    @param replaced values of the raw sample replaced by this one, 0 if
+     *    it is a new sample. Its contribution to the bucket average is
+     *    replaced by the new values.
+     */
+    void add_sample(Slot * s, unsigned int k, time_t timestamp,
+            const std::vector<double>& values,
+            const std::vector<double> * replaced);
+
+    /**
+     *  @return index of the series used for the resolution
+     */
+    unsigned int series_index(unsigned int resolution) const;
+
+    /**
+     *  Maps the file with the given capacity, growing it if needed. The write
+     *  lock SHOULD be held.
+     *    @return 0 on success
+     */
+    int map_file(uint32_t capacity);
+
+    /**
+     *  Gets the slot of an object, allocates a new one if needed. The write
+     *  lock SHOULD be held.
+     *    @return the slot, 0 if it cannot be allocated
+     */
+    Slot * get_slot(int oid);
+};
+
+#endif /*MONITOR_STORE_H_*/
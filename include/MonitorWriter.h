@@ -0,0 +1,141 @@
+/* -------------------------------------------------------------------------- */
+/* Copyright 2002-2017, OpenNebula Project, OpenNebula Systems                */
+/*                                                                            */
+/* Licensed under the Apache License, Version 2.0 (the "License"); you may    */
+/* not use this file except in compliance with the License. You may obtain    */
+/* a copy of the License at                                                   */
+/*                                                                            */
+/* http://www.apache.org/licenses/LICENSE-2.0                                 */
+/*                                                                            */
+/* Unless required by applicable law or agreed to in writing, software        */
+/* distributed under the License is distributed on an "AS IS" BASIS,          */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   */
+/* See the License for the specific language governing permissions and        */
+/* limitations under the License.                                             */
+/* -------------------------------------------------------------------------- */
+
+#ifndef MONITOR_WRITER_H_
+#define MONITOR_WRITER_H_
+
+#include <pthread.h>
+#include <time.h>
+
+#include <map>
+#include <string>
+
+#include "SqlDB.h"
+
+extern "C" void * monitor_writer_thread(void *arg);
+
+// -----------------------------------------------------------------------------
+// -----------------------------------------------------------------------------
+// Monitor writer class. It buffers the monitoring records of a pool (hosts or
+// VMs) and writes them periodically with multi-row REPLACE statements (or a
+// single transaction if not supported by the DB backend). Monitoring records
+// are not replicated so they are written with exec_local_wr.
+// -----------------------------------------------------------------------------
+// -----------------------------------------------------------------------------
+class MonitorWriter
+{
+public:
+    /**
+     *  @param _db pointer to the DB
+     *  @param _table name of the monitoring table
+     *  @param _db_names columns of the monitoring table (oid, time, body)
+     *  @param _flush_period seconds between writes
+     */
+    MonitorWriter(SqlDB * _db, const char * _table, const char * _db_names,
+        time_t _flush_period);
+
+    ~MonitorWriter();
+
+    /**
+     *  Starts the writer thread
+     *    @return 0 on success
+     */
+    int start();
+
+    /**
+     *  Stops the writer thread and writes any pending record to the DB
+     */
+    void finalize();
+
+    /**
+     *  Adds a monitoring record to the buffer. A record with the same object
+     *  id and timestamp replaces the previous one.
+     *    @param oid of the object
+     *    @param timestamp of the monitoring record
+     *    @param body XML document with the monitoring data
+     */
+    void insert(int oid, time_t timestamp, const std::string& body);
+
+    /**
+     *  Removes the pending records of an object, so they are not written once
+     *  the object has been deleted. It waits for any write in progress.
+     *    @param oid of the object
+     */
+    void drop(int oid);
+
+    /**
+     *  Writes the buffered records to the DB
+     *    @return 0 on success
+     */
+    int flush();
+
+private:
+    friend void * monitor_writer_thread(void *arg);
+
+    /**
+     *  Loop of the writer thread, flush the buffer every flush_period or when
+     *  max_records are waiting to be written
+     */
+    void do_write();
+
+    /**
+     *  Pointer to the DB
+     */
+    SqlDB * db;
+
+    /**
+     *  Table and columns of the monitoring records
+     */
+    std::string table;
+
+    std::string db_names;
+
+    /**
+     *  Seconds between writes
+     */
+    time_t flush_period;
+
+    /**
+     *  Pending records, indexed by <oid, timestamp>
+     */
+    std::map<std::pair<int, time_t>, std::string> records;
+
+    /**
+     *  Max. number of pending records before forcing a write, this is also
+     *  the max. number of rows per SQL statement
+     */
+    static const unsigned int max_records;
+
+    // -------------------------------------------------------------------------
+    // pthread synchronization variables
+    // -------------------------------------------------------------------------
+    pthread_t thread_id;
+
+    pthread_mutex_t mutex;
+
+    pthread_cond_t cond;
+
+    /**
+     *  Serializes flush calls, so records are written in order
+     */
+    pthread_mutex_t write_mutex;
+
+    bool running;
+
+    bool _finalize;
+};
+
+#endif /*MONITOR_WRITER_H_*/
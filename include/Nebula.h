@@ -426,6 +426,16 @@ public:
         return master_oned;
     };
 
+    /**
+     *  Enables or disables the name index and the change log of the pools.
+     *  They are only used by the leader (or solo) server, as followers do
+     *  not see the changes made by the leader. Users and groups of a
+     *  federation are updated by other zones and are not indexed.
+     *    @param enable true to use the indexes, the name index is loaded on
+     *    first use and the change log is reset
+     */
+    void set_pool_indexes(bool enable);
+
     // -----------------------------------------------------------------------
     // Configuration attributes (read from oned.conf)
     // -----------------------------------------------------------------------
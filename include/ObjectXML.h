@@ -242,6 +242,13 @@ public:
      */
     int add_node(const char * xpath_expr, xmlNodePtr node, const char * new_name);
 
+    /**
+     *  Removes the nodes of an xpath expression from the document
+     *    @param xpath_expr Path of the nodes
+     *    @return the number of nodes removed
+     */
+    int remove_nodes(const char * xpath_expr);
+
     /**
      *  Frees a vector of XMLNodes, as returned by the get_nodes function
      *    @param content the vector of xmlNodePtr
@@ -292,7 +299,8 @@ public:
     // ---------------------------------------------------------
 
     /**
-     *  Evaluates a requirement expression on the given host.
+     *  Evaluates a requirement expression on the given host. The expression
+     *  is compiled once and cached, see ExpressionProgram.
      *    @param requirements string
      *    @param result true if the host matches the requirements
      *    @param errmsg string describing the error, must be freed by the
@@ -302,7 +310,8 @@ public:
     int eval_bool(const std::string& expr, bool& result, char **errmsg);
 
     /**
-     *  Evaluates a rank expression on the given host.
+     *  Evaluates a rank expression on the given host. The expression is
+     *  compiled once and cached, see ExpressionProgram.
      *    @param rank string
      *    @param result of the rank evaluation
      *    @param errmsg string describing the error, must be freed by the
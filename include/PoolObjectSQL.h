@@ -20,6 +20,7 @@
 #include "ObjectSQL.h"
 #include "ObjectXML.h"
 #include "Template.h"
+#include "LatencyHistogram.h"
 
 #include <pthread.h>
 #include <string.h>
@@ -287,11 +288,23 @@ public:
     };
 
     /**
-     *  Function to lock the object
+     *  Function to lock the object. The time the calling thread is blocked
+     *  waiting for the lock is added to lock_wait
      */
     void lock()
     {
+        if ( pthread_mutex_trylock(&mutex) == 0 )
+        {
+            return;
+        }
+
+        struct timespec start;
+
+        clock_gettime(CLOCK_MONOTONIC, &start);
+
         pthread_mutex_lock(&mutex);
+
+        lock_wait += LatencyHistogram::elapsed(start);
     };
 
     /**
@@ -302,6 +315,12 @@ public:
         pthread_mutex_unlock(&mutex);
     };
 
+    /**
+     *  Microseconds the calling thread has been blocked in lock(). It is
+     *  reset by the Request Manager to account the lock wait of each request
+     */
+    static __thread unsigned long long lock_wait;
+
     /**
      * Function to print the object into a string in XML format
      * base64 encoded
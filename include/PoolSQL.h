@@ -26,6 +26,7 @@
 #include "PoolObjectSQL.h"
 #include "Log.h"
 #include "Hook.h"
+#include "NebulaUtil.h"
 
 using namespace std;
 
@@ -73,8 +74,26 @@ public:
     PoolObjectSQL * get(int oid, bool lock);
 
     /**
-     * Updates the cache name index. Must be called when the owner of an object
-     * is changed
+     *  Gets the id of an object by name. The name index is used if enabled,
+     *  so the object is not loaded from the DB
+     *   @param name of the object
+     *   @param uid id of owner
+     *
+     *   @return the oid of the object, -1 if not found
+     */
+    int get_oid(const string& name, int uid);
+
+    /**
+     *  Enables (or disables) the name index. The index is loaded from the DB
+     *  the first time it is used, it MUST be disabled if the DB is modified
+     *  by other servers (e.g. HA followers or federated zones)
+     *    @param enable true to use the index
+     */
+    void set_name_index(bool enable);
+
+    /**
+     * Updates the cache name index. Must be called when the name or the owner
+     * of an object is changed
      *
      * @param old_name Object's name before the change
      * @param old_uid Object's owner ID before the change
@@ -129,6 +148,8 @@ public:
 
         if ( rc == 0 )
         {
+            record_change(objsql->oid);
+
             do_hooks(objsql, Hook::UPDATE);
         }
 
@@ -153,12 +174,36 @@ public:
         }
         else
         {
+            drop_cache_index(objsql);
+
             do_hooks(objsql, Hook::REMOVE);
         }
 
         return 0;
     };
 
+    /**
+     *  Enables (or disables) the change log of the pool. It records the
+     *  objects created, updated or dropped so clients can get the changes
+     *  since a given revision. The log MUST be disabled if the DB is
+     *  modified by other servers (e.g. HA followers)
+     *    @param enable true to record the changes, the log is reset
+     */
+    void set_change_log(bool enable);
+
+    /**
+     *  Gets the objects changed since a revision of the pool
+     *    @param revision returned by a previous call, empty to get all
+     *    @param changed oids of the objects created or updated
+     *    @param dropped oids of the objects dropped
+     *    @param current the current revision of the pool
+     *    @return true if changed and dropped are relative to revision, false
+     *    if the client needs to reload all the objects (e.g. the log is not
+     *    enabled, was reset or does not go back to revision)
+     */
+    bool get_changes(const string& revision, set<int>& changed,
+            set<int>& dropped, string& current);
+
     /**
      *  Removes all the elements from the pool
      */
@@ -240,6 +285,33 @@ public:
     static void oid_filter(int     start_id,
                            int     end_id,
                            string& filter);
+
+    /**
+     *  Creates a filter for the objects with a column in a set of values. It
+     *  uses a single comparison or an IN list, so the DB can use the indexes
+     *  of the column
+     *    @param column name
+     *    @param ids set of values, it should not be empty
+     *    @param filter the output stream to add the filter to
+     */
+    static void in_filter(const string&   column,
+                          const set<int>& ids,
+                          ostringstream&  filter)
+    {
+        if ( ids.empty() )
+        {
+            filter << "0 = 1";
+        }
+        else if ( ids.size() == 1 )
+        {
+            filter << column << " = " << *(ids.begin());
+        }
+        else
+        {
+            filter << column << " IN (" << one_util::join(ids, ',') << ")";
+        }
+    };
+
 protected:
 
     /**
@@ -264,6 +336,21 @@ protected:
      */
     PoolObjectSQL * get(const string& name, int uid, bool lock);
 
+    /**
+     *  Removes a dropped object from the name index and records the drop in
+     *  the change log. Must be called by the pools that do not use
+     *  PoolSQL::drop
+     *    @param objsql the object
+     */
+    void drop_cache_index(PoolObjectSQL * objsql);
+
+    /**
+     *  Records an object created or updated in the change log, it MUST be
+     *  called after writing the object to the DB
+     *    @param oid of the object
+     */
+    void record_change(int oid);
+
     /**
      *  Pointer to the database.
      */
@@ -366,6 +453,104 @@ private:
      */
     map<string,PoolObjectSQL *> name_pool;
 
+    /**
+     *  Name index of the pool objects, key (name and owner) to oid. It holds
+     *  every object in the DB once loaded, so names not found in the index do
+     *  not exist.
+     */
+    map<string,int> name_index;
+
+    /**
+     *  The name index is used for name lookups
+     */
+    bool name_index_enabled;
+
+    /**
+     *  The name index has been loaded from the DB
+     */
+    bool name_index_loaded;
+
+    /**
+     *  Protects the name index. It is not protected by the pool mutex, as
+     *  objects are removed from the index while locked
+     */
+    pthread_mutex_t index_mutex;
+
+    /**
+     *  Loads the name index from the DB, index_mutex MUST be locked
+     *    @return 0 on success
+     */
+    int load_name_index();
+
+    /**
+     *  Looks up the id of an object in the name index
+     *    @param name_key of the object
+     *    @param oid of the object, -1 if not found
+     *    @return true if the index was used
+     */
+    bool lookup_name_index(const string& name_key, int& oid);
+
+    /**
+     *  Adds an object to the name index, if loaded
+     *    @param name_key of the object
+     *    @param oid of the object
+     */
+    void insert_name_index(const string& name_key, int oid);
+
+    /**
+     *  Removes an object from the name index
+     *    @param name_key of the object
+     *    @param oid of the object, the entry is kept if it is a different one
+     */
+    void erase_name_index(const string& name_key, int oid);
+
+    /**
+     *  Max number of dropped objects in the change log, older drops are
+     *  forgotten and clients asking for them reload the pool
+     */
+    static const unsigned int CHANGE_LOG_DROPS;
+
+    /**
+     *  The change log is recording changes
+     */
+    bool change_log_enabled;
+
+    /**
+     *  Identifies a change log, it changes every time the log is reset
+     */
+    unsigned long long change_log_epoch;
+
+    /**
+     *  Current revision of the pool, incremented with every change
+     */
+    unsigned long long revision;
+
+    /**
+     *  Oldest revision the change log can compute the changes from
+     */
+    unsigned long long min_revision;
+
+    /**
+     *  Revision of the last change of each object
+     */
+    map<int, unsigned long long> changes;
+
+    /**
+     *  Dropped objects by revision
+     */
+    map<unsigned long long, int> drops;
+
+    /**
+     *  Protects the change log, objects are recorded while locked
+     */
+    pthread_mutex_t change_mutex;
+
+    /**
+     *  Records a dropped object in the change log
+     *    @param oid of the object
+     */
+    void record_drop(int oid);
+
     /**
      *  Factory method, must return an ObjectSQL pointer to an allocated pool
      *  specific object.
@@ -428,6 +613,11 @@ private:
      */
     int  search_cb(void *_oids, int num, char **values, char **names);
 
+    /**
+     *  Callback to load the name index (PoolSQL::load_name_index)
+     */
+    int  name_index_cb(void *nil, int num, char **values, char **names);
+
     /**
      *  Callback function to get output in XML format
      *    @param num the number of columns read from the DB
@@ -0,0 +1,293 @@
+/* -------------------------------------------------------------------------- */
+/* Copyright 2002-2017, OpenNebula Project, OpenNebula Systems                */
+/*                                                                            */
+/* Licensed under the Apache License, Version 2.0 (the "License"); you may    */
+/* not use this file except in compliance with the License. You may obtain    */
+/* a copy of the License at                                                   */
+/*                                                                            */
+/* http://www.apache.org/licenses/LICENSE-2.0                                 */
+/*                                                                            */
+/* Unless required by applicable law or agreed to in writing, software        */
+/* distributed under the License is distributed on an "AS IS" BASIS,          */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   */
+/* See the License for the specific language governing permissions and        */
+/* limitations under the License.                                             */
+/* -------------------------------------------------------------------------- */
+
+#ifndef QUOTA_LEDGER_H_
+#define QUOTA_LEDGER_H_
+
+#include <pthread.h>
+#include <time.h>
+
+#include <map>
+#include <set>
+
+#include "QuotasSQL.h"
+
+class PoolSQL;
+
+extern "C" void * quota_ledger_thread(void *arg);
+
+/**
+ *  The QuotaLedger keeps the quotas of the users (or groups) in memory, so
+ *  quota checks and rollbacks do not need to load and write back the whole
+ *  object. The quotas of an object are loaded from the DB the first time
+ *  they are used, after checking that the object exists.
+ *
+ *  Operations on the quotas of an object are serialized with a per object
+ *  mutex. Changes are written to the DB:
+ *    - as they happen, if the flush period is 0
+ *    - every flush period by the ledger thread, if greater than 0. Pending
+ *      changes of an object are also written before the object is read from
+ *      the pool (see flush(oid))
+ *    - If the flush period is negative the quotas are not cached, they are
+ *      loaded from the DB for every operation and written back
+ */
+class QuotaLedger
+{
+public:
+    /**
+     *  @param _pool of the objects (users or groups)
+     *  @param _db pointer to the DB
+     *  @param _flush_period seconds between writes of the modified quotas
+     */
+    QuotaLedger(PoolSQL * _pool, SqlDB * _db, time_t _flush_period);
+
+    virtual ~QuotaLedger();
+
+    /**
+     *  Starts the ledger thread, if changes are written periodically. The
+     *  quotas are written as they change if the thread can not be started
+     *    @return 0 on success
+     */
+    int start();
+
+    /**
+     *  Stops the ledger thread and writes any pending change to the DB
+     */
+    void finalize();
+
+    /**
+     *  Checks the quotas of an object and adds the usage of the template
+     *    @param oid of the user or group
+     *    @param type the quota to work with
+     *    @param tmpl template with the usage
+     *    @param default_quotas Quotas that contain the default limits
+     *    @param error_str string describing the error
+     *    @return 0 on success, -1 if quotas are exceeded, -2 if the object
+     *    does not exist
+     */
+    int check(int oid, Quotas::QuotaType type, Template * tmpl,
+            Quotas& default_quotas, string& error_str);
+
+    /**
+     *  Updates the usage of an existing quota (e.g. VM resize), see
+     *  Quotas::quota_update
+     *    @return 0 on success, -1 if quotas are exceeded, -2 if the object
+     *    does not exist
+     */
+    int update(int oid, Quotas::QuotaType type, Template * tmpl,
+            Quotas& default_quotas, string& error_str);
+
+    /**
+     *  Removes the usage of the template from the quotas of an object
+     *    @param oid of the user or group
+     *    @param type the quota to work with
+     *    @param tmpl template with the usage
+     */
+    void del(int oid, Quotas::QuotaType type, Template * tmpl);
+
+    /**
+     *  Sets the quota limits of an object, the quotas are written to the DB
+     *    @param oid of the user or group
+     *    @param tmpl template with the limits
+     *    @param error_str string describing the error
+     *    @return 0 on success, -1 if the limits are not valid, -2 if the
+     *    object does not exist
+     */
+    int set(int oid, Template * tmpl, string& error_str);
+
+    /**
+     *  Writes the pending changes of an object to the DB
+     *    @param oid of the user or group
+     *    @return true if there were pending changes
+     */
+    bool flush(int oid);
+
+    /**
+     *  Writes all the pending changes to the DB
+     */
+    void flush();
+
+    /**
+     *  Writes the pending changes of an object and removes it from the
+     *  ledger. It MUST be called before dropping the object.
+     *    @param oid of the user or group
+     */
+    void drop(int oid);
+
+    /**
+     *  Removes all the objects from the ledger, pending changes are
+     *  discarded. Quotas are loaded again from the DB when used (e.g. after
+     *  a new leader is elected)
+     */
+    void clear();
+
+protected:
+    /**
+     *  Loads the quotas of an object from the DB
+     *    @param oid of the user or group
+     *    @return the quotas, 0 if the object does not exist
+     */
+    virtual QuotasSQL * load(int oid) = 0;
+
+    /**
+     *  Pool of the objects
+     */
+    PoolSQL * pool;
+
+    /**
+     *  Pointer to the DB
+     */
+    SqlDB * db;
+
+private:
+    friend void * quota_ledger_thread(void *arg);
+
+    /**
+     *  Quotas of an object
+     */
+    struct Entry
+    {
+        Entry():quotas(0), refs(0), dirty(false), removed(false)
+        {
+            pthread_mutex_init(&mutex, 0);
+        };
+
+        ~Entry()
+        {
+            delete quotas;
+
+            pthread_mutex_destroy(&mutex);
+        };
+
+        /**
+         *  Serializes the operations on the quotas
+         */
+        pthread_mutex_t mutex;
+
+        QuotasSQL * quotas;
+
+        /**
+         *  Number of threads using the entry, protected by the ledger mutex
+         */
+        unsigned int refs;
+
+        /**
+         *  The quotas have changes not written to the DB
+         */
+        bool dirty;
+
+        /**
+         *  The entry is no longer in the ledger
+         */
+        bool removed;
+    };
+
+    /**
+     *  Seconds between writes, 0 writes every change and -1 disables the
+     *  cache
+     */
+    time_t flush_period;
+
+    /**
+     *  Quotas by object id
+     */
+    std::map<int, Entry *> entries;
+
+    /**
+     *  Objects with pending changes
+     */
+    std::set<int> pending;
+
+    /**
+     *  Gets the entry of an object, loading its quotas if needed. The entry
+     *  is returned locked and MUST be released
+     *    @param oid of the user or group
+     *    @return the entry, 0 if the object does not exist
+     */
+    Entry * acquire(int oid);
+
+    /**
+     *  Unlocks an entry, it is deleted when no longer used if removed from
+     *  the ledger
+     */
+    void release(int oid, Entry * entry);
+
+    /**
+     *  Records a change in the quotas of a locked entry, it is written to
+     *  the DB or added to the pending list
+     */
+    void changed(int oid, Entry * entry);
+
+    /**
+     *  Writes the quotas of a locked entry if there are pending changes
+     *    @return true if the quotas were written
+     */
+    bool write(int oid, Entry * entry);
+
+    /**
+     *  Loop of the ledger thread, writes the pending changes every
+     *  flush_period
+     */
+    void do_flush();
+
+    // -------------------------------------------------------------------------
+    // pthread synchronization variables
+    // -------------------------------------------------------------------------
+    pthread_t thread_id;
+
+    /**
+     *  Protects the entries map and the pending list
+     */
+    pthread_mutex_t mutex;
+
+    pthread_cond_t cond;
+
+    bool running;
+
+    bool _finalize;
+};
+
+/**
+ *  Ledger for the user quotas
+ */
+class UserQuotaLedger : public QuotaLedger
+{
+public:
+    UserQuotaLedger(PoolSQL * _pool, SqlDB * _db, time_t _flush_period):
+        QuotaLedger(_pool, _db, _flush_period){};
+
+    virtual ~UserQuotaLedger(){};
+
+protected:
+    QuotasSQL * load(int oid);
+};
+
+/**
+ *  Ledger for the group quotas
+ */
+class GroupQuotaLedger : public QuotaLedger
+{
+public:
+    GroupQuotaLedger(PoolSQL * _pool, SqlDB * _db, time_t _flush_period):
+        QuotaLedger(_pool, _db, _flush_period){};
+
+    virtual ~GroupQuotaLedger(){};
+
+protected:
+    QuotasSQL * load(int oid);
+};
+
+#endif /*QUOTA_LEDGER_H_*/
@@ -23,6 +23,8 @@
 class QuotasSQL : public Quotas, ObjectSQL
 {
 public:
+    virtual ~QuotasSQL(){};
+
     /**
      *  Reads the ObjectSQL (identified with its OID) from the database.
      *    @param oid the Group/User oid
@@ -74,8 +76,6 @@ protected:
                 ObjectSQL(),
                 oid(-1){};
 
-    virtual ~QuotasSQL(){};
-
     virtual const char * table() const = 0;
 
     virtual const char * table_names() const = 0;
@@ -24,6 +24,9 @@
 #include "AuthRequest.h"
 #include "PoolObjectSQL.h"
 #include "Quotas.h"
+#include "RequestScheduler.h"
+#include "RequestMetrics.h"
+#include "Tracer.h"
 
 using namespace std;
 
@@ -55,11 +58,17 @@ public:
     int                       resp_id;  /**< Id of the object */
     string                    resp_msg; /**< Additional response message */
 
+    int                trace_vid;   /**< VM traced by the request, -1 if none */
+    unsigned long long trace_start; /**< Start of the request trace, 0 if off */
+
     RequestAttributes()
     {
         resp_obj = PoolObjectSQL::NONE;
         resp_id  = -1;
         resp_msg = "";
+
+        trace_vid   = -1;
+        trace_start = 0;
     };
 
     RequestAttributes(const RequestAttributes& ra)
@@ -84,6 +93,9 @@ public:
         resp_obj = ra.resp_obj;
         resp_id  = ra.resp_id;
         resp_msg = ra.resp_msg;
+
+        trace_vid   = ra.trace_vid;
+        trace_start = ra.trace_start;
     };
 
     RequestAttributes(int _uid, int _gid, const RequestAttributes& ra)
@@ -110,6 +122,9 @@ public:
         resp_obj = PoolObjectSQL::NONE;
         resp_id  = -1;
         resp_msg = "";
+
+        trace_vid   = -1;
+        trace_start = 0;
     };
 };
 
@@ -131,7 +146,8 @@ public:
         ACTION         = 0x0800,
         XML_RPC_API    = 0x1000,
         INTERNAL       = 0x2000,
-        ALLOCATE       = 0x4000
+        ALLOCATE       = 0x4000,
+        BUSY           = 0x8000
     };
 
     /**
@@ -161,6 +177,15 @@ public:
         format_str = log_format;
     }
 
+    /**
+     *  Sets the scheduler used to admit the requests, 0 to execute them
+     *  without admission control
+     */
+    static void set_scheduler(RequestScheduler * rs)
+    {
+        scheduler = rs;
+    }
+
 protected:
     /* ---------------------------------------------------------------------- */
     /* Static Request Attributes: shared among request of the same method     */
@@ -175,17 +200,31 @@ protected:
 
     static string format_str;
 
+    static RequestScheduler * scheduler;
+
+    RequestMetrics::Method * metrics; /**< Latency metrics of the method */
+
+    /**
+     *  Microseconds the calling thread has spent building responses in the
+     *  current request
+     */
+    static __thread unsigned long long response_time;
+
     bool log_method_call; //Write method call and result to the log
 
     bool leader_only; //Method can be only execute by leaders or solo servers
 
+    bool admission; //Method is subject to the scheduler admission control
+
+    int trace_param; //Param with the VM id to trace the request, -1 if none
+
     static const long long xmlrpc_timeout; //Timeout (ms) for request forwarding
 
     /* ---------------------------------------------------------------------- */
     /* Class Constructors                                                     */
     /* ---------------------------------------------------------------------- */
     Request(const string& mn, const string& signature, const string& help):
-        pool(0),method_name(mn)
+        pool(0),method_name(mn),metrics(RequestMetrics::get(mn))
     {
         _signature = signature;
         _help      = help;
@@ -195,6 +234,10 @@ protected:
         log_method_call = true;
 
         leader_only     = true;
+
+        admission       = true;
+
+        trace_param     = -1;
     };
 
     virtual ~Request(){};
@@ -211,6 +254,25 @@ protected:
     virtual void execute(xmlrpc_c::paramList const& _paramList,
         xmlrpc_c::value * const _retval);
 
+    /**
+     *  Executes an admitted request and accounts the time of each stage in
+     *  the method metrics
+     *    @param _paramlist list of XML parameters
+     *    @param att the specific request attributes
+     */
+    void execute_measured(xmlrpc_c::paramList const& _paramList,
+        RequestAttributes& att);
+
+    /**
+     *  Authenticates the user and executes the request, or forwards it to
+     *  the leader. Called once the request has been admitted
+     *    @param _paramlist list of XML parameters
+     *    @param att the specific request attributes
+     *    @param auth_time microseconds spent authenticating the user
+     */
+    void execute_admitted(xmlrpc_c::paramList const& _paramList,
+        RequestAttributes& att, unsigned long long& auth_time);
+
     /**
      *  Actual Execution method for the request. Must be implemented by the
      *  XML-RPC requests
@@ -290,6 +352,23 @@ protected:
     /* ---------------------------------------------------------------------- */
     /* Authorization methods for requests                                     */
     /* ---------------------------------------------------------------------- */
+    /**
+     *  Starts the trace of the VM handled by the request. It MUST be called
+     *  once the user has been authorized on the VM, only the first call of
+     *  a request starts a trace
+     *    @param vid of the VM
+     *    @param att the specific request attributes
+     */
+    void start_trace(int vid, RequestAttributes& att)
+    {
+        if ( trace_param > 0 && att.trace_start != 0 && att.trace_vid == -1 )
+        {
+            att.trace_vid = vid;
+
+            Tracer::start(vid);
+        }
+    };
+
     /**
      *  Performs a basic authorization for this request using the uid/gid
      *  from the request. The function gets the object from the pool to get
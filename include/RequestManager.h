@@ -27,6 +27,7 @@
 #include "GroupPool.h"
 
 #include "AuthManager.h"
+#include "RequestScheduler.h"
 
 #include <xmlrpc-c/base.hpp>
 #include <xmlrpc-c/registry.hpp>
@@ -38,6 +39,8 @@ extern "C" void * rm_action_loop(void *arg);
 
 extern "C" void * rm_xml_server_loop(void *arg);
 
+extern "C" void * rm_metrics_server_loop(void *arg);
+
 class RequestManager : public ActionListener
 {
 public:
@@ -52,9 +55,14 @@ public:
             const string& _xml_log_file,
             const string& call_log_format,
             const string& _listen_address,
-            int message_size);
+            int message_size,
+            int _metrics_port,
+            RequestScheduler * _scheduler);
 
-    ~RequestManager(){};
+    ~RequestManager()
+    {
+        delete scheduler;
+    };
 
     /**
      *  This functions starts the associated listener thread (XML server), and
@@ -81,6 +89,15 @@ public:
         am.finalize();
     };
 
+    /**
+     *  Gets the scheduler that admits the XML-RPC requests
+     *    @return the scheduler, 0 if admission control is disabled
+     */
+    RequestScheduler * get_scheduler() const
+    {
+        return scheduler;
+    };
+
 
 private:
 
@@ -92,6 +109,8 @@ private:
 
     friend void * rm_action_loop(void *arg);
 
+    friend void * rm_metrics_server_loop(void *arg);
+
     /**
      *  Thread id for the RequestManager
      */
@@ -102,6 +121,11 @@ private:
      */
     pthread_t               rm_xml_server_thread;
 
+    /**
+     *  Thread id for the metrics server
+     */
+    pthread_t               rm_metrics_thread;
+
     /**
      *  Port number where the connection will be open
      */
@@ -147,6 +171,21 @@ private:
      */
     string listen_address;
 
+    /**
+     *  Local port for the Prometheus metrics endpoint, 0 if disabled
+     */
+    int metrics_port;
+
+    /**
+     *  FD for the metrics server socket
+     */
+    int metrics_fd;
+
+    /**
+     *  Admission control for the XML-RPC requests
+     */
+    RequestScheduler * scheduler;
+
     /**
      *  Action engine for the Manager
      */
@@ -167,7 +206,20 @@ private:
      */
     void register_xml_methods();
 
-    int setup_socket();
+    /**
+     *  Creates a server socket and binds it to the given address
+     *    @param address to bind to
+     *    @param sport port to bind to
+     *    @param fd of the socket, -1 on error
+     *    @return 0 on success
+     */
+    int setup_socket(const string& address, const string& sport, int& fd);
+
+    /**
+     *  Sends the metrics in the Prometheus text format to a client
+     *    @param fd of the client connection
+     */
+    void serve_metrics(int fd);
 
     // ------------------------------------------------------------------------
     // ActioListener Interface
@@ -188,6 +240,15 @@ private:
         {
             close(socket_fd);
         }
+
+        if ( metrics_fd != -1 )
+        {
+            pthread_cancel(rm_metrics_thread);
+
+            pthread_join(rm_metrics_thread,0);
+
+            close(metrics_fd);
+        }
     };
 };
 
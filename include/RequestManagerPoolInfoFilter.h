@@ -290,6 +290,31 @@ public:
 /* ------------------------------------------------------------------------- */
 /* ------------------------------------------------------------------------- */
 
+class HostPoolChanges : public RequestManagerPoolInfoFilter
+{
+public:
+    HostPoolChanges():
+        RequestManagerPoolInfoFilter("one.hostpool.changes",
+                                     "Returns the hosts changed since a "
+                                     "revision of the pool",
+                                     "A:ss")
+    {
+        Nebula& nd  = Nebula::instance();
+        pool        = nd.get_hpool();
+        auth_object = PoolObjectSQL::HOST;
+    };
+
+    ~HostPoolChanges(){};
+
+    /* -------------------------------------------------------------------- */
+
+    void request_execute(
+            xmlrpc_c::paramList const& paramList, RequestAttributes& att);
+};
+
+/* ------------------------------------------------------------------------- */
+/* ------------------------------------------------------------------------- */
+
 class HostPoolMonitoring : public RequestManagerPoolInfoFilter
 {
 public:
@@ -79,6 +79,27 @@ public:
 /* ------------------------------------------------------------------------- */
 /* ------------------------------------------------------------------------- */
 
+class SystemMetrics : public RequestManagerSystem
+{
+public:
+    SystemMetrics():
+        RequestManagerSystem("one.system.metrics",
+                          "Returns the XML-RPC server metrics",
+                          "A:s")
+    {
+        log_method_call = false;
+        leader_only     = false;
+    };
+
+    ~SystemMetrics(){};
+
+    void request_execute(xmlrpc_c::paramList const& _paramList,
+                         RequestAttributes& att);
+};
+
+/* ------------------------------------------------------------------------- */
+/* ------------------------------------------------------------------------- */
+
 class SystemSql: public RequestManagerSystem
 {
 public:
@@ -39,6 +39,8 @@ protected:
 
         auth_object = PoolObjectSQL::VM;
         auth_op     = AuthRequest::MANAGE;
+
+        trace_param = 1;
     };
 
     ~RequestManagerVirtualMachine(){};
@@ -117,7 +119,10 @@ public:
     VirtualMachineAction():
         RequestManagerVirtualMachine("one.vm.action",
                                      "Performs an action on a virtual machine",
-                                     "A:ssi"){};
+                                     "A:ssi")
+    {
+        trace_param = 2;
+    };
     ~VirtualMachineAction(){};
 
     void request_execute(xmlrpc_c::paramList const& _paramList,
@@ -193,7 +198,8 @@ public:
         RequestManagerVirtualMachine("one.vm.monitoring",
                 "Returns the virtual machine monitoring records",
                 "A:si"){
-        auth_op = AuthRequest::USE;
+        auth_op     = AuthRequest::USE;
+        trace_param = -1;
     };
 
     ~VirtualMachineMonitoring(){};
@@ -205,6 +211,27 @@ public:
 /* ------------------------------------------------------------------------- */
 /* ------------------------------------------------------------------------- */
 
+class VirtualMachineTrace : public RequestManagerVirtualMachine
+{
+public:
+
+    VirtualMachineTrace():
+        RequestManagerVirtualMachine("one.vm.trace",
+                "Returns the operation traces of a virtual machine",
+                "A:si"){
+        auth_op     = AuthRequest::USE;
+        trace_param = -1;
+    };
+
+    ~VirtualMachineTrace(){};
+
+    void request_execute(
+            xmlrpc_c::paramList const& paramList, RequestAttributes& att);
+};
+
+/* ------------------------------------------------------------------------- */
+/* ------------------------------------------------------------------------- */
+
 class VirtualMachineAttach : public RequestManagerVirtualMachine
 {
 public:
@@ -418,6 +445,7 @@ public:
         pool        = nd.get_vmpool();
 
         auth_object = PoolObjectSQL::VM;
+        trace_param = -1;
     };
 
     ~VirtualMachinePoolCalculateShowback(){};
@@ -39,6 +39,10 @@ protected:
 
         auth_object = PoolObjectSQL::ZONE;
         auth_op     = AuthRequest::ADMIN;
+
+        // Raft and federation calls between servers are never throttled, a
+        // rejected heartbeat or vote would trigger a new election
+        admission   = false;
     };
 
     ~RequestManagerZone(){};
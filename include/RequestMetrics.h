@@ -0,0 +1,109 @@
+/* -------------------------------------------------------------------------- */
+/* Copyright 2002-2017, OpenNebula Project, OpenNebula Systems                */
+/*                                                                            */
+/* Licensed under the Apache License, Version 2.0 (the "License"); you may    */
+/* not use this file except in compliance with the License. You may obtain    */
+/* a copy of the License at                                                   */
+/*                                                                            */
+/* http://www.apache.org/licenses/LICENSE-2.0                                 */
+/*                                                                            */
+/* Unless required by applicable law or agreed to in writing, software        */
+/* distributed under the License is distributed on an "AS IS" BASIS,          */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   */
+/* See the License for the specific language governing permissions and        */
+/* limitations under the License.                                             */
+/* -------------------------------------------------------------------------- */
+
+#ifndef REQUEST_METRICS_H_
+#define REQUEST_METRICS_H_
+
+#include <pthread.h>
+
+#include <map>
+#include <sstream>
+#include <string>
+
+#include "LatencyHistogram.h"
+
+using namespace std;
+
+/**
+ *  Latency metrics of the XML-RPC methods. Each method has a histogram for
+ *  each stage of the request:
+ *    - AUTH, authentication of the session
+ *    - LOCK_WAIT, time blocked waiting for object locks
+ *    - EXECUTION, the request itself (excluding lock waits and response)
+ *    - RESPONSE, building the XML-RPC response value
+ *    - TOTAL, the whole request including the wait for an execution slot
+ *  Methods are registered when the Request objects are created, the
+ *  histograms are then updated without locks.
+ */
+class RequestMetrics
+{
+public:
+    enum Stage
+    {
+        AUTH      = 0,
+        LOCK_WAIT = 1,
+        EXECUTION = 2,
+        RESPONSE  = 3,
+        TOTAL     = 4
+    };
+
+    static const unsigned int STAGES = 5;
+
+    /**
+     *  Metrics of a method
+     */
+    struct Method
+    {
+        LatencyHistogram stages[STAGES];
+
+        unsigned long long failures;
+
+        Method():failures(0){};
+
+        void add(Stage stage, unsigned long long usec)
+        {
+            stages[stage].add(usec);
+        };
+
+        void add_failure()
+        {
+            __atomic_fetch_add(&failures, 1, __ATOMIC_RELAXED);
+        };
+    };
+
+    /**
+     *  Gets the metrics of a method, registering it if needed
+     *    @param method name of the XML-RPC method
+     *    @return the metrics, valid for the life of the process
+     */
+    static Method * get(const string& method);
+
+    /**
+     *  Dumps the metrics of the methods that have been called in XML format
+     *    @param oss the output stream
+     */
+    static void to_xml(ostringstream& oss);
+
+    /**
+     *  Dumps the metrics of the methods that have been called in the
+     *  Prometheus text format
+     *    @param oss the output stream
+     */
+    static void to_prometheus(ostringstream& oss);
+
+private:
+    static map<string, Method *> methods;
+
+    static pthread_mutex_t mutex;
+
+    /**
+     *  @return the name of the stage, as used in the XML and Prometheus
+     *  representations
+     */
+    static const char * stage_name(unsigned int stage);
+};
+
+#endif /*REQUEST_METRICS_H_*/
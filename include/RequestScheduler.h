@@ -0,0 +1,155 @@
+/* -------------------------------------------------------------------------- */
+/* Copyright 2002-2017, OpenNebula Project, OpenNebula Systems                */
+/*                                                                            */
+/* Licensed under the Apache License, Version 2.0 (the "License"); you may    */
+/* not use this file except in compliance with the License. You may obtain    */
+/* a copy of the License at                                                   */
+/*                                                                            */
+/* http://www.apache.org/licenses/LICENSE-2.0                                 */
+/*                                                                            */
+/* Unless required by applicable law or agreed to in writing, software        */
+/* distributed under the License is distributed on an "AS IS" BASIS,          */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   */
+/* See the License for the specific language governing permissions and        */
+/* limitations under the License.                                             */
+/* -------------------------------------------------------------------------- */
+
+#ifndef REQUEST_SCHEDULER_H_
+#define REQUEST_SCHEDULER_H_
+
+#include <pthread.h>
+#include <time.h>
+
+#include <map>
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+/**
+ *  The RequestScheduler controls the execution of the XML-RPC requests. The
+ *  server threads ask for a slot before executing a request:
+ *    - At most WORKERS requests are executed at the same time, and at most
+ *      LIMIT requests of a given method.
+ *    - Requests that cannot be executed wait in a bounded queue, if the
+ *      queue is full or the request waits for more than QUEUE_TIMEOUT
+ *      seconds it is rejected, so the client gets a fast "busy" error
+ *      instead of a timeout.
+ *  The scheduler also accounts the calls, rejections and queue time of each
+ *  method.
+ */
+class RequestScheduler
+{
+public:
+    /**
+     *  @param _workers max. number of concurrent requests, 0 for no limit
+     *  @param _queue_size max. number of requests waiting for a slot
+     *  @param _queue_timeout max. seconds a request waits for a slot
+     *  @param _limits max. number of concurrent requests of each method
+     */
+    RequestScheduler(unsigned int _workers, unsigned int _queue_size,
+            time_t _queue_timeout, const map<string, unsigned int>& _limits);
+
+    ~RequestScheduler();
+
+    /**
+     *  Waits for a slot to execute a request. If the request is admitted
+     *  release() MUST be called once it has been executed.
+     *    @param method name of the XML-RPC method
+     *    @return 0 if the request can be executed, -1 if it was rejected
+     */
+    int admit(const string& method);
+
+    /**
+     *  Frees the slot of a request
+     *    @param method name of the XML-RPC method
+     */
+    void release(const string& method);
+
+    /**
+     *  Dumps the scheduler counters in XML format
+     *    @param oss the output stream
+     */
+    void to_xml(ostringstream& oss);
+
+    /**
+     *  Dumps the scheduler counters in the Prometheus text format
+     *    @param oss the output stream
+     */
+    void to_prometheus(ostringstream& oss);
+
+    /**
+     *  Parses a list of method limits in the form "method:limit,..."
+     *    @param str the list
+     *    @param limits parsed
+     *    @param error_str describing the error
+     *    @return 0 on success
+     */
+    static int parse_limits(const string& str, map<string, unsigned int>& limits,
+            string& error_str);
+
+private:
+    /**
+     *  Limit and counters of a method
+     */
+    struct Method
+    {
+        unsigned int limit;
+        unsigned int running;
+
+        unsigned long long calls;
+        unsigned long long rejected;
+
+        double queue_time;
+        double max_queue_time;
+    };
+
+    unsigned int workers;
+
+    unsigned int queue_size;
+
+    time_t queue_timeout;
+
+    map<string, unsigned int> limits;
+
+    /**
+     *  Requests being executed and waiting for a slot
+     */
+    unsigned int running;
+
+    unsigned int queued;
+
+    map<string, Method> methods;
+
+    pthread_mutex_t mutex;
+
+    pthread_cond_t  cond;
+
+    /**
+     *  Gets the counters of a method, creates them if needed. The mutex
+     *  SHOULD be locked.
+     */
+    Method& get_method(const string& method);
+
+    /**
+     *  @return true if a request of the method can be executed now
+     */
+    bool can_run(const Method& m) const
+    {
+        return (workers == 0 || running < workers) &&
+               (m.limit == 0 || m.running < m.limit);
+    };
+
+    /**
+     *  Accounts a new request in execution
+     */
+    void start(Method& m)
+    {
+        running++;
+
+        m.running++;
+        m.calls++;
+    };
+};
+
+#endif /*REQUEST_SCHEDULER_H_*/
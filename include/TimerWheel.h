@@ -0,0 +1,172 @@
+/* -------------------------------------------------------------------------- */
+/* Copyright 2002-2017, OpenNebula Project, OpenNebula Systems                */
+/*                                                                            */
+/* Licensed under the Apache License, Version 2.0 (the "License"); you may    */
+/* not use this file except in compliance with the License. You may obtain    */
+/* a copy of the License at                                                   */
+/*                                                                            */
+/* http://www.apache.org/licenses/LICENSE-2.0                                 */
+/*                                                                            */
+/* Unless required by applicable law or agreed to in writing, software        */
+/* distributed under the License is distributed on an "AS IS" BASIS,          */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   */
+/* See the License for the specific language governing permissions and        */
+/* limitations under the License.                                             */
+/* -------------------------------------------------------------------------- */
+
+#ifndef TIMER_WHEEL_H_
+#define TIMER_WHEEL_H_
+
+#include <map>
+#include <vector>
+#include <pthread.h>
+#include <time.h>
+
+/**
+ *  Hierarchical timer wheel. Keeps a deadline for a set of objects (e.g. the
+ *  next monitor time of each host) and returns the expired ones, so periodic
+ *  work is proportional to the number of expired timers instead of the number
+ *  of objects.
+ *
+ *  Deadlines are expressed in ticks (e.g. seconds). Each level of the wheel
+ *  has SLOTS slots, a slot of level L spans SLOTS^L ticks. Timers are moved
+ *  to lower levels as the wheel advances, so schedule and cancel are O(1)
+ *  and each timer is moved at most LEVELS times.
+ *
+ *  The wheel starts on the first call to expire(), timers scheduled before
+ *  are placed relative to that time. All the methods are thread-safe.
+ */
+class TimerWheel
+{
+public:
+    TimerWheel();
+
+    ~TimerWheel();
+
+    /**
+     *  Sets the deadline of a timer, replacing the previous one (if any)
+     *    @param id of the timer (e.g. the host id)
+     *    @param deadline of the timer
+     */
+    void schedule(int id, time_t deadline);
+
+    /**
+     *  Removes a timer
+     *    @param id of the timer
+     */
+    void cancel(int id);
+
+    /**
+     *  Gets the timers whose deadline is not later than now. Timers are
+     *  returned in the order they expired.
+     *    @param now current time
+     *    @param limit max. number of timers to return
+     *    @param ids of the expired timers
+     *    @param keep if true the returned timers are kept in the expired list
+     *    (after the other expired timers) until they are scheduled again or
+     *    cancelled. Otherwise they are removed.
+     */
+    void expire(time_t now, unsigned int limit, std::vector<int>& ids,
+            bool keep);
+
+    /**
+     *  Removes all the timers, the wheel is started again by the next call
+     *  to expire()
+     */
+    void clear();
+
+    /**
+     *  @return the number of timers
+     */
+    size_t size();
+
+private:
+    /**
+     *  Each level has 2^SLOT_BITS slots
+     */
+    static const unsigned int LEVELS    = 4;
+    static const unsigned int SLOT_BITS = 6;
+    static const unsigned int SLOTS     = 1 << SLOT_BITS;
+    static const unsigned int SLOT_MASK = SLOTS - 1;
+
+    static const int EXPIRED = -1;
+    static const int WAITING = -2;
+
+    /**
+     *  A timer, linked in the list of a slot. The head of each list is a
+     *  sentinel timer
+     */
+    struct Timer
+    {
+        int     id;
+        time_t  deadline;
+
+        int     level; /**< slot level, EXPIRED or WAITING */
+
+        Timer * prev;
+        Timer * next;
+    };
+
+    /**
+     *  Timers by id
+     */
+    std::map<int, Timer> timers;
+
+    /**
+     *  Slots of each level, and list of expired timers
+     */
+    Timer slots[LEVELS][SLOTS];
+
+    Timer expired;
+
+    /**
+     *  Timers not expired (in total and in each level), and timers scheduled
+     *  before the wheel started
+     */
+    size_t pending;
+
+    size_t counts[LEVELS];
+
+    Timer waiting;
+
+    /**
+     *  Next tick to be processed
+     */
+    time_t current;
+
+    bool   started;
+
+    pthread_mutex_t mutex;
+
+    TimerWheel(const TimerWheel&);
+
+    TimerWheel& operator=(const TimerWheel&);
+
+    static void init_list(Timer * head);
+
+    static void link(Timer * head, Timer * timer);
+
+    static void unlink(Timer * timer);
+
+    /**
+     *  Unlinks a timer and updates the counters of the wheel
+     */
+    void remove(Timer * timer);
+
+    /**
+     *  Places a timer in the expired list or in the slot for its deadline
+     */
+    void add(Timer * timer);
+
+    /**
+     *  Moves the timers of a slot to the lower levels
+     */
+    void cascade(unsigned int level);
+
+    /**
+     *  Processes the current tick and advances the wheel
+     */
+    void tick();
+};
+
+#endif /*TIMER_WHEEL_H_*/
@@ -0,0 +1,150 @@
+/* -------------------------------------------------------------------------- */
+/* Copyright 2002-2017, OpenNebula Project, OpenNebula Systems                */
+/*                                                                            */
+/* Licensed under the Apache License, Version 2.0 (the "License"); you may    */
+/* not use this file except in compliance with the License. You may obtain    */
+/* a copy of the License at                                                   */
+/*                                                                            */
+/* http://www.apache.org/licenses/LICENSE-2.0                                 */
+/*                                                                            */
+/* Unless required by applicable law or agreed to in writing, software        */
+/* distributed under the License is distributed on an "AS IS" BASIS,          */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   */
+/* See the License for the specific language governing permissions and        */
+/* limitations under the License.                                             */
+/* -------------------------------------------------------------------------- */
+
+#ifndef TRACER_H_
+#define TRACER_H_
+
+#include <sstream>
+#include <string>
+
+/**
+ *  Traces the operations on the VMs as they go through the managers (RM, DM,
+ *  LCM, TM, VMM) and the drivers. Each component records timestamped spans
+ *  for the VM being processed. A new trace is started for a VM when an
+ *  operation is requested (e.g. one.vm.deploy), the spans recorded after
+ *  that carry its trace id. The VM id is the trace context, as it is
+ *  already propagated through every action and driver message.
+ *
+ *  Spans are stored in a fixed-size ring, the oldest spans are overwritten.
+ *  Spans are recorded without locks: a writer reserves a position with an
+ *  atomic increment and publishes the span with a sequence number, readers
+ *  discard the spans being written.
+ *
+ *  Tracing is disabled until init() is called with a non-zero size.
+ */
+class Tracer
+{
+public:
+    /**
+     *  Allocates the span buffer. It MUST be called before any other thread
+     *  uses the tracer
+     *    @param size number of spans, rounded up to a power of 2. 0 disables
+     *    tracing
+     */
+    static void init(unsigned int size);
+
+    /**
+     *  @return true if tracing is enabled
+     */
+    static bool enabled()
+    {
+        return spans != 0;
+    };
+
+    /**
+     *  @return current time in microseconds since the epoch
+     */
+    static unsigned long long now();
+
+    /**
+     *  Starts a new trace for a VM
+     *    @param vm_id of the VM
+     *    @return the trace id
+     */
+    static unsigned int start(int vm_id);
+
+    /**
+     *  @return the current trace of a VM, 0 if unknown
+     */
+    static unsigned int current(int vm_id);
+
+    /**
+     *  Records a span for a VM
+     *    @param vm_id of the VM
+     *    @param component recording the span (e.g. "LCM"), it MUST be a
+     *    string literal
+     *    @param name of the operation, truncated to NAME_SIZE characters
+     *    @param start time of the operation (see now())
+     *    @param end time of the operation (see now())
+     */
+    static void span(int vm_id, const char * component, const std::string& name,
+            unsigned long long start, unsigned long long end);
+
+    /**
+     *  Records an instant event for a VM
+     */
+    static void event(int vm_id, const char * component,
+            const std::string& name)
+    {
+        unsigned long long ts = now();
+
+        span(vm_id, component, name, ts, ts);
+    };
+
+    /**
+     *  Dumps the spans of a VM in XML format, ordered by start time
+     *    @param vm_id of the VM
+     *    @param oss the output stream
+     */
+    static void to_xml(int vm_id, std::ostringstream& oss);
+
+    /**
+     *  Max length of the span names
+     */
+    static const unsigned int NAME_SIZE = 47;
+
+private:
+    struct Span
+    {
+        /**
+         *  Position + 1 of the span in the ring, 0 while it is being written
+         */
+        unsigned long long seq;
+
+        unsigned int       trace_id;
+
+        int                vm_id;
+
+        const char *       component;
+
+        char               name[NAME_SIZE + 1];
+
+        unsigned long long start;
+
+        unsigned long long end;
+    };
+
+    static Span * spans;
+
+    static unsigned long long mask;
+
+    /**
+     *  Next position of the ring
+     */
+    static unsigned long long head;
+
+    /**
+     *  Current trace of the VMs, direct mapped by VM id. Each slot stores the
+     *  VM id (high 32 bits) and the trace id (low 32 bits)
+     */
+    static const unsigned int TRACE_SLOTS = 16384;
+
+    static unsigned long long traces[TRACE_SLOTS];
+
+    static unsigned int next_trace;
+};
+
+#endif /*TRACER_H_*/
@@ -79,6 +79,21 @@ public:
         return new TMAction(*this);
     }
 
+    ActionRequest * clone(void * buffer, size_t size) const
+    {
+        return clone_in(*this, buffer, size);
+    }
+
+    int object_id() const
+    {
+        return _vm_id;
+    }
+
+    /**
+     *  @return the name of the action in the operation traces
+     */
+    const char * trace_name() const;
+
 private:
     Actions _action;
 
@@ -92,12 +107,16 @@ public:
     TransferManager(
         VirtualMachinePool * _vmpool,
         HostPool *           _hpool,
-        vector<const VectorAttribute*>& _mads):
+        vector<const VectorAttribute*>& _mads,
+        unsigned int         workers):
             MadManager(_mads),
             vmpool(_vmpool),
-            hpool(_hpool)
+            hpool(_hpool),
+            am(workers)
     {
         am.addListener(this);
+
+        am.trace("TM");
     };
 
     ~TransferManager(){};
@@ -233,16 +233,6 @@ public:
      */
     UserQuotas quota;
 
-    /**
-     *  Writes/updates the User quotas fields in the database.
-     *    @param db pointer to the db
-     *    @return 0 on success
-     */
-    int update_quotas(SqlDB *db)
-    {
-        return quota.update(oid, db);
-    };
-
     // *************************************************************************
     // Login tokens
     // *************************************************************************
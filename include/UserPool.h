@@ -20,6 +20,7 @@
 #include "PoolSQL.h"
 #include "User.h"
 #include "GroupPool.h"
+#include "QuotaLedger.h"
 
 #include <time.h>
 #include <sstream>
@@ -43,9 +44,13 @@ public:
              time_t  __session_expiration_time,
              vector<const VectorAttribute *> hook_mads,
              const string&             remotes_location,
-             bool                      is_federation_slave);
+             bool                      is_federation_slave,
+             time_t                    quota_flush_period);
 
-    ~UserPool(){};
+    ~UserPool()
+    {
+        delete quota_ledger;
+    };
 
     /**
      *  Function to allocate a new User object
@@ -80,6 +85,8 @@ public:
      */
     User * get(int oid, bool lock)
     {
+        quota_ledger->flush(oid);
+
         return static_cast<User *>(PoolSQL::get(oid,lock));
     };
 
@@ -93,7 +100,14 @@ public:
     User * get(string name, bool lock)
     {
         // The owner is set to -1, because it is not used in the key() method
-        return static_cast<User *>(PoolSQL::get(name,-1,lock));
+        User * user = static_cast<User *>(PoolSQL::get(name,-1,lock));
+
+        if ( user != 0 && quota_ledger->flush(user->get_oid()) )
+        {
+            user->quota.select(user->get_oid(), db);
+        }
+
+        return user;
     };
 
     /**
@@ -117,11 +131,31 @@ public:
     int update(PoolObjectSQL * objsql);
 
     /**
-     * Update a particular User's Quotas
-     *    @param user pointer to User
-     *    @return 0 on success
+     *  Returns the ledger of the user quotas. Quota usage and limits MUST be
+     *  changed through the ledger
+     *    @return the quota ledger
+     */
+    QuotaLedger * get_quota_ledger()
+    {
+        return quota_ledger;
+    };
+
+    /**
+     *  Drops the user quotas cached in memory, they are loaded again from
+     *  the DB when needed
+     */
+    void clean_quotas()
+    {
+        quota_ledger->clear();
+    };
+
+    /**
+     *  Writes the pending changes of the user quotas and stops the ledger
      */
-    int update_quotas(User * user);
+    void finalize_quotas()
+    {
+        quota_ledger->finalize();
+    };
 
     /**
      *  Bootstraps the database table(s) associated to the User pool
@@ -162,7 +196,7 @@ public:
 
     /**
      *  Dumps the User pool in XML format. A filter can be also added to the
-     *  query
+     *  query. The quota changes pending in the ledger are written first
      *  @param oss the output stream to dump the pool contents
      *  @param where filter for the objects, defaults to all
      *  @param limit parameters used for pagination
@@ -212,6 +246,24 @@ private:
      **/
     static time_t _session_expiration_time;
 
+    /**
+     *  Authentication sessions validated by the auth drivers
+     */
+    SessionCache session_cache;
+
+    /**
+     *  Quotas of the users
+     */
+    QuotaLedger * quota_ledger;
+
+    /**
+     *  Builds the fingerprint of the user auth attributes for the session
+     *  cache. The user MUST be locked
+     *    @param user the user
+     *    @return the fingerprint
+     */
+    static string session_fingerprint(User * user);
+
     /**
      *  Function to authenticate internal (known) users
      */
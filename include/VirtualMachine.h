@@ -1824,6 +1824,14 @@ private:
      */
     int update_monitoring(SqlDB * db);
 
+    /**
+     *  Function that renders the monitoring record of the VM in XML format
+     *  (last poll, monitoring data and capacity)
+     *  @param xml the resulting XML string
+     *  @return a reference to the generated string
+     */
+    string& to_xml_monitoring(string& xml) const;
+
     /**
      *  Function that renders the VM in XML format optinally including
      *  extended information (all history records)
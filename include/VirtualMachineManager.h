@@ -83,6 +83,37 @@ public:
         return new VMMAction(*this);
     }
 
+    ActionRequest * clone(void * buffer, size_t size) const
+    {
+        return clone_in(*this, buffer, size);
+    }
+
+    int object_id() const
+    {
+        return _vm_id;
+    }
+
+    /**
+     *  @return the name of the action in the operation traces
+     */
+    const char * trace_name() const;
+
+    /**
+     *  VM polls are idempotent, pending duplicates are coalesced
+     */
+    int coalesce_key() const
+    {
+        return _action == POLL ? _action : -1;
+    }
+
+    /**
+     *  VM polls are background work, processed after the other actions
+     */
+    Priority priority() const
+    {
+        return _action == POLL ? LOW : HIGH;
+    }
+
 private:
     Actions _action;
 
@@ -98,7 +129,8 @@ public:
         time_t                    _poll_period,
         bool                      _do_vm_poll,
         int                       _vm_limit,
-        vector<const VectorAttribute*>& _mads);
+        vector<const VectorAttribute*>& _mads,
+        unsigned int              workers);
 
     ~VirtualMachineManager(){};
 
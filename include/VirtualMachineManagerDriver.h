@@ -20,11 +20,13 @@
 #include <map>
 #include <string>
 #include <sstream>
+#include <string.h>
 
 #include "Mad.h"
 #include "ActionSet.h"
 #include "VirtualMachinePool.h"
 #include "History.h"
+#include "Tracer.h"
 
 using namespace std;
 
@@ -436,6 +438,11 @@ private:
 
         os << aname << " " << oid << " " << msg << endl;
 
+        if ( strcmp(aname, "POLL") != 0 )
+        {
+            Tracer::event(oid, "VMM_DRIVER", string(aname) + " sent");
+        }
+
         write(os);
     }
 };
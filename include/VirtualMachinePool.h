@@ -19,6 +19,9 @@
 
 #include "PoolSQL.h"
 #include "VirtualMachine.h"
+#include "MonitorWriter.h"
+#include "MonitorStore.h"
+#include "TimerWheel.h"
 
 #include <time.h>
 
@@ -37,12 +40,18 @@ public:
                        const string&                remotes_location,
                        vector<const SingleAttribute *>& restricted_attrs,
                        time_t                       expire_time,
+                       time_t                       flush_period,
                        bool                         on_hold,
                        float                        default_cpu_cost,
                        float                        default_mem_cost,
                        float                        default_disk_cost);
 
-    ~VirtualMachinePool(){};
+    ~VirtualMachinePool()
+    {
+        delete monitor_writer;
+
+        delete monitor_store;
+    };
 
     /**
      *  Function to allocate a new VM object
@@ -124,7 +133,42 @@ public:
 
         vm->set_prev_state();
 
-        return vm->update(db);
+        int rc = vm->update(db);
+
+        if ( rc == 0 )
+        {
+            schedule_poll(vm);
+        }
+
+        return rc;
+    };
+
+    /**
+     *  Drops the VM from the DB, the poll schedule and the monitoring data
+     *    @param objsql a pointer to the VM
+     *    @param error_msg Error reason, if any
+     *    @return 0 on success
+     */
+    int drop(PoolObjectSQL * objsql, string& error_msg)
+    {
+        if ( monitor_writer != 0 )
+        {
+            monitor_writer->drop(objsql->get_oid());
+        }
+
+        int rc = PoolSQL::drop(objsql, error_msg);
+
+        if ( rc == 0 )
+        {
+            poll_wheel.cancel(objsql->get_oid());
+
+            if ( monitor_store != 0 )
+            {
+                monitor_store->drop(objsql->get_oid());
+            }
+        }
+
+        return rc;
     };
 
     /**
@@ -149,6 +193,18 @@ public:
         int             vm_limit,
         time_t          last_poll);
 
+    /**
+     *  Removes the poll schedule, it is loaded again from the DB by the next
+     *  call to get_running (e.g. when the DB has been modified by the leader
+     *  of the zone)
+     */
+    void clean_cache()
+    {
+        poll_wheel.clear();
+
+        poll_wheel_loaded = false;
+    };
+
     /**
      *  Function to get the IDs of pending VMs
      *   @param oids a vector that contains the IDs
@@ -201,15 +257,31 @@ public:
      * @param vm pointer to the virtual machine object
      * @return 0 on success
      */
-    int update_monitoring(
-        VirtualMachine * vm)
+    int update_monitoring(VirtualMachine * vm);
+
+    /**
+     *  Stores the VM monitoring metrics in a time series store instead of
+     *  the vm_monitoring table
+     *    @param file path of the store
+     *    @param samples number of samples kept for each VM
+     *    @param rollups <interval, samples> of the rollup series
+     *    @param error_str describing the error
+     *    @return 0 on success
+     */
+    int init_monitor_store(const string& file, unsigned int samples,
+            const vector<pair<unsigned int, unsigned int> >& rollups,
+            string& error_str);
+
+    /**
+     *  Stops the monitoring writer (if any), pending monitoring records are
+     *  written to the DB
+     */
+    void finalize_monitoring()
     {
-        if ( _monitor_expiration <= 0 )
+        if ( monitor_writer != 0 )
         {
-            return 0;
+            monitor_writer->finalize();
         }
-
-        return vm->update_monitoring(db);
     };
 
     /**
@@ -299,28 +371,33 @@ public:
      *
      *  @param oss the output stream to dump the pool contents
      *  @param where filter for the objects, defaults to all
+     *  @param resolution in seconds of the samples, 0 for the raw samples.
+     *  Only used by the time series store, see MonitorStore::range
      *
      *  @return 0 on success
      */
     int dump_monitoring(ostringstream& oss,
-                        const string&  where);
+                        const string&  where,
+                        unsigned int   resolution = 0);
 
     /**
      *  Dumps the VM monitoring information  for a single VM
      *
      *  @param oss the output stream to dump the pool contents
      *  @param vmid id of the target VM
+     *  @param resolution in seconds of the samples, 0 for the raw samples
      *
      *  @return 0 on success
      */
     int dump_monitoring(ostringstream& oss,
-                        int            vmid)
+                        int            vmid,
+                        unsigned int   resolution = 0)
     {
         ostringstream filter;
 
         filter << "oid = " << vmid;
 
-        return dump_monitoring(oss, filter.str());
+        return dump_monitoring(oss, filter.str(), resolution);
     }
 
     /**
@@ -394,6 +471,22 @@ private:
      */
     time_t _monitor_expiration;
 
+    /**
+     * Writer for the monitoring records, 0 if records are written directly
+     */
+    MonitorWriter * monitor_writer;
+
+    /**
+     * Time series store for the monitoring metrics, 0 if the vm_monitoring
+     * table is used
+     */
+    MonitorStore * monitor_store;
+
+    /**
+     * VM metrics kept in the monitoring store
+     */
+    static const char * monitor_metrics[];
+
     /**
      * True or false whether to submit new VM on HOLD or not
      */
@@ -438,6 +531,45 @@ private:
      * @param attach true for an attach action, false for detach
      */
     void delete_hotplug_nic(int vid, bool attach);
+
+    // -------------------------------------------------------------------------
+    // Poll schedule, the deadline of each running VM is its last_poll time so
+    // VMs are selected for polling without querying the DB
+    // -------------------------------------------------------------------------
+    TimerWheel poll_wheel;
+
+    bool poll_wheel_loaded;
+
+    /**
+     *  Adds the VM to the poll schedule if it is running, removes it otherwise
+     *    @param vm the virtual machine
+     */
+    void schedule_poll(VirtualMachine * vm)
+    {
+        VirtualMachine::LcmState lstate = vm->get_lcm_state();
+
+        if ( vm->get_state() == VirtualMachine::ACTIVE &&
+             (lstate == VirtualMachine::RUNNING ||
+              lstate == VirtualMachine::UNKNOWN) )
+        {
+            poll_wheel.schedule(vm->get_oid(), vm->get_last_poll());
+        }
+        else
+        {
+            poll_wheel.cancel(vm->get_oid());
+        }
+    };
+
+    /**
+     *  Callback function to load the poll schedule (oid, last_poll)
+     */
+    int load_wheel_cb(void * _null, int num, char **values, char **names);
+
+    /**
+     *  Loads the poll schedule from the DB
+     *    @return 0 on success
+     */
+    int load_poll_wheel();
 };
 
 #endif /*VIRTUAL_MACHINE_POOL_H_*/
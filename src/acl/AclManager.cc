@@ -71,9 +71,11 @@ AclManager::AclManager(
     SqlDB * _db,
     int     _zone_id,
     bool    _is_federation_slave,
-    time_t  _timer_period)
-        :zone_id(_zone_id), db(_db), is_federation_slave(_is_federation_slave),
-        timer_period(_timer_period)
+    time_t  _timer_period,
+    bool    _index_enabled)
+        :acl_index(_zone_id), index_enabled(_index_enabled),
+        zone_id(_zone_id), db(_db),
+        is_federation_slave(_is_federation_slave), timer_period(_timer_period)
 {
     int lastOID;
 
@@ -338,55 +340,47 @@ const bool AclManager::authorize(
     tmp_rules.insert( make_pair(other_rule.user, &other_rule) );
 
     // -------------------------------------------------------------------------
-    // Look for rules that apply to everyone
+    // Look for rules that apply to everyone, to the individual user id and to
+    // each one of the user's groups
     // -------------------------------------------------------------------------
 
-    user_req = AclRule::ALL_ID;
-    auth     = match_rules_wrapper(user_req,
-                                   resource_oid_req,
-                                   resource_gid_req,
-                                   resource_cid_req,
-                                   resource_all_req,
-                                   rights_req,
-                                   resource_oid_mask,
-                                   resource_gid_mask,
-                                   resource_cid_mask,
-                                   tmp_rules);
-    if ( auth == true )
-    {
-        return true;
-    }
+    vector<long long>           user_reqs;
+    vector<long long>::iterator reqs_it;
 
-    // -------------------------------------------------------------------------
-    // Look for rules that apply to the individual user id
-    // -------------------------------------------------------------------------
+    set<int>::iterator  g_it;
 
-    user_req = AclRule::INDIVIDUAL_ID | uid;
-    auth     = match_rules_wrapper(user_req,
-                                   resource_oid_req,
-                                   resource_gid_req,
-                                   resource_cid_req,
-                                   resource_all_req,
-                                   rights_req,
-                                   resource_oid_mask,
-                                   resource_gid_mask,
-                                   resource_cid_mask,
-                                   tmp_rules);
-    if ( auth == true )
+    user_reqs.push_back(AclRule::ALL_ID);
+
+    user_reqs.push_back(AclRule::INDIVIDUAL_ID | uid);
+
+    for (g_it = user_groups.begin(); g_it != user_groups.end(); g_it++)
     {
-        return true;
+        user_reqs.push_back(AclRule::GROUP_ID | *g_it);
     }
 
-    // ----------------------------------------------------------
-    // Look for rules that apply to each one of the user's groups
-    // ----------------------------------------------------------
-
-    set<int>::iterator  g_it;
+    bool use_index = index_enabled &&
+                     AclRuleIndex::indexed(obj_perms.obj_type, rights_req);
 
-    for (g_it = user_groups.begin(); g_it != user_groups.end(); g_it++)
+    for (reqs_it = user_reqs.begin(); reqs_it != user_reqs.end(); reqs_it++)
     {
-        user_req = AclRule::GROUP_ID | *g_it;
-        auth     = match_rules_wrapper(user_req,
+        user_req = *reqs_it;
+
+        if ( use_index )
+        {
+            auth = match_rules(user_req,
+                               resource_oid_req,
+                               resource_gid_req,
+                               resource_cid_req,
+                               resource_all_req,
+                               rights_req,
+                               resource_oid_mask,
+                               resource_gid_mask,
+                               resource_cid_mask,
+                               tmp_rules);
+        }
+        else
+        {
+            auth = match_rules_wrapper(user_req,
                                        resource_oid_req,
                                        resource_gid_req,
                                        resource_cid_req,
@@ -396,6 +390,39 @@ const bool AclManager::authorize(
                                        resource_gid_mask,
                                        resource_cid_mask,
                                        tmp_rules);
+        }
+
+        if ( auth == true )
+        {
+            return true;
+        }
+    }
+
+    // -------------------------------------------------------------------------
+    // Look for the rules in the compiled index
+    // -------------------------------------------------------------------------
+
+    if ( use_index )
+    {
+        set<int> no_cids;
+
+        int gid = -1;
+
+        if ( !obj_perms.disable_group_acl )
+        {
+            gid = obj_perms.gid;
+        }
+
+        const set<int>& cids = obj_perms.disable_cluster_acl ? no_cids :
+                                                               obj_perms.cids;
+
+        auth = acl_index.match(user_reqs,
+                               obj_perms.obj_type,
+                               rights_req,
+                               !obj_perms.disable_all_acl,
+                               obj_perms.oid,
+                               gid,
+                               cids);
         if ( auth == true )
         {
             return true;
@@ -622,6 +649,8 @@ int AclManager::add_rule(long long user, long long resource, long long rights,
     acl_rules.insert( make_pair(rule->user, rule) );
     acl_rules_oids.insert( make_pair(rule->oid, rule) );
 
+    acl_index.add(rule);
+
     set_lastOID(db, lastOID);
 
     unlock();
@@ -743,6 +772,8 @@ int AclManager::del_rule(int oid, string& error_str)
     acl_rules.erase( it );
     acl_rules_oids.erase( oid );
 
+    acl_index.del(rule);
+
     delete rule;
 
     unlock();
@@ -959,6 +990,34 @@ void AclManager::del_zone_matching_rules(long long zone_req)
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
+bool AclManager::ReverseSearchKey::operator<(
+        const ReverseSearchKey& other) const
+{
+    if ( uid != other.uid )
+    {
+        return uid < other.uid;
+    }
+
+    if ( obj_type != other.obj_type )
+    {
+        return obj_type < other.obj_type;
+    }
+
+    if ( op != other.op )
+    {
+        return op < other.op;
+    }
+
+    if ( disable_flags != other.disable_flags )
+    {
+        return disable_flags < other.disable_flags;
+    }
+
+    return user_groups < other.user_groups;
+}
+
+/* -------------------------------------------------------------------------- */
+
 void AclManager::reverse_search(int                       uid,
                                 const set<int>&           user_groups,
                                 PoolObjectSQL::ObjectType obj_type,
@@ -970,6 +1029,80 @@ void AclManager::reverse_search(int                       uid,
                                 vector<int>&              oids,
                                 vector<int>&              gids,
                                 vector<int>&              cids)
+{
+    map<ReverseSearchKey, ReverseSearchResult>::iterator it;
+
+    ReverseSearchKey    key;
+    ReverseSearchResult result;
+
+    key.uid           = uid;
+    key.user_groups   = user_groups;
+    key.obj_type      = obj_type;
+    key.op            = op;
+    key.disable_flags = (disable_all_acl ? 1 : 0) |
+                        (disable_cluster_acl ? 2 : 0) |
+                        (disable_group_acl ? 4 : 0);
+
+    // Read the version before searching, so a result computed while the
+    // rules change is never used
+    result.generation = acl_index.generation();
+
+    lock();
+
+    it = reverse_search_cache.find(key);
+
+    if ( it != reverse_search_cache.end() &&
+         it->second.generation == result.generation )
+    {
+        all = it->second.all;
+
+        oids.insert(oids.end(), it->second.oids.begin(), it->second.oids.end());
+        gids.insert(gids.end(), it->second.gids.begin(), it->second.gids.end());
+        cids.insert(cids.end(), it->second.cids.begin(), it->second.cids.end());
+
+        unlock();
+
+        return;
+    }
+
+    unlock();
+
+    reverse_search_rules(uid, user_groups, obj_type, op, disable_all_acl,
+            disable_cluster_acl, disable_group_acl, result.all, result.oids,
+            result.gids, result.cids);
+
+    all = result.all;
+
+    oids.insert(oids.end(), result.oids.begin(), result.oids.end());
+    gids.insert(gids.end(), result.gids.begin(), result.gids.end());
+    cids.insert(cids.end(), result.cids.begin(), result.cids.end());
+
+    lock();
+
+    if ( reverse_search_cache.size() >= REVERSE_SEARCH_CACHE_SIZE )
+    {
+        reverse_search_cache.clear();
+    }
+
+    reverse_search_cache[key] = result;
+
+    unlock();
+}
+
+/* -------------------------------------------------------------------------- */
+
+void AclManager::reverse_search_rules(
+        int                       uid,
+        const set<int>&           user_groups,
+        PoolObjectSQL::ObjectType obj_type,
+        AuthRequest::Operation    op,
+        bool                      disable_all_acl,
+        bool                      disable_cluster_acl,
+        bool                      disable_group_acl,
+        bool&                     all,
+        vector<int>&              oids,
+        vector<int>&              gids,
+        vector<int>&              cids)
 {
     ostringstream oss;
 
@@ -1186,6 +1319,10 @@ int AclManager::select()
 
     rc = db->exec_rd(oss,this);
 
+    // The index is rebuilt aside, so requests authorized while the rules are
+    // loaded use the previous rule set
+    acl_index.replace(acl_rules);
+
     unlock();
 
     unset_callback();
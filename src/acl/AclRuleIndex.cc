@@ -0,0 +1,224 @@
+/* -------------------------------------------------------------------------- */
+/* Copyright 2002-2017, OpenNebula Project, OpenNebula Systems                */
+/*                                                                            */
+/* Licensed under the Apache License, Version 2.0 (the "License"); you may    */
+/* not use this file except in compliance with the License. You may obtain    */
+/* a copy of the License at                                                   */
+/*                                                                            */
+/* http://www.apache.org/licenses/LICENSE-2.0                                 */
+/*                                                                            */
+/* Unless required by applicable law or agreed to in writing, software        */
+/* distributed under the License is distributed on an "AS IS" BASIS,          */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   */
+/* See the License for the specific language governing permissions and        */
+/* limitations under the License.                                             */
+/* -------------------------------------------------------------------------- */
+
+#include "AclRuleIndex.h"
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+static void update_ids(multiset<int>& ids, int id, int inc)
+{
+    if ( inc > 0 )
+    {
+        ids.insert(id);
+    }
+    else
+    {
+        multiset<int>::iterator it = ids.find(id);
+
+        if ( it != ids.end() )
+        {
+            ids.erase(it);
+        }
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+bool AclRuleIndex::local_zone(const AclRule * rule) const
+{
+    long long zone_oid_mask = AclRule::INDIVIDUAL_ID | 0x00000000FFFFFFFFLL;
+    long long zone_req      = AclRule::INDIVIDUAL_ID | zone_id;
+
+    return ( rule->zone & AclRule::ALL_ID ) == AclRule::ALL_ID ||
+           ( rule->zone & zone_oid_mask ) == zone_req;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void AclRuleIndex::update(const AclRule * rule, int inc)
+{
+    if ( !local_zone(rule) )
+    {
+        return;
+    }
+
+    int id = rule->resource_id();
+
+    // Object types are the resource bits over the ID and selector flags
+    for (int type_bit = 36; type_bit < 64; type_bit++)
+    {
+        if ( ((static_cast<unsigned long long>(rule->resource) >> type_bit) &
+                1) == 0 )
+        {
+            continue;
+        }
+
+        for (int op_bit = 0; op_bit < OPERATIONS; op_bit++)
+        {
+            if ( (rule->rights & (1LL << op_bit)) == 0 )
+            {
+                continue;
+            }
+
+            IndexKey key(rule->user, type_bit * OPERATIONS + op_bit);
+
+            Grants& grants = index[key];
+
+            if ( (rule->resource & AclRule::ALL_ID) &&
+                    (inc > 0 || grants.all > 0) )
+            {
+                grants.all += inc;
+            }
+
+            if ( rule->resource & AclRule::GROUP_ID )
+            {
+                update_ids(grants.gids, id, inc);
+            }
+
+            if ( rule->resource & AclRule::CLUSTER_ID )
+            {
+                update_ids(grants.cids, id, inc);
+            }
+
+            if ( rule->resource & AclRule::INDIVIDUAL_ID )
+            {
+                update_ids(grants.oids, id, inc);
+            }
+
+            if ( grants.empty() )
+            {
+                index.erase(key);
+            }
+        }
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void AclRuleIndex::add(const AclRule * rule)
+{
+    pthread_rwlock_wrlock(&rwlock);
+
+    update(rule, 1);
+
+    __atomic_add_fetch(&_generation, 1, __ATOMIC_RELEASE);
+
+    pthread_rwlock_unlock(&rwlock);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void AclRuleIndex::del(const AclRule * rule)
+{
+    pthread_rwlock_wrlock(&rwlock);
+
+    update(rule, -1);
+
+    __atomic_add_fetch(&_generation, 1, __ATOMIC_RELEASE);
+
+    pthread_rwlock_unlock(&rwlock);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void AclRuleIndex::clear()
+{
+    pthread_rwlock_wrlock(&rwlock);
+
+    index.clear();
+
+    __atomic_add_fetch(&_generation, 1, __ATOMIC_RELEASE);
+
+    pthread_rwlock_unlock(&rwlock);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void AclRuleIndex::replace(const multimap<long long, AclRule *>& rules)
+{
+    AclRuleIndex loaded(zone_id);
+
+    multimap<long long, AclRule *>::const_iterator it;
+
+    for (it = rules.begin(); it != rules.end(); ++it)
+    {
+        loaded.update(it->second, 1);
+    }
+
+    pthread_rwlock_wrlock(&rwlock);
+
+    index.swap(loaded.index);
+
+    __atomic_add_fetch(&_generation, 1, __ATOMIC_RELEASE);
+
+    pthread_rwlock_unlock(&rwlock);
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+bool AclRuleIndex::match(const vector<long long>& user_reqs, long long obj_type,
+        long long op, bool all, int oid, int gid, const set<int>& cids)
+{
+    int key_op = (__builtin_ctzll(obj_type) * OPERATIONS) +
+                 __builtin_ctzll(op);
+
+    bool auth = false;
+
+    pthread_rwlock_rdlock(&rwlock);
+
+    for (size_t i = 0; i < user_reqs.size() && !auth; i++)
+    {
+        map<IndexKey, Grants>::const_iterator it;
+
+        it = index.find(IndexKey(user_reqs[i], key_op));
+
+        if ( it == index.end() )
+        {
+            continue;
+        }
+
+        const Grants& grants = it->second;
+
+        if ( all && grants.all > 0 )
+        {
+            auth = true;
+        }
+        else if ( oid >= 0 && grants.oids.count(oid) > 0 )
+        {
+            auth = true;
+        }
+        else if ( gid >= 0 && grants.gids.count(gid) > 0 )
+        {
+            auth = true;
+        }
+        else if ( !grants.cids.empty() )
+        {
+            set<int>::const_iterator c_it;
+
+            for (c_it = cids.begin(); c_it != cids.end() && !auth; c_it++)
+            {
+                auth = grants.cids.count(*c_it) > 0;
+            }
+        }
+    }
+
+    pthread_rwlock_unlock(&rwlock);
+
+    return auth;
+}
@@ -25,6 +25,8 @@
 
 const char * AuthManager::auth_driver_name = "auth_exe";
 
+const size_t AuthManager::NEGATIVE_CACHE_SIZE = 10000;
+
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
@@ -110,6 +112,33 @@ void AuthRequest::add_auth(Operation             op,
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
+AuthManager::AuthManager(
+        time_t                    timer,
+        vector<const VectorAttribute*>& _mads):
+            MadManager(_mads), timer_period(timer), request_timeout(90),
+            negative_cache_time(0), authz_enabled(false), next_driver(0),
+            negative_cache_hits(0)
+{
+    if ( timer_period > 1 )
+    {
+        timer_period = 1;
+    }
+
+    pthread_mutex_init(&mutex, 0);
+
+    am.addListener(this);
+}
+
+/* -------------------------------------------------------------------------- */
+
+AuthManager::~AuthManager()
+{
+    pthread_mutex_destroy(&mutex);
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
 extern "C" void * authm_action_loop(void *arg)
 {
     AuthManager *  authm;
@@ -157,6 +186,184 @@ int AuthManager::start()
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
+void AuthManager::trigger(AMAction::Actions action, AuthRequest* request)
+{
+    if ( action == AMAction::AUTHENTICATE && negative_cache_time > 0 )
+    {
+        bool   cached = false;
+        string key    = negative_cache_key(request);
+
+        pthread_mutex_lock(&mutex);
+
+        map<string, pair<time_t, string> >::iterator it;
+
+        it = negative_cache.find(key);
+
+        if ( it != negative_cache.end() && it->second.first > time(0) )
+        {
+            request->message = it->second.second;
+
+            negative_cache_hits++;
+
+            cached = true;
+        }
+
+        pthread_mutex_unlock(&mutex);
+
+        if ( cached )
+        {
+            request->result = false;
+            request->notify();
+
+            return;
+        }
+    }
+
+    AMAction auth_ar(action, request);
+
+    am.trigger(auth_ar);
+}
+
+/* -------------------------------------------------------------------------- */
+
+string AuthManager::negative_cache_key(AuthRequest * ar)
+{
+    ostringstream oss;
+
+    oss << ar->driver << ":" << ar->username << ":" << ar->password << ":"
+        << ar->session;
+
+    return one_util::sha1_digest(oss.str());
+}
+
+/* -------------------------------------------------------------------------- */
+
+void AuthManager::add_pending(AMAction::Actions action, AuthRequest * ar)
+{
+    PendingRequest preq;
+
+    preq.action   = action;
+    preq.time_out = time(0) + request_timeout;
+
+    clock_gettime(CLOCK_MONOTONIC, &preq.start);
+
+    if ( action == AMAction::AUTHENTICATE && negative_cache_time > 0 )
+    {
+        preq.cache_key = negative_cache_key(ar);
+    }
+
+    pthread_mutex_lock(&mutex);
+
+    pending[ar->id] = preq;
+
+    pthread_mutex_unlock(&mutex);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void AuthManager::notify_request(int id, bool result, const string& message)
+{
+    pthread_mutex_lock(&mutex);
+
+    map<int, PendingRequest>::iterator it = pending.find(id);
+
+    if ( it != pending.end() )
+    {
+        ActionMetrics& m = metrics[it->second.action];
+
+        m.latency.add(LatencyHistogram::elapsed(it->second.start));
+
+        if ( result )
+        {
+            m.success++;
+        }
+        else
+        {
+            m.failure++;
+
+            if ( !it->second.cache_key.empty() &&
+                    negative_cache.size() < NEGATIVE_CACHE_SIZE )
+            {
+                negative_cache[it->second.cache_key] =
+                    make_pair(time(0) + negative_cache_time, message);
+            }
+        }
+
+        pending.erase(it);
+    }
+
+    pthread_mutex_unlock(&mutex);
+
+    MadManager::notify_request(id, result, message);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void AuthManager::check_time_outs()
+{
+    vector<int> expired;
+
+    time_t the_time = time(0);
+
+    pthread_mutex_lock(&mutex);
+
+    map<int, PendingRequest>::iterator it = pending.begin();
+
+    while ( it != pending.end() )
+    {
+        if ( the_time > it->second.time_out )
+        {
+            metrics[it->second.action].timeout++;
+
+            expired.push_back(it->first);
+
+            pending.erase(it++);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    map<string, pair<time_t, string> >::iterator nc_it;
+
+    nc_it = negative_cache.begin();
+
+    while ( nc_it != negative_cache.end() )
+    {
+        if ( the_time >= nc_it->second.first )
+        {
+            negative_cache.erase(nc_it++);
+        }
+        else
+        {
+            ++nc_it;
+        }
+    }
+
+    pthread_mutex_unlock(&mutex);
+
+    for (vector<int>::iterator e_it = expired.begin(); e_it != expired.end();
+            ++e_it)
+    {
+        SyncRequest * ar = get_request(*e_it);
+
+        if ( ar == 0 )
+        {
+            continue;
+        }
+
+        ar->result  = false;
+        ar->timeout = true;
+        ar->message = "Request timeout";
+
+        ar->notify();
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
 void AuthManager::user_action(const ActionRequest& ar)
 {
     const AMAction& auth_ar = static_cast<const AMAction& >(ar);
@@ -203,6 +410,8 @@ void AuthManager::authenticate_action(AuthRequest * ar)
 
     add_request(ar);
 
+    add_pending(AMAction::AUTHENTICATE, ar);
+
     // ------------------------------------------------------------------------
     // Make the request to the driver
     // ---- --------------------------------------------------------------------
@@ -241,24 +450,26 @@ void AuthManager::authorize_action(AuthRequest * ar)
         goto error;
     }
 
+    auths = ar->get_auths();
+
+    if ( auths.empty() )
+    {
+        ar->message = "Empty authorization string";
+        goto error;
+    }
+
     // ------------------------------------------------------------------------
     // Queue the request
     // ------------------------------------------------------------------------
 
     add_request(ar);
 
+    add_pending(AMAction::AUTHORIZE, ar);
+
     // ------------------------------------------------------------------------
     // Make the request to the driver
     // ------------------------------------------------------------------------
 
-    auths = ar->get_auths();
-
-    if ( auths.empty() )
-    {
-        ar->message = "Empty authorization string";
-        goto error;
-    }
-
     authm_md->authorize(ar->id, ar->uid, auths, ar->self_authorize);
 
     return;
@@ -279,6 +490,8 @@ int AuthManager::load_mads(int uid)
     ostringstream                   oss;
     const VectorAttribute *         vattr = 0;
     int                             rc;
+    int                             instances;
+    int                             threads;
     string                          name;
     AuthManagerDriver *             authm_driver = 0;
 
@@ -299,8 +512,6 @@ int AuthManager::load_mads(int uid)
 
     VectorAttribute auth_conf("AUTH_MAD",vattr->value());
 
-    auth_conf.replace("NAME",auth_driver_name);
-
     oss.str("");
 
     string authn = auth_conf.vector_value("AUTHN");
@@ -322,19 +533,152 @@ int AuthManager::load_mads(int uid)
         authz_enabled = false;
     }
 
+    if ( auth_conf.vector_value("THREADS", threads) == 0 && threads > 0 )
+    {
+        oss << " --threads " << threads;
+    }
+
     auth_conf.replace("ARGUMENTS", oss.str());
 
-    authm_driver = new AuthManagerDriver(uid,auth_conf.value(),(uid!=0),this);
+    if ( auth_conf.vector_value("INSTANCES", instances) != 0 || instances < 1 )
+    {
+        instances = 1;
+    }
+
+    if ( auth_conf.vector_value("REQUEST_TIMEOUT", request_timeout) != 0 ||
+            request_timeout <= 0 )
+    {
+        request_timeout = 90;
+    }
+
+    if ( auth_conf.vector_value("NEGATIVE_CACHE_TIME", negative_cache_time)
+            != 0 || negative_cache_time < 0 )
+    {
+        negative_cache_time = 0;
+    }
+
+    for (int i = 0; i < instances; i++)
+    {
+        // First instance keeps the generic driver name
+        oss.str("");
+        oss << auth_driver_name;
+
+        if ( i > 0 )
+        {
+            oss << "_" << i;
+        }
+
+        auth_conf.replace("NAME", oss.str());
+
+        authm_driver = new AuthManagerDriver(uid, auth_conf.value(), (uid!=0),
+                this);
+
+        rc = add(authm_driver);
+
+        if ( rc != 0 )
+        {
+            delete authm_driver;
+            break;
+        }
 
-    rc = add(authm_driver);
+        drivers.push_back(authm_driver);
+    }
 
-    if ( rc == 0 )
+    if ( !drivers.empty() )
     {
         oss.str("");
-        oss << "\tAuth Manager loaded";
+        oss << "\tAuth Manager loaded, " << drivers.size() << " driver "
+            << "instance(s), request timeout " << request_timeout << "s";
 
         NebulaLog::log("AuM",Log::INFO,oss);
+
+        rc = 0;
     }
 
     return rc;
 }
+
+/* ************************************************************************** */
+/* Auth driver metrics                                                        */
+/* ************************************************************************** */
+
+void AuthManager::to_xml(ostringstream& oss)
+{
+    static const char * names[] = {"AUTHENTICATE", "AUTHORIZE"};
+
+    pthread_mutex_lock(&mutex);
+
+    oss << "<AUTH_METRICS>"
+        << "<PENDING>" << pending.size() << "</PENDING>"
+        << "<NEGATIVE_CACHE_SIZE>" << negative_cache.size()
+        << "</NEGATIVE_CACHE_SIZE>"
+        << "<NEGATIVE_CACHE_HITS>" << negative_cache_hits
+        << "</NEGATIVE_CACHE_HITS>";
+
+    for (int i = 0; i < 2; i++)
+    {
+        oss << "<ACTION>"
+            << "<NAME>"     << names[i]           << "</NAME>"
+            << "<SUCCESS>"  << metrics[i].success << "</SUCCESS>"
+            << "<FAILURES>" << metrics[i].failure << "</FAILURES>"
+            << "<TIMEOUTS>" << metrics[i].timeout << "</TIMEOUTS>";
+
+        metrics[i].latency.to_xml(oss, "LATENCY");
+
+        oss << "</ACTION>";
+    }
+
+    oss << "</AUTH_METRICS>";
+
+    pthread_mutex_unlock(&mutex);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void AuthManager::to_prometheus(ostringstream& oss)
+{
+    static const char * names[] = {"authenticate", "authorize"};
+
+    static const string metric = "opennebula_auth_driver_duration_seconds";
+    static const string total  = "opennebula_auth_driver_requests_total";
+
+    pthread_mutex_lock(&mutex);
+
+    oss << "# HELP " << metric << " Latency of the auth driver by action\n"
+        << "# TYPE " << metric << " histogram\n";
+
+    for (int i = 0; i < 2; i++)
+    {
+        ostringstream labels;
+
+        labels << "action=\"" << names[i] << "\"";
+
+        metrics[i].latency.to_prometheus(oss, metric, labels.str());
+    }
+
+    oss << "# HELP " << total << " Auth driver requests by action and "
+        << "result\n"
+        << "# TYPE " << total << " counter\n";
+
+    for (int i = 0; i < 2; i++)
+    {
+        oss << total << "{action=\"" << names[i] << "\",result=\"success\"} "
+            << metrics[i].success << "\n"
+            << total << "{action=\"" << names[i] << "\",result=\"failure\"} "
+            << metrics[i].failure << "\n"
+            << total << "{action=\"" << names[i] << "\",result=\"timeout\"} "
+            << metrics[i].timeout << "\n";
+    }
+
+    oss << "# HELP opennebula_auth_driver_pending Requests waiting for the "
+        << "auth driver\n"
+        << "# TYPE opennebula_auth_driver_pending gauge\n"
+        << "opennebula_auth_driver_pending " << pending.size() << "\n"
+        << "# HELP opennebula_auth_negative_cache_hits_total Authentications "
+        << "rejected by the negative cache\n"
+        << "# TYPE opennebula_auth_negative_cache_hits_total counter\n"
+        << "opennebula_auth_negative_cache_hits_total " << negative_cache_hits
+        << "\n";
+
+    pthread_mutex_unlock(&mutex);
+}
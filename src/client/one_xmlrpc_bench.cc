@@ -0,0 +1,592 @@
+/* -------------------------------------------------------------------------- */
+/* Copyright 2002-2017, OpenNebula Project, OpenNebula Systems                */
+/*                                                                            */
+/* Licensed under the Apache License, Version 2.0 (the "License"); you may    */
+/* not use this file except in compliance with the License. You may obtain    */
+/* a copy of the License at                                                   */
+/*                                                                            */
+/* http://www.apache.org/licenses/LICENSE-2.0                                 */
+/*                                                                            */
+/* Unless required by applicable law or agreed to in writing, software        */
+/* distributed under the License is distributed on an "AS IS" BASIS,          */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   */
+/* See the License for the specific language governing permissions and        */
+/* limitations under the License.                                             */
+/* -------------------------------------------------------------------------- */
+
+/* -------------------------------------------------------------------------- */
+/* XML-RPC load generator for oned. N worker threads replay a weighted mix of */
+/* calls at a target rate and report the throughput and latency percentiles  */
+/* of each method.                                                            */
+/*                                                                            */
+/*   one_xmlrpc_bench [options]                                               */
+/*                                                                            */
+/* Latencies are measured from the time each call was scheduled, so a slow   */
+/* server is not hidden by the workers falling behind the target rate.       */
+/* -------------------------------------------------------------------------- */
+
+#include "Client.h"
+#include "LatencyHistogram.h"
+#include "NebulaUtil.h"
+
+#include <getopt.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+/**
+ *  Calls that can be included in the mix
+ */
+enum CallType
+{
+    VM_INFO              = 0,
+    VMPOOL_INFO          = 1,
+    TEMPLATE_INSTANTIATE = 2,
+    VM_ACTION            = 3,
+    HOST_INFO            = 4
+};
+
+static const unsigned int CALL_TYPES = 5;
+
+static const char * call_names[] = {"vm.info", "vmpool.info",
+    "template.instantiate", "vm.action", "host.info"};
+
+/**
+ *  Results of a call type, shared by all the workers
+ */
+struct CallStats
+{
+    LatencyHistogram latency;
+
+    unsigned long long failures;
+
+    CallStats():failures(0){};
+};
+
+/**
+ *  Benchmark configuration
+ */
+struct BenchConf
+{
+    string endpoint;
+
+    string secret;
+
+    unsigned int connections;
+
+    /**
+     *  Total calls per second, 0 to send them as fast as possible
+     */
+    double rate;
+
+    unsigned int duration;
+
+    unsigned int timeout;
+
+    /**
+     *  Cumulative weights of the call types
+     */
+    unsigned int weights[CALL_TYPES];
+
+    vector<int> vm_ids;
+
+    vector<int> host_ids;
+
+    int template_id;
+
+    string vm_action;
+
+    int pool_filter;
+
+    int pool_state;
+
+    BenchConf():endpoint("http://localhost:2633/RPC2"), connections(4),
+        rate(0), duration(10), timeout(30000), template_id(0),
+        vm_action("resume"), pool_filter(-2), pool_state(-1)
+    {
+        for (unsigned int i = 0; i < CALL_TYPES; i++)
+        {
+            weights[i] = 0;
+        }
+
+        vm_ids.push_back(0);
+
+        host_ids.push_back(0);
+    };
+};
+
+static BenchConf conf;
+
+static CallStats stats[CALL_TYPES];
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+static unsigned long long now_usec()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void sleep_until(unsigned long long usec)
+{
+    unsigned long long now = now_usec();
+
+    if ( usec <= now )
+    {
+        return;
+    }
+
+    struct timespec ts;
+
+    ts.tv_sec  = (usec - now) / 1000000;
+    ts.tv_nsec = ((usec - now) % 1000000) * 1000;
+
+    nanosleep(&ts, 0);
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+/**
+ *  Builds the parameters of a call
+ *    @param type of the call
+ *    @param seed of the worker random generator
+ *    @param id of the worker, used to name the VMs
+ *    @param n number of the call in the worker, used to name the VMs
+ *    @param plist the parameters
+ *    @return the XML-RPC method name
+ */
+static string build_call(CallType type, unsigned int * seed, int id,
+        unsigned long long n, xmlrpc_c::paramList& plist)
+{
+    int vm_id   = conf.vm_ids[rand_r(seed) % conf.vm_ids.size()];
+    int host_id = conf.host_ids[rand_r(seed) % conf.host_ids.size()];
+
+    ostringstream oss;
+
+    plist.add(xmlrpc_c::value_string(conf.secret));
+
+    switch (type)
+    {
+        case VM_INFO:
+            plist.add(xmlrpc_c::value_int(vm_id));
+            return "one.vm.info";
+
+        case VMPOOL_INFO:
+            plist.add(xmlrpc_c::value_int(conf.pool_filter));
+            plist.add(xmlrpc_c::value_int(-1));
+            plist.add(xmlrpc_c::value_int(-1));
+            plist.add(xmlrpc_c::value_int(conf.pool_state));
+            return "one.vmpool.info";
+
+        case TEMPLATE_INSTANTIATE:
+            oss << "bench-" << id << "-" << n;
+
+            plist.add(xmlrpc_c::value_int(conf.template_id));
+            plist.add(xmlrpc_c::value_string(oss.str()));
+            plist.add(xmlrpc_c::value_boolean(true));
+            plist.add(xmlrpc_c::value_string(""));
+            return "one.template.instantiate";
+
+        case VM_ACTION:
+            plist.add(xmlrpc_c::value_string(conf.vm_action));
+            plist.add(xmlrpc_c::value_int(vm_id));
+            return "one.vm.action";
+
+        case HOST_INFO:
+            plist.add(xmlrpc_c::value_int(host_id));
+            return "one.host.info";
+    }
+
+    return "";
+}
+
+/* -------------------------------------------------------------------------- */
+
+/**
+ *  Performs a call and records its latency
+ *    @param scheduled time of the call (usec)
+ */
+static void do_call(CallType type, unsigned int * seed, int id,
+        unsigned long long n, unsigned long long scheduled)
+{
+    xmlrpc_c::paramList plist;
+    xmlrpc_c::value     result;
+
+    string error;
+
+    string method = build_call(type, seed, id, n, plist);
+
+    int rc = Client::call(conf.endpoint, method, plist, conf.timeout, &result,
+            error);
+
+    if ( rc == 0 )
+    {
+        try
+        {
+            vector<xmlrpc_c::value> values =
+                xmlrpc_c::value_array(result).vectorValueValue();
+
+            if ( !static_cast<bool>(xmlrpc_c::value_boolean(values[0])) )
+            {
+                rc = -1;
+            }
+        }
+        catch (exception const& e)
+        {
+            rc = -1;
+        }
+    }
+
+    stats[type].latency.add(now_usec() - scheduled);
+
+    if ( rc != 0 )
+    {
+        __atomic_fetch_add(&stats[type].failures, 1, __ATOMIC_RELAXED);
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+extern "C" void * bench_worker(void * arg)
+{
+    int id = static_cast<int>(reinterpret_cast<long>(arg));
+
+    unsigned int seed = id + time(0);
+
+    unsigned int total = conf.weights[CALL_TYPES - 1];
+
+    // Each worker sends an equal share of the target rate
+    unsigned long long interval = 0;
+
+    if ( conf.rate > 0 )
+    {
+        interval = static_cast<unsigned long long>(
+                1000000.0 * conf.connections / conf.rate);
+    }
+
+    unsigned long long start = now_usec();
+    unsigned long long end   = start + conf.duration * 1000000ULL;
+
+    // Spread the first call of each worker over the interval
+    unsigned long long next = start + interval * id / conf.connections;
+
+    for (unsigned long long n = 0; ; n++)
+    {
+        unsigned long long scheduled = now_usec();
+
+        if ( interval > 0 )
+        {
+            sleep_until(next);
+
+            scheduled = next;
+            next     += interval;
+        }
+
+        if ( scheduled >= end )
+        {
+            break;
+        }
+
+        unsigned int w = rand_r(&seed) % total;
+        unsigned int t = 0;
+
+        while ( w >= conf.weights[t] )
+        {
+            t++;
+        }
+
+        do_call(static_cast<CallType>(t), &seed, id, n, scheduled);
+    }
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+/**
+ *  Parses the call mix, e.g. "vm.info:60,vmpool.info:20,host.info:20"
+ *    @return 0 on success
+ */
+static int parse_mix(const string& mix)
+{
+    vector<string> entries = one_util::split(mix, ',', true);
+
+    unsigned int acc = 0;
+
+    for (unsigned int i = 0; i < CALL_TYPES; i++)
+    {
+        unsigned int weight = 0;
+
+        for (size_t j = 0; j < entries.size(); j++)
+        {
+            vector<string> kv = one_util::split(entries[j], ':');
+
+            if ( one_util::trim(kv[0]) == call_names[i] )
+            {
+                weight = kv.size() > 1 ? atoi(kv[1].c_str()) : 1;
+            }
+        }
+
+        acc += weight;
+
+        conf.weights[i] = acc;
+    }
+
+    for (size_t j = 0; j < entries.size(); j++)
+    {
+        vector<string> kv = one_util::split(entries[j], ':');
+
+        unsigned int i;
+
+        for (i = 0; i < CALL_TYPES && one_util::trim(kv[0]) != call_names[i];
+                i++);
+
+        if ( i == CALL_TYPES )
+        {
+            cerr << "Unknown call in mix: " << kv[0] << endl;
+            return -1;
+        }
+    }
+
+    if ( acc == 0 )
+    {
+        cerr << "Empty call mix" << endl;
+        return -1;
+    }
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+
+static int parse_ids(const string& str, vector<int>& ids)
+{
+    vector<string> entries = one_util::split(str, ',', true);
+
+    ids.clear();
+
+    for (size_t i = 0; i < entries.size(); i++)
+    {
+        ids.push_back(atoi(entries[i].c_str()));
+    }
+
+    return ids.empty() ? -1 : 0;
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void print_usage(ostream& str)
+{
+    str << "Usage: one_xmlrpc_bench [options]\n\n"
+        << "  -e, --endpoint URL    XML-RPC endpoint (default $ONE_XMLRPC or "
+           "http://localhost:2633/RPC2)\n"
+        << "  -c, --connections N   concurrent connections (default 4)\n"
+        << "  -r, --rate R          total calls per second, 0 for no limit "
+           "(default 0)\n"
+        << "  -d, --duration S      duration in seconds (default 10)\n"
+        << "  -m, --mix MIX         weighted calls, e.g. "
+           "vm.info:60,vmpool.info:20,host.info:20\n"
+        << "                        calls: vm.info, vmpool.info, "
+           "template.instantiate,\n"
+        << "                        vm.action, host.info "
+           "(default vm.info:1)\n"
+        << "  -v, --vms IDS         VM ids for vm.info and vm.action "
+           "(default 0)\n"
+        << "  -H, --hosts IDS       host ids for host.info (default 0)\n"
+        << "  -t, --template ID     template for template.instantiate, VMs "
+           "are created on hold\n"
+        << "                        (default 0)\n"
+        << "  -a, --action ACTION   action for vm.action (default resume)\n"
+        << "  -f, --filter FLAG     vmpool.info filter flag (default -2)\n"
+        << "  -s, --state STATE     vmpool.info state filter (default -1)\n"
+        << "  -T, --timeout S       call timeout in seconds (default 30)\n"
+        << "  -h, --help            this help\n\n"
+        << "Credentials are read from $ONE_AUTH or $HOME/.one/one_auth\n";
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void print_report(double elapsed)
+{
+    unsigned long long total    = 0;
+    unsigned long long failures = 0;
+
+    cout << left << setw(22) << "METHOD" << right
+         << setw(10) << "CALLS"  << setw(10) << "FAILED"
+         << setw(10) << "CALLS/S"
+         << setw(10) << "AVG(ms)" << setw(10) << "P50(ms)"
+         << setw(10) << "P90(ms)" << setw(10) << "P99(ms)" << endl;
+
+    cout << fixed << setprecision(1);
+
+    for (unsigned int i = 0; i < CALL_TYPES; i++)
+    {
+        const LatencyHistogram& h = stats[i].latency;
+
+        if ( h.count() == 0 )
+        {
+            continue;
+        }
+
+        total    += h.count();
+        failures += stats[i].failures;
+
+        cout << left << setw(22) << call_names[i] << right
+             << setw(10) << h.count() << setw(10) << stats[i].failures
+             << setw(10) << h.count() / elapsed
+             << setw(10) << h.sum() / 1000.0 / h.count()
+             << setw(10) << h.percentile(50) / 1000.0
+             << setw(10) << h.percentile(90) / 1000.0
+             << setw(10) << h.percentile(99) / 1000.0 << endl;
+    }
+
+    cout << endl << "Total: " << total << " calls, " << failures
+         << " failed, " << total / elapsed << " calls/s in " << elapsed
+         << "s" << endl;
+
+    cout << "Percentiles are upper bounds of log2 latency buckets" << endl;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+int main(int argc, char ** argv)
+{
+    static struct option long_options[] = {
+        {"endpoint",    required_argument, 0, 'e'},
+        {"connections", required_argument, 0, 'c'},
+        {"rate",        required_argument, 0, 'r'},
+        {"duration",    required_argument, 0, 'd'},
+        {"mix",         required_argument, 0, 'm'},
+        {"vms",         required_argument, 0, 'v'},
+        {"hosts",       required_argument, 0, 'H'},
+        {"template",    required_argument, 0, 't'},
+        {"action",      required_argument, 0, 'a'},
+        {"filter",      required_argument, 0, 'f'},
+        {"state",       required_argument, 0, 's'},
+        {"timeout",     required_argument, 0, 'T'},
+        {"help",        no_argument,       0, 'h'},
+        {0, 0, 0, 0}
+    };
+
+    string mix = "vm.info:1";
+    string error;
+
+    int opt;
+
+    const char * xmlrpc_env = getenv("ONE_XMLRPC");
+
+    if ( xmlrpc_env != 0 )
+    {
+        conf.endpoint = xmlrpc_env;
+    }
+
+    while ((opt = getopt_long(argc, argv, "e:c:r:d:m:v:H:t:a:f:s:T:h",
+                    long_options, 0)) != -1)
+    {
+        switch (opt)
+        {
+            case 'e': conf.endpoint    = optarg; break;
+            case 'c': conf.connections = atoi(optarg); break;
+            case 'r': conf.rate        = atof(optarg); break;
+            case 'd': conf.duration    = atoi(optarg); break;
+            case 'm': mix              = optarg; break;
+            case 't': conf.template_id = atoi(optarg); break;
+            case 'a': conf.vm_action   = optarg; break;
+            case 'f': conf.pool_filter = atoi(optarg); break;
+            case 's': conf.pool_state  = atoi(optarg); break;
+            case 'T': conf.timeout     = atoi(optarg) * 1000; break;
+
+            case 'v':
+                if ( parse_ids(optarg, conf.vm_ids) != 0 )
+                {
+                    cerr << "Wrong VM ids: " << optarg << endl;
+                    return -1;
+                }
+                break;
+
+            case 'H':
+                if ( parse_ids(optarg, conf.host_ids) != 0 )
+                {
+                    cerr << "Wrong host ids: " << optarg << endl;
+                    return -1;
+                }
+                break;
+
+            case 'h':
+                print_usage(cout);
+                return 0;
+
+            default:
+                print_usage(cerr);
+                return -1;
+        }
+    }
+
+    if ( conf.connections == 0 || conf.duration == 0 )
+    {
+        cerr << "Connections and duration must be greater than 0" << endl;
+        return -1;
+    }
+
+    if ( parse_mix(mix) != 0 )
+    {
+        return -1;
+    }
+
+    if ( Client::read_oneauth(conf.secret, error) != 0 )
+    {
+        cerr << error << endl;
+        return -1;
+    }
+
+    cout << "Benchmarking " << conf.endpoint << ": " << conf.connections
+         << " connections, ";
+
+    if ( conf.rate > 0 )
+    {
+        cout << conf.rate << " calls/s";
+    }
+    else
+    {
+        cout << "unlimited rate";
+    }
+
+    cout << ", " << conf.duration << "s, mix " << mix << endl << endl;
+
+    vector<pthread_t> workers(conf.connections);
+
+    unsigned long long start = now_usec();
+
+    for (unsigned int i = 0; i < conf.connections; i++)
+    {
+        pthread_create(&workers[i], 0, bench_worker,
+                reinterpret_cast<void *>(static_cast<long>(i)));
+    }
+
+    for (unsigned int i = 0; i < conf.connections; i++)
+    {
+        pthread_join(workers[i], 0);
+    }
+
+    print_report((now_usec() - start) / 1e6);
+
+    return 0;
+}
@@ -41,6 +41,8 @@ ClusterPool::ClusterPool(SqlDB * db, const VectorAttribute * _vnc_conf):
     ostringstream oss;
     string        error_str;
 
+    pthread_mutex_init(&cache_mutex, 0);
+
     // ---------------------------------------------------------------------
     // Create the default cluster
     // ---------------------------------------------------------------------
@@ -159,6 +161,16 @@ int ClusterPool::drop(PoolObjectSQL * objsql, string& error_msg)
         error_msg = "SQL DB error";
         rc = -1;
     }
+    else
+    {
+        drop_cache_index(objsql);
+
+        pthread_mutex_lock(&cache_mutex);
+
+        reserved_cache.erase(cluster->get_oid());
+
+        pthread_mutex_unlock(&cache_mutex);
+    }
 
     return rc;
 }
@@ -166,6 +178,63 @@ int ClusterPool::drop(PoolObjectSQL * objsql, string& error_msg)
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
+int ClusterPool::update(PoolObjectSQL * objsql)
+{
+    int rc = PoolSQL::update(objsql);
+
+    if ( rc == 0 )
+    {
+        set_cache(static_cast<Cluster *>(objsql));
+    }
+
+    return rc;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+int ClusterPool::get_reserved_capacity(int oid, string& cpu, string& mem)
+{
+    map<int, pair<string, string> >::iterator it;
+
+    pthread_mutex_lock(&cache_mutex);
+
+    it = reserved_cache.find(oid);
+
+    if ( it != reserved_cache.end() )
+    {
+        cpu = it->second.first;
+        mem = it->second.second;
+
+        pthread_mutex_unlock(&cache_mutex);
+
+        return 0;
+    }
+
+    pthread_mutex_unlock(&cache_mutex);
+
+    Cluster * cluster = get(oid, true);
+
+    if ( cluster == 0 )
+    {
+        return -1;
+    }
+
+    cpu.clear();
+    mem.clear();
+
+    cluster->get_reserved_capacity(cpu, mem);
+
+    set_cache(cluster);
+
+    cluster->unlock();
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
 void ClusterPool::cluster_acl_filter(ostringstream& filter,
         PoolObjectSQL::ObjectType auth_object, const vector<int>& cids)
 {
@@ -174,6 +243,8 @@ void ClusterPool::cluster_acl_filter(ostringstream& filter,
         return;
     }
 
+    set<int> cid_set(cids.begin(), cids.end());
+
     string fc = "";
 
     switch (auth_object)
@@ -198,15 +269,7 @@ void ClusterPool::cluster_acl_filter(ostringstream& filter,
             return;
     }
 
-    for ( vector<int>::const_iterator it = cids.begin(); it < cids.end(); it++ )
-    {
-        if ( it != cids.begin() )
-        {
-            filter << " OR ";
-        }
-
-        filter << "cid = " << *it;
-    }
+    in_filter("cid", cid_set, filter);
 
     filter << fc;
 }
@@ -15,26 +15,42 @@
 /* -------------------------------------------------------------------------- */
 
 #include "ActionManager.h"
+#include "Tracer.h"
+
 #include <ctime>
+#include <errno.h>
 
 /* ************************************************************************** */
 /* ActionManager constructor & destructor                                   */
 /* ************************************************************************** */
 
-ActionManager::ActionManager(): listener(0)
+ActionManager::ActionManager(unsigned int num_workers, bool _coalesce):
+    listener(0), coalesce(_coalesce), trace_component(0)
 {
-    pthread_mutex_init(&mutex,0);
+    pthread_mutex_init(&pending_mutex, 0);
+
+    for (unsigned int i = 0; num_workers > 1 && i < num_workers; i++)
+    {
+        Worker * worker = new Worker;
+
+        worker->am = this;
 
-    pthread_cond_init(&cond,0);
+        workers.push_back(worker);
+    }
 }
 
 /* -------------------------------------------------------------------------- */
 
 ActionManager::~ActionManager()
 {
-    pthread_mutex_destroy(&mutex);
+    std::vector<Worker *>::iterator it;
+
+    for (it = workers.begin(); it != workers.end(); ++it)
+    {
+        delete *it;
+    }
 
-    pthread_cond_destroy(&cond);
+    pthread_mutex_destroy(&pending_mutex);
 }
 
 /* ************************************************************************** */
@@ -43,13 +59,85 @@ ActionManager::~ActionManager()
 
 void ActionManager::trigger(const ActionRequest& ar )
 {
-    lock();
+    int oid = ar.object_id();
+
+    if ( coalesce && !add_pending(ar) )
+    {
+        return;
+    }
+
+    if ( trace_component != 0 && Tracer::enabled() && ar.trace_name() != 0 )
+    {
+        Tracer::event(oid, trace_component, std::string(ar.trace_name()) +
+                " queued");
+    }
+
+    if ( !workers.empty() && ar.type() == ActionRequest::USER && oid >= 0 )
+    {
+        workers[oid % workers.size()]->actions.push(ar);
+        return;
+    }
+
+    actions.push(ar);
+}
+
+/* -------------------------------------------------------------------------- */
+
+bool ActionManager::add_pending(const ActionRequest& ar)
+{
+    int key = ar.coalesce_key();
+    int oid = ar.object_id();
+
+    if ( key < 0 || oid < 0 )
+    {
+        return true;
+    }
+
+    pthread_mutex_lock(&pending_mutex);
+
+    bool rc = pending.insert(std::make_pair(key, oid)).second;
+
+    pthread_mutex_unlock(&pending_mutex);
+
+    return rc;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void ActionManager::del_pending(const ActionRequest& ar)
+{
+    int key = ar.coalesce_key();
+    int oid = ar.object_id();
+
+    if ( key < 0 || oid < 0 )
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&pending_mutex);
+
+    pending.erase(std::make_pair(key, oid));
+
+    pthread_mutex_unlock(&pending_mutex);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void ActionManager::do_action(const ActionRequest& ar)
+{
+    const char * name = ar.trace_name();
+
+    if ( trace_component == 0 || !Tracer::enabled() || name == 0 )
+    {
+        listener->_do_action(ar);
+        return;
+    }
 
-    actions.push(ar.clone());
+    unsigned long long start = Tracer::now();
 
-    pthread_cond_signal(&cond);
+    listener->_do_action(ar);
 
-    unlock();
+    Tracer::span(ar.object_id(), trace_component, name, start, Tracer::now());
 }
 
 /* -------------------------------------------------------------------------- */
@@ -80,48 +168,138 @@ void ActionManager::loop(struct timespec& _tout, const ActionRequest& trequest)
 
     set_timeout(timeout, _tout);
 
+    start_workers();
+
+    bool timed = _tout.tv_sec != 0 || _tout.tv_nsec != 0;
+
     //Action Loop, end when a finalize action is triggered to this manager
     while (finalize == 0)
     {
-        lock();
-
-        while ( actions.empty() == true )
+        // Process all the pending actions before waiting for new ones
+        while ( finalize == 0 && (action = actions.front()) != 0 )
         {
-            if ( _tout.tv_sec != 0 || _tout.tv_nsec != 0 )
+            if ( action->type() == ActionRequest::FINALIZE )
             {
-                rc = pthread_cond_timedwait(&cond, &mutex, &timeout);
+                stop_workers();
+            }
+            else if ( coalesce )
+            {
+                del_pending(*action);
+            }
+
+            do_action(*action);
 
-                if ( rc == ETIMEDOUT )
-                    actions.push(trequest.clone());
+            switch(action->type())
+            {
+                case ActionRequest::TIMER:
+                    set_timeout(timeout, _tout);
+                break;
+
+                case ActionRequest::FINALIZE:
+                    finalize = 1;
+                break;
+
+                default:
+                break;
             }
-            else
-                pthread_cond_wait(&cond,&mutex);
+
+            actions.pop();
+        }
+
+        if ( finalize != 0 )
+        {
+            break;
         }
 
-        action = actions.front();
-        actions.pop();
+        rc = actions.wait(timed ? &timeout : 0);
+
+        if ( rc == ETIMEDOUT )
+        {
+            actions.push(trequest);
+        }
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+/* ************************************************************************** */
+/* ActionManager workers                                                      */
+/* ************************************************************************** */
+
+extern "C" void * action_worker(void *arg)
+{
+    ActionManager::Worker * worker = static_cast<ActionManager::Worker *>(arg);
 
-        unlock();
+    worker->am->worker_loop(worker);
 
-        listener->_do_action(*action);
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
 
-        switch(action->type())
+void ActionManager::worker_loop(Worker * worker)
+{
+    ActionRequest * action;
+
+    while (true)
+    {
+        while ( (action = worker->actions.front()) != 0 )
         {
-            case ActionRequest::TIMER:
-                set_timeout(timeout, _tout);
-            break;
+            if ( action->type() == ActionRequest::FINALIZE )
+            {
+                worker->actions.pop();
+                return;
+            }
 
-            case ActionRequest::FINALIZE:
-                finalize = 1;
-            break;
+            if ( coalesce )
+            {
+                del_pending(*action);
+            }
 
-            default:
-            break;
+            do_action(*action);
+
+            worker->actions.pop();
         }
 
-        delete action;
+        worker->actions.wait(0);
     }
 }
 
 /* -------------------------------------------------------------------------- */
+
+void ActionManager::start_workers()
+{
+    pthread_attr_t pattr;
+
+    std::vector<Worker *>::iterator it;
+
+    pthread_attr_init(&pattr);
+    pthread_attr_setdetachstate(&pattr, PTHREAD_CREATE_JOINABLE);
+
+    for (it = workers.begin(); it != workers.end(); ++it)
+    {
+        pthread_create(&((*it)->thread_id), &pattr, action_worker,
+                static_cast<void *>(*it));
+    }
+
+    pthread_attr_destroy(&pattr);
+}
+
 /* -------------------------------------------------------------------------- */
+
+void ActionManager::stop_workers()
+{
+    std::vector<Worker *>::iterator it;
+
+    // FINALIZE goes after the pending actions of each worker
+    for (it = workers.begin(); it != workers.end(); ++it)
+    {
+        (*it)->actions.push(ActionRequest(ActionRequest::FINALIZE));
+    }
+
+    for (it = workers.begin(); it != workers.end(); ++it)
+    {
+        pthread_join((*it)->thread_id, 0);
+    }
+}
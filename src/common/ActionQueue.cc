@@ -0,0 +1,449 @@
+/* -------------------------------------------------------------------------- */
+/* Copyright 2002-2017, OpenNebula Project, OpenNebula Systems                */
+/*                                                                            */
+/* Licensed under the Apache License, Version 2.0 (the "License"); you may    */
+/* not use this file except in compliance with the License. You may obtain    */
+/* a copy of the License at                                                   */
+/*                                                                            */
+/* http://www.apache.org/licenses/LICENSE-2.0                                 */
+/*                                                                            */
+/* Unless required by applicable law or agreed to in writing, software        */
+/* distributed under the License is distributed on an "AS IS" BASIS,          */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   */
+/* See the License for the specific language governing permissions and        */
+/* limitations under the License.                                             */
+/* -------------------------------------------------------------------------- */
+
+#include "ActionQueue.h"
+#include "ActionManager.h"
+
+#include <errno.h>
+#include <sched.h>
+
+unsigned int ActionQueue::weights[] = {4, 1};
+
+/* -------------------------------------------------------------------------- */
+
+void ActionQueue::set_weights(unsigned int high, unsigned int low)
+{
+    weights[ActionRequest::HIGH] = high > 0 ? high : 1;
+    weights[ActionRequest::LOW]  = low  > 0 ? low  : 1;
+}
+
+/* ************************************************************************** */
+/* ActionQueue constructor & destructor                                       */
+/* ************************************************************************** */
+
+ActionQueue::ActionQueue(unsigned int capacity):current(0), current_lane(0),
+    current_overflow(false), lane(0), served(0), waiting(false)
+{
+    size_t size = 2;
+
+    while ( size < capacity )
+    {
+        size <<= 1;
+    }
+
+    for (unsigned int l = 0; l < LANES; l++)
+    {
+        lanes[l].cells = new Cell[size];
+        lanes[l].mask  = size - 1;
+
+        lanes[l].enqueue_pos   = 0;
+        lanes[l].dequeue_pos   = 0;
+        lanes[l].overflow_size = 0;
+
+        for (size_t i = 0; i < size; i++)
+        {
+            lanes[l].cells[i].sequence = i;
+            lanes[l].cells[i].action   = 0;
+            lanes[l].cells[i].in_place = false;
+        }
+    }
+
+    for (unsigned int i = 0; i < OBJECT_SLOTS; i++)
+    {
+        object_lanes[i] = 0;
+    }
+
+    pthread_mutex_init(&mutex, 0);
+
+    pthread_cond_init(&cond, 0);
+}
+
+/* -------------------------------------------------------------------------- */
+
+ActionQueue::~ActionQueue()
+{
+    for (unsigned int l = 0; l < LANES; l++)
+    {
+        bool in_overflow;
+
+        while ( (current = front(l, in_overflow)) != 0 )
+        {
+            current_lane     = l;
+            current_overflow = in_overflow;
+
+            pop();
+        }
+
+        delete[] lanes[l].cells;
+    }
+
+    pthread_mutex_destroy(&mutex);
+
+    pthread_cond_destroy(&cond);
+}
+
+/* ************************************************************************** */
+/* Producers                                                                  */
+/* ************************************************************************** */
+
+unsigned int ActionQueue::acquire_lane(const ActionRequest& ar)
+{
+    unsigned int l = ar.priority() % LANES;
+    int        oid = ar.object_id();
+
+    if ( oid < 0 )
+    {
+        return l;
+    }
+
+    unsigned int * slot = &object_lanes[oid % OBJECT_SLOTS];
+
+    unsigned int value = __atomic_load_n(slot, __ATOMIC_RELAXED);
+    unsigned int next;
+
+    do
+    {
+        if ( value < LANES ) //No pending actions, use the action priority
+        {
+            next = LANES + l;
+        }
+        else
+        {
+            next = value + LANES;
+        }
+    }
+    while (!__atomic_compare_exchange_n(slot, &value, next, true,
+                __ATOMIC_ACQ_REL, __ATOMIC_RELAXED));
+
+    return next % LANES;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void ActionQueue::release_lane(int oid)
+{
+    if ( oid < 0 )
+    {
+        return;
+    }
+
+    __atomic_sub_fetch(&object_lanes[oid % OBJECT_SLOTS], LANES,
+            __ATOMIC_ACQ_REL);
+}
+
+/* -------------------------------------------------------------------------- */
+
+bool ActionQueue::push_ring(Lane& l, const ActionRequest& ar)
+{
+    Cell * cell;
+    size_t pos = __atomic_load_n(&l.enqueue_pos, __ATOMIC_RELAXED);
+
+    while (true)
+    {
+        cell = &l.cells[pos & l.mask];
+
+        size_t   seq = __atomic_load_n(&(cell->sequence), __ATOMIC_ACQUIRE);
+        intptr_t dif = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+
+        if ( dif == 0 )
+        {
+            if ( __atomic_compare_exchange_n(&l.enqueue_pos, &pos, pos + 1,
+                    true, __ATOMIC_RELAXED, __ATOMIC_RELAXED) )
+            {
+                break;
+            }
+        }
+        else if ( dif < 0 )
+        {
+            return false;
+        }
+        else
+        {
+            pos = __atomic_load_n(&l.enqueue_pos, __ATOMIC_RELAXED);
+        }
+    }
+
+    cell->action = ar.clone(cell->storage.buffer, ACTION_SIZE);
+
+    if ( cell->action != 0 )
+    {
+        cell->in_place = true;
+    }
+    else
+    {
+        cell->action   = ar.clone();
+        cell->in_place = false;
+    }
+
+    __atomic_store_n(&(cell->sequence), pos + 1, __ATOMIC_SEQ_CST);
+
+    return true;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void ActionQueue::notify()
+{
+    // Only the first producer after the consumer starts waiting signals it
+    if ( __atomic_exchange_n(&waiting, false, __ATOMIC_SEQ_CST) )
+    {
+        pthread_mutex_lock(&mutex);
+
+        pthread_cond_signal(&cond);
+
+        pthread_mutex_unlock(&mutex);
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+void ActionQueue::push(const ActionRequest& ar)
+{
+    Lane& l = lanes[acquire_lane(ar)];
+
+    // Once the ring overflows, actions go to the overflow list till it is
+    // consumed to preserve the order. When the ring is full the producer
+    // yields to let the consumer catch up, the action may be triggered by the
+    // consumer itself so it cannot block.
+    for (int i = 0; i <= MAX_RETRIES; i++)
+    {
+        if ( __atomic_load_n(&l.overflow_size, __ATOMIC_SEQ_CST) != 0 )
+        {
+            break;
+        }
+
+        if ( push_ring(l, ar) )
+        {
+            notify();
+            return;
+        }
+
+        notify();
+
+        sched_yield();
+    }
+
+    pthread_mutex_lock(&mutex);
+
+    l.overflow.push(ar.clone());
+
+    __atomic_add_fetch(&l.overflow_size, 1, __ATOMIC_SEQ_CST);
+
+    pthread_cond_signal(&cond);
+
+    pthread_mutex_unlock(&mutex);
+}
+
+/* ************************************************************************** */
+/* Consumer                                                                   */
+/* ************************************************************************** */
+
+bool ActionQueue::empty(Lane& l)
+{
+    Cell * cell = &l.cells[l.dequeue_pos & l.mask];
+
+    return __atomic_load_n(&(cell->sequence), __ATOMIC_SEQ_CST) !=
+        l.dequeue_pos + 1 &&
+        __atomic_load_n(&l.overflow_size, __ATOMIC_SEQ_CST) == 0;
+}
+
+/* -------------------------------------------------------------------------- */
+
+bool ActionQueue::empty()
+{
+    if ( current != 0 )
+    {
+        return false;
+    }
+
+    for (unsigned int l = 0; l < LANES; l++)
+    {
+        if ( !empty(lanes[l]) )
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/* -------------------------------------------------------------------------- */
+
+ActionRequest * ActionQueue::front(unsigned int l, bool& in_overflow)
+{
+    ActionRequest * ar = 0;
+
+    Lane& ln    = lanes[l];
+    Cell * cell = &ln.cells[ln.dequeue_pos & ln.mask];
+
+    if ( __atomic_load_n(&(cell->sequence), __ATOMIC_SEQ_CST) ==
+            ln.dequeue_pos + 1 )
+    {
+        ar          = cell->action;
+        in_overflow = false;
+    }
+    else if ( __atomic_load_n(&ln.overflow_size, __ATOMIC_SEQ_CST) > 0 )
+    {
+        pthread_mutex_lock(&mutex);
+
+        ar          = ln.overflow.front();
+        in_overflow = true;
+
+        pthread_mutex_unlock(&mutex);
+    }
+
+    return ar;
+}
+
+/* -------------------------------------------------------------------------- */
+
+ActionRequest * ActionQueue::front()
+{
+    if ( current != 0 )
+    {
+        return current;
+    }
+
+    // Weighted round robin, a lane is skipped when it is empty or it has
+    // been served weight actions in this turn
+    for (unsigned int i = 0; i <= LANES; i++)
+    {
+        bool in_overflow;
+
+        if ( served >= weights[lane] )
+        {
+            lane   = (lane + 1) % LANES;
+            served = 0;
+        }
+
+        ActionRequest * ar = front(lane, in_overflow);
+
+        if ( ar != 0 && ar->type() == ActionRequest::FINALIZE )
+        {
+            for (unsigned int l = 0; l < LANES; l++)
+            {
+                if ( l != lane && !empty(lanes[l]) )
+                {
+                    ar = 0;
+                    break;
+                }
+            }
+        }
+
+        if ( ar != 0 )
+        {
+            current          = ar;
+            current_lane     = lane;
+            current_overflow = in_overflow;
+
+            served++;
+
+            return current;
+        }
+
+        lane   = (lane + 1) % LANES;
+        served = 0;
+    }
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void ActionQueue::free_action(Cell * cell)
+{
+    if ( cell->in_place )
+    {
+        cell->action->~ActionRequest();
+    }
+    else
+    {
+        delete cell->action;
+    }
+
+    cell->action = 0;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void ActionQueue::pop()
+{
+    if ( current == 0 )
+    {
+        return;
+    }
+
+    Lane& ln = lanes[current_lane];
+
+    int oid = current->object_id();
+
+    if ( current_overflow )
+    {
+        pthread_mutex_lock(&mutex);
+
+        ln.overflow.pop();
+
+        pthread_mutex_unlock(&mutex);
+
+        delete current;
+
+        __atomic_sub_fetch(&ln.overflow_size, 1, __ATOMIC_SEQ_CST);
+    }
+    else
+    {
+        Cell * cell = &ln.cells[ln.dequeue_pos & ln.mask];
+
+        free_action(cell);
+
+        __atomic_store_n(&(cell->sequence), ln.dequeue_pos + ln.mask + 1,
+                __ATOMIC_RELEASE);
+
+        ln.dequeue_pos++;
+    }
+
+    release_lane(oid);
+
+    current = 0;
+}
+
+/* -------------------------------------------------------------------------- */
+
+int ActionQueue::wait(const struct timespec * timeout)
+{
+    int rc = 0;
+
+    pthread_mutex_lock(&mutex);
+
+    __atomic_store_n(&waiting, true, __ATOMIC_SEQ_CST);
+
+    if ( empty() )
+    {
+        if ( timeout != 0 )
+        {
+            rc = pthread_cond_timedwait(&cond, &mutex, timeout);
+        }
+        else
+        {
+            pthread_cond_wait(&cond, &mutex);
+        }
+    }
+
+    __atomic_store_n(&waiting, false, __ATOMIC_SEQ_CST);
+
+    pthread_mutex_unlock(&mutex);
+
+    return rc;
+}
@@ -0,0 +1,152 @@
+/* -------------------------------------------------------------------------- */
+/* Copyright 2002-2017, OpenNebula Project, OpenNebula Systems                */
+/*                                                                            */
+/* Licensed under the Apache License, Version 2.0 (the "License"); you may    */
+/* not use this file except in compliance with the License. You may obtain    */
+/* a copy of the License at                                                   */
+/*                                                                            */
+/* http://www.apache.org/licenses/LICENSE-2.0                                 */
+/*                                                                            */
+/* Unless required by applicable law or agreed to in writing, software        */
+/* distributed under the License is distributed on an "AS IS" BASIS,          */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   */
+/* See the License for the specific language governing permissions and        */
+/* limitations under the License.                                             */
+/* -------------------------------------------------------------------------- */
+
+#include "LatencyHistogram.h"
+
+#include <math.h>
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+LatencyHistogram::LatencyHistogram():_count(0), _sum(0)
+{
+    for (unsigned int i = 0; i < BUCKETS; i++)
+    {
+        buckets[i] = 0;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+void LatencyHistogram::add(unsigned long long usec)
+{
+    unsigned int bucket = 0;
+
+    // Smallest bucket with usec <= 2^bucket
+    if ( usec > 1 )
+    {
+        bucket = 64 - __builtin_clzll(usec - 1);
+    }
+
+    if ( bucket >= BUCKETS )
+    {
+        bucket = BUCKETS - 1;
+    }
+
+    __atomic_fetch_add(&buckets[bucket], 1, __ATOMIC_RELAXED);
+
+    __atomic_fetch_add(&_sum, usec, __ATOMIC_RELAXED);
+
+    __atomic_fetch_add(&_count, 1, __ATOMIC_RELAXED);
+}
+
+/* -------------------------------------------------------------------------- */
+
+unsigned long long LatencyHistogram::percentile(double p) const
+{
+    unsigned long long total = 0;
+    unsigned long long values[BUCKETS];
+
+    for (unsigned int i = 0; i < BUCKETS; i++)
+    {
+        values[i] = __atomic_load_n(&buckets[i], __ATOMIC_RELAXED);
+
+        total += values[i];
+    }
+
+    if ( total == 0 )
+    {
+        return 0;
+    }
+
+    unsigned long long rank = static_cast<unsigned long long>(
+            ceil(p * total / 100));
+
+    unsigned long long acc = 0;
+
+    if ( rank == 0 )
+    {
+        rank = 1;
+    }
+
+    for (unsigned int i = 0; i < BUCKETS; i++)
+    {
+        acc += values[i];
+
+        if ( acc >= rank )
+        {
+            return bound(i);
+        }
+    }
+
+    return bound(BUCKETS - 1);
+}
+
+/* -------------------------------------------------------------------------- */
+
+unsigned long long LatencyHistogram::elapsed(const struct timespec& start)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    long long usec = (now.tv_sec - start.tv_sec) * 1000000LL +
+                     (now.tv_nsec - start.tv_nsec) / 1000;
+
+    return usec > 0 ? usec : 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void LatencyHistogram::to_xml(std::ostringstream& oss,
+        const std::string& name) const
+{
+    oss << "<" << name << ">"
+        << "<COUNT>" << count() << "</COUNT>"
+        << "<SUM>"   << sum()   << "</SUM>"
+        << "<P50>"   << percentile(50) << "</P50>"
+        << "<P90>"   << percentile(90) << "</P90>"
+        << "<P99>"   << percentile(99) << "</P99>"
+        << "</" << name << ">";
+}
+
+/* -------------------------------------------------------------------------- */
+
+void LatencyHistogram::to_prometheus(std::ostringstream& oss,
+        const std::string& metric, const std::string& labels) const
+{
+    unsigned long long acc = 0;
+
+    std::string sep = labels.empty() ? "" : ",";
+
+    for (unsigned int i = 0; i < BUCKETS - 1; i++)
+    {
+        acc += __atomic_load_n(&buckets[i], __ATOMIC_RELAXED);
+
+        oss << metric << "_bucket{" << labels << sep << "le=\""
+            << bound(i) / 1e6 << "\"} " << acc << "\n";
+    }
+
+    acc += __atomic_load_n(&buckets[BUCKETS - 1], __ATOMIC_RELAXED);
+
+    oss << metric << "_bucket{" << labels << sep << "le=\"+Inf\"} " << acc
+        << "\n";
+
+    oss << metric << "_sum{" << labels << "} " << sum() / 1e6 << "\n";
+
+    oss << metric << "_count{" << labels << "} " << acc << "\n";
+}
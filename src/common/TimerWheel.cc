@@ -0,0 +1,361 @@
+/* -------------------------------------------------------------------------- */
+/* Copyright 2002-2017, OpenNebula Project, OpenNebula Systems                */
+/*                                                                            */
+/* Licensed under the Apache License, Version 2.0 (the "License"); you may    */
+/* not use this file except in compliance with the License. You may obtain    */
+/* a copy of the License at                                                   */
+/*                                                                            */
+/* http://www.apache.org/licenses/LICENSE-2.0                                 */
+/*                                                                            */
+/* Unless required by applicable law or agreed to in writing, software        */
+/* distributed under the License is distributed on an "AS IS" BASIS,          */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   */
+/* See the License for the specific language governing permissions and        */
+/* limitations under the License.                                             */
+/* -------------------------------------------------------------------------- */
+
+#include "TimerWheel.h"
+
+/* ************************************************************************** */
+/* TimerWheel constructor & destructor                                        */
+/* ************************************************************************** */
+
+TimerWheel::TimerWheel():pending(0), current(0), started(false)
+{
+    for (unsigned int i = 0; i < LEVELS; i++)
+    {
+        for (unsigned int j = 0; j < SLOTS; j++)
+        {
+            init_list(&slots[i][j]);
+        }
+
+        counts[i] = 0;
+    }
+
+    init_list(&expired);
+
+    init_list(&waiting);
+
+    pthread_mutex_init(&mutex, 0);
+}
+
+/* -------------------------------------------------------------------------- */
+
+TimerWheel::~TimerWheel()
+{
+    pthread_mutex_destroy(&mutex);
+}
+
+/* ************************************************************************** */
+/* Timer lists                                                                */
+/* ************************************************************************** */
+
+void TimerWheel::init_list(Timer * head)
+{
+    head->id   = -1;
+    head->prev = head;
+    head->next = head;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void TimerWheel::link(Timer * head, Timer * timer)
+{
+    timer->prev = head->prev;
+    timer->next = head;
+
+    head->prev->next = timer;
+    head->prev       = timer;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void TimerWheel::unlink(Timer * timer)
+{
+    timer->prev->next = timer->next;
+    timer->next->prev = timer->prev;
+
+    timer->prev = timer;
+    timer->next = timer;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void TimerWheel::remove(Timer * timer)
+{
+    unlink(timer);
+
+    if ( timer->level >= 0 )
+    {
+        counts[timer->level]--;
+
+        pending--;
+    }
+}
+
+/* ************************************************************************** */
+/* Wheel operations                                                           */
+/* ************************************************************************** */
+
+void TimerWheel::add(Timer * timer)
+{
+    if ( !started )
+    {
+        timer->level = WAITING;
+
+        link(&waiting, timer);
+        return;
+    }
+
+    if ( timer->deadline < current )
+    {
+        timer->level = EXPIRED;
+
+        link(&expired, timer);
+        return;
+    }
+
+    time_t delta = timer->deadline - current;
+    time_t slot  = timer->deadline;
+    time_t span  = static_cast<time_t>(1) << (SLOT_BITS * LEVELS);
+
+    unsigned int level = 0;
+
+    while ( level < LEVELS - 1 &&
+            delta >= (static_cast<time_t>(1) << (SLOT_BITS * (level + 1))) )
+    {
+        level++;
+    }
+
+    // Beyond the wheel range, cascaded again when the last slot is reached
+    if ( delta >= span )
+    {
+        slot = current + span - 1;
+    }
+
+    slot = (slot >> (SLOT_BITS * level)) & SLOT_MASK;
+
+    timer->level = level;
+
+    link(&slots[level][slot], timer);
+
+    counts[level]++;
+
+    pending++;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void TimerWheel::cascade(unsigned int level)
+{
+    Timer * head = &slots[level][(current >> (SLOT_BITS * level)) & SLOT_MASK];
+
+    while ( head->next != head )
+    {
+        Timer * timer = head->next;
+
+        remove(timer);
+
+        add(timer);
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+void TimerWheel::tick()
+{
+    for (unsigned int level = LEVELS - 1; level > 0; level--)
+    {
+        time_t mask = (static_cast<time_t>(1) << (SLOT_BITS * level)) - 1;
+
+        if ( (current & mask) == 0 )
+        {
+            cascade(level);
+        }
+    }
+
+    Timer * head = &slots[0][current & SLOT_MASK];
+
+    while ( head->next != head )
+    {
+        Timer * timer = head->next;
+
+        remove(timer);
+
+        timer->level = EXPIRED;
+
+        link(&expired, timer);
+    }
+
+    current++;
+}
+
+/* ************************************************************************** */
+/* TimerWheel public interface                                                */
+/* ************************************************************************** */
+
+void TimerWheel::schedule(int id, time_t deadline)
+{
+    pthread_mutex_lock(&mutex);
+
+    std::pair<std::map<int, Timer>::iterator, bool> rc;
+
+    rc = timers.insert(std::make_pair(id, Timer()));
+
+    Timer * timer = &(rc.first->second);
+
+    if ( rc.second )
+    {
+        timer->id = id;
+    }
+    else
+    {
+        remove(timer);
+    }
+
+    timer->deadline = deadline;
+
+    add(timer);
+
+    pthread_mutex_unlock(&mutex);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void TimerWheel::cancel(int id)
+{
+    pthread_mutex_lock(&mutex);
+
+    std::map<int, Timer>::iterator it = timers.find(id);
+
+    if ( it != timers.end() )
+    {
+        remove(&(it->second));
+
+        timers.erase(it);
+    }
+
+    pthread_mutex_unlock(&mutex);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void TimerWheel::expire(time_t now, unsigned int limit, std::vector<int>& ids,
+        bool keep)
+{
+    pthread_mutex_lock(&mutex);
+
+    if ( !started )
+    {
+        started = true;
+        current = now + 1;
+
+        while ( waiting.next != &waiting )
+        {
+            Timer * timer = waiting.next;
+
+            unlink(timer);
+
+            add(timer);
+        }
+    }
+
+    while ( current <= now )
+    {
+        if ( pending == 0 )
+        {
+            current = now + 1;
+            break;
+        }
+
+        // Skip the ticks with no timers up to the next cascade of the lowest
+        // level with timers
+        unsigned int level = 0;
+
+        while ( counts[level] == 0 )
+        {
+            level++;
+        }
+
+        time_t mask = (static_cast<time_t>(1) << (SLOT_BITS * level)) - 1;
+
+        if ( (current & mask) != 0 )
+        {
+            current = (current | mask) + 1;
+
+            if ( current > now )
+            {
+                current = now + 1;
+            }
+
+            continue;
+        }
+
+        tick();
+    }
+
+    size_t num = timers.size() - pending;
+
+    for (size_t i = 0 ; i < num && i < limit ; i++)
+    {
+        Timer * timer = expired.next;
+
+        ids.push_back(timer->id);
+
+        unlink(timer);
+
+        if ( keep )
+        {
+            link(&expired, timer);
+        }
+        else
+        {
+            timers.erase(timer->id);
+        }
+    }
+
+    pthread_mutex_unlock(&mutex);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void TimerWheel::clear()
+{
+    pthread_mutex_lock(&mutex);
+
+    for (unsigned int i = 0; i < LEVELS; i++)
+    {
+        for (unsigned int j = 0; j < SLOTS; j++)
+        {
+            init_list(&slots[i][j]);
+        }
+
+        counts[i] = 0;
+    }
+
+    init_list(&expired);
+
+    init_list(&waiting);
+
+    timers.clear();
+
+    pending = 0;
+    started = false;
+
+    pthread_mutex_unlock(&mutex);
+}
+
+/* -------------------------------------------------------------------------- */
+
+size_t TimerWheel::size()
+{
+    size_t num;
+
+    pthread_mutex_lock(&mutex);
+
+    num = timers.size();
+
+    pthread_mutex_unlock(&mutex);
+
+    return num;
+}
@@ -0,0 +1,206 @@
+/* -------------------------------------------------------------------------- */
+/* Copyright 2002-2017, OpenNebula Project, OpenNebula Systems                */
+/*                                                                            */
+/* Licensed under the Apache License, Version 2.0 (the "License"); you may    */
+/* not use this file except in compliance with the License. You may obtain    */
+/* a copy of the License at                                                   */
+/*                                                                            */
+/* http://www.apache.org/licenses/LICENSE-2.0                                 */
+/*                                                                            */
+/* Unless required by applicable law or agreed to in writing, software        */
+/* distributed under the License is distributed on an "AS IS" BASIS,          */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   */
+/* See the License for the specific language governing permissions and        */
+/* limitations under the License.                                             */
+/* -------------------------------------------------------------------------- */
+
+#include "Tracer.h"
+
+#include <string.h>
+#include <time.h>
+
+#include <algorithm>
+#include <vector>
+
+Tracer::Span * Tracer::spans = 0;
+
+unsigned long long Tracer::mask = 0;
+
+unsigned long long Tracer::head = 0;
+
+unsigned long long Tracer::traces[Tracer::TRACE_SLOTS];
+
+unsigned int Tracer::next_trace = 0;
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void Tracer::init(unsigned int size)
+{
+    unsigned long long capacity = 1;
+
+    if ( size == 0 || spans != 0 )
+    {
+        return;
+    }
+
+    while ( capacity < size )
+    {
+        capacity <<= 1;
+    }
+
+    spans = new Span[capacity];
+
+    memset(spans, 0, capacity * sizeof(Span));
+
+    mask = capacity - 1;
+}
+
+/* -------------------------------------------------------------------------- */
+
+unsigned long long Tracer::now()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+
+    return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+unsigned int Tracer::start(int vm_id)
+{
+    if ( spans == 0 || vm_id < 0 )
+    {
+        return 0;
+    }
+
+    unsigned int id = __atomic_add_fetch(&next_trace, 1, __ATOMIC_RELAXED);
+
+    if ( id == 0 ) // 0 is reserved for spans without trace
+    {
+        id = __atomic_add_fetch(&next_trace, 1, __ATOMIC_RELAXED);
+    }
+
+    unsigned long long slot = (static_cast<unsigned long long>(vm_id) << 32) |
+        id;
+
+    __atomic_store_n(&traces[vm_id % TRACE_SLOTS], slot, __ATOMIC_RELAXED);
+
+    return id;
+}
+
+/* -------------------------------------------------------------------------- */
+
+unsigned int Tracer::current(int vm_id)
+{
+    if ( spans == 0 || vm_id < 0 )
+    {
+        return 0;
+    }
+
+    unsigned long long slot = __atomic_load_n(&traces[vm_id % TRACE_SLOTS],
+            __ATOMIC_RELAXED);
+
+    if ( (slot >> 32) != static_cast<unsigned long long>(vm_id) )
+    {
+        return 0;
+    }
+
+    return slot & 0xFFFFFFFF;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void Tracer::span(int vm_id, const char * component, const std::string& name,
+        unsigned long long start, unsigned long long end)
+{
+    if ( spans == 0 || vm_id < 0 )
+    {
+        return;
+    }
+
+    unsigned long long pos = __atomic_fetch_add(&head, 1, __ATOMIC_RELAXED);
+
+    Span * span = &spans[pos & mask];
+
+    __atomic_store_n(&span->seq, 0, __ATOMIC_RELAXED);
+
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    span->trace_id  = current(vm_id);
+    span->vm_id     = vm_id;
+    span->component = component;
+    span->start     = start;
+    span->end       = end;
+
+    strncpy(span->name, name.c_str(), NAME_SIZE);
+
+    span->name[NAME_SIZE] = '\0';
+
+    __atomic_store_n(&span->seq, pos + 1, __ATOMIC_RELEASE);
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void Tracer::to_xml(int vm_id, std::ostringstream& oss)
+{
+    typedef std::pair<unsigned long long, unsigned long long> SpanKey;
+
+    // Spans ordered by start time and then by the order they were recorded
+    std::vector<std::pair<SpanKey, std::string> > found;
+
+    oss << "<TRACE>";
+
+    for (unsigned long long i = 0; spans != 0 && i <= mask; i++)
+    {
+        Span copy;
+
+        unsigned long long seq = __atomic_load_n(&spans[i].seq,
+                __ATOMIC_ACQUIRE);
+
+        if ( seq == 0 || spans[i].vm_id != vm_id )
+        {
+            continue;
+        }
+
+        copy = spans[i];
+
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+        // Discard the span if it was overwritten while copying it
+        if ( __atomic_load_n(&spans[i].seq, __ATOMIC_RELAXED) != seq ||
+                copy.vm_id != vm_id )
+        {
+            continue;
+        }
+
+        copy.name[NAME_SIZE] = '\0';
+
+        std::ostringstream span_oss;
+
+        span_oss << "<SPAN>"
+            << "<TRACE_ID>"  << copy.trace_id  << "</TRACE_ID>"
+            << "<COMPONENT>" << copy.component << "</COMPONENT>"
+            << "<NAME>"      << copy.name      << "</NAME>"
+            << "<START>"     << copy.start     << "</START>"
+            << "<END>"       << copy.end       << "</END>"
+            << "<DURATION>"  << copy.end - copy.start << "</DURATION>"
+            << "</SPAN>";
+
+        found.push_back(make_pair(SpanKey(copy.start, seq), span_oss.str()));
+    }
+
+    std::sort(found.begin(), found.end());
+
+    for (size_t i = 0; i < found.size(); i++)
+    {
+        oss << found[i].second;
+    }
+
+    oss << "</TRACE>";
+}
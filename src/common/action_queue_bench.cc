@@ -0,0 +1,263 @@
+/* -------------------------------------------------------------------------- */
+/* Copyright 2002-2017, OpenNebula Project, OpenNebula Systems                */
+/*                                                                            */
+/* Licensed under the Apache License, Version 2.0 (the "License"); you may    */
+/* not use this file except in compliance with the License. You may obtain    */
+/* a copy of the License at                                                   */
+/*                                                                            */
+/* http://www.apache.org/licenses/LICENSE-2.0                                 */
+/*                                                                            */
+/* Unless required by applicable law or agreed to in writing, software        */
+/* distributed under the License is distributed on an "AS IS" BASIS,          */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   */
+/* See the License for the specific language governing permissions and        */
+/* limitations under the License.                                             */
+/* -------------------------------------------------------------------------- */
+
+/* -------------------------------------------------------------------------- */
+/* Microbenchmark of the ActionManager queues. N producer threads trigger     */
+/* actions that are consumed by a single thread, as in oned managers.         */
+/*                                                                            */
+/*   action_queue_bench [producers] [actions per producer]                    */
+/*                                                                            */
+/* Compares the ActionQueue with a std::queue protected by a mutex (previous  */
+/* ActionManager implementation).                                             */
+/* -------------------------------------------------------------------------- */
+
+#include "ActionManager.h"
+
+#include <stdlib.h>
+#include <sys/time.h>
+
+#include <iostream>
+#include <iomanip>
+#include <queue>
+#include <vector>
+
+using namespace std;
+
+class BenchAction : public ActionRequest
+{
+public:
+    BenchAction(int _id, long _seq):ActionRequest(ActionRequest::USER),
+        id(_id), seq(_seq){};
+
+    BenchAction(const BenchAction& o):ActionRequest(o._type), id(o.id),
+        seq(o.seq){};
+
+    ActionRequest * clone() const
+    {
+        return new BenchAction(*this);
+    }
+
+    ActionRequest * clone(void * buffer, size_t size) const
+    {
+        return clone_in(*this, buffer, size);
+    }
+
+    int  id;
+    long seq;
+};
+
+/* -------------------------------------------------------------------------- */
+/* Previous implementation: std::queue + mutex + condition variable           */
+/* -------------------------------------------------------------------------- */
+
+class LockedQueue
+{
+public:
+    LockedQueue()
+    {
+        pthread_mutex_init(&mutex, 0);
+        pthread_cond_init(&cond, 0);
+    };
+
+    void push(const ActionRequest& ar)
+    {
+        pthread_mutex_lock(&mutex);
+
+        actions.push(ar.clone());
+
+        pthread_cond_signal(&cond);
+
+        pthread_mutex_unlock(&mutex);
+    };
+
+    ActionRequest * pop()
+    {
+        ActionRequest * ar;
+
+        pthread_mutex_lock(&mutex);
+
+        while (actions.empty())
+        {
+            pthread_cond_wait(&cond, &mutex);
+        }
+
+        ar = actions.front();
+        actions.pop();
+
+        pthread_mutex_unlock(&mutex);
+
+        return ar;
+    };
+
+private:
+    queue<ActionRequest *> actions;
+
+    pthread_mutex_t mutex;
+    pthread_cond_t  cond;
+};
+
+/* -------------------------------------------------------------------------- */
+
+struct Bench
+{
+    LockedQueue * locked;
+    ActionQueue * lockfree;
+
+    int  producers;
+    long actions;
+
+    int  id;
+};
+
+static double now()
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, 0);
+
+    return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+extern "C" void * producer(void * arg)
+{
+    Bench * b = static_cast<Bench *>(arg);
+
+    for (long i = 0; i < b->actions; i++)
+    {
+        BenchAction ar(b->id, i);
+
+        if ( b->locked != 0 )
+        {
+            b->locked->push(ar);
+        }
+        else
+        {
+            b->lockfree->push(ar);
+        }
+    }
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+
+static double run(Bench& base, bool& ordered)
+{
+    vector<pthread_t> threads(base.producers);
+    vector<Bench>     args(base.producers, base);
+    vector<long>      last(base.producers, -1);
+
+    long total = base.producers * base.actions;
+
+    ordered = true;
+
+    double start = now();
+
+    for (int i = 0; i < base.producers; i++)
+    {
+        args[i].id = i;
+
+        pthread_create(&threads[i], 0, producer, &args[i]);
+    }
+
+    for (long i = 0; i < total; i++)
+    {
+        BenchAction * ar;
+
+        if ( base.locked != 0 )
+        {
+            ar = static_cast<BenchAction *>(base.locked->pop());
+        }
+        else
+        {
+            while ( (ar = static_cast<BenchAction *>(base.lockfree->front())) == 0)
+            {
+                base.lockfree->wait(0);
+            }
+        }
+
+        if ( ar->seq != last[ar->id] + 1 )
+        {
+            ordered = false;
+        }
+
+        last[ar->id] = ar->seq;
+
+        if ( base.locked != 0 )
+        {
+            delete ar;
+        }
+        else
+        {
+            base.lockfree->pop();
+        }
+    }
+
+    double elapsed = now() - start;
+
+    for (int i = 0; i < base.producers; i++)
+    {
+        pthread_join(threads[i], 0);
+    }
+
+    return elapsed;
+}
+
+/* -------------------------------------------------------------------------- */
+
+int main(int argc, char ** argv)
+{
+    Bench b;
+
+    b.producers = argc > 1 ? atoi(argv[1]) : 4;
+    b.actions   = argc > 2 ? atol(argv[2]) : 1000000;
+
+    if ( b.producers <= 0 || b.actions <= 0 )
+    {
+        cerr << "Usage: " << argv[0] << " [producers] [actions]" << endl;
+        return -1;
+    }
+
+    LockedQueue lq;
+    ActionQueue aq;
+
+    bool   ordered[2];
+    double elapsed[2];
+
+    b.locked   = &lq;
+    b.lockfree = 0;
+
+    elapsed[0] = run(b, ordered[0]);
+
+    b.locked   = 0;
+    b.lockfree = &aq;
+
+    elapsed[1] = run(b, ordered[1]);
+
+    long total = b.producers * b.actions;
+
+    cout << b.producers << " producers, " << total << " actions" << endl;
+
+    cout << fixed << setprecision(0);
+
+    cout << "  mutex queue:  " << total / elapsed[0] << " actions/s"
+         << (ordered[0] ? "" : " (OUT OF ORDER)") << endl;
+
+    cout << "  action queue: " << total / elapsed[1] << " actions/s"
+         << (ordered[1] ? "" : " (OUT OF ORDER)") << endl;
+
+    return (ordered[0] && ordered[1]) ? 0 : -1;
+}
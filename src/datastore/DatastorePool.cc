@@ -49,6 +49,8 @@ DatastorePool::DatastorePool(
 
     vector<const SingleAttribute *>::const_iterator it;
 
+    pthread_mutex_init(&cache_mutex, 0);
+
     for (it = _inherit_attrs.begin(); it != _inherit_attrs.end(); it++)
     {
         inherit_attrs.push_back((*it)->value());
@@ -267,6 +269,16 @@ int DatastorePool::drop(PoolObjectSQL * objsql, string& error_msg)
         error_msg = "SQL DB error";
         rc = -1;
     }
+    else
+    {
+        drop_cache_index(objsql);
+
+        pthread_mutex_lock(&cache_mutex);
+
+        type_cache.erase(datastore->get_oid());
+
+        pthread_mutex_unlock(&cache_mutex);
+    }
 
     return rc;
 }
@@ -274,6 +286,62 @@ int DatastorePool::drop(PoolObjectSQL * objsql, string& error_msg)
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
+int DatastorePool::update(PoolObjectSQL * objsql)
+{
+    int rc = PoolSQL::update(objsql);
+
+    if ( rc == 0 )
+    {
+        set_cache(static_cast<Datastore *>(objsql));
+    }
+
+    return rc;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+int DatastorePool::get_ds_type(int oid, Datastore::DatastoreType& type,
+        bool& shared)
+{
+    map<int, pair<Datastore::DatastoreType, bool> >::iterator it;
+
+    pthread_mutex_lock(&cache_mutex);
+
+    it = type_cache.find(oid);
+
+    if ( it != type_cache.end() )
+    {
+        type   = it->second.first;
+        shared = it->second.second;
+
+        pthread_mutex_unlock(&cache_mutex);
+
+        return 0;
+    }
+
+    pthread_mutex_unlock(&cache_mutex);
+
+    Datastore * ds = get(oid, true);
+
+    if ( ds == 0 )
+    {
+        return -1;
+    }
+
+    type   = ds->get_type();
+    shared = ds->is_shared();
+
+    set_cache(ds);
+
+    ds->unlock();
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
 int DatastorePool::disk_attribute(int ds_id, VirtualMachineDisk * disk)
 {
     Datastore * ds = get(ds_id, true);
@@ -112,3 +112,15 @@ void DispatchManager::init_managers()
     vrouterpool = nd.get_vrouterpool();
 }
 
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+const char * DMAction::trace_name() const
+{
+    static const char * names[] = {
+        "SUSPEND_SUCCESS", "STOP_SUCCESS", "UNDEPLOY_SUCCESS",
+        "POWEROFF_SUCCESS", "DONE", "RESUBMIT"
+    };
+
+    return names[_action];
+}
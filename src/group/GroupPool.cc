@@ -38,12 +38,20 @@ const int    GroupPool::USERS_ID      = 1;
 /* -------------------------------------------------------------------------- */
 
 GroupPool::GroupPool(SqlDB * db, vector<const VectorAttribute *> hook_mads,
-    const string& remotes_location, bool is_federation_slave) :
-        PoolSQL(db, Group::table, !is_federation_slave, true)
+    const string& remotes_location, bool is_federation_slave,
+    time_t quota_flush_period) :
+        PoolSQL(db, Group::table, !is_federation_slave, true),
+        quota_ledger(new GroupQuotaLedger(this, db, quota_flush_period))
 {
     ostringstream oss;
     string        error_str;
 
+    if ( quota_ledger->start() != 0 )
+    {
+        NebulaLog::log("GROUP", Log::ERROR, "Could not start the quota "
+            "ledger, group quotas will be written as they change");
+    }
+
     //Federation slaves do not need to init the pool
     if (is_federation_slave)
     {
@@ -97,6 +105,7 @@ error_groups:
 int GroupPool::allocate(string name, int * oid, string& error_str)
 {
     Group * group;
+    int     db_oid;
 
     ostringstream   oss;
 
@@ -116,9 +125,9 @@ int GroupPool::allocate(string name, int * oid, string& error_str)
     }
 
     // Check for duplicates
-    group = get(name, false);
+    db_oid = get_oid(name, -1);
 
-    if( group != 0 )
+    if( db_oid != -1 )
     {
         goto error_duplicated;
     }
@@ -132,7 +141,7 @@ int GroupPool::allocate(string name, int * oid, string& error_str)
     return *oid;
 
 error_duplicated:
-    oss << "NAME is already taken by GROUP " << group->get_oid() << ".";
+    oss << "NAME is already taken by GROUP " << db_oid << ".";
     error_str = oss.str();
 
 error_name:
@@ -161,14 +170,6 @@ int GroupPool::update(PoolObjectSQL * objsql)
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
-int GroupPool::update_quotas(Group * group)
-{
-    return group->update_quotas(db);
-}
-
-/* -------------------------------------------------------------------------- */
-/* -------------------------------------------------------------------------- */
-
 int GroupPool::drop(PoolObjectSQL * objsql, string& error_msg)
 {
     Group * group = static_cast<Group*>(objsql);
@@ -202,6 +203,8 @@ int GroupPool::drop(PoolObjectSQL * objsql, string& error_msg)
         return -3;
     }
 
+    quota_ledger->drop(group->get_oid());
+
     rc = group->drop(db);
 
     if( rc != 0 )
@@ -211,6 +214,8 @@ int GroupPool::drop(PoolObjectSQL * objsql, string& error_msg)
     }
     else
     {
+        drop_cache_index(objsql);
+
         do_hooks(objsql, Hook::REMOVE);
     }
 
@@ -227,6 +232,9 @@ int GroupPool::dump(ostringstream& oss, const string& where, const string& limit
 
     ostringstream cmd;
 
+    // Quotas are read from the DB, write the changes buffered by the ledger
+    quota_ledger->flush();
+
     cmd << "SELECT " << Group::table << ".body, "
         << GroupQuotas::db_table << ".body" << " FROM " << Group::table
         << " LEFT JOIN " << GroupQuotas::db_table << " ON "
@@ -20,6 +20,7 @@
 
 #include <stdexcept>
 #include <sstream>
+#include <algorithm>
 
 #include "Nebula.h"
 #include "HostPool.h"
@@ -40,8 +41,11 @@ HostPool::HostPool(SqlDB*                    db,
                    vector<const VectorAttribute *> hook_mads,
                    const string&             hook_location,
                    const string&             remotes_location,
-                   time_t                    expire_time)
-                        : PoolSQL(db, Host::table, true, true)
+                   time_t                    expire_time,
+                   time_t                    flush_period)
+                        : PoolSQL(db, Host::table, true, true),
+                        monitor_writer(0), monitor_store(0),
+                        monitor_wheel_loaded(false)
 {
 
     _monitor_expiration = expire_time;
@@ -50,6 +54,21 @@ HostPool::HostPool(SqlDB*                    db,
     {
         clean_all_monitoring();
     }
+    else if ( flush_period > 0 )
+    {
+        monitor_writer = new MonitorWriter(db, Host::monit_table,
+                Host::monit_db_names, flush_period);
+
+        if ( monitor_writer->start() != 0 )
+        {
+            NebulaLog::log("ONE", Log::ERROR, "Could not start the monitoring "
+                "writer, monitoring records will not be buffered");
+
+            delete monitor_writer;
+
+            monitor_writer = 0;
+        }
+    }
 
     // ------------------ Initialize Hooks for the pool ----------------------
     string name;
@@ -155,6 +174,7 @@ int HostPool::allocate (
     string& error_str)
 {
     Host *        host;
+    int           db_oid;
     ostringstream oss;
 
     if ( !PoolObjectSQL::name_is_valid(hostname, error_str) )
@@ -172,9 +192,9 @@ int HostPool::allocate (
         goto error_vmm;
     }
 
-    host = get(hostname,false);
+    db_oid = get_oid(hostname, -1);
 
-    if ( host !=0)
+    if ( db_oid != -1 )
     {
         goto error_duplicated;
     }
@@ -193,6 +213,11 @@ int HostPool::allocate (
 
     *oid = PoolSQL::allocate(host, error_str);
 
+    if ( *oid >= 0 )
+    {
+        monitor_wheel.schedule(*oid, 0);
+    }
+
     return *oid;
 
 error_im:
@@ -204,7 +229,7 @@ error_vmm:
     goto error_common;
 
 error_duplicated:
-    oss << "NAME is already taken by HOST " << host->get_oid() << ".";
+    oss << "NAME is already taken by HOST " << db_oid << ".";
     error_str = oss.str();
 
 error_name:
@@ -247,6 +272,31 @@ int HostPool::discover(
     ostringstream   sql;
     int             rc;
 
+    RaftManager * raftm = Nebula::instance().get_raftm();
+
+    // Followers do not update the pool, the schedule is only used by the
+    // leader (or solo) server
+    if ( raftm->is_leader() || raftm->is_solo() )
+    {
+        vector<int> oids;
+
+        if ( !monitor_wheel_loaded )
+        {
+            if ( load_monitor_wheel() != 0 )
+            {
+                return -1;
+            }
+        }
+
+        // Discovered hosts are kept in the wheel till they are updated, so
+        // hosts not updated are discovered again
+        monitor_wheel.expire(target_time, host_limit, oids, true);
+
+        discovered_hosts->insert(oids.begin(), oids.end());
+
+        return 0;
+    }
+
     set_callback(static_cast<Callbackable::Callback>(&HostPool::discover_cb),
                  static_cast<void *>(discovered_hosts));
 
@@ -261,15 +311,85 @@ int HostPool::discover(
     return rc;
 }
 
+/* -------------------------------------------------------------------------- */
+
+int HostPool::load_wheel_cb(void * _null, int num, char **values, char **names)
+{
+    if ( (num < 2) || (values[0] == 0) || (values[1] == 0) )
+    {
+        return -1;
+    }
+
+    monitor_wheel.schedule(atoi(values[0]), atol(values[1]));
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+
+int HostPool::load_monitor_wheel()
+{
+    ostringstream sql;
+    int           rc;
+
+    set_callback(static_cast<Callbackable::Callback>(&HostPool::load_wheel_cb));
+
+    sql << "SELECT oid, last_mon_time FROM " << Host::table
+        << " ORDER BY last_mon_time ASC";
+
+    rc = db->exec_rd(sql,this);
+
+    unset_callback();
+
+    if ( rc == 0 )
+    {
+        monitor_wheel_loaded = true;
+    }
+
+    return rc;
+}
+
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
 int HostPool::dump_monitoring(
         ostringstream& oss,
-        const string&  where)
+        const string&  where,
+        unsigned int   resolution)
 {
     ostringstream cmd;
 
+    if ( monitor_store != 0 )
+    {
+        vector<int> oids;
+        vector<int>::iterator it;
+
+        time_t start = 0;
+
+        // Rollup series keep their own retention, raw samples are filtered
+        // by the monitoring expiration time
+        if ( monitor_store->get_interval(resolution) == 0 )
+        {
+            start = time(0) - _monitor_expiration;
+        }
+
+        int rc = search(oids, where);
+
+        sort(oids.begin(), oids.end());
+
+        oss << "<MONITORING_DATA>";
+
+        for (it = oids.begin(); it != oids.end(); ++it)
+        {
+            monitor_store->to_xml(oss, *it, resolution, start, "HOST",
+                "LAST_MON_TIME");
+        }
+
+        oss << "</MONITORING_DATA>";
+
+        return rc;
+    }
+
     cmd << "SELECT " << Host::monit_table << ".body FROM " << Host::monit_table
         << " INNER JOIN " << Host::table
         << " WHERE hid = oid";
@@ -300,6 +420,13 @@ int HostPool::clean_expired_monitoring()
 
     max_mon_time = time(0) - _monitor_expiration;
 
+    if ( monitor_store != 0 )
+    {
+        monitor_store->expire(max_mon_time);
+
+        return 0;
+    }
+
     oss << "DELETE FROM " << Host::monit_table
         << " WHERE last_mon_time < " << max_mon_time;
 
@@ -322,3 +449,89 @@ int HostPool::clean_all_monitoring()
 
     return rc;
 }
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+const char * HostPool::monitor_metrics[] = {
+    "HOST_SHARE/MEM_USAGE",
+    "HOST_SHARE/CPU_USAGE",
+    "HOST_SHARE/TOTAL_MEM",
+    "HOST_SHARE/TOTAL_CPU",
+    "HOST_SHARE/MAX_MEM",
+    "HOST_SHARE/MAX_CPU",
+    "HOST_SHARE/FREE_MEM",
+    "HOST_SHARE/FREE_CPU",
+    "HOST_SHARE/USED_MEM",
+    "HOST_SHARE/USED_CPU",
+    "HOST_SHARE/RUNNING_VMS",
+    0
+};
+
+int HostPool::init_monitor_store(const string& file, unsigned int samples,
+        const vector<pair<unsigned int, unsigned int> >& rollups,
+        string& error_str)
+{
+    vector<string> metrics;
+
+    for (int i = 0; monitor_metrics[i] != 0; i++)
+    {
+        metrics.push_back(monitor_metrics[i]);
+    }
+
+    MonitorStore * store = new MonitorStore(file, metrics, samples, rollups);
+
+    if ( store->init(error_str) != 0 )
+    {
+        delete store;
+
+        return -1;
+    }
+
+    monitor_store = store;
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+int HostPool::update_monitoring(Host * host)
+{
+    if ( _monitor_expiration <= 0 )
+    {
+        return 0;
+    }
+
+    if ( monitor_store != 0 )
+    {
+        const vector<string>& metrics = monitor_store->get_metrics();
+        vector<double> values;
+
+        for (unsigned int i = 0; i < metrics.size(); i++)
+        {
+            const string& metric = metrics[i];
+            long long     value  = 0;
+
+            host->host_share.get_counter(metric.substr(metric.find('/')+1),
+                    value);
+
+            values.push_back(value);
+        }
+
+        return monitor_store->insert(host->get_oid(),
+                host->get_last_monitored(), values);
+    }
+
+    if ( monitor_writer != 0 )
+    {
+        string xml;
+
+        monitor_writer->insert(host->get_oid(), host->get_last_monitored(),
+                host->to_xml(xml));
+
+        return 0;
+    }
+
+    return host->update_monitoring(db);
+}
@@ -444,6 +444,48 @@ string& HostShare::to_xml(string& xml) const
 /* ------------------------------------------------------------------------ */
 /* ------------------------------------------------------------------------ */
 
+bool HostShare::get_counter(const string& name, long long& value) const
+{
+    if ( name == "DISK_USAGE" ) {
+        value = disk_usage;
+    } else if ( name == "MEM_USAGE" ) {
+        value = mem_usage;
+    } else if ( name == "CPU_USAGE" ) {
+        value = cpu_usage;
+    } else if ( name == "TOTAL_MEM" ) {
+        value = total_mem;
+    } else if ( name == "TOTAL_CPU" ) {
+        value = total_cpu;
+    } else if ( name == "MAX_DISK" ) {
+        value = max_disk;
+    } else if ( name == "MAX_MEM" ) {
+        value = max_mem;
+    } else if ( name == "MAX_CPU" ) {
+        value = max_cpu;
+    } else if ( name == "FREE_DISK" ) {
+        value = free_disk;
+    } else if ( name == "FREE_MEM" ) {
+        value = free_mem;
+    } else if ( name == "FREE_CPU" ) {
+        value = free_cpu;
+    } else if ( name == "USED_DISK" ) {
+        value = used_disk;
+    } else if ( name == "USED_MEM" ) {
+        value = used_mem;
+    } else if ( name == "USED_CPU" ) {
+        value = used_cpu;
+    } else if ( name == "RUNNING_VMS" ) {
+        value = running_vms;
+    } else {
+        return false;
+    }
+
+    return true;
+}
+
+/* ------------------------------------------------------------------------ */
+/* ------------------------------------------------------------------------ */
+
 int HostShare::from_xml_node(const xmlNodePtr node)
 {
     vector<xmlNodePtr> content;
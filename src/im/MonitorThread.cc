@@ -125,7 +125,6 @@ void MonitorThread::do_message()
     map<int, const VectorAttribute*>::iterator itm;
 
     Template    tmpl;
-    Datastore * ds;
 
     set<int>    non_shared_ds;
 
@@ -146,33 +145,26 @@ void MonitorThread::do_message()
         return;
     }
 
+    // Cluster and datastore metadata is served from the pool caches
     if (cid != -1)
     {
-        Cluster *cluster = cpool->get(cid, true);
-
-        if (cluster != 0)
-        {
-            cluster->get_reserved_capacity(reserved_cpu, reserved_mem);
-
-            cluster->unlock();
-        }
+        cpool->get_reserved_capacity(cid, reserved_cpu, reserved_mem);
     }
 
     for (itm = datastores.begin(); itm != datastores.end(); itm++)
     {
-        ds = dspool->get(itm->first, true);
+        Datastore::DatastoreType ds_type;
+        bool                     shared;
 
-        if (ds == 0)
+        if (dspool->get_ds_type(itm->first, ds_type, shared) != 0)
         {
             continue;
         }
 
-        if (ds->get_type() == Datastore::SYSTEM_DS && !ds->is_shared())
+        if (ds_type == Datastore::SYSTEM_DS && !shared)
         {
             non_shared_ds.insert(itm->first);
         }
-
-        ds->unlock();
     }
 
     // -------------------------------------------------------------------------
@@ -16,35 +16,85 @@
 
 #include "ListenerThread.h"
 
+#include <algorithm>
+
 #include <unistd.h>
+#include <limits.h>
+#include <errno.h>
+#include <string.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
 const size_t ListenerThread::MESSAGE_SIZE = 100000;
-const size_t ListenerThread::BUFFER_SIZE  = 100;
+const size_t ListenerThread::BATCH_SIZE   = 8;
+
+unsigned long long ListenerThread::sequence = 0;
 
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
-void ListenerThread::flush_buffer(int fd)
+void ListenerThread::add_message(const char * buffer, size_t size,
+        unsigned long long seq)
 {
-    lock();
+    // Messages are "MONITOR <RESULT> <HOST_ID> <DATA>", the host ID is the
+    // third word. Unknown messages are kept as they are.
+    std::string key;
 
-    std::vector<std::string>::iterator it;
+    size_t pos = 0;
 
-    for(it = monitor_data.begin() ; it != monitor_data.end(); ++it)
+    for (int i = 0; i < 2 && pos < size; i++)
     {
-        size_t size = (*it).size();
-        const char * message = (*it).c_str();
+        const char * sp = static_cast<const char *>(
+                memchr(buffer + pos, ' ', size - pos));
+
+        pos = sp == 0 ? size : sp - buffer + 1;
+    }
 
-        write(fd, message, size);
+    const char * end = static_cast<const char *>(
+            memchr(buffer + pos, ' ', size - pos));
+
+    if ( pos < size && end != 0 )
+    {
+        key.assign(buffer + pos, end - buffer - pos);
+    }
+    else
+    {
+        key.assign(buffer, size);
     }
 
-    monitor_data.clear();
+    Message& msg = monitor_data[key];
+
+    msg.seq = seq;
+    msg.data.assign(buffer, size);
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void ListenerThread::flush_buffer(std::map<std::string, Message>& messages)
+{
+    std::map<std::string, Message> data;
+    std::map<std::string, Message>::iterator it;
+
+    lock();
+
+    data.swap(monitor_data);
 
     unlock();
+
+    for(it = data.begin() ; it != data.end(); ++it)
+    {
+        Message& msg = messages[it->first];
+
+        if ( msg.data.empty() || msg.seq < it->second.seq )
+        {
+            msg.seq = it->second.seq;
+            msg.data.swap(it->second.data);
+        }
+    }
 }
 
 /* -------------------------------------------------------------------------- */
@@ -52,27 +102,69 @@ void ListenerThread::flush_buffer(int fd)
 
 void ListenerThread::monitor_loop()
 {
-    char   buffer[MESSAGE_SIZE];
-    size_t rc;
+    std::vector<char> buffer(BATCH_SIZE * MESSAGE_SIZE);
 
-    struct sockaddr addr;
-    socklen_t addr_size = sizeof(struct sockaddr);
+#ifdef MSG_WAITFORONE
+    struct mmsghdr msgs[BATCH_SIZE];
+    struct iovec   iovs[BATCH_SIZE];
+
+    for (size_t i = 0; i < BATCH_SIZE; i++)
+    {
+        iovs[i].iov_base = &buffer[i * MESSAGE_SIZE];
+        iovs[i].iov_len  = MESSAGE_SIZE;
+
+        memset(&msgs[i], 0, sizeof(struct mmsghdr));
+
+        msgs[i].msg_hdr.msg_iov    = &iovs[i];
+        msgs[i].msg_hdr.msg_iovlen = 1;
+    }
 
     while(true)
     {
-        rc = recvfrom(socket, buffer, MESSAGE_SIZE, 0, &addr, &addr_size);
+        // Block for the first message, then get the ones already queued
+        int rc = recvmmsg(socket, msgs, BATCH_SIZE, MSG_WAITFORONE, 0);
+
+        if (rc <= 0)
+        {
+            continue;
+        }
+
+        unsigned long long seq = __sync_fetch_and_add(&sequence, rc);
+
+        lock();
 
-        if (rc > 0 && rc < MESSAGE_SIZE)
+        for (int i = 0; i < rc; i++)
         {
-            std::string message(buffer, rc);
+            size_t size = msgs[i].msg_len;
+
+            if ( size > 0 && size < MESSAGE_SIZE &&
+                 (msgs[i].msg_hdr.msg_flags & MSG_TRUNC) == 0 )
+            {
+                add_message(&buffer[i * MESSAGE_SIZE], size, seq + i);
+            }
+        }
+
+        unlock();
+    }
+#else
+    ssize_t rc;
+
+    while(true)
+    {
+        rc = recv(socket, &buffer[0], MESSAGE_SIZE, 0);
+
+        if (rc > 0 && static_cast<size_t>(rc) < MESSAGE_SIZE)
+        {
+            unsigned long long seq = __sync_fetch_and_add(&sequence, 1);
 
             lock();
 
-            monitor_data.push_back(message);
+            add_message(&buffer[0], rc, seq);
 
             unlock();
         }
     }
+#endif
 }
 
 /* -------------------------------------------------------------------------- */
@@ -90,14 +182,28 @@ extern "C" void * listener_main(void *arg)
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
+ListenerPool::ListenerPool(int fd, const std::vector<int>& socks, size_t num)
+    :out_fd(fd), sockets(socks)
+{
+    for (size_t i = 0; i < num; i++)
+    {
+        listeners.push_back(new ListenerThread(sockets[i % sockets.size()]));
+    }
+};
+
+/* -------------------------------------------------------------------------- */
+
 ListenerPool::~ListenerPool()
 {
-    std::vector<ListenerThread>::iterator it;
+    std::vector<ListenerThread *>::iterator it;
 
     for(it = listeners.begin() ; it != listeners.end(); ++it)
     {
-        pthread_cancel((*it).thread_id());
+        pthread_cancel((*it)->thread_id());
     }
+
+    // Threads are detached, so listeners are not freed as they may be still
+    // running
 };
 
 /* -------------------------------------------------------------------------- */
@@ -108,16 +214,16 @@ void ListenerPool::start_pool()
     pthread_attr_t attr;
     pthread_t id;
 
-    std::vector<ListenerThread>::iterator it;
+    std::vector<ListenerThread *>::iterator it;
 
     pthread_attr_init(&attr);
     pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
 
     for(it = listeners.begin() ; it != listeners.end(); ++it)
     {
-        pthread_create(&id, &attr, listener_main, (void *)&(*it));
+        pthread_create(&id, &attr, listener_main, (void *)(*it));
 
-        (*it).thread_id(id);
+        (*it)->thread_id(id);
     }
 
     pthread_attr_destroy(&attr);
@@ -128,10 +234,60 @@ void ListenerPool::start_pool()
 
 void ListenerPool::flush_pool()
 {
-    std::vector<ListenerThread>::iterator it;
+    std::map<std::string, ListenerThread::Message> messages;
+    std::map<std::string, ListenerThread::Message>::iterator jt;
+
+    std::vector<ListenerThread *>::iterator it;
+    std::vector<struct iovec> iovs;
 
     for(it = listeners.begin() ; it != listeners.end(); ++it)
     {
-        (*it).flush_buffer(out_fd);
+        (*it)->flush_buffer(messages);
+    }
+
+    for(jt = messages.begin() ; jt != messages.end(); ++jt)
+    {
+        struct iovec iov;
+
+        iov.iov_base = const_cast<char *>(jt->second.data.data());
+        iov.iov_len  = jt->second.data.size();
+
+        iovs.push_back(iov);
+    }
+
+    // Write all the messages, in chunks of IOV_MAX, resuming partial writes
+    size_t first = 0;
+
+    while ( first < iovs.size() )
+    {
+        size_t  num = std::min(iovs.size() - first, (size_t) IOV_MAX);
+        ssize_t rc  = writev(out_fd, &iovs[first], num);
+
+        if ( rc < 0 )
+        {
+            if ( errno == EINTR || errno == EAGAIN )
+            {
+                continue;
+            }
+
+            break;
+        }
+
+        while ( rc > 0 && first < iovs.size() )
+        {
+            if ( static_cast<size_t>(rc) >= iovs[first].iov_len )
+            {
+                rc -= iovs[first].iov_len;
+                first++;
+            }
+            else
+            {
+                iovs[first].iov_base = static_cast<char *>(
+                        iovs[first].iov_base) + rc;
+                iovs[first].iov_len -= rc;
+
+                rc = 0;
+            }
+        }
     }
 }
@@ -16,29 +16,39 @@
 
 #include <string>
 #include <vector>
+#include <map>
 
 #include <pthread.h>
 
 /**
  *  This class implements a listener thread for the IM collector. It receives
- *  messages from a UDP port and stores it in a BUFFER. The class is controlled
- *  by two parameters
- *    - BUFFER_SIZE the number of pre-allocated capacity to store monitor
- *      messages. It should be roughly equal to the number of hosts per thread
+ *  messages from a UDP port and stores it in a BUFFER. Messages are received
+ *  in batches, and only the last message of each host is kept until the next
+ *  flush. The class is controlled by these parameters
  *    - MESSAGE_SIZE the size of each monitor message (100K by default). Each VM
  *      needs ~100bytes so ~1000VMs per host
+ *    - BATCH_SIZE the number of messages read from the socket in one call
  */
 class ListenerThread
 {
 public:
+    /**
+     *  Monitor message, with its arrival sequence to keep the last one of
+     *  each host when merging the buffers of the listeners
+     */
+    struct Message
+    {
+        unsigned long long seq;
+
+        std::string data;
+    };
+
     /**
      *  @param _socket descriptor to listen for messages
      */
     ListenerThread(int _socket):socket(_socket)
     {
         pthread_mutex_init(&mutex,0);
-
-        monitor_data.reserve(BUFFER_SIZE);
     };
 
     ~ListenerThread()
@@ -47,11 +57,11 @@ public:
     };
 
     /**
-     *  Write the contents of the message buffer to a descriptor. Buffer is
-     *  cleared
-     *    @param fd file descriptor to send monitor data.
+     *  Moves the contents of the message buffer to the given map, keeping the
+     *  last message of each host. Buffer is cleared
+     *    @param messages indexed by host
      */
-    void flush_buffer(int fd);
+    void flush_buffer(std::map<std::string, Message>& messages);
 
     /**
      *  Waits for UDP messages in a loop and store them in a buffer
@@ -76,15 +86,29 @@ public:
 
 private:
     static const size_t MESSAGE_SIZE; /**< Monitor message size */
-    static const size_t BUFFER_SIZE;  /**< Pre-allocated capacoty */
+    static const size_t BATCH_SIZE;   /**< Messages per receive call */
 
     pthread_mutex_t mutex;
     pthread_t       _thread_id;
 
-    std::vector<std::string> monitor_data;
+    /**
+     *  Last message of each host, indexed by the host ID
+     */
+    std::map<std::string, Message> monitor_data;
 
     int socket;
 
+    /**
+     *  Arrival sequence of the messages, shared by all the listeners
+     */
+    static unsigned long long sequence;
+
+    /**
+     *  Adds a message to the buffer, replacing the previous message of the
+     *  same host. The mutex SHOULD be locked.
+     */
+    void add_message(const char * buffer, size_t size, unsigned long long seq);
+
     void lock()
     {
         pthread_mutex_lock(&mutex);
@@ -113,21 +137,26 @@ class ListenerPool
 public:
     /**
      *  @param fd descriptor to flush the data
-     *  @param sock socket for the UDP connections
+     *  @param socks sockets for the UDP connections, the threads are evenly
+     *  distributed among them
      *  @param num number of threads in the pool
      */
-    ListenerPool(int fd, int sock, size_t num)
-        :listeners(num, ListenerThread(sock)), out_fd(fd), socket(sock){};
+    ListenerPool(int fd, const std::vector<int>& socks, size_t num);
 
     ~ListenerPool();
 
     void start_pool();
 
+    /**
+     *  Writes the last message of each host received by the listeners to the
+     *  output descriptor, in a single vectored write
+     */
     void flush_pool();
 
 private:
-    std::vector<ListenerThread> listeners;
+    std::vector<ListenerThread *> listeners;
 
     int out_fd;
-    int socket;
+
+    std::vector<int> sockets;
 };
@@ -25,9 +25,13 @@
 #include <errno.h>
 #include <string.h>
 
+#include <vector>
+
 #include "OpenNebulaDriver.h"
 #include "ListenerThread.h"
 
+const int IMCollectorDriver::RCVBUF_SIZE = 16 * 1024 * 1024;
+
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
@@ -117,15 +121,7 @@ void OpenNebulaDriver::driver_loop()
 int IMCollectorDriver::init_collector()
 {
     struct sockaddr_in im_server;
-    int rc;
-
-    int sock = socket(PF_INET, SOCK_DGRAM, IPPROTO_UDP);
-
-    if ( sock < 0 )
-    {
-        std::cerr << strerror(errno);
-        return -1;
-    }
+    std::vector<int>   socks;
 
     im_server.sin_family = AF_INET;
     im_server.sin_port   = htons(_port);
@@ -140,15 +136,67 @@ int IMCollectorDriver::init_collector()
         return -1;
     }
 
-    rc = bind(sock, (struct sockaddr *) &im_server, sizeof(struct sockaddr_in));
+    // With SO_REUSEPORT a socket is opened for each core (up to the number of
+    // threads) and the kernel balances the hosts among them. Otherwise all the
+    // threads share a single socket.
+    long num_socks = sysconf(_SC_NPROCESSORS_ONLN);
 
-    if ( rc < 0 )
+    if ( num_socks < 1 )
     {
-        std::cerr << strerror(errno);
-        return -1;
+        num_socks = 1;
+    }
+    else if ( num_socks > _threads )
+    {
+        num_socks = _threads;
+    }
+
+    for (long i = 0; i < num_socks; i++)
+    {
+        int sock = socket(PF_INET, SOCK_DGRAM, IPPROTO_UDP);
+
+        if ( sock < 0 )
+        {
+            std::cerr << strerror(errno);
+            return -1;
+        }
+
+        bool reuse = false;
+
+#ifdef SO_REUSEPORT
+        int on = 1;
+
+        reuse = setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, &on,
+                sizeof(on)) == 0;
+#endif
+        int rcvbuf = RCVBUF_SIZE;
+
+        setsockopt(sock, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+        int rc = bind(sock, (struct sockaddr *) &im_server,
+                sizeof(struct sockaddr_in));
+
+        if ( rc < 0 )
+        {
+            close(sock);
+
+            if ( !socks.empty() ) // Use the sockets already bound
+            {
+                break;
+            }
+
+            std::cerr << strerror(errno);
+            return -1;
+        }
+
+        socks.push_back(sock);
+
+        if ( !reuse )
+        {
+            break;
+        }
     }
 
-    pool = new ListenerPool(1, sock, _threads);
+    pool = new ListenerPool(1, socks, _threads);
 
     return 0;
 }
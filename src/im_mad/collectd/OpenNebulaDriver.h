@@ -103,6 +103,12 @@ private:
     int _flush_period;
 
     ListenerPool *pool;
+
+    /**
+     *  Receive buffer requested for the UDP sockets, so bursts of messages
+     *  are not dropped between batches (capped by net.core.rmem_max)
+     */
+    static const int RCVBUF_SIZE;
 };
 
 #endif
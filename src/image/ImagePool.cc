@@ -98,7 +98,7 @@ int ImagePool::allocate (
     ImageManager *  imagem = nd.get_imagem();
 
     Image *         img;
-    Image *         img_aux = 0;
+    int             img_aux = -1;
     string          name;
     string          type;
     string          fs_type;
@@ -142,9 +142,9 @@ int ImagePool::allocate (
         break;
     }
 
-    img_aux = get(name,uid,false);
+    img_aux = get_oid(name, uid);
 
-    if( img_aux != 0 )
+    if( img_aux != -1 )
     {
         goto error_duplicated;
     }
@@ -272,7 +272,7 @@ error_types_missmatch_image:
     goto error_common;
 
 error_duplicated:
-    oss << "NAME is already taken by IMAGE " << img_aux->get_oid() << ".";
+    oss << "NAME is already taken by IMAGE " << img_aux << ".";
     error_str = oss.str();
 
     goto error_common;
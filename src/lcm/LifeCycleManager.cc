@@ -287,3 +287,37 @@ void LifeCycleManager::user_action(const ActionRequest& ar)
 
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+const char * LCMAction::trace_name() const
+{
+    static const char * names[] = {
+        "NONE", "SAVE_SUCCESS", "SAVE_FAILURE", "DEPLOY_SUCCESS",
+        "DEPLOY_FAILURE", "SHUTDOWN_SUCCESS", "SHUTDOWN_FAILURE",
+        "CANCEL_SUCCESS", "CANCEL_FAILURE", "MONITOR_SUSPEND", "MONITOR_DONE",
+        "MONITOR_POWEROFF", "MONITOR_POWERON", "PROLOG_SUCCESS",
+        "PROLOG_FAILURE", "EPILOG_SUCCESS", "EPILOG_FAILURE", "ATTACH_SUCCESS",
+        "ATTACH_FAILURE", "DETACH_SUCCESS", "DETACH_FAILURE",
+        "ATTACH_NIC_SUCCESS", "ATTACH_NIC_FAILURE", "DETACH_NIC_SUCCESS",
+        "DETACH_NIC_FAILURE", "CLEANUP_SUCCESS", "CLEANUP_FAILURE",
+        "SAVEAS_SUCCESS", "SAVEAS_FAILURE", "SNAPSHOT_CREATE_SUCCESS",
+        "SNAPSHOT_CREATE_FAILURE", "SNAPSHOT_REVERT_SUCCESS",
+        "SNAPSHOT_REVERT_FAILURE", "SNAPSHOT_DELETE_SUCCESS",
+        "SNAPSHOT_DELETE_FAILURE", "DISK_SNAPSHOT_SUCCESS",
+        "DISK_SNAPSHOT_FAILURE", "DEPLOY", "SUSPEND", "RESTORE", "STOP",
+        "CANCEL", "MIGRATE", "LIVE_MIGRATE", "SHUTDOWN", "UNDEPLOY",
+        "UNDEPLOY_HARD", "POWEROFF", "POWEROFF_HARD", "RESTART", "DELETE",
+        "DELETE_RECREATE", "UPDATESG", "DISK_LOCK_SUCCESS", "DISK_LOCK_FAILURE",
+        "DISK_RESIZE_SUCCESS", "DISK_RESIZE_FAILURE"
+    };
+
+    // Security group updates are not bound to a VM
+    if ( _action == UPDATESG )
+    {
+        return 0;
+    }
+
+    return names[_action];
+}
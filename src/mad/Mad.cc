@@ -40,6 +40,8 @@ Mad::~Mad()
     int     status;
     pid_t   rp;
 
+    pthread_mutex_destroy(&write_mutex);
+
     if ( pid==-1)
     {
         return;
@@ -20,6 +20,7 @@
 #include "SqliteDB.h"
 #include "MySqlDB.h"
 #include "Client.h"
+#include "Tracer.h"
 
 #include <stdlib.h>
 #include <stdexcept>
@@ -485,11 +486,42 @@ void Nebula::start(bool bootstrap_only)
     nebula_configuration->get("MANAGER_TIMER", timer_period);
     nebula_configuration->get("MONITORING_INTERVAL", monitor_period);
 
+    // ---- Priority weights of the manager actions ----
+    {
+        unsigned int high_weight = 4;
+        unsigned int low_weight  = 1;
+
+        const VectorAttribute * action_priority;
+
+        action_priority = nebula_configuration->get("ACTION_PRIORITY");
+
+        if ( action_priority != 0 )
+        {
+            action_priority->vector_value("HIGH", high_weight);
+            action_priority->vector_value("LOW", low_weight);
+        }
+
+        ActionQueue::set_weights(high_weight, low_weight);
+    }
+
+    // ---- Operation traces ----
+    {
+        unsigned int trace_buffer = 0;
+
+        nebula_configuration->get("TRACE_BUFFER", trace_buffer);
+
+        Tracer::init(trace_buffer);
+    }
+
     // ---- ACL Manager ----
     try
     {
+        bool acl_index;
+
+        nebula_configuration->get("ACL_INDEX", acl_index);
+
         aclm = new AclManager(db_ptr, zone_id, is_federation_slave(),
-                timer_period);
+                timer_period, acl_index);
     }
     catch (bad_alloc&)
     {
@@ -522,6 +554,8 @@ void Nebula::start(bool bootstrap_only)
         time_t vm_expiration;
         bool   vm_submit_on_hold;
 
+        time_t monitoring_flush;
+
         float cpu_cost;
         float mem_cost;
         float disk_cost;
@@ -534,6 +568,8 @@ void Nebula::start(bool bootstrap_only)
 
         nebula_configuration->get("VM_MONITORING_EXPIRATION_TIME",vm_expiration);
 
+        nebula_configuration->get("MONITORING_FLUSH_INTERVAL",monitoring_flush);
+
         nebula_configuration->get("VM_SUBMIT_ON_HOLD",vm_submit_on_hold);
 
         default_cost = nebula_configuration->get("DEFAULT_COST");
@@ -555,7 +591,7 @@ void Nebula::start(bool bootstrap_only)
 
         vmpool = new VirtualMachinePool(logdb, vm_hooks, hook_location,
             remotes_location, vm_restricted_attrs, vm_expiration,
-            vm_submit_on_hold, cpu_cost, mem_cost, disk_cost);
+            monitoring_flush, vm_submit_on_hold, cpu_cost, mem_cost, disk_cost);
 
         /* ---------------------------- Host Pool --------------------------- */
         vector<const VectorAttribute *> host_hooks;
@@ -568,7 +604,70 @@ void Nebula::start(bool bootstrap_only)
                 host_expiration);
 
         hpool  = new HostPool(logdb, host_hooks, hook_location, remotes_location,
-            host_expiration);
+            host_expiration, monitoring_flush);
+
+        /* ------------------------ Monitoring Store ------------------------ */
+        const VectorAttribute * mon_store;
+        string mon_backend;
+
+        mon_store = nebula_configuration->get("MONITORING_STORE");
+
+        if ( mon_store != 0 )
+        {
+            mon_backend = mon_store->vector_value("BACKEND");
+
+            one_util::toupper(mon_backend);
+        }
+
+        if ( mon_backend == "MMAP" )
+        {
+            unsigned int host_samples;
+            unsigned int vm_samples;
+
+            string error_str;
+
+            vector<pair<unsigned int, unsigned int> > rollups;
+            vector<string>::iterator it;
+
+            mon_store->vector_value("HOST_SAMPLES", host_samples);
+            mon_store->vector_value("VM_SAMPLES", vm_samples);
+
+            // ROLLUPS = "interval:samples,interval:samples,..."
+            vector<string> rollup_str = one_util::split(
+                    mon_store->vector_value("ROLLUPS"), ',');
+
+            for (it = rollup_str.begin(); it != rollup_str.end(); ++it)
+            {
+                unsigned int interval, samples;
+                char         sep;
+
+                istringstream iss(*it);
+
+                iss >> interval >> sep >> samples;
+
+                if ( iss.fail() || sep != ':' || interval == 0 || samples == 0 )
+                {
+                    throw runtime_error("Wrong rollup in MONITORING_STORE: "
+                            + *it);
+                }
+
+                rollups.push_back(make_pair(interval, samples));
+            }
+
+            if ( host_expiration != 0 && hpool->init_monitor_store(
+                    var_location + "host_monitoring.mon", host_samples,
+                    rollups, error_str) != 0 )
+            {
+                throw runtime_error(error_str);
+            }
+
+            if ( vm_expiration != 0 && vmpool->init_monitor_store(
+                    var_location + "vm_monitoring.mon", vm_samples, rollups,
+                    error_str) != 0 )
+            {
+                throw runtime_error(error_str);
+            }
+        }
 
         /* --------------------- VirtualRouter Pool ------------------------- */
         vector<const VectorAttribute *> vrouter_hooks;
@@ -612,18 +711,34 @@ void Nebula::start(bool bootstrap_only)
         vector<const VectorAttribute *> group_hooks;
 
         time_t  expiration_time;
+        time_t  quota_flush;
+
+        nebula_configuration->get("QUOTA_FLUSH_INTERVAL", quota_flush);
+
+        if ( federation_enabled )
+        {
+            // Quotas are shared by the zones, load them for every change
+            quota_flush = -1;
+        }
+        else if ( quota_flush > 0 && !solo )
+        {
+            NebulaLog::log("ONE", Log::WARNING, "QUOTA_FLUSH_INTERVAL is not "
+                "supported in HA mode, quotas will be written as they change");
+
+            quota_flush = 0;
+        }
 
         nebula_configuration->get("GROUP_HOOK", group_hooks);
 
         gpool = new GroupPool(db_ptr, group_hooks, remotes_location,
-                is_federation_slave());
+                is_federation_slave(), quota_flush);
 
         nebula_configuration->get("SESSION_EXPIRATION_TIME", expiration_time);
 
         nebula_configuration->get("USER_HOOK", user_hooks);
 
         upool = new UserPool(db_ptr, expiration_time, user_hooks,
-                remotes_location, is_federation_slave());
+                remotes_location, is_federation_slave(), quota_flush);
 
         /* -------------------- Image/Datastore Pool ------------------------ */
         string  image_type;
@@ -669,6 +784,8 @@ void Nebula::start(bool bootstrap_only)
 
         default_user_quota.select();
         default_group_quota.select();
+
+        set_pool_indexes(solo);
     }
     catch (exception&)
     {
@@ -764,6 +881,26 @@ void Nebula::start(bool bootstrap_only)
        throw runtime_error("Could not start the Federation Replica Manager");
     }
 
+    // ---- Action workers of the VM managers ----
+    unsigned int vmm_workers;
+    unsigned int lcm_workers;
+    unsigned int tm_workers;
+    unsigned int dm_workers;
+
+    const VectorAttribute * action_workers;
+
+    vmm_workers = lcm_workers = tm_workers = dm_workers = 1;
+
+    action_workers = nebula_configuration->get("ACTION_WORKERS");
+
+    if ( action_workers != 0 )
+    {
+        action_workers->vector_value("VMM", vmm_workers);
+        action_workers->vector_value("LCM", lcm_workers);
+        action_workers->vector_value("TM", tm_workers);
+        action_workers->vector_value("DM", dm_workers);
+    }
+
     // ---- Virtual Machine Manager ----
     try
     {
@@ -786,7 +923,8 @@ void Nebula::start(bool bootstrap_only)
             poll_period,
             do_poll,
             vm_limit,
-            vmm_mads);
+            vmm_mads,
+            vmm_workers);
     }
     catch (bad_alloc&)
     {
@@ -803,7 +941,7 @@ void Nebula::start(bool bootstrap_only)
     // ---- Life-cycle Manager ----
     try
     {
-        lcm = new LifeCycleManager();
+        lcm = new LifeCycleManager(lcm_workers);
     }
     catch (bad_alloc&)
     {
@@ -859,7 +997,7 @@ void Nebula::start(bool bootstrap_only)
 
         nebula_configuration->get("TM_MAD", tm_mads);
 
-        tm = new TransferManager(vmpool, hpool, tm_mads);
+        tm = new TransferManager(vmpool, hpool, tm_mads, tm_workers);
     }
     catch (bad_alloc&)
     {
@@ -876,7 +1014,7 @@ void Nebula::start(bool bootstrap_only)
     // ---- Dispatch Manager ----
     try
     {
-        dm = new DispatchManager();
+        dm = new DispatchManager(dm_workers);
     }
     catch (bad_alloc&)
     {
@@ -1047,8 +1185,19 @@ void Nebula::start(bool bootstrap_only)
         string log_call_format;
         string rpc_filename = "";
         int  message_size;
+        int  metrics_port;
         string rm_listen_address = "0.0.0.0";
 
+        const VectorAttribute * rpc_sched;
+
+        unsigned int rs_workers    = 0;
+        unsigned int rs_queue_size = 64;
+        time_t       rs_queue_timeout = 5;
+        string       rs_limits_str;
+        string       error_str;
+
+        map<string, unsigned int> rs_limits;
+
         nebula_configuration->get("PORT", rm_port);
         nebula_configuration->get("LISTEN_ADDRESS", rm_listen_address);
         nebula_configuration->get("MAX_CONN", max_conn);
@@ -1059,15 +1208,36 @@ void Nebula::start(bool bootstrap_only)
         nebula_configuration->get("RPC_LOG", rpc_log);
         nebula_configuration->get("LOG_CALL_FORMAT", log_call_format);
         nebula_configuration->get("MESSAGE_SIZE", message_size);
+        nebula_configuration->get("METRICS_PORT", metrics_port);
 
         if (rpc_log)
         {
             rpc_filename = log_location + "one_xmlrpc.log";
         }
 
+        rpc_sched = nebula_configuration->get("RPC_SCHEDULER");
+
+        if ( rpc_sched != 0 )
+        {
+            rpc_sched->vector_value("WORKERS", rs_workers);
+            rpc_sched->vector_value("QUEUE_SIZE", rs_queue_size);
+            rpc_sched->vector_value("QUEUE_TIMEOUT", rs_queue_timeout);
+
+            rs_limits_str = rpc_sched->vector_value("METHOD_LIMITS");
+        }
+
+        if ( RequestScheduler::parse_limits(rs_limits_str, rs_limits,
+                    error_str) != 0 )
+        {
+            throw runtime_error("Wrong RPC_SCHEDULER configuration. " +
+                    error_str);
+        }
+
         rm = new RequestManager(rm_port, max_conn, max_conn_backlog,
             keepalive_timeout, keepalive_max_conn, timeout, rpc_filename,
-            log_call_format, rm_listen_address, message_size);
+            log_call_format, rm_listen_address, message_size, metrics_port,
+            new RequestScheduler(rs_workers, rs_queue_size, rs_queue_timeout,
+                rs_limits));
     }
     catch (bad_alloc&)
     {
@@ -1144,6 +1314,12 @@ void Nebula::start(bool bootstrap_only)
         pthread_join(aclm->get_thread_id(),0);
     }
 
+    hpool->finalize_monitoring();
+    vmpool->finalize_monitoring();
+
+    upool->finalize_quotas();
+    gpool->finalize_quotas();
+
     //XML Library
     xmlCleanupParser();
 
@@ -1263,3 +1439,17 @@ int Nebula::get_conf_attribute(
     return -1;
 };
 
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void Nebula::set_pool_indexes(bool enable)
+{
+    upool->set_name_index(enable && !federation_enabled);
+    gpool->set_name_index(enable && !federation_enabled);
+
+    hpool->set_name_index(enable);
+    ipool->set_name_index(enable);
+    vnpool->set_name_index(enable);
+
+    hpool->set_change_log(enable);
+}
@@ -375,6 +375,7 @@ void OpenNebulaTemplate::set_conf_default()
 #  VM_INDIVIDUAL_MONITORING
 #  VM_PER_INTERVAL
 #  VM_MONITORING_EXPIRATION_TIME
+#  MONITORING_FLUSH_INTERVAL
 #  LISTEN_ADDRESS
 #  PORT
 #  DB
@@ -391,10 +392,12 @@ void OpenNebulaTemplate::set_conf_default()
     set_conf_single("VM_INDIVIDUAL_MONITORING", "no");
     set_conf_single("VM_PER_INTERVAL", "5");
     set_conf_single("VM_MONITORING_EXPIRATION_TIME", "14400");
+    set_conf_single("MONITORING_FLUSH_INTERVAL", "5");
     set_conf_single("PORT", "2633");
     set_conf_single("LISTEN_ADDRESS", "0.0.0.0");
     set_conf_single("SCRIPTS_REMOTE_DIR", "/var/tmp/one");
     set_conf_single("VM_SUBMIT_ON_HOLD", "NO");
+    set_conf_single("TRACE_BUFFER", "0");
 
     //DB CONFIGURATION
     vvalue.insert(make_pair("BACKEND","sqlite"));
@@ -418,6 +421,34 @@ void OpenNebulaTemplate::set_conf_default()
     vattribute = new VectorAttribute("VNC_PORTS",vvalue);
     conf_default.insert(make_pair(vattribute->name(),vattribute));
 
+    // ACTION WORKERS CONFIGURATION
+    vvalue.clear();
+    vvalue.insert(make_pair("LCM","1"));
+    vvalue.insert(make_pair("DM","1"));
+    vvalue.insert(make_pair("TM","1"));
+    vvalue.insert(make_pair("VMM","1"));
+
+    vattribute = new VectorAttribute("ACTION_WORKERS",vvalue);
+    conf_default.insert(make_pair(vattribute->name(),vattribute));
+
+    // ACTION PRIORITY WEIGHTS
+    vvalue.clear();
+    vvalue.insert(make_pair("HIGH","4"));
+    vvalue.insert(make_pair("LOW","1"));
+
+    vattribute = new VectorAttribute("ACTION_PRIORITY",vvalue);
+    conf_default.insert(make_pair(vattribute->name(),vattribute));
+
+    // MONITORING STORE CONFIGURATION
+    vvalue.clear();
+    vvalue.insert(make_pair("BACKEND","sql"));
+    vvalue.insert(make_pair("HOST_SAMPLES","1440"));
+    vvalue.insert(make_pair("VM_SAMPLES","480"));
+    vvalue.insert(make_pair("ROLLUPS",""));
+
+    vattribute = new VectorAttribute("MONITORING_STORE",vvalue);
+    conf_default.insert(make_pair(vattribute->name(),vattribute));
+
 /*
 #*******************************************************************************
 # Federation configuration attributes
@@ -481,6 +512,8 @@ void OpenNebulaTemplate::set_conf_default()
 #  RPC_LOG
 #  MESSAGE_SIZE
 #  LOG_CALL_FORMAT
+#  METRICS_PORT
+#  RPC_SCHEDULER
 #*******************************************************************************
 */
     set_conf_single("MAX_CONN", "15");
@@ -491,6 +524,16 @@ void OpenNebulaTemplate::set_conf_default()
     set_conf_single("RPC_LOG", "NO");
     set_conf_single("MESSAGE_SIZE", "1073741824");
     set_conf_single("LOG_CALL_FORMAT", "Req:%i UID:%u %m invoked %l");
+    set_conf_single("METRICS_PORT", "0");
+
+    vvalue.clear();
+    vvalue.insert(make_pair("WORKERS","0"));
+    vvalue.insert(make_pair("QUEUE_SIZE","64"));
+    vvalue.insert(make_pair("QUEUE_TIMEOUT","5"));
+    vvalue.insert(make_pair("METHOD_LIMITS",""));
+
+    vattribute = new VectorAttribute("RPC_SCHEDULER",vvalue);
+    conf_default.insert(make_pair(vattribute->name(),vattribute));
 
 /*
 #*******************************************************************************
@@ -551,12 +594,16 @@ void OpenNebulaTemplate::set_conf_default()
 # SESSION_EXPIRATION_TIME
 # ENABLE_OTHER_PERMISSIONS
 # DEFAULT_UMASK
+# QUOTA_FLUSH_INTERVAL
+# ACL_INDEX
 #*******************************************************************************
 */
     set_conf_single("DEFAULT_AUTH", "default");
     set_conf_single("SESSION_EXPIRATION_TIME", "0");
     set_conf_single("ENABLE_OTHER_PERMISSIONS", "YES");
     set_conf_single("DEFAULT_UMASK", "177");
+    set_conf_single("QUOTA_FLUSH_INTERVAL", "0");
+    set_conf_single("ACL_INDEX", "YES");
 
 /*
 #*******************************************************************************
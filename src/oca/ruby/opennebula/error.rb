@@ -29,6 +29,7 @@ module OpenNebula
         EXML_RPC_API    = 0x1000
         EINTERNAL       = 0x2000
         EALLOCATE       = 0x4000
+        EBUSY           = 0x8000
         ENOTDEFINED     = 0xF001
         EXML_RPC_CALL   = 0xF002
         
@@ -182,11 +182,14 @@ module OpenNebula
 
         # Retrieves this Host's monitoring data from OpenNebula, in XML
         #
+        # @param resolution [Integer] Optional resolution of the samples in
+        #   seconds, 0 for the raw samples
+        #
         # @return [String] Monitoring data, in XML
-        def monitoring_xml()
+        def monitoring_xml(resolution=0)
             return Error.new('ID not defined') if !@pe_id
 
-            return @client.call(HOST_METHODS[:monitoring], @pe_id)
+            return @client.call(HOST_METHODS[:monitoring], @pe_id, resolution)
         end
 
         # Renames this Host
@@ -85,9 +85,12 @@ module OpenNebula
 
         # Retrieves the monitoring data for all the Hosts in the pool, in XML
         #
+        # @param resolution [Integer] Optional resolution of the samples in
+        #   seconds, 0 for the raw samples
+        #
         # @return [String] VM monitoring data, in XML
-        def monitoring_xml()
-            return @client.call(HOST_POOL_METHODS[:monitoring])
+        def monitoring_xml(resolution=0)
+            return @client.call(HOST_POOL_METHODS[:monitoring], resolution)
         end
     end
 end
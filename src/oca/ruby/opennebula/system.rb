@@ -30,6 +30,7 @@ module OpenNebula
             :groupquotaupdate   => "groupquota.update",
             :version            => "system.version",
             :config             => "system.config",
+            :metrics            => "system.metrics",
             :sql                => "system.sql"
         }
 
@@ -98,6 +99,23 @@ module OpenNebula
             return config
         end
 
+        # Gets the XML-RPC server metrics (latency of each method)
+        #
+        # @return [XMLElement, OpenNebula::Error] the metrics in case
+        #   of success, Error otherwise
+        def get_metrics()
+            rc = @client.call(SYSTEM_METHODS[:metrics])
+
+            if OpenNebula.is_error?(rc)
+                return rc
+            end
+
+            metrics = XMLElement.new
+            metrics.initialize_xml(rc, 'METRICS')
+
+            return metrics
+        end
+
         # Gets the default user quota limits
         #
         # @return [XMLElement, OpenNebula::Error] the default user quota in case
@@ -32,6 +32,7 @@ module OpenNebula
             :chown          => "vm.chown",
             :chmod          => "vm.chmod",
             :monitoring     => "vm.monitoring",
+            :trace          => "vm.trace",
             :attach         => "vm.attach",
             :detach         => "vm.detach",
             :rename         => "vm.rename",
@@ -573,11 +574,24 @@ module OpenNebula
 
         # Retrieves this VM's monitoring data from OpenNebula, in XML
         #
+        # @param resolution [Integer] Optional resolution of the samples in
+        #   seconds, 0 for the raw samples
+        #
         # @return [String] VM monitoring data, in XML
-        def monitoring_xml()
+        def monitoring_xml(resolution=0)
+            return Error.new('ID not defined') if !@pe_id
+
+            return @client.call(VM_METHODS[:monitoring], @pe_id, resolution)
+        end
+
+        # Retrieves the operation traces of this VM (time spent by each
+        # component processing its operations), in XML
+        #
+        # @return [String] VM traces, in XML
+        def trace_xml()
             return Error.new('ID not defined') if !@pe_id
 
-            return @client.call(VM_METHODS[:monitoring], @pe_id)
+            return @client.call(VM_METHODS[:trace], @pe_id)
         end
 
         # Renames this VM
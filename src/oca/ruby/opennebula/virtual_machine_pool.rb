@@ -159,10 +159,13 @@ module OpenNebula
         #
         # @param [Integer] filter_flag Optional filter flag to retrieve all or
         #   part of the Pool. Possible values: INFO_ALL, INFO_GROUP, INFO_MINE.
+        # @param resolution [Integer] Optional resolution of the samples in
+        #   seconds, 0 for the raw samples
         #
         # @return [String] VM monitoring data, in XML
-        def monitoring_xml(filter_flag=INFO_ALL)
-            return @client.call(VM_POOL_METHODS[:monitoring], filter_flag)
+        def monitoring_xml(filter_flag=INFO_ALL, resolution=0)
+            return @client.call(VM_POOL_METHODS[:monitoring], filter_flag,
+                resolution)
         end
 
         # Processes all the history records, and stores the monthly cost for
@@ -0,0 +1,697 @@
+/* -------------------------------------------------------------------------- */
+/* Copyright 2002-2017, OpenNebula Project, OpenNebula Systems                */
+/*                                                                            */
+/* Licensed under the Apache License, Version 2.0 (the "License"); you may    */
+/* not use this file except in compliance with the License. You may obtain    */
+/* a copy of the License at                                                   */
+/*                                                                            */
+/* http://www.apache.org/licenses/LICENSE-2.0                                 */
+/*                                                                            */
+/* Unless required by applicable law or agreed to in writing, software        */
+/* distributed under the License is distributed on an "AS IS" BASIS,          */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   */
+/* See the License for the specific language governing permissions and        */
+/* limitations under the License.                                             */
+/* -------------------------------------------------------------------------- */
+
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+#include <math.h>
+
+#include "MonitorStore.h"
+#include "NebulaLog.h"
+
+using namespace std;
+
+const uint32_t MonitorStore::initial_capacity = 64;
+
+const char MonitorStore::magic[8] = {'O','N','E','M','O','N','2','\0'};
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+MonitorStore::MonitorStore(const string& _file, const vector<string>& _metrics,
+    unsigned int _samples, const vector<pair<unsigned int,unsigned int> >& rollups)
+    :file(_file), metrics(_metrics), rollup_window(0), fd(-1), base(0),
+    map_size(0)
+{
+    vector<string>::const_iterator it;
+    vector<pair<unsigned int,unsigned int> >::const_iterator jt;
+
+    Series raw = {0, _samples == 0 ? 1 : _samples, 0};
+
+    series.push_back(raw);
+
+    for (jt = rollups.begin(); jt != rollups.end(); ++jt)
+    {
+        if ( jt->first == 0 || jt->second == 0 || series.size() >= max_series )
+        {
+            continue;
+        }
+
+        Series rollup = {jt->first, jt->second, 0};
+
+        series.push_back(rollup);
+
+        if ( (time_t) jt->first * jt->second > rollup_window )
+        {
+            rollup_window = (time_t) jt->first * jt->second;
+        }
+    }
+
+    for (it = metrics.begin(); it != metrics.end(); ++it)
+    {
+        size_t pos = it->find('/');
+
+        if ( pos == string::npos )
+        {
+            metric_xml.push_back(make_pair(string(), *it));
+        }
+        else
+        {
+            metric_xml.push_back(make_pair(it->substr(0, pos),
+                        it->substr(pos + 1)));
+        }
+    }
+
+    slot_size = sizeof(Slot);
+
+    for (vector<Series>::iterator st = series.begin(); st != series.end(); ++st)
+    {
+        st->offset = slot_size;
+
+        // time, weight and metric columns, all of them 8 bytes wide
+        slot_size += sizeof(Ring) + st->samples * sizeof(int64_t) *
+            (metrics.size() + 2);
+    }
+
+    pthread_rwlock_init(&rwlock, 0);
+};
+
+/* -------------------------------------------------------------------------- */
+
+MonitorStore::~MonitorStore()
+{
+    if ( base != 0 )
+    {
+        msync(base, map_size, MS_ASYNC);
+
+        munmap(base, map_size);
+    }
+
+    if ( fd != -1 )
+    {
+        close(fd);
+    }
+
+    pthread_rwlock_destroy(&rwlock);
+};
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+int MonitorStore::map_file(uint32_t capacity)
+{
+    size_t size = sizeof(Header) + capacity * slot_size;
+
+    if ( base != 0 )
+    {
+        munmap(base, map_size);
+
+        base     = 0;
+        map_size = 0;
+    }
+
+    if ( ftruncate(fd, size) != 0 )
+    {
+        return -1;
+    }
+
+    void * addr = mmap(0, size, PROT_READ|PROT_WRITE, MAP_SHARED, fd, 0);
+
+    if ( addr == MAP_FAILED )
+    {
+        return -1;
+    }
+
+    base     = static_cast<char *>(addr);
+    map_size = size;
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void MonitorStore::clear_slot(Slot * s, int32_t oid)
+{
+    s->oid = oid;
+
+    for (unsigned int k = 0; k < series.size(); k++)
+    {
+        ring(s, k)->next  = 0;
+        ring(s, k)->count = 0;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+int MonitorStore::init(string& error_str)
+{
+    struct stat   sb;
+    ostringstream oss;
+
+    bool reuse = false;
+
+    fd = open(file.c_str(), O_RDWR | O_CREAT, S_IRUSR | S_IWUSR);
+
+    if ( fd == -1 )
+    {
+        oss << "Cannot open monitoring store " << file << ": "
+            << strerror(errno);
+
+        error_str = oss.str();
+        return -1;
+    }
+
+    if ( fstat(fd, &sb) == 0 && sb.st_size >= (off_t) sizeof(Header) )
+    {
+        Header hdr;
+
+        bool same = pread(fd, &hdr, sizeof(Header), 0) == sizeof(Header) &&
+            memcmp(hdr.magic, magic, sizeof(magic)) == 0 &&
+            hdr.num_metrics == metrics.size() &&
+            hdr.num_series == series.size();
+
+        for (unsigned int k = 0; same && k < series.size(); k++)
+        {
+            same = hdr.interval[k] == series[k].interval &&
+                   hdr.samples[k] == series[k].samples;
+        }
+
+        if ( same &&
+             (off_t)(sizeof(Header) + hdr.capacity * slot_size) <= sb.st_size )
+        {
+            reuse = true;
+
+            if ( map_file(hdr.capacity) != 0 )
+            {
+                goto error_map;
+            }
+        }
+    }
+
+    if ( !reuse )
+    {
+        if ( ftruncate(fd, 0) != 0 || map_file(initial_capacity) != 0 )
+        {
+            goto error_map;
+        }
+
+        memcpy(header()->magic, magic, sizeof(magic));
+
+        header()->num_metrics = metrics.size();
+        header()->num_series  = series.size();
+        header()->capacity    = initial_capacity;
+        header()->reserved    = 0;
+
+        for (unsigned int k = 0; k < max_series; k++)
+        {
+            if ( k < series.size() )
+            {
+                header()->interval[k] = series[k].interval;
+                header()->samples[k]  = series[k].samples;
+            }
+            else
+            {
+                header()->interval[k] = 0;
+                header()->samples[k]  = 0;
+            }
+        }
+
+        for (uint32_t i = 0; i < initial_capacity; i++)
+        {
+            clear_slot(slot(i), -1);
+        }
+    }
+
+    for (uint32_t i = 0; i < header()->capacity; i++)
+    {
+        Slot * s = slot(i);
+
+        if ( s->oid == -1 )
+        {
+            free_slots.push_back(i);
+        }
+        else
+        {
+            Ring * r = ring(s, 0);
+
+            uint32_t n    = series[0].samples;
+            uint32_t last = (r->next + n - 1) % n;
+
+            index.insert(make_pair(s->oid, i));
+
+            if ( r->count == 0 )
+            {
+                expiration.schedule(s->oid, 0);
+            }
+            else
+            {
+                expiration.schedule(s->oid, times(s, 0)[last] + rollup_window);
+            }
+        }
+    }
+
+    oss << "Monitoring store " << file << (reuse ? " loaded, " : " created, ")
+        << index.size() << " objects";
+
+    NebulaLog::log("ONE", Log::INFO, oss);
+
+    return 0;
+
+error_map:
+    oss << "Cannot map monitoring store " << file << ": " << strerror(errno);
+
+    error_str = oss.str();
+    return -1;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+MonitorStore::Slot * MonitorStore::get_slot(int oid)
+{
+    map<int, uint32_t>::iterator it = index.find(oid);
+
+    if ( it != index.end() )
+    {
+        return slot(it->second);
+    }
+
+    if ( free_slots.empty() )
+    {
+        uint32_t capacity = header()->capacity;
+
+        if ( map_file(2 * capacity) != 0 )
+        {
+            if ( map_file(capacity) != 0 )
+            {
+                NebulaLog::log("ONE", Log::ERROR, "Cannot remap monitoring "
+                    "store " + file);
+            }
+
+            return 0;
+        }
+
+        header()->capacity = 2 * capacity;
+
+        for (uint32_t i = 2 * capacity; i > capacity; i--)
+        {
+            clear_slot(slot(i-1), -1);
+
+            free_slots.push_back(i-1);
+        }
+    }
+
+    uint32_t i = free_slots.back();
+
+    free_slots.pop_back();
+
+    Slot * s = slot(i);
+
+    clear_slot(s, oid);
+
+    index.insert(make_pair(oid, i));
+
+    return s;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void MonitorStore::add_sample(Slot * s, unsigned int k, time_t timestamp,
+        const vector<double>& values, const vector<double> * replaced)
+{
+    Ring *    r   = ring(s, k);
+    int64_t * ts  = times(s, k);
+    double *  w   = weights(s, k);
+    uint32_t  n   = series[k].samples;
+    uint32_t  pos = r->next;
+
+    // The last position is also the next one when n == 1, so a sample in the
+    // last bucket is tracked explicitly
+    bool merge = false;
+
+    if ( series[k].interval != 0 )
+    {
+        timestamp -= timestamp % series[k].interval;
+    }
+
+    if ( r->count > 0 )
+    {
+        uint32_t last = (r->next + n - 1) % n;
+
+        if ( ts[last] > timestamp )
+        {
+            return;
+        }
+        else if ( ts[last] == timestamp )
+        {
+            pos   = last;
+            merge = true;
+        }
+    }
+
+    if ( merge && series[k].interval != 0 )
+    {
+        for (unsigned int i = 0; i < metrics.size(); i++)
+        {
+            double * col = column(s, k, i);
+
+            if ( replaced != 0 )
+            {
+                // Swap the replaced sample in the average of the bucket
+                col[pos] += (values[i] - (*replaced)[i]) / w[pos];
+            }
+            else
+            {
+                // Incremental average of the samples in the bucket
+                col[pos] += (values[i] - col[pos]) / (w[pos] + 1);
+            }
+        }
+
+        if ( replaced == 0 )
+        {
+            w[pos] += 1;
+        }
+
+        return;
+    }
+
+    ts[pos] = timestamp;
+    w[pos]  = 1;
+
+    for (unsigned int i = 0; i < metrics.size(); i++)
+    {
+        column(s, k, i)[pos] = values[i];
+    }
+
+    if ( merge )
+    {
+        return;
+    }
+
+    r->next = (r->next + 1) % n;
+
+    if ( r->count < n )
+    {
+        r->count++;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+int MonitorStore::insert(int oid, time_t timestamp, const vector<double>& values)
+{
+    if ( values.size() != metrics.size() )
+    {
+        return -1;
+    }
+
+    pthread_rwlock_wrlock(&rwlock);
+
+    if ( base == 0 )
+    {
+        pthread_rwlock_unlock(&rwlock);
+        return -1;
+    }
+
+    Slot * s = get_slot(oid);
+
+    if ( s == 0 )
+    {
+        pthread_rwlock_unlock(&rwlock);
+        return -1;
+    }
+
+    Ring *    r  = ring(s, 0);
+    int64_t * ts = times(s, 0);
+
+    vector<double> last_values;
+
+    bool replace = false;
+
+    if ( r->count > 0 )
+    {
+        uint32_t n    = series[0].samples;
+        uint32_t last = (r->next + n - 1) % n;
+
+        if ( ts[last] > timestamp )
+        {
+            pthread_rwlock_unlock(&rwlock);
+            return -1;
+        }
+        else if ( ts[last] == timestamp )
+        {
+            replace = true;
+
+            for (unsigned int i = 0; i < metrics.size(); i++)
+            {
+                last_values.push_back(column(s, 0, i)[last]);
+            }
+        }
+    }
+
+    add_sample(s, 0, timestamp, values, 0);
+
+    // A sample that replaces the last one is not averaged twice in the
+    // rollups, it replaces the previous values in the bucket
+    for (unsigned int k = 1; k < series.size(); k++)
+    {
+        add_sample(s, k, timestamp, values, replace ? &last_values : 0);
+    }
+
+    expiration.schedule(oid, timestamp + rollup_window);
+
+    pthread_rwlock_unlock(&rwlock);
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+unsigned int MonitorStore::series_index(unsigned int resolution) const
+{
+    unsigned int idx = 0;
+
+    for (unsigned int k = 1; k < series.size(); k++)
+    {
+        if ( series[k].interval <= resolution &&
+             series[k].interval > series[idx].interval )
+        {
+            idx = k;
+        }
+    }
+
+    return idx;
+}
+
+unsigned int MonitorStore::get_interval(unsigned int resolution) const
+{
+    return series[series_index(resolution)].interval;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+int MonitorStore::range(int oid, unsigned int resolution, time_t start,
+        time_t end, vector<time_t>& t, vector<vector<double> >& values)
+{
+    unsigned int k = series_index(resolution);
+    uint32_t     n = series[k].samples;
+
+    map<int, uint32_t>::iterator it;
+
+    t.clear();
+
+    values.clear();
+    values.resize(metrics.size());
+
+    pthread_rwlock_rdlock(&rwlock);
+
+    it = index.find(oid);
+
+    if ( base == 0 || it == index.end() )
+    {
+        pthread_rwlock_unlock(&rwlock);
+        return 0;
+    }
+
+    Slot *    s  = slot(it->second);
+    Ring *    r  = ring(s, k);
+    int64_t * ts = times(s, k);
+
+    uint32_t first = (r->next + n - r->count) % n;
+
+    for (uint32_t j = 0; j < r->count; j++)
+    {
+        uint32_t pos = (first + j) % n;
+
+        if ( ts[pos] < start || (end != 0 && ts[pos] > end) )
+        {
+            continue;
+        }
+
+        t.push_back(ts[pos]);
+
+        for (unsigned int i = 0; i < metrics.size(); i++)
+        {
+            values[i].push_back(column(s, k, i)[pos]);
+        }
+    }
+
+    pthread_rwlock_unlock(&rwlock);
+
+    return t.size();
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+static void value_to_xml(ostringstream& oss, double value)
+{
+    if ( value == floor(value) && fabs(value) < 1e15 )
+    {
+        oss << static_cast<long long>(value);
+    }
+    else
+    {
+        oss << value;
+    }
+}
+
+void MonitorStore::to_xml(ostringstream& oss, int oid, unsigned int resolution,
+        time_t start, const string& elem_name, const string& time_name)
+{
+    vector<time_t>          t;
+    vector<vector<double> > values;
+
+    int n = range(oid, resolution, start, 0, t, values);
+
+    for (int j = 0; j < n; j++)
+    {
+        string section;
+
+        oss << "<" << elem_name << ">"
+            << "<ID>" << oid << "</ID>"
+            << "<" << time_name << ">" << t[j] << "</" << time_name << ">";
+
+        for (unsigned int i = 0; i < metric_xml.size(); i++)
+        {
+            const string& msection = metric_xml[i].first;
+            const string& mname    = metric_xml[i].second;
+
+            if ( msection != section )
+            {
+                if ( !section.empty() )
+                {
+                    oss << "</" << section << ">";
+                }
+
+                if ( !msection.empty() )
+                {
+                    oss << "<" << msection << ">";
+                }
+
+                section = msection;
+            }
+
+            oss << "<" << mname << ">";
+
+            value_to_xml(oss, values[i][j]);
+
+            oss << "</" << mname << ">";
+        }
+
+        if ( !section.empty() )
+        {
+            oss << "</" << section << ">";
+        }
+
+        oss << "</" << elem_name << ">";
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void MonitorStore::expire(time_t max_time)
+{
+    vector<int> oids;
+
+    vector<int>::iterator        it;
+    map<int, uint32_t>::iterator jt;
+
+    pthread_rwlock_wrlock(&rwlock);
+
+    if ( base == 0 )
+    {
+        pthread_rwlock_unlock(&rwlock);
+        return;
+    }
+
+    // Objects are kept while their rollup series hold samples, the deadline
+    // of an object is its last sample + rollup_window
+    expiration.expire(max_time - 1, index.size(), oids, false);
+
+    for (it = oids.begin(); it != oids.end(); ++it)
+    {
+        jt = index.find(*it);
+
+        if ( jt == index.end() )
+        {
+            continue;
+        }
+
+        clear_slot(slot(jt->second), -1);
+
+        free_slots.push_back(jt->second);
+
+        index.erase(jt);
+    }
+
+    pthread_rwlock_unlock(&rwlock);
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void MonitorStore::drop(int oid)
+{
+    map<int, uint32_t>::iterator it;
+
+    pthread_rwlock_wrlock(&rwlock);
+
+    it = index.find(oid);
+
+    if ( base != 0 && it != index.end() )
+    {
+        clear_slot(slot(it->second), -1);
+
+        free_slots.push_back(it->second);
+
+        index.erase(it);
+
+        expiration.cancel(oid);
+    }
+
+    pthread_rwlock_unlock(&rwlock);
+}
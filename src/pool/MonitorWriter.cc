@@ -0,0 +1,306 @@
+/* -------------------------------------------------------------------------- */
+/* Copyright 2002-2017, OpenNebula Project, OpenNebula Systems                */
+/*                                                                            */
+/* Licensed under the Apache License, Version 2.0 (the "License"); you may    */
+/* not use this file except in compliance with the License. You may obtain    */
+/* a copy of the License at                                                   */
+/*                                                                            */
+/* http://www.apache.org/licenses/LICENSE-2.0                                 */
+/*                                                                            */
+/* Unless required by applicable law or agreed to in writing, software        */
+/* distributed under the License is distributed on an "AS IS" BASIS,          */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   */
+/* See the License for the specific language governing permissions and        */
+/* limitations under the License.                                             */
+/* -------------------------------------------------------------------------- */
+
+#include <errno.h>
+#include <limits>
+
+#include "MonitorWriter.h"
+#include "NebulaLog.h"
+
+using namespace std;
+
+const unsigned int MonitorWriter::max_records = 1000;
+
+// -----------------------------------------------------------------------------
+// -----------------------------------------------------------------------------
+
+extern "C" void * monitor_writer_thread(void *arg)
+{
+    MonitorWriter * mw;
+
+    if ( arg == 0 )
+    {
+        return 0;
+    }
+
+    mw = static_cast<MonitorWriter *>(arg);
+
+    mw->do_write();
+
+    return 0;
+}
+
+// -----------------------------------------------------------------------------
+// -----------------------------------------------------------------------------
+
+MonitorWriter::MonitorWriter(SqlDB * _db, const char * _table,
+    const char * _db_names, time_t _flush_period):db(_db), table(_table),
+    db_names(_db_names), flush_period(_flush_period), running(false),
+    _finalize(false)
+{
+    pthread_mutex_init(&mutex, 0);
+
+    pthread_mutex_init(&write_mutex, 0);
+
+    pthread_cond_init(&cond, 0);
+};
+
+// -----------------------------------------------------------------------------
+
+MonitorWriter::~MonitorWriter()
+{
+    finalize();
+
+    pthread_mutex_destroy(&mutex);
+
+    pthread_mutex_destroy(&write_mutex);
+
+    pthread_cond_destroy(&cond);
+};
+
+// -----------------------------------------------------------------------------
+// -----------------------------------------------------------------------------
+
+int MonitorWriter::start()
+{
+    pthread_attr_t pattr;
+
+    pthread_attr_init(&pattr);
+    pthread_attr_setdetachstate(&pattr, PTHREAD_CREATE_JOINABLE);
+
+    int rc = pthread_create(&thread_id, &pattr, monitor_writer_thread,
+            (void *) this);
+
+    pthread_attr_destroy(&pattr);
+
+    if ( rc == 0 )
+    {
+        running = true;
+    }
+
+    return rc;
+}
+
+// -----------------------------------------------------------------------------
+
+void MonitorWriter::finalize()
+{
+    pthread_mutex_lock(&mutex);
+
+    _finalize = true;
+
+    pthread_cond_signal(&cond);
+
+    pthread_mutex_unlock(&mutex);
+
+    if ( running )
+    {
+        pthread_join(thread_id, 0);
+
+        running = false;
+    }
+
+    flush();
+}
+
+// -----------------------------------------------------------------------------
+// -----------------------------------------------------------------------------
+
+void MonitorWriter::do_write()
+{
+    while (true)
+    {
+        struct timespec timeout;
+
+        pthread_mutex_lock(&mutex);
+
+        timeout.tv_sec  = time(0) + flush_period;
+        timeout.tv_nsec = 0;
+
+        while ( !_finalize && records.size() < max_records )
+        {
+            if (pthread_cond_timedwait(&cond, &mutex, &timeout) == ETIMEDOUT)
+            {
+                break;
+            }
+        }
+
+        bool end = _finalize;
+
+        pthread_mutex_unlock(&mutex);
+
+        if ( end )
+        {
+            return;
+        }
+
+        flush();
+    }
+}
+
+// -----------------------------------------------------------------------------
+// -----------------------------------------------------------------------------
+
+void MonitorWriter::insert(int oid, time_t timestamp, const string& body)
+{
+    pthread_mutex_lock(&mutex);
+
+    records[make_pair(oid, timestamp)] = body;
+
+    if ( records.size() >= max_records )
+    {
+        pthread_cond_signal(&cond);
+    }
+
+    pthread_mutex_unlock(&mutex);
+}
+
+// -----------------------------------------------------------------------------
+
+void MonitorWriter::drop(int oid)
+{
+    map<pair<int, time_t>, string>::iterator first, last;
+
+    time_t min_time = numeric_limits<time_t>::min();
+
+    // Records of the object may be being written by flush
+    pthread_mutex_lock(&write_mutex);
+
+    pthread_mutex_lock(&mutex);
+
+    first = records.lower_bound(make_pair(oid, min_time));
+    last  = records.lower_bound(make_pair(oid + 1, min_time));
+
+    records.erase(first, last);
+
+    pthread_mutex_unlock(&mutex);
+
+    pthread_mutex_unlock(&write_mutex);
+}
+
+// -----------------------------------------------------------------------------
+// -----------------------------------------------------------------------------
+
+int MonitorWriter::flush()
+{
+    map<pair<int, time_t>, string> pending;
+    map<pair<int, time_t>, string>::iterator it;
+
+    ostringstream oss;
+
+    string sql_cmd_start;
+    string sql_cmd_separator;
+    string sql_cmd_end;
+
+    unsigned int n_entries = 0;
+    int rc = 0;
+
+    pthread_mutex_lock(&write_mutex);
+
+    pthread_mutex_lock(&mutex);
+
+    pending.swap(records);
+
+    pthread_mutex_unlock(&mutex);
+
+    if ( pending.empty() )
+    {
+        pthread_mutex_unlock(&write_mutex);
+        return 0;
+    }
+
+    if (db->multiple_values_support())
+    {
+        oss << "REPLACE INTO " << table << " (" << db_names << ") VALUES ";
+
+        sql_cmd_start = oss.str();
+
+        sql_cmd_separator = ",";
+
+        sql_cmd_end = "";
+    }
+    else
+    {
+        oss << "BEGIN TRANSACTION; "
+            << "REPLACE INTO " << table << " (" << db_names << ") VALUES ";
+
+        sql_cmd_start = oss.str();
+
+        oss.str("");
+        oss << "; REPLACE INTO " << table << " (" << db_names << ") VALUES ";
+
+        sql_cmd_separator = oss.str();
+
+        sql_cmd_end = "; COMMIT";
+    }
+
+    for ( it = pending.begin(); it != pending.end(); it++ )
+    {
+        char * sql_body = db->escape_str(it->second.c_str());
+
+        if ( sql_body == 0 )
+        {
+            continue;
+        }
+
+        if ( n_entries == 0 )
+        {
+            oss.str("");
+            oss << sql_cmd_start;
+        }
+        else
+        {
+            oss << sql_cmd_separator;
+        }
+
+        oss << "(" <<  it->first.first  << ","
+            <<         it->first.second << ","
+            << "'" <<  sql_body         << "')";
+
+        db->free_str(sql_body);
+
+        // To avoid the oss to grow indefinitely, flush contents
+        if ( ++n_entries == max_records )
+        {
+            oss << sql_cmd_end;
+
+            rc += db->exec_local_wr(oss);
+
+            n_entries = 0;
+        }
+    }
+
+    if ( n_entries > 0 )
+    {
+        oss << sql_cmd_end;
+
+        rc += db->exec_local_wr(oss);
+    }
+
+    pthread_mutex_unlock(&write_mutex);
+
+    if ( rc != 0 )
+    {
+        oss.str("");
+        oss << "Error writing monitoring records to " << table;
+
+        NebulaLog::log("ONE", Log::ERROR, oss);
+
+        return -1;
+    }
+
+    return 0;
+}
@@ -88,9 +88,15 @@ void PoolSQL::set_lastOID(int _last_oid)
 /* -------------------------------------------------------------------------- */
 
 PoolSQL::PoolSQL(SqlDB * _db, const char * _table, bool _cache, bool by_name):
-    db(_db), table(_table), uses_name_pool(by_name)
+    db(_db), table(_table), uses_name_pool(by_name), name_index_enabled(false),
+    name_index_loaded(false), change_log_enabled(false), change_log_epoch(0),
+    revision(0), min_revision(0)
 {
     pthread_mutex_init(&mutex,0);
+
+    pthread_mutex_init(&index_mutex,0);
+
+    pthread_mutex_init(&change_mutex,0);
 };
 
 /* -------------------------------------------------------------------------- */
@@ -112,6 +118,10 @@ PoolSQL::~PoolSQL()
     pthread_mutex_unlock(&mutex);
 
     pthread_mutex_destroy(&mutex);
+
+    pthread_mutex_destroy(&index_mutex);
+
+    pthread_mutex_destroy(&change_mutex);
 }
 
 /* -------------------------------------------------------------------------- */
@@ -146,6 +156,11 @@ int PoolSQL::allocate(PoolObjectSQL *objsql, string& error_str)
     else
     {
         rc = lastOID;
+
+        insert_name_index(key(objsql->name, objsql->uid), lastOID);
+
+        record_change(lastOID);
+
         do_hooks(objsql, Hook::ALLOCATE);
     }
 
@@ -209,15 +224,43 @@ PoolObjectSQL * PoolSQL::get(int oid, bool olock)
 
 PoolObjectSQL * PoolSQL::get(const string& name, int ouid, bool olock)
 {
+    int oid;
+
     if ( uses_name_pool == false )
     {
         return 0;
     }
 
-    lock();
-
     string name_key = key(name, ouid);
 
+    if ( lookup_name_index(name_key, oid) )
+    {
+        if ( oid == -1 )
+        {
+            return 0;
+        }
+
+        PoolObjectSQL * objectsql = get(oid, olock);
+
+        if ( objectsql != 0 )
+        {
+            // Check the object was not renamed after the lookup
+            if ( key(objectsql->name, objectsql->uid) == name_key )
+            {
+                return objectsql;
+            }
+
+            if ( olock == true )
+            {
+                objectsql->unlock();
+            }
+        }
+
+        erase_name_index(name_key, oid);
+    }
+
+    lock();
+
     flush_cache(name_key);
 
     PoolObjectSQL * objectsql = create();
@@ -239,6 +282,8 @@ PoolObjectSQL * PoolSQL::get(const string& name, int ouid, bool olock)
 
     name_pool.insert(make_pair(name_key, objectsql));
 
+    insert_name_index(name_key, objectsql->oid);
+
     if ( olock == true )
     {
         objectsql->lock();
@@ -252,6 +297,301 @@ PoolObjectSQL * PoolSQL::get(const string& name, int ouid, bool olock)
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
+int PoolSQL::get_oid(const string& name, int uid)
+{
+    int oid;
+
+    if ( lookup_name_index(key(name, uid), oid) )
+    {
+        return oid;
+    }
+
+    PoolObjectSQL * objectsql = get(name, uid, true);
+
+    if ( objectsql == 0 )
+    {
+        return -1;
+    }
+
+    oid = objectsql->oid;
+
+    objectsql->unlock();
+
+    return oid;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void PoolSQL::set_name_index(bool enable)
+{
+    pthread_mutex_lock(&index_mutex);
+
+    name_index_enabled = enable && uses_name_pool;
+    name_index_loaded  = false;
+
+    name_index.clear();
+
+    pthread_mutex_unlock(&index_mutex);
+}
+
+/* -------------------------------------------------------------------------- */
+
+int PoolSQL::name_index_cb(void *nil, int num, char **values, char **names)
+{
+    if ( num != 3 || values == 0 || values[0] == 0 || values[1] == 0 ||
+            values[2] == 0 )
+    {
+        return -1;
+    }
+
+    name_index[key(values[1], atoi(values[2]))] = atoi(values[0]);
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+
+int PoolSQL::load_name_index()
+{
+    ostringstream oss;
+
+    name_index.clear();
+
+    set_callback(static_cast<Callbackable::Callback>(&PoolSQL::name_index_cb));
+
+    oss << "SELECT oid, name, uid FROM " << table;
+
+    int rc = db->exec_rd(oss, this);
+
+    unset_callback();
+
+    if ( rc != 0 )
+    {
+        name_index.clear();
+        return -1;
+    }
+
+    name_index_loaded = true;
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+
+bool PoolSQL::lookup_name_index(const string& name_key, int& oid)
+{
+    bool indexed = false;
+
+    oid = -1;
+
+    pthread_mutex_lock(&index_mutex);
+
+    if ( name_index_enabled &&
+            ( name_index_loaded || load_name_index() == 0 ) )
+    {
+        map<string,int>::iterator it = name_index.find(name_key);
+
+        if ( it != name_index.end() )
+        {
+            oid = it->second;
+        }
+
+        indexed = true;
+    }
+
+    pthread_mutex_unlock(&index_mutex);
+
+    return indexed;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void PoolSQL::insert_name_index(const string& name_key, int oid)
+{
+    pthread_mutex_lock(&index_mutex);
+
+    if ( name_index_loaded )
+    {
+        name_index[name_key] = oid;
+    }
+
+    pthread_mutex_unlock(&index_mutex);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void PoolSQL::update_cache_index(string& old_name,
+                                 int     old_uid,
+                                 string& new_name,
+                                 int     new_uid)
+{
+    pthread_mutex_lock(&index_mutex);
+
+    if ( name_index_loaded )
+    {
+        map<string,int>::iterator it = name_index.find(key(old_name, old_uid));
+
+        if ( it != name_index.end() )
+        {
+            int oid = it->second;
+
+            name_index.erase(it);
+
+            name_index[key(new_name, new_uid)] = oid;
+        }
+    }
+
+    pthread_mutex_unlock(&index_mutex);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void PoolSQL::erase_name_index(const string& name_key, int oid)
+{
+    pthread_mutex_lock(&index_mutex);
+
+    map<string,int>::iterator it = name_index.find(name_key);
+
+    if ( it != name_index.end() && it->second == oid )
+    {
+        name_index.erase(it);
+    }
+
+    pthread_mutex_unlock(&index_mutex);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void PoolSQL::drop_cache_index(PoolObjectSQL * objsql)
+{
+    erase_name_index(key(objsql->name, objsql->uid), objsql->oid);
+
+    record_drop(objsql->oid);
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+const unsigned int PoolSQL::CHANGE_LOG_DROPS = 10000;
+
+/* -------------------------------------------------------------------------- */
+
+void PoolSQL::set_change_log(bool enable)
+{
+    static unsigned long long epoch_seq = 0;
+
+    pthread_mutex_lock(&change_mutex);
+
+    change_log_enabled = enable;
+
+    // A new epoch invalidates the revisions returned before the reset
+    change_log_epoch = (static_cast<unsigned long long>(time(0)) << 16) +
+                       (++epoch_seq & 0xFFFF);
+
+    revision     = 0;
+    min_revision = 0;
+
+    changes.clear();
+    drops.clear();
+
+    pthread_mutex_unlock(&change_mutex);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void PoolSQL::record_change(int oid)
+{
+    pthread_mutex_lock(&change_mutex);
+
+    if ( change_log_enabled )
+    {
+        changes[oid] = ++revision;
+    }
+
+    pthread_mutex_unlock(&change_mutex);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void PoolSQL::record_drop(int oid)
+{
+    pthread_mutex_lock(&change_mutex);
+
+    if ( change_log_enabled )
+    {
+        changes.erase(oid);
+
+        drops.insert(make_pair(++revision, oid));
+
+        if ( drops.size() > CHANGE_LOG_DROPS )
+        {
+            min_revision = drops.begin()->first;
+
+            drops.erase(drops.begin());
+        }
+    }
+
+    pthread_mutex_unlock(&change_mutex);
+}
+
+/* -------------------------------------------------------------------------- */
+
+bool PoolSQL::get_changes(const string& rev_str, set<int>& changed,
+        set<int>& dropped, string& current)
+{
+    unsigned long long epoch;
+    unsigned long long since;
+
+    char sep;
+
+    ostringstream oss;
+    istringstream iss(rev_str);
+
+    bool delta = false;
+
+    changed.clear();
+    dropped.clear();
+
+    iss >> epoch >> sep >> since;
+
+    pthread_mutex_lock(&change_mutex);
+
+    oss << change_log_epoch << ":" << revision;
+
+    current = oss.str();
+
+    if ( change_log_enabled && !iss.fail() && sep == ':' &&
+            epoch == change_log_epoch && since >= min_revision &&
+            since <= revision )
+    {
+        map<int, unsigned long long>::iterator it;
+        map<unsigned long long, int>::iterator d_it;
+
+        for (it = changes.begin(); it != changes.end(); ++it)
+        {
+            if ( it->second > since )
+            {
+                changed.insert(it->first);
+            }
+        }
+
+        for (d_it = drops.upper_bound(since); d_it != drops.end(); ++d_it)
+        {
+            dropped.insert(d_it->second);
+        }
+
+        delta = true;
+    }
+
+    pthread_mutex_unlock(&change_mutex);
+
+    return delta;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
 void PoolSQL::flush_cache(int oid)
 {
     int  rc;
@@ -495,8 +835,7 @@ void PoolSQL::acl_filter(int                       uid,
     Nebula&     nd   = Nebula::instance();
     AclManager* aclm = nd.get_aclm();
 
-    ostringstream         acl_filter;
-    vector<int>::iterator it;
+    ostringstream acl_filter;
 
     vector<int> oids;
     vector<int> gids;
@@ -514,14 +853,18 @@ void PoolSQL::acl_filter(int                       uid,
                          gids,
                          cids);
 
-    for ( it = oids.begin(); it < oids.end(); it++ )
+    if ( !oids.empty() )
     {
-        acl_filter << " OR oid = " << *it;
+        acl_filter << " OR ";
+
+        in_filter("oid", set<int>(oids.begin(), oids.end()), acl_filter);
     }
 
-    for ( it = gids.begin(); it < gids.end(); it++ )
+    if ( !gids.empty() )
     {
-        acl_filter << " OR gid = " << *it;
+        acl_filter << " OR ";
+
+        in_filter("gid", set<int>(gids.begin(), gids.end()), acl_filter);
     }
 
     ClusterPool::cluster_acl_filter(acl_filter, auth_object, cids);
@@ -541,8 +884,6 @@ void PoolSQL::usr_filter(int                uid,
 {
     ostringstream uid_filter;
 
-    set<int>::iterator g_it;
-
     if ( filter_flag == RequestManagerPoolInfoFilter::MINE )
     {
         uid_filter << "uid = " << uid;
@@ -553,28 +894,17 @@ void PoolSQL::usr_filter(int                uid,
     }
     else if ( filter_flag == RequestManagerPoolInfoFilter::MINE_GROUP )
     {
-        uid_filter << "uid = " << uid << " OR ( (";
+        uid_filter << "uid = " << uid << " OR ( ";
 
-        string sep = " ";
-
-        for (g_it = user_groups.begin(); g_it != user_groups.end(); g_it++)
-        {
-            uid_filter << sep << "( gid = " << *g_it << " )";
-            sep = " OR ";
-        }
-
-        uid_filter << ")";
+        in_filter("gid", user_groups, uid_filter);
 
         if ( !all )
         {
-            uid_filter << " AND ( other_u = 1";
+            uid_filter << " AND ( other_u = 1 OR ( group_u = 1 AND ";
 
-            for (g_it = user_groups.begin(); g_it != user_groups.end(); g_it++)
-            {
-                uid_filter << " OR ( gid = " << *g_it << " AND group_u = 1 )";
-            }
+            in_filter("gid", user_groups, uid_filter);
 
-            uid_filter << acl_str << ")";
+            uid_filter << " )" << acl_str << ")";
         }
 
         uid_filter << ")";
@@ -584,14 +914,11 @@ void PoolSQL::usr_filter(int                uid,
         if (!all)
         {
             uid_filter << " uid = " << uid
-                    << " OR other_u = 1";
+                    << " OR other_u = 1 OR ( group_u = 1 AND ";
 
-            for (g_it = user_groups.begin(); g_it != user_groups.end(); g_it++)
-            {
-                uid_filter << " OR ( gid = " << *g_it << " AND group_u = 1 )";
-            }
+            in_filter("gid", user_groups, uid_filter);
 
-            uid_filter << acl_str;
+            uid_filter << " )" << acl_str;
         }
     }
     else
@@ -600,14 +927,11 @@ void PoolSQL::usr_filter(int                uid,
 
         if ( filter_flag != uid && !all )
         {
-            uid_filter << " AND ( other_u = 1";
+            uid_filter << " AND ( other_u = 1 OR ( group_u = 1 AND ";
 
-            for (g_it = user_groups.begin(); g_it != user_groups.end(); g_it++)
-            {
-                uid_filter << " OR ( gid = " << *g_it << " AND group_u = 1 )";
-            }
+            in_filter("gid", user_groups, uid_filter);
 
-            uid_filter << acl_str << ")";
+            uid_filter << " )" << acl_str << ")";
         }
     }
 
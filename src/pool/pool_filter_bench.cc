@@ -0,0 +1,432 @@
+/* -------------------------------------------------------------------------- */
+/* Copyright 2002-2017, OpenNebula Project, OpenNebula Systems                */
+/*                                                                            */
+/* Licensed under the Apache License, Version 2.0 (the "License"); you may    */
+/* not use this file except in compliance with the License. You may obtain    */
+/* a copy of the License at                                                   */
+/*                                                                            */
+/* http://www.apache.org/licenses/LICENSE-2.0                                 */
+/*                                                                            */
+/* Unless required by applicable law or agreed to in writing, software        */
+/* distributed under the License is distributed on an "AS IS" BASIS,          */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   */
+/* See the License for the specific language governing permissions and        */
+/* limitations under the License.                                             */
+/* -------------------------------------------------------------------------- */
+
+/* -------------------------------------------------------------------------- */
+/* Benchmark of the pool ACL filters. A pool table is filled with random      */
+/* objects and queried with the filter of a user with individual and group    */
+/* ACL grants, as built by PoolSQL::usr_filter and acl_filter:                */
+/*   - OR chains: one "oid = N" / "gid = N" term per grant (previous filters) */
+/*   - IN lists: a single "oid IN (...)" / "gid IN (...)" per column          */
+/*                                                                            */
+/*   pool_filter_bench [options]                                              */
+/*                                                                            */
+/* Both filters must return the same rows. The query plan of each filter is   */
+/* printed with -e.                                                           */
+/* -------------------------------------------------------------------------- */
+
+#include "PoolSQL.h"
+#include "SqliteDB.h"
+#include "MySqlDB.h"
+#include "NebulaLog.h"
+#include "NebulaUtil.h"
+
+#include <getopt.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <iomanip>
+#include <iostream>
+#include <set>
+
+using namespace std;
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+static const char * table = "pool_filter_bench";
+
+/**
+ *  Counts the rows returned by a query, and prints them if verbose
+ */
+class RowCounter : public Callbackable
+{
+public:
+    RowCounter(bool _verbose):rows(0), verbose(_verbose){};
+
+    int count_cb(void * nil, int num, char **values, char **names)
+    {
+        rows++;
+
+        if ( verbose )
+        {
+            for (int i = 0; i < num; i++)
+            {
+                cout << (i == 0 ? "  " : " | ") << (values[i] ? values[i] : "");
+            }
+
+            cout << endl;
+        }
+
+        return 0;
+    };
+
+    long rows;
+
+private:
+    bool verbose;
+};
+
+/* -------------------------------------------------------------------------- */
+
+static double now()
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* -------------------------------------------------------------------------- */
+
+static int query(SqlDB * db, const string& sql, RowCounter& counter)
+{
+    ostringstream oss(sql);
+
+    counter.set_callback(
+            static_cast<Callbackable::Callback>(&RowCounter::count_cb));
+
+    int rc = db->exec_rd(oss, &counter);
+
+    counter.unset_callback();
+
+    return rc;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+static int create_pool(SqlDB * db, int num_objects, int num_groups)
+{
+    ostringstream oss;
+
+    oss << "DROP TABLE IF EXISTS " << table;
+
+    db->exec_local_wr(oss);
+
+    oss.str("");
+    oss << "CREATE TABLE " << table << " (oid INTEGER PRIMARY KEY, "
+        << "name VARCHAR(128), body MEDIUMTEXT, uid INTEGER, gid INTEGER, "
+        << "owner_u INTEGER, group_u INTEGER, other_u INTEGER)";
+
+    if ( db->exec_local_wr(oss) != 0 )
+    {
+        return -1;
+    }
+
+    string body(512, 'x');
+
+    unsigned int seed = 1;
+
+    for (int oid = 0; oid < num_objects; )
+    {
+        oss.str("");
+
+        if ( !db->multiple_values_support() )
+        {
+            oss << "BEGIN TRANSACTION; ";
+        }
+
+        for (int i = 0; i < 1000 && oid < num_objects; i++, oid++)
+        {
+            if ( db->multiple_values_support() )
+            {
+                oss << (i == 0 ? "INSERT INTO " : ",");
+
+                if ( i == 0 )
+                {
+                    oss << table << " VALUES ";
+                }
+            }
+            else
+            {
+                oss << "INSERT INTO " << table << " VALUES ";
+            }
+
+            oss << "(" << oid << ",'obj-" << oid << "','" << body << "',"
+                << 2 + rand_r(&seed) % 100 << ","
+                << rand_r(&seed) % num_groups << ",1,"
+                << (rand_r(&seed) % 4 == 0 ? 1 : 0) << ","
+                << (rand_r(&seed) % 50 == 0 ? 1 : 0) << ")";
+
+            if ( !db->multiple_values_support() )
+            {
+                oss << "; ";
+            }
+        }
+
+        if ( !db->multiple_values_support() )
+        {
+            oss << "COMMIT";
+        }
+
+        if ( db->exec_local_wr(oss) != 0 )
+        {
+            return -1;
+        }
+    }
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+/**
+ *  Filter of the previous usr_filter/acl_filter implementation
+ */
+static string or_filter(int uid, const set<int>& groups, const set<int>& oids,
+        const set<int>& gids)
+{
+    ostringstream oss;
+
+    set<int>::const_iterator it;
+
+    oss << "uid = " << uid << " OR other_u = 1";
+
+    for (it = groups.begin(); it != groups.end(); ++it)
+    {
+        oss << " OR ( gid = " << *it << " AND group_u = 1 )";
+    }
+
+    for (it = oids.begin(); it != oids.end(); ++it)
+    {
+        oss << " OR oid = " << *it;
+    }
+
+    for (it = gids.begin(); it != gids.end(); ++it)
+    {
+        oss << " OR gid = " << *it;
+    }
+
+    return oss.str();
+}
+
+/* -------------------------------------------------------------------------- */
+
+/**
+ *  Filter of the current usr_filter/acl_filter implementation
+ */
+static string in_list_filter(int uid, const set<int>& groups,
+        const set<int>& oids, const set<int>& gids)
+{
+    ostringstream oss;
+
+    oss << "uid = " << uid << " OR other_u = 1 OR ( group_u = 1 AND ";
+
+    PoolSQL::in_filter("gid", groups, oss);
+
+    oss << " )";
+
+    if ( !oids.empty() )
+    {
+        oss << " OR ";
+
+        PoolSQL::in_filter("oid", oids, oss);
+    }
+
+    if ( !gids.empty() )
+    {
+        oss << " OR ";
+
+        PoolSQL::in_filter("gid", gids, oss);
+    }
+
+    return oss.str();
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+static int run(SqlDB * db, const string& name, const string& filter,
+        int iterations, bool explain)
+{
+    RowCounter counter(false);
+
+    ostringstream sql;
+
+    sql << "SELECT body FROM " << table << " WHERE " << filter
+        << " ORDER BY oid";
+
+    if ( explain )
+    {
+        RowCounter plan(true);
+
+        cout << name << " plan:" << endl;
+
+        query(db, "EXPLAIN QUERY PLAN " + sql.str(), plan);
+    }
+
+    double start = now();
+
+    for (int i = 0; i < iterations; i++)
+    {
+        counter.rows = 0;
+
+        if ( query(db, sql.str(), counter) != 0 )
+        {
+            cerr << "Error executing the " << name << " query" << endl;
+            return -1;
+        }
+    }
+
+    double elapsed = (now() - start) / iterations;
+
+    cout << setw(10) << left << name
+         << " filter: "  << setw(7) << right << filter.size() << " bytes"
+         << "  rows: "   << setw(7) << counter.rows
+         << "  query: "  << fixed << setprecision(2) << setw(8)
+         << elapsed * 1000 << " ms" << endl;
+
+    return counter.rows;
+}
+
+/* -------------------------------------------------------------------------- */
+
+static void usage()
+{
+    cout << "Usage: pool_filter_bench [options]\n"
+         << "  -n objects   rows of the pool table (default 20000)\n"
+         << "  -o grants    individual object grants (default 300)\n"
+         << "  -g grants    group grants (default 10)\n"
+         << "  -i iters     queries of each filter (default 20)\n"
+         << "  -f file      SQLite DB file (default pool_filter_bench.db)\n"
+#ifdef MYSQL_DB
+         << "  -m server:port:user:password:db  use a MySQL DB\n"
+#endif
+         << "  -e           print the query plans (SQLite)\n";
+}
+
+/* -------------------------------------------------------------------------- */
+
+int main(int argc, char ** argv)
+{
+    int  num_objects = 20000;
+    int  num_oids    = 300;
+    int  num_gids    = 10;
+    int  iterations  = 20;
+    bool explain     = false;
+
+    string file = "pool_filter_bench.db";
+    string mysql;
+
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:o:g:i:f:m:eh")) != -1)
+    {
+        switch (opt)
+        {
+            case 'n': num_objects = atoi(optarg); break;
+            case 'o': num_oids    = atoi(optarg); break;
+            case 'g': num_gids    = atoi(optarg); break;
+            case 'i': iterations  = atoi(optarg); break;
+            case 'f': file        = optarg;       break;
+            case 'm': mysql       = optarg;       break;
+            case 'e': explain     = true;         break;
+            default:
+                usage();
+                return opt == 'h' ? 0 : -1;
+        }
+    }
+
+    if ( num_objects <= 0 || iterations <= 0 )
+    {
+        usage();
+        return -1;
+    }
+
+    NebulaLog::init_log_system(NebulaLog::STD, Log::ERROR, "", ios_base::trunc,
+            "pool_filter_bench");
+
+    SqlDB * db = 0;
+
+    if ( mysql.empty() )
+    {
+#ifdef SQLITE_DB
+        db = new SqliteDB(file);
+#endif
+    }
+    else
+    {
+#ifdef MYSQL_DB
+        vector<string> conn = one_util::split(mysql, ':', false);
+
+        if ( conn.size() != 5 )
+        {
+            usage();
+            return -1;
+        }
+
+        db = new MySqlDB(conn[0], atoi(conn[1].c_str()), conn[2], conn[3],
+                conn[4]);
+#endif
+        explain = false;
+    }
+
+    if ( db == 0 )
+    {
+        cerr << "DB backend not supported in this build" << endl;
+        return -1;
+    }
+
+    int num_groups = 100;
+
+    if ( create_pool(db, num_objects, num_groups) != 0 )
+    {
+        cerr << "Error creating the pool table" << endl;
+        return -1;
+    }
+
+    // ACL grants of the user, as returned by AclManager::reverse_search
+    set<int> groups;
+    set<int> oids;
+    set<int> gids;
+
+    unsigned int seed = 2;
+
+    groups.insert(1);
+    groups.insert(2 + rand_r(&seed) % (num_groups - 2));
+
+    for (int i = 0; i < num_oids; i++)
+    {
+        oids.insert(rand_r(&seed) % num_objects);
+    }
+
+    for (int i = 0; i < num_gids; i++)
+    {
+        gids.insert(rand_r(&seed) % num_groups);
+    }
+
+    cout << num_objects << " objects, " << oids.size() << " object grants, "
+         << gids.size() << " group grants, " << iterations << " queries"
+         << endl;
+
+    int or_rows = run(db, "OR chain", or_filter(0, groups, oids, gids),
+            iterations, explain);
+
+    int in_rows = run(db, "IN list", in_list_filter(0, groups, oids, gids),
+            iterations, explain);
+
+    delete db;
+
+    if ( or_rows != in_rows )
+    {
+        cerr << "Filters returned different rows" << endl;
+        return -1;
+    }
+
+    return or_rows < 0 ? -1 : 0;
+}
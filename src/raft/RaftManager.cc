@@ -443,6 +443,20 @@ void RaftManager::leader()
 
     aclm->reload_rules();
 
+    nd.get_clpool()->clean_cache();
+
+    nd.get_dspool()->clean_cache();
+
+    nd.get_hpool()->clean_cache();
+
+    nd.get_vmpool()->clean_cache();
+
+    nd.get_upool()->clean_quotas();
+
+    nd.get_gpool()->clean_quotas();
+
+    nd.set_pool_indexes(true);
+
     if ( nd.is_federation_master() )
     {
         frm->start_replica_threads();
@@ -493,6 +507,8 @@ void RaftManager::follower(unsigned int _term)
 
     raft_state.to_xml(raft_state_xml);
 
+    nd.set_pool_indexes(false);
+
     NebulaLog::log("RCM", Log::INFO, "oned is set to follower mode");
 
     std::map<int, ReplicaRequest *>::iterator it;
@@ -260,6 +260,10 @@ void Request::log_xmlrpc_value(const xmlrpc_c::value& v, std::ostringstream& oss
 
 string Request::format_str;
 
+RequestScheduler * Request::scheduler = 0;
+
+__thread unsigned long long Request::response_time = 0;
+
 const long long Request::xmlrpc_timeout = 10000;
 
 /* -------------------------------------------------------------------------- */
@@ -275,14 +279,103 @@ void Request::execute(
 
     att.req_id  = (reinterpret_cast<uintptr_t>(this) * rand()) % 10000;
 
+    struct timespec start;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    // The VM trace is started by start_trace() once the request is authorized
+    if ( trace_param > 0 && Tracer::enabled() )
+    {
+        att.trace_start = Tracer::now();
+    }
+
+    if ( scheduler == 0 || !admission )
+    {
+        execute_measured(_paramList, att);
+    }
+    else if ( scheduler->admit(method_name) != 0 )
+    {
+        att.resp_msg = "Server busy, try again later";
+        failure_response(BUSY, att);
+
+        if ( log_method_call )
+        {
+            log_result(att, method_name);
+        }
+    }
+    else
+    {
+        execute_measured(_paramList, att);
+
+        scheduler->release(method_name);
+    }
+
+    metrics->add(RequestMetrics::TOTAL, LatencyHistogram::elapsed(start));
+
+    if ( att.trace_vid != -1 )
+    {
+        Tracer::span(att.trace_vid, "RM", method_name, att.trace_start,
+                Tracer::now());
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+void Request::execute_measured(
+        xmlrpc_c::paramList const& _paramList,
+        RequestAttributes& att)
+{
+    struct timespec start;
+
+    unsigned long long auth_time = 0;
+
+    PoolObjectSQL::lock_wait = 0;
+    response_time            = 0;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    execute_admitted(_paramList, att, auth_time);
+
+    unsigned long long exec_time = LatencyHistogram::elapsed(start);
+    unsigned long long lock_time = PoolObjectSQL::lock_wait;
+    unsigned long long resp_time = response_time;
+
+    if ( exec_time > auth_time + lock_time + resp_time )
+    {
+        exec_time -= auth_time + lock_time + resp_time;
+    }
+    else
+    {
+        exec_time = 0;
+    }
+
+    metrics->add(RequestMetrics::AUTH, auth_time);
+    metrics->add(RequestMetrics::LOCK_WAIT, lock_time);
+    metrics->add(RequestMetrics::EXECUTION, exec_time);
+    metrics->add(RequestMetrics::RESPONSE, resp_time);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void Request::execute_admitted(
+        xmlrpc_c::paramList const& _paramList,
+        RequestAttributes& att,
+        unsigned long long& auth_time)
+{
     Nebula& nd  = Nebula::instance();
 
     RaftManager * raftm = nd.get_raftm();
     UserPool* upool     = nd.get_upool();
 
+    struct timespec start;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
     bool authenticated = upool->authenticate(att.session, att.password,
         att.uid, att.gid, att.uname, att.gname, att.group_ids, att.umask);
 
+    auth_time = LatencyHistogram::elapsed(start);
+
     if ( log_method_call )
     {
         log_method_invoked(att, _paramList, format_str, method_name,
@@ -313,7 +406,7 @@ void Request::execute(
         }
 
         int rc = Client::call(leader_endpoint, method_name, _paramList,
-                xmlrpc_timeout, _retval, att.resp_msg);
+                xmlrpc_timeout, att.retval, att.resp_msg);
 
         if ( rc != 0 )
         {
@@ -428,27 +521,17 @@ bool Request::user_quota_authorization (Template * tmpl,
 {
     Nebula& nd        = Nebula::instance();
     UserPool *  upool = nd.get_upool();
-    User *      user;
-
-    bool   rc = false;
-
-    user = upool->get(att.uid, true);
-
-    if ( user == 0 )
-    {
-        error_str = "User not found";
-        return false;
-    }
 
     DefaultQuotas default_user_quotas = nd.get_default_user_quota();
 
-    rc = user->quota.quota_check(qtype, tmpl, default_user_quotas, error_str);
+    int rc = upool->get_quota_ledger()->check(att.uid, qtype, tmpl,
+            default_user_quotas, error_str);
 
-    if (rc == true)
+    if ( rc == -2 )
     {
-        upool->update_quotas(user);
+        error_str = "User not found";
     }
-    else
+    else if ( rc != 0 )
     {
         ostringstream oss;
 
@@ -458,9 +541,7 @@ bool Request::user_quota_authorization (Template * tmpl,
         error_str = oss.str();
     }
 
-    user->unlock();
-
-    return rc;
+    return rc == 0;
 }
 
 /* -------------------------------------------------------------------------- */
@@ -472,27 +553,17 @@ bool Request::group_quota_authorization (Template * tmpl,
 {
     Nebula&     nd    = Nebula::instance();
     GroupPool * gpool = nd.get_gpool();
-    Group *     group;
-
-    bool   rc = false;
-
-    group = gpool->get(att.gid, true);
-
-    if ( group == 0 )
-    {
-        error_str = "Group not found";
-        return false;
-    }
 
     DefaultQuotas default_group_quotas = nd.get_default_group_quota();
 
-    rc = group->quota.quota_check(qtype, tmpl, default_group_quotas, error_str);
+    int rc = gpool->get_quota_ledger()->check(att.gid, qtype, tmpl,
+            default_group_quotas, error_str);
 
-    if (rc == true)
+    if ( rc == -2 )
     {
-        gpool->update_quotas(group);
+        error_str = "Group not found";
     }
-    else
+    else if ( rc != 0 )
     {
         ostringstream oss;
 
@@ -502,9 +573,7 @@ bool Request::group_quota_authorization (Template * tmpl,
         error_str = oss.str();
     }
 
-    group->unlock();
-
-    return rc;
+    return rc == 0;
 }
 
 /* -------------------------------------------------------------------------- */
@@ -513,23 +582,9 @@ void Request::user_quota_rollback(Template *         tmpl,
                                   Quotas::QuotaType  qtype,
                                   RequestAttributes& att)
 {
-    Nebula& nd        = Nebula::instance();
-    UserPool * upool  = nd.get_upool();
-
-    User * user;
-
-    user = upool->get(att.uid, true);
-
-    if ( user == 0 )
-    {
-        return;
-    }
+    UserPool * upool = Nebula::instance().get_upool();
 
-    user->quota.quota_del(qtype, tmpl);
-
-    upool->update_quotas(user);
-
-    user->unlock();
+    upool->get_quota_ledger()->del(att.uid, qtype, tmpl);
 }
 
 /* -------------------------------------------------------------------------- */
@@ -538,23 +593,9 @@ void Request::group_quota_rollback(Template *         tmpl,
                                    Quotas::QuotaType  qtype,
                                    RequestAttributes& att)
 {
-    Nebula& nd        = Nebula::instance();
-    GroupPool * gpool = nd.get_gpool();
+    GroupPool * gpool = Nebula::instance().get_gpool();
 
-    Group * group;
-
-    group = gpool->get(att.gid, true);
-
-    if ( group == 0 )
-    {
-        return;
-    }
-
-    group->quota.quota_del(qtype, tmpl);
-
-    gpool->update_quotas(group);
-
-    group->unlock();
+    gpool->get_quota_ledger()->del(att.gid, qtype, tmpl);
 }
 
 /* -------------------------------------------------------------------------- */
@@ -638,6 +679,12 @@ void Request::quota_rollback(Template *         tmpl,
 void Request::failure_response(ErrorCode ec, const string& str_val,
                                RequestAttributes& att)
 {
+    struct timespec start;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    metrics->add_failure();
+
     vector<xmlrpc_c::value> arrayData;
 
     arrayData.push_back(xmlrpc_c::value_boolean(false));
@@ -648,6 +695,8 @@ void Request::failure_response(ErrorCode ec, const string& str_val,
     xmlrpc_c::value_array arrayresult(arrayData);
 
     *(att.retval) = arrayresult;
+
+    response_time += LatencyHistogram::elapsed(start);
 }
 
 /* -------------------------------------------------------------------------- */
@@ -693,6 +742,7 @@ string Request::failure_message(ErrorCode ec, RequestAttributes& att)
         case ACTION:
         case XML_RPC_API:
         case INTERNAL:
+        case BUSY:
             oss << att.resp_msg;
             break;
 
@@ -735,6 +785,10 @@ void Request::failure_response(ErrorCode ec, RequestAttributes& att)
 
 void Request::success_response(int id, RequestAttributes& att)
 {
+    struct timespec start;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
     vector<xmlrpc_c::value> arrayData;
 
     arrayData.push_back(xmlrpc_c::value_boolean(true));
@@ -745,12 +799,18 @@ void Request::success_response(int id, RequestAttributes& att)
     xmlrpc_c::value_array arrayresult(arrayData);
 
     *(att.retval) = arrayresult;
+
+    response_time += LatencyHistogram::elapsed(start);
 }
 
 /* -------------------------------------------------------------------------- */
 
 void Request::success_response(const string& val, RequestAttributes& att)
 {
+    struct timespec start;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
     vector<xmlrpc_c::value> arrayData;
 
     arrayData.push_back(xmlrpc_c::value_boolean(true));
@@ -760,6 +820,8 @@ void Request::success_response(const string& val, RequestAttributes& att)
     xmlrpc_c::value_array arrayresult(arrayData);
 
     *(att.retval) = arrayresult;
+
+    response_time += LatencyHistogram::elapsed(start);
 }
 
 /* -------------------------------------------------------------------------- */
@@ -767,6 +829,10 @@ void Request::success_response(const string& val, RequestAttributes& att)
 
 void Request::success_response(bool val, RequestAttributes& att)
 {
+    struct timespec start;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
     vector<xmlrpc_c::value> arrayData;
 
     arrayData.push_back(xmlrpc_c::value_boolean(true));
@@ -777,6 +843,8 @@ void Request::success_response(bool val, RequestAttributes& att)
     xmlrpc_c::value_array arrayresult(arrayData);
 
     *(att.retval) = arrayresult;
+
+    response_time += LatencyHistogram::elapsed(start);
 }
 
 /* -------------------------------------------------------------------------- */
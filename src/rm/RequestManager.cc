@@ -52,6 +52,7 @@
 #include "RequestManagerProxy.h"
 
 #include "Request.h"
+#include "Nebula.h"
 
 #include <sys/signal.h>
 #include <sys/socket.h>
@@ -73,7 +74,9 @@ RequestManager::RequestManager(
         const string& _xml_log_file,
         const string& call_log_format,
         const string& _listen_address,
-        int message_size):
+        int message_size,
+        int _metrics_port,
+        RequestScheduler * _scheduler):
             port(_port),
             socket_fd(-1),
             max_conn(_max_conn),
@@ -82,10 +85,15 @@ RequestManager::RequestManager(
             keepalive_max_conn(_keepalive_max_conn),
             timeout(_timeout),
             xml_log_file(_xml_log_file),
-            listen_address(_listen_address)
+            listen_address(_listen_address),
+            metrics_port(_metrics_port),
+            metrics_fd(-1),
+            scheduler(_scheduler)
 {
     Request::set_call_log_format(call_log_format);
 
+    Request::set_scheduler(scheduler);
+
     xmlrpc_limit_set(XMLRPC_XML_SIZE_LIMIT_ID, message_size);
 
     am.addListener(this);
@@ -165,7 +173,116 @@ extern "C" void * rm_xml_server_loop(void *arg)
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
-int RequestManager::setup_socket()
+extern "C" void * rm_metrics_server_loop(void *arg)
+{
+    RequestManager * rm;
+
+    if ( arg == 0 )
+    {
+        return 0;
+    }
+
+    rm = static_cast<RequestManager *>(arg);
+
+    // Cancelled while waiting in accept, read or write
+
+    pthread_setcancelstate(PTHREAD_CANCEL_ENABLE,0);
+
+    pthread_setcanceltype(PTHREAD_CANCEL_DEFERRED,0);
+
+    while (true)
+    {
+        int fd = accept(rm->metrics_fd, 0, 0);
+
+        if ( fd == -1 )
+        {
+            if ( errno != EINTR && errno != ECONNABORTED )
+            {
+                ostringstream oss;
+
+                oss << "Error accepting metrics connection: "
+                    << strerror(errno);
+
+                NebulaLog::log("ReM", Log::ERROR, oss);
+
+                sleep(1);
+            }
+
+            continue;
+        }
+
+        rm->serve_metrics(fd);
+
+        close(fd);
+    }
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void RequestManager::serve_metrics(int fd)
+{
+    char buffer[1024];
+
+    struct timeval tv = {1, 0};
+
+    ostringstream body;
+    ostringstream oss;
+
+    // Any request is answered with the metrics, just consume the request
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    if ( read(fd, buffer, sizeof(buffer)) <= 0 )
+    {
+        return;
+    }
+
+    RequestMetrics::to_prometheus(body);
+
+    if ( scheduler != 0 )
+    {
+        scheduler->to_prometheus(body);
+    }
+
+    AuthManager * authm = Nebula::instance().get_authm();
+
+    if ( authm != 0 )
+    {
+        authm->to_prometheus(body);
+    }
+
+    string str_body = body.str();
+
+    oss << "HTTP/1.0 200 OK\r\n"
+        << "Content-Type: text/plain; version=0.0.4\r\n"
+        << "Content-Length: " << str_body.size() << "\r\n"
+        << "Connection: close\r\n\r\n"
+        << str_body;
+
+    string response = oss.str();
+
+    size_t sent = 0;
+
+    while ( sent < response.size() )
+    {
+        ssize_t rc = send(fd, response.c_str() + sent, response.size() - sent,
+                MSG_NOSIGNAL);
+
+        if ( rc <= 0 )
+        {
+            return;
+        }
+
+        sent += rc;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+int RequestManager::setup_socket(const string& address, const string& sport,
+        int& fd)
 {
     int rc;
     int yes = 1;
@@ -177,7 +294,7 @@ int RequestManager::setup_socket()
     hints.ai_socktype = SOCK_STREAM;
     hints.ai_flags    = AI_PASSIVE;
 
-    rc = getaddrinfo(listen_address.c_str(), port.c_str(), &hints, &result);
+    rc = getaddrinfo(address.c_str(), sport.c_str(), &hints, &result);
 
     if ( rc != 0 )
     {
@@ -189,9 +306,9 @@ int RequestManager::setup_socket()
         return -1;
     }
 
-    socket_fd = socket(result->ai_family, result->ai_socktype, 0);
+    fd = socket(result->ai_family, result->ai_socktype, 0);
 
-    if ( socket_fd == -1 )
+    if ( fd == -1 )
     {
         ostringstream oss;
 
@@ -203,7 +320,7 @@ int RequestManager::setup_socket()
         return -1;
     }
 
-    rc = setsockopt(socket_fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(int));
+    rc = setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(int));
 
     if ( rc == -1 )
     {
@@ -212,16 +329,18 @@ int RequestManager::setup_socket()
         oss << "Cannot set socket options: " << strerror(errno);
         NebulaLog::log("ReM",Log::ERROR,oss);
 
-        close(socket_fd);
+        close(fd);
+
+        fd = -1;
 
         freeaddrinfo(result);
 
         return -1;
     }
 
-    fcntl(socket_fd,F_SETFD,FD_CLOEXEC); // Close socket in MADs
+    fcntl(fd,F_SETFD,FD_CLOEXEC); // Close socket in MADs
 
-    rc = bind(socket_fd, result->ai_addr, result->ai_addrlen);
+    rc = bind(fd, result->ai_addr, result->ai_addrlen);
 
     freeaddrinfo(result);
 
@@ -229,12 +348,14 @@ int RequestManager::setup_socket()
     {
         ostringstream oss;
 
-        oss << "Cannot bind to " << listen_address << ":" << port << " : "
+        oss << "Cannot bind to " << address << ":" << sport << " : "
             << strerror(errno);
 
         NebulaLog::log("ReM",Log::ERROR,oss);
 
-        close(socket_fd);
+        close(fd);
+
+        fd = -1;
 
         return -1;
     }
@@ -252,13 +373,33 @@ int RequestManager::start()
 
     NebulaLog::log("ReM",Log::INFO,"Starting Request Manager...");
 
-    int rc = setup_socket();
+    int rc = setup_socket(listen_address, port, socket_fd);
 
     if ( rc != 0 )
     {
         return -1;
     }
 
+    if ( metrics_port > 0 )
+    {
+        ostringstream mport;
+
+        mport << metrics_port;
+
+        if ( setup_socket("127.0.0.1", mport.str(), metrics_fd) != 0 )
+        {
+            return -1;
+        }
+
+        if ( listen(metrics_fd, 16) == -1 )
+        {
+            oss << "Cannot listen on metrics port: " << strerror(errno);
+            NebulaLog::log("ReM",Log::ERROR,oss);
+
+            return -1;
+        }
+    }
+
     register_xml_methods();
 
     pthread_attr_init (&pattr);
@@ -274,6 +415,20 @@ int RequestManager::start()
 
     pthread_create(&rm_xml_server_thread,&pattr,rm_xml_server_loop,(void *)this);
 
+    if ( metrics_fd != -1 )
+    {
+        oss.str("");
+
+        oss << "Starting metrics server, port " << metrics_port << " ...";
+        NebulaLog::log("ReM",Log::INFO,oss);
+
+        pthread_attr_init (&pattr);
+        pthread_attr_setdetachstate (&pattr, PTHREAD_CREATE_JOINABLE);
+
+        pthread_create(&rm_metrics_thread, &pattr, rm_metrics_server_loop,
+                (void *)this);
+    }
+
     return 0;
 }
 
@@ -292,6 +447,7 @@ void RequestManager::register_xml_methods()
     xmlrpc_c::methodPtr vm_migrate(new VirtualMachineMigrate());
     xmlrpc_c::methodPtr vm_action(new VirtualMachineAction());
     xmlrpc_c::methodPtr vm_monitoring(new VirtualMachineMonitoring());
+    xmlrpc_c::methodPtr vm_trace(new VirtualMachineTrace());
     xmlrpc_c::methodPtr vm_attach(new VirtualMachineAttach());
     xmlrpc_c::methodPtr vm_detach(new VirtualMachineDetach());
     xmlrpc_c::methodPtr vm_attachnic(new VirtualMachineAttachNic());
@@ -385,6 +541,7 @@ void RequestManager::register_xml_methods()
 
     // PoolInfo Methods
     xmlrpc_c::methodPtr hostpool_info(new HostPoolInfo());
+    xmlrpc_c::methodPtr hostpool_changes(new HostPoolChanges());
     xmlrpc_c::methodPtr datastorepool_info(new DatastorePoolInfo());
     xmlrpc_c::methodPtr vm_pool_info(new VirtualMachinePoolInfo());
     xmlrpc_c::methodPtr template_pool_info(new TemplatePoolInfo());
@@ -446,6 +603,7 @@ void RequestManager::register_xml_methods()
     // System Methods
     xmlrpc_c::methodPtr system_version(new SystemVersion());
     xmlrpc_c::methodPtr system_config(new SystemConfig());
+    xmlrpc_c::methodPtr system_metrics(new SystemMetrics());
     xmlrpc_c::methodPtr system_sql(new SystemSql());
 
     // Rename Methods
@@ -478,6 +636,7 @@ void RequestManager::register_xml_methods()
     RequestManagerRegistry.addMethod("one.vm.chown", vm_chown);
     RequestManagerRegistry.addMethod("one.vm.chmod", vm_chmod);
     RequestManagerRegistry.addMethod("one.vm.monitoring", vm_monitoring);
+    RequestManagerRegistry.addMethod("one.vm.trace", vm_trace);
     RequestManagerRegistry.addMethod("one.vm.attach", vm_attach);
     RequestManagerRegistry.addMethod("one.vm.detach", vm_detach);
     RequestManagerRegistry.addMethod("one.vm.attachnic", vm_attachnic);
@@ -526,6 +685,7 @@ void RequestManager::register_xml_methods()
 
     RequestManagerRegistry.addMethod("one.hostpool.info", hostpool_info);
     RequestManagerRegistry.addMethod("one.hostpool.monitoring", host_pool_monitoring);
+    RequestManagerRegistry.addMethod("one.hostpool.changes", hostpool_changes);
 
     /* Group related methods */
 
@@ -1064,6 +1224,7 @@ void RequestManager::register_xml_methods()
     /* System related methods */
     RequestManagerRegistry.addMethod("one.system.version", system_version);
     RequestManagerRegistry.addMethod("one.system.config", system_config);
+    RequestManagerRegistry.addMethod("one.system.metrics", system_metrics);
     RequestManagerRegistry.addMethod("one.system.sql", system_sql);
 };
 
@@ -372,6 +372,9 @@ void RequestManagerChown::request_execute(xmlrpc_c::paramList const& paramList,
         return;
     }
 
+    string obj_name = object->get_name();
+    int    obj_uid  = object->get_uid();
+
     if ( noid != -1 )
     {
         object->set_user(noid, nuname);
@@ -384,6 +387,11 @@ void RequestManagerChown::request_execute(xmlrpc_c::paramList const& paramList,
 
     pool->update(object);
 
+    if ( noid != -1 )
+    {
+        pool->update_cache_index(obj_name, obj_uid, obj_name, noid);
+    }
+
     object->unlock();
 
     success_response(oid, att);
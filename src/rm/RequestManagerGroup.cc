@@ -25,8 +25,6 @@ void GroupSetQuota::
     int     id        = xmlrpc_c::value_int(paramList.getInt(1));
     string  quota_str = xmlrpc_c::value_string(paramList.getString(2));
 
-    Group * group;
-
     Template quota_tmpl;
     int      rc;
 
@@ -50,21 +48,15 @@ void GroupSetQuota::
         return;
     }
 
-    group = static_cast<Group *>(pool->get(id,true));
+    QuotaLedger * ledger = static_cast<GroupPool *>(pool)->get_quota_ledger();
 
-    if ( group == 0 )
+    if ( ledger->set(id, &quota_tmpl, att.resp_msg) == -2 )
     {
         att.resp_id = id;
         failure_response(NO_EXISTS, att);
         return;
     }
 
-    group->quota.set(&quota_tmpl, att.resp_msg);
-
-    static_cast<GroupPool *>(pool)->update_quotas(group);
-
-    group->unlock();
-
     if ( rc != 0 )
     {
         failure_response(ACTION, att);
@@ -79,14 +79,22 @@ void HostMonitoring::request_execute(
     int id  = xmlrpc_c::value_int(paramList.getInt(1));
     int rc;
 
+    int resolution = 0;
+
     ostringstream oss;
 
+    if ( paramList.size() > 2 )
+    {
+        resolution = xmlrpc_c::value_int(paramList.getInt(2));
+    }
+
     if ( basic_authorization(id, att) == false )
     {
         return;
     }
 
-    rc = (static_cast<HostPool *>(pool))->dump_monitoring(oss, id);
+    rc = (static_cast<HostPool *>(pool))->dump_monitoring(oss, id,
+            resolution < 0 ? 0 : resolution);
 
     if ( rc != 0 )
     {
@@ -215,11 +215,17 @@ void VirtualMachinePoolMonitoring::request_execute(
         RequestAttributes& att)
 {
     int filter_flag = xmlrpc_c::value_int(paramList.getInt(1));
+    int resolution  = 0;
 
     ostringstream oss;
     string        where;
     int           rc;
 
+    if ( paramList.size() > 2 )
+    {
+        resolution = xmlrpc_c::value_int(paramList.getInt(2));
+    }
+
     if ( filter_flag < GROUP )
     {
         att.resp_msg = "Incorrect filter_flag";
@@ -229,7 +235,8 @@ void VirtualMachinePoolMonitoring::request_execute(
 
     where_filter(att, filter_flag, -1, -1, "", "", false, false, false, where);
 
-    rc = (static_cast<VirtualMachinePool *>(pool))->dump_monitoring(oss, where);
+    rc = (static_cast<VirtualMachinePool *>(pool))->dump_monitoring(oss, where,
+            resolution < 0 ? 0 : resolution);
 
     if ( rc != 0 )
     {
@@ -256,6 +263,75 @@ void HostPoolInfo::request_execute(
 /* ------------------------------------------------------------------------- */
 /* ------------------------------------------------------------------------- */
 
+void HostPoolChanges::request_execute(
+        xmlrpc_c::paramList const& paramList,
+        RequestAttributes& att)
+{
+    ostringstream oss;
+    ostringstream in_oids;
+
+    string where;
+    string current;
+
+    set<int> changed;
+    set<int> dropped;
+
+    set<int>::iterator it;
+
+    int rc = 0;
+
+    string revision = xmlrpc_c::value_string(paramList.getString(1));
+
+    bool delta = pool->get_changes(revision, changed, dropped, current);
+
+    oss << "<HOST_POOL_CHANGES>"
+        << "<REVISION>" << current << "</REVISION>"
+        << "<FULL>" << !delta << "</FULL>";
+
+    if ( !delta )
+    {
+        where_filter(att, ALL, -1, -1, "", "", false, false, false, where);
+
+        rc = pool->dump(oss, where, "");
+    }
+    else if ( !changed.empty() )
+    {
+        PoolSQL::in_filter("oid", changed, in_oids);
+
+        where_filter(att, ALL, -1, -1, in_oids.str(), "", false, false, false,
+                where);
+
+        rc = pool->dump(oss, where, "");
+    }
+    else
+    {
+        oss << "<HOST_POOL></HOST_POOL>";
+    }
+
+    if ( rc != 0 )
+    {
+        att.resp_msg = "Internal error";
+        failure_response(INTERNAL, att);
+        return;
+    }
+
+    oss << "<DELETED>";
+
+    for (it = dropped.begin(); it != dropped.end(); ++it)
+    {
+        oss << "<ID>" << *it << "</ID>";
+    }
+
+    oss << "</DELETED></HOST_POOL_CHANGES>";
+
+    success_response(oss.str(), att);
+
+    return;
+}
+
+/* ------------------------------------------------------------------------- */
+/* ------------------------------------------------------------------------- */
+
 void HostPoolMonitoring::request_execute(
         xmlrpc_c::paramList const& paramList,
         RequestAttributes& att)
@@ -264,9 +340,17 @@ void HostPoolMonitoring::request_execute(
     string        where;
     int           rc;
 
+    int resolution = 0;
+
+    if ( paramList.size() > 1 )
+    {
+        resolution = xmlrpc_c::value_int(paramList.getInt(1));
+    }
+
     where_filter(att, ALL, -1, -1, "", "", false, false, false, where);
 
-    rc = (static_cast<HostPool *>(pool))->dump_monitoring(oss, where);
+    rc = (static_cast<HostPool *>(pool))->dump_monitoring(oss, where,
+            resolution < 0 ? 0 : resolution);
 
     if ( rc != 0 )
     {
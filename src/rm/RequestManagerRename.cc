@@ -124,6 +124,8 @@ void RequestManagerRename::request_execute(xmlrpc_c::paramList const& paramList,
 
     pool->update(object);
 
+    pool->update_cache_index(old_name, operms.uid, new_name, operms.uid);
+
     object->unlock();
 
     batch_rename(oid);
@@ -52,6 +52,45 @@ void SystemConfig::request_execute(xmlrpc_c::paramList const& paramList,
 /* ------------------------------------------------------------------------- */
 /* ------------------------------------------------------------------------- */
 
+void SystemMetrics::request_execute(xmlrpc_c::paramList const& paramList,
+                                 RequestAttributes& att)
+{
+    ostringstream oss;
+
+    if ( att.gid != GroupPool::ONEADMIN_ID )
+    {
+        att.resp_msg = "The server metrics can only be retrieved by users "
+            "in the oneadmin group";
+        failure_response(AUTHORIZATION, att);
+        return;
+    }
+
+    oss << "<METRICS>";
+
+    RequestMetrics::to_xml(oss);
+
+    if ( scheduler != 0 )
+    {
+        scheduler->to_xml(oss);
+    }
+
+    AuthManager * authm = Nebula::instance().get_authm();
+
+    if ( authm != 0 )
+    {
+        authm->to_xml(oss);
+    }
+
+    oss << "</METRICS>";
+
+    success_response(oss.str(), att);
+
+    return;
+}
+
+/* ------------------------------------------------------------------------- */
+/* ------------------------------------------------------------------------- */
+
 void SystemSql::request_execute(xmlrpc_c::paramList const& paramList,
                                  RequestAttributes& att)
 {
@@ -158,7 +158,6 @@ int UserSetQuota::user_action(int     user_id,
     Template quota_tmpl;
 
     int    rc;
-    User * user;
 
     if ( user_id == UserPool::ONEADMIN_ID )
     {
@@ -173,19 +172,15 @@ int UserSetQuota::user_action(int     user_id,
         return -1;
     }
 
-    user = static_cast<User *>(pool->get(user_id,true));
+    QuotaLedger * ledger = static_cast<UserPool *>(pool)->get_quota_ledger();
 
-    if ( user == 0 )
+    rc = ledger->set(user_id, &quota_tmpl, error_str);
+
+    if ( rc == -2 )
     {
         return -1;
     }
 
-    rc = user->quota.set(&quota_tmpl, error_str);
-
-    static_cast<UserPool *>(pool)->update_quotas(user);
-
-    user->unlock();
-
     return rc;
 }
 
@@ -49,6 +49,9 @@ bool RequestManagerVirtualMachine::vm_authorization(
     if ( att.uid == 0 )
     {
         object->unlock();
+
+        start_trace(oid, att);
+
         return true;
     }
 
@@ -95,6 +98,8 @@ bool RequestManagerVirtualMachine::vm_authorization(
         return false;
     }
 
+    start_trace(oid, att);
+
     return true;
 }
 
@@ -141,66 +146,47 @@ bool RequestManagerVirtualMachine::quota_resize_authorization(
     DefaultQuotas user_dquotas  = nd.get_default_user_quota();
     DefaultQuotas group_dquotas = nd.get_default_group_quota();
 
+    // Missing users or groups are skipped (rc == -2)
     if (vm_perms.uid != UserPool::ONEADMIN_ID)
     {
-        User * user  = upool->get(vm_perms.uid, true);
+        rc = upool->get_quota_ledger()->update(vm_perms.uid, Quotas::VM,
+                deltas, user_dquotas, att.resp_msg);
 
-        if ( user != 0 )
+        if (rc == -1)
         {
-            rc = user->quota.quota_update(Quotas::VM, deltas, user_dquotas, att.resp_msg);
-
-            if (rc == false)
-            {
-                ostringstream oss;
-
-                oss << object_name(PoolObjectSQL::USER) << " [" << vm_perms.uid << "] "
-                    << att.resp_msg;
-
-                att.resp_msg = oss.str();
-
-                failure_response(AUTHORIZATION, att);
+            ostringstream oss;
 
-                user->unlock();
+            oss << object_name(PoolObjectSQL::USER) << " [" << vm_perms.uid << "] "
+                << att.resp_msg;
 
-                return false;
-            }
+            att.resp_msg = oss.str();
 
-            upool->update_quotas(user);
+            failure_response(AUTHORIZATION, att);
 
-            user->unlock();
+            return false;
         }
     }
 
     if (vm_perms.gid != GroupPool::ONEADMIN_ID)
     {
-        Group * group  = gpool->get(vm_perms.gid, true);
+        rc = gpool->get_quota_ledger()->update(vm_perms.gid, Quotas::VM,
+                deltas, group_dquotas, att.resp_msg);
 
-        if ( group != 0 )
+        if (rc == -1)
         {
-            rc = group->quota.quota_update(Quotas::VM, deltas, group_dquotas, att.resp_msg);
-
-            if (rc == false)
-            {
-                ostringstream oss;
-                RequestAttributes att_tmp(vm_perms.uid, -1, att);
-
-                oss << object_name(PoolObjectSQL::GROUP) << " [" << vm_perms.gid << "] "
-                    << att.resp_msg;
-
-                att.resp_msg = oss.str();
-
-                failure_response(AUTHORIZATION, att);
+            ostringstream oss;
+            RequestAttributes att_tmp(vm_perms.uid, -1, att);
 
-                group->unlock();
+            oss << object_name(PoolObjectSQL::GROUP) << " [" << vm_perms.gid << "] "
+                << att.resp_msg;
 
-                quota_rollback(deltas, Quotas::VM, att_tmp);
+            att.resp_msg = oss.str();
 
-                return false;
-            }
+            failure_response(AUTHORIZATION, att);
 
-            gpool->update_quotas(group);
+            quota_rollback(deltas, Quotas::VM, att_tmp);
 
-            group->unlock();
+            return false;
         }
     }
 
@@ -1585,8 +1571,15 @@ void VirtualMachineMonitoring::request_execute(
     int  id = xmlrpc_c::value_int(paramList.getInt(1));
     int  rc;
 
+    int  resolution = 0;
+
     ostringstream oss;
 
+    if ( paramList.size() > 2 )
+    {
+        resolution = xmlrpc_c::value_int(paramList.getInt(2));
+    }
+
     bool auth = vm_authorization(id, 0, 0, att, 0, 0, 0, auth_op);
 
     if ( auth == false )
@@ -1594,7 +1587,8 @@ void VirtualMachineMonitoring::request_execute(
         return;
     }
 
-    rc = (static_cast<VirtualMachinePool *>(pool))->dump_monitoring(oss, id);
+    rc = (static_cast<VirtualMachinePool *>(pool))->dump_monitoring(oss, id,
+            resolution < 0 ? 0 : resolution);
 
     if ( rc != 0 )
     {
@@ -1611,6 +1605,31 @@ void VirtualMachineMonitoring::request_execute(
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
+void VirtualMachineTrace::request_execute(
+        xmlrpc_c::paramList const&  paramList,
+        RequestAttributes&          att)
+{
+    int  id = xmlrpc_c::value_int(paramList.getInt(1));
+
+    ostringstream oss;
+
+    bool auth = vm_authorization(id, 0, 0, att, 0, 0, 0, auth_op);
+
+    if ( auth == false )
+    {
+        return;
+    }
+
+    Tracer::to_xml(id, oss);
+
+    success_response(oss.str(), att);
+
+    return;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
 void VirtualMachineAttach::request_execute(xmlrpc_c::paramList const& paramList,
                                             RequestAttributes& att)
 {
@@ -0,0 +1,152 @@
+/* -------------------------------------------------------------------------- */
+/* Copyright 2002-2017, OpenNebula Project, OpenNebula Systems                */
+/*                                                                            */
+/* Licensed under the Apache License, Version 2.0 (the "License"); you may    */
+/* not use this file except in compliance with the License. You may obtain    */
+/* a copy of the License at                                                   */
+/*                                                                            */
+/* http://www.apache.org/licenses/LICENSE-2.0                                 */
+/*                                                                            */
+/* Unless required by applicable law or agreed to in writing, software        */
+/* distributed under the License is distributed on an "AS IS" BASIS,          */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   */
+/* See the License for the specific language governing permissions and        */
+/* limitations under the License.                                             */
+/* -------------------------------------------------------------------------- */
+
+#include "RequestMetrics.h"
+#include "NebulaUtil.h"
+
+map<string, RequestMetrics::Method *> RequestMetrics::methods;
+
+pthread_mutex_t RequestMetrics::mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+const char * RequestMetrics::stage_name(unsigned int stage)
+{
+    static const char * names[] = {"auth", "lock_wait", "execution",
+        "response", "total"};
+
+    return stage < STAGES ? names[stage] : "";
+}
+
+/* -------------------------------------------------------------------------- */
+
+RequestMetrics::Method * RequestMetrics::get(const string& method)
+{
+    Method * m;
+
+    pthread_mutex_lock(&mutex);
+
+    map<string, Method *>::iterator it = methods.find(method);
+
+    if ( it != methods.end() )
+    {
+        m = it->second;
+    }
+    else
+    {
+        m = new Method();
+
+        methods.insert(make_pair(method, m));
+    }
+
+    pthread_mutex_unlock(&mutex);
+
+    return m;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void RequestMetrics::to_xml(ostringstream& oss)
+{
+    map<string, Method *>::iterator it;
+
+    pthread_mutex_lock(&mutex);
+
+    oss << "<REQUEST_METRICS>";
+
+    for (it = methods.begin(); it != methods.end(); ++it)
+    {
+        Method * m = it->second;
+
+        if ( m->stages[TOTAL].count() == 0 )
+        {
+            continue;
+        }
+
+        oss << "<METHOD>"
+            << "<NAME>" << it->first << "</NAME>"
+            << "<FAILURES>"
+            << __atomic_load_n(&m->failures, __ATOMIC_RELAXED)
+            << "</FAILURES>";
+
+        for (unsigned int i = 0; i < STAGES; i++)
+        {
+            string name = stage_name(i);
+
+            m->stages[i].to_xml(oss, one_util::toupper(name));
+        }
+
+        oss << "</METHOD>";
+    }
+
+    oss << "</REQUEST_METRICS>";
+
+    pthread_mutex_unlock(&mutex);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void RequestMetrics::to_prometheus(ostringstream& oss)
+{
+    map<string, Method *>::iterator it;
+
+    static const string metric = "opennebula_xmlrpc_request_duration_seconds";
+
+    pthread_mutex_lock(&mutex);
+
+    oss << "# HELP " << metric << " Latency of the XML-RPC requests by "
+        << "method and stage\n"
+        << "# TYPE " << metric << " histogram\n";
+
+    for (it = methods.begin(); it != methods.end(); ++it)
+    {
+        if ( it->second->stages[TOTAL].count() == 0 )
+        {
+            continue;
+        }
+
+        for (unsigned int i = 0; i < STAGES; i++)
+        {
+            ostringstream labels;
+
+            labels << "method=\"" << it->first << "\",stage=\""
+                   << stage_name(i) << "\"";
+
+            it->second->stages[i].to_prometheus(oss, metric, labels.str());
+        }
+    }
+
+    oss << "# HELP opennebula_xmlrpc_request_failures_total Failed XML-RPC "
+        << "requests by method\n"
+        << "# TYPE opennebula_xmlrpc_request_failures_total counter\n";
+
+    for (it = methods.begin(); it != methods.end(); ++it)
+    {
+        if ( it->second->stages[TOTAL].count() == 0 )
+        {
+            continue;
+        }
+
+        oss << "opennebula_xmlrpc_request_failures_total{method=\""
+            << it->first << "\"} "
+            << __atomic_load_n(&it->second->failures, __ATOMIC_RELAXED)
+            << "\n";
+    }
+
+    pthread_mutex_unlock(&mutex);
+}
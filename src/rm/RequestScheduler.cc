@@ -0,0 +1,290 @@
+/* -------------------------------------------------------------------------- */
+/* Copyright 2002-2017, OpenNebula Project, OpenNebula Systems                */
+/*                                                                            */
+/* Licensed under the Apache License, Version 2.0 (the "License"); you may    */
+/* not use this file except in compliance with the License. You may obtain    */
+/* a copy of the License at                                                   */
+/*                                                                            */
+/* http://www.apache.org/licenses/LICENSE-2.0                                 */
+/*                                                                            */
+/* Unless required by applicable law or agreed to in writing, software        */
+/* distributed under the License is distributed on an "AS IS" BASIS,          */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   */
+/* See the License for the specific language governing permissions and        */
+/* limitations under the License.                                             */
+/* -------------------------------------------------------------------------- */
+
+#include "RequestScheduler.h"
+#include "NebulaUtil.h"
+#include "NebulaLog.h"
+
+#include <errno.h>
+#include <vector>
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+RequestScheduler::RequestScheduler(unsigned int _workers,
+        unsigned int _queue_size, time_t _queue_timeout,
+        const map<string, unsigned int>& _limits):workers(_workers),
+        queue_size(_queue_size), queue_timeout(_queue_timeout),
+        limits(_limits), running(0), queued(0)
+{
+    pthread_mutex_init(&mutex, 0);
+
+    pthread_cond_init(&cond, 0);
+}
+
+/* -------------------------------------------------------------------------- */
+
+RequestScheduler::~RequestScheduler()
+{
+    pthread_mutex_destroy(&mutex);
+
+    pthread_cond_destroy(&cond);
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+RequestScheduler::Method& RequestScheduler::get_method(const string& method)
+{
+    map<string, Method>::iterator it = methods.find(method);
+
+    if ( it != methods.end() )
+    {
+        return it->second;
+    }
+
+    Method m;
+
+    map<string, unsigned int>::const_iterator lt = limits.find(method);
+
+    m.limit   = lt != limits.end() ? lt->second : 0;
+    m.running = 0;
+
+    m.calls    = 0;
+    m.rejected = 0;
+
+    m.queue_time     = 0;
+    m.max_queue_time = 0;
+
+    return methods.insert(make_pair(method, m)).first->second;
+}
+
+/* -------------------------------------------------------------------------- */
+
+static double elapsed(const struct timespec& start)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (now.tv_sec - start.tv_sec) + (now.tv_nsec - start.tv_nsec) / 1e9;
+}
+
+/* -------------------------------------------------------------------------- */
+
+int RequestScheduler::admit(const string& method)
+{
+    struct timespec wait_start;
+    struct timespec timeout;
+
+    int rc = 0;
+
+    pthread_mutex_lock(&mutex);
+
+    Method& m = get_method(method);
+
+    if ( can_run(m) )
+    {
+        start(m);
+
+        pthread_mutex_unlock(&mutex);
+
+        return 0;
+    }
+
+    if ( queued >= queue_size )
+    {
+        m.rejected++;
+
+        pthread_mutex_unlock(&mutex);
+
+        NebulaLog::log("ReM", Log::DEBUG, "Request queue full, rejecting " +
+                method + " request.");
+
+        return -1;
+    }
+
+    queued++;
+
+    clock_gettime(CLOCK_MONOTONIC, &wait_start);
+
+    clock_gettime(CLOCK_REALTIME, &timeout);
+
+    timeout.tv_sec += queue_timeout;
+
+    while ( !can_run(m) && rc != ETIMEDOUT )
+    {
+        rc = pthread_cond_timedwait(&cond, &mutex, &timeout);
+    }
+
+    queued--;
+
+    if ( !can_run(m) )
+    {
+        m.rejected++;
+
+        pthread_mutex_unlock(&mutex);
+
+        NebulaLog::log("ReM", Log::DEBUG, "Timeout in request queue, "
+                "rejecting " + method + " request.");
+
+        return -1;
+    }
+
+    double qtime = elapsed(wait_start);
+
+    m.queue_time += qtime;
+
+    if ( qtime > m.max_queue_time )
+    {
+        m.max_queue_time = qtime;
+    }
+
+    start(m);
+
+    pthread_mutex_unlock(&mutex);
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void RequestScheduler::release(const string& method)
+{
+    pthread_mutex_lock(&mutex);
+
+    Method& m = get_method(method);
+
+    running--;
+
+    m.running--;
+
+    // Waiting requests may be of different methods
+    pthread_cond_broadcast(&cond);
+
+    pthread_mutex_unlock(&mutex);
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void RequestScheduler::to_xml(ostringstream& oss)
+{
+    map<string, Method>::iterator it;
+
+    pthread_mutex_lock(&mutex);
+
+    oss << "<REQUEST_SCHEDULER>"
+        << "<WORKERS>" << workers << "</WORKERS>"
+        << "<RUNNING>" << running << "</RUNNING>"
+        << "<QUEUED>"  << queued  << "</QUEUED>";
+
+    for (it = methods.begin(); it != methods.end(); ++it)
+    {
+        const Method& m = it->second;
+
+        oss << "<METHOD>"
+            << "<NAME>"     << it->first  << "</NAME>"
+            << "<LIMIT>"    << m.limit    << "</LIMIT>"
+            << "<RUNNING>"  << m.running  << "</RUNNING>"
+            << "<CALLS>"    << m.calls    << "</CALLS>"
+            << "<REJECTED>" << m.rejected << "</REJECTED>"
+            << "<QUEUE_TIME>"     << m.queue_time     << "</QUEUE_TIME>"
+            << "<MAX_QUEUE_TIME>" << m.max_queue_time << "</MAX_QUEUE_TIME>"
+            << "</METHOD>";
+    }
+
+    oss << "</REQUEST_SCHEDULER>";
+
+    pthread_mutex_unlock(&mutex);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void RequestScheduler::to_prometheus(ostringstream& oss)
+{
+    map<string, Method>::iterator it;
+
+    pthread_mutex_lock(&mutex);
+
+    oss << "# HELP opennebula_xmlrpc_running Requests being executed\n"
+        << "# TYPE opennebula_xmlrpc_running gauge\n"
+        << "opennebula_xmlrpc_running " << running << "\n"
+        << "# HELP opennebula_xmlrpc_queued Requests waiting to be executed\n"
+        << "# TYPE opennebula_xmlrpc_queued gauge\n"
+        << "opennebula_xmlrpc_queued " << queued << "\n";
+
+    oss << "# HELP opennebula_xmlrpc_rejected_total Requests rejected by "
+        << "the scheduler\n"
+        << "# TYPE opennebula_xmlrpc_rejected_total counter\n";
+
+    for (it = methods.begin(); it != methods.end(); ++it)
+    {
+        oss << "opennebula_xmlrpc_rejected_total{method=\"" << it->first
+            << "\"} " << it->second.rejected << "\n";
+    }
+
+    oss << "# HELP opennebula_xmlrpc_queue_seconds_total Time requests "
+        << "waited to be executed\n"
+        << "# TYPE opennebula_xmlrpc_queue_seconds_total counter\n";
+
+    for (it = methods.begin(); it != methods.end(); ++it)
+    {
+        oss << "opennebula_xmlrpc_queue_seconds_total{method=\"" << it->first
+            << "\"} " << it->second.queue_time << "\n";
+    }
+
+    pthread_mutex_unlock(&mutex);
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+int RequestScheduler::parse_limits(const string& str,
+        map<string, unsigned int>& limits, string& error_str)
+{
+    vector<string> limit_str = one_util::split(str, ',', true);
+    vector<string>::iterator it;
+
+    for (it = limit_str.begin(); it != limit_str.end(); ++it)
+    {
+        size_t pos = it->find(':');
+
+        if ( pos == string::npos || pos == 0 )
+        {
+            error_str = "Wrong method limit: " + *it;
+            return -1;
+        }
+
+        string method = one_util::trim(it->substr(0, pos));
+
+        unsigned int limit;
+
+        istringstream iss(it->substr(pos + 1));
+
+        iss >> limit;
+
+        if ( iss.fail() || limit == 0 )
+        {
+            error_str = "Wrong method limit: " + *it;
+            return -1;
+        }
+
+        limits[method] = limit;
+    }
+
+    return 0;
+}
@@ -24,6 +24,12 @@
 
 using namespace std;
 
+/**
+ *  The hosts are kept across scheduling cycles and updated with the changes
+ *  made in oned since the last cycle (one.hostpool.changes). The whole pool
+ *  is loaded in the first cycle, when oned resets its change log or if the
+ *  incremental update fails.
+ */
 class HostPoolXML : public PoolXML
 {
 public:
@@ -47,7 +53,7 @@ public:
 
     /**
      * For each Host in a cluster, adds the cluster template as a new
-     * Host xml element
+     * Host xml element. Any previous cluster template is replaced.
      *
      * @param clpool Cluster pool
      */
@@ -63,6 +69,35 @@ protected:
     void add_object(xmlNodePtr node);
 
     int load_info(xmlrpc_c::value &result);
+
+private:
+    /**
+     *  Revision of the pool in oned the hosts are up to date with, empty to
+     *  load the whole pool
+     */
+    string revision;
+
+    /**
+     *  Updates the hosts with the changes since the last revision
+     *    @return 0 on success
+     */
+    int update_changes();
+
+    /**
+     *  Reloads a host from oned
+     *    @param oid of the host
+     *    @return 0 on success
+     */
+    int reload(int oid);
+
+    /**
+     *  Removes a host from the pool
+     *    @param oid of the host
+     */
+    void remove(int oid)
+    {
+        delete erase(oid);
+    };
 };
 
 #endif /* HOST_POOL_XML_H_ */
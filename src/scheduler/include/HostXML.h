@@ -54,6 +54,14 @@ public:
         return dispatched_vms.size();
     }
 
+    /**
+     *  Pseudo-attributes computed by search (see __search), their value
+     *  depends on the value looked for and on the VMs dispatched in this
+     *  cycle.
+     */
+    static const char *pseudo_attributes[];
+    static int num_pseudo_attributes;
+
     /**
      *  Tests whether a new VM can be hosted by the host or not
      *    @param cpu needed by the VM (percentage)
@@ -237,7 +245,7 @@ private:
     {
         string s_name(name);
 
-        if (s_name == "CURRENT_VMS")
+        if (s_name == pseudo_attributes[0]) //CURRENT_VMS
         {
             typename std::vector<T>::iterator it;
             std::vector<T> results;
@@ -0,0 +1,110 @@
+/* -------------------------------------------------------------------------- */
+/* Copyright 2002-2017, OpenNebula Project, OpenNebula Systems                */
+/*                                                                            */
+/* Licensed under the Apache License, Version 2.0 (the "License"); you may    */
+/* not use this file except in compliance with the License. You may obtain    */
+/* a copy of the License at                                                   */
+/*                                                                            */
+/* http://www.apache.org/licenses/LICENSE-2.0                                 */
+/*                                                                            */
+/* Unless required by applicable law or agreed to in writing, software        */
+/* distributed under the License is distributed on an "AS IS" BASIS,          */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   */
+/* See the License for the specific language governing permissions and        */
+/* limitations under the License.                                             */
+/* -------------------------------------------------------------------------- */
+
+
+#ifndef MATCH_THREAD_POOL_H_
+#define MATCH_THREAD_POOL_H_
+
+#include <vector>
+#include <pthread.h>
+
+extern "C" void * match_thread_loop(void *arg);
+
+/**
+ *  A MatchJob is a unit of work split in independent chunks, that can be
+ *  processed concurrently by the MatchThreadPool threads.
+ */
+class MatchJob
+{
+public:
+    virtual ~MatchJob(){};
+
+    /**
+     *  Process a chunk of the job. This method is called concurrently from
+     *  the pool threads, each chunk is processed exactly once.
+     *    @param chunk index of the chunk, in [0, num_chunks)
+     */
+    virtual void execute(int chunk) = 0;
+};
+
+/**
+ *  Set of threads used by the scheduler to evaluate the hosts of a VM in
+ *  parallel. The threads are started once and reused for every job.
+ */
+class MatchThreadPool
+{
+public:
+    /**
+     *  @param num_threads total number of threads processing a job, including
+     *  the calling thread. A pool of 1 thread runs the jobs sequentially
+     */
+    MatchThreadPool(unsigned int num_threads);
+
+    ~MatchThreadPool();
+
+    /**
+     *  Process all the chunks of a job. The calling thread also process
+     *  chunks and this function returns when all of them are done.
+     *    @param job to process
+     *    @param num_chunks number of chunks of the job
+     */
+    void run(MatchJob * job, int num_chunks);
+
+    /**
+     *  @return number of threads processing a job
+     */
+    unsigned int size() const
+    {
+        return threads.size() + 1;
+    };
+
+private:
+    friend void * match_thread_loop(void *arg);
+
+    /**
+     *  Loop executed by the pool threads
+     */
+    void do_chunks();
+
+    std::vector<pthread_t> threads;
+
+    // -------------------------------------------------------------------------
+    // Current job, protected by mutex
+    // -------------------------------------------------------------------------
+    MatchJob * job;
+
+    int num_chunks;
+
+    int next_chunk;
+
+    int pending_chunks;
+
+    bool finalize;
+
+    pthread_mutex_t mutex;
+
+    /**
+     *  Signals the pool threads that there are new chunks to process
+     */
+    pthread_cond_t  job_cond;
+
+    /**
+     *  Signals the calling thread that all the chunks has been processed
+     */
+    pthread_cond_t  done_cond;
+};
+
+#endif /*MATCH_THREAD_POOL_H_*/
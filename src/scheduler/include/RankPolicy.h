@@ -19,6 +19,7 @@
 
 #include "SchedulerPolicy.h"
 #include "Scheduler.h"
+#include "ExpressionProgram.h"
 
 using namespace std;
 
@@ -73,13 +74,18 @@ private:
             return;
         }
 
+        ExpressionProgram tmp;
+
+        const ExpressionProgram * prog = ExpressionProgram::get(srank,
+                ExpressionProgram::ARITH, tmp);
+
         for (unsigned int i=0; i<resources.size(); rank=0, i++)
         {
             resource = pool->get(resources[i]->oid);
 
             if ( resource != 0 )
             {
-                rc = resource->eval_arith(srank, rank, &errmsg);
+                rc = prog->eval_arith(resource, rank, &errmsg);
 
                 if (rc != 0)
                 {
@@ -90,9 +96,10 @@ private:
                     if (errmsg != 0)
                     {
                         oss << ", error: " << errmsg;
-                        errmsg = 0;
 
                         free(errmsg);
+
+                        errmsg = 0;
                     }
 
                     NebulaLog::log("RANK",Log::ERROR,oss);
@@ -27,6 +27,7 @@
 #include "SchedulerPolicy.h"
 #include "ActionManager.h"
 #include "AclXML.h"
+#include "MatchThreadPool.h"
 
 using namespace std;
 
@@ -64,7 +65,8 @@ protected:
         one_xmlrpc(""),
         machines_limit(0),
         dispatch_limit(0),
-        host_dispatch_limit(0)
+        host_dispatch_limit(0),
+        match_pool(0)
     {
         am.addListener(this);
     };
@@ -85,6 +87,8 @@ protected:
         delete vmgpool;
 
         delete acls;
+
+        delete match_pool;
     };
 
     // ---------------------------------------------------------------
@@ -183,6 +187,11 @@ private:
      */
     unsigned int host_dispatch_limit;
 
+    /**
+     *  Threads used to match the hosts of each pending VM
+     */
+    MatchThreadPool * match_pool;
+
     /**
      *  OpenNebula zone id.
      */
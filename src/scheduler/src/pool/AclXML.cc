@@ -89,6 +89,8 @@ int AclXML::load_rules(const string& xml_str)
 
     acl_xml.free_nodes(rules);
 
+    acl_index.replace(acl_rules);
+
     return 0;
 }
 
@@ -106,5 +108,7 @@ void AclXML::flush_rules()
 
     acl_rules.clear();
     acl_rules_oids.clear();
+
+    acl_index.clear();
 }
 
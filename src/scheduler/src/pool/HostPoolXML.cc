@@ -21,7 +21,14 @@ int HostPoolXML::set_up()
     ostringstream   oss;
     int             rc;
 
-    rc = PoolXML::set_up();
+    rc = update_changes();
+
+    if ( rc != 0 )
+    {
+        revision.clear();
+
+        rc = PoolXML::set_up();
+    }
 
     if ( rc == 0 )
     {
@@ -52,6 +59,160 @@ int HostPoolXML::set_up()
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
+int HostPoolXML::update_changes()
+{
+    xmlrpc_c::value result;
+
+    vector<int> ids;
+    vector<int> stale;
+
+    vector<int>::iterator id_it;
+
+    vector<xmlNodePtr> nodes;
+
+    map<int, ObjectXML*>::iterator it;
+
+    string full;
+
+    try
+    {
+        client->call("one.hostpool.changes", "s", &result, revision.c_str());
+    }
+    catch (exception const& e)
+    {
+        ostringstream   oss;
+        oss << "Cannot get host pool changes, loading the pool: " << e.what();
+
+        NebulaLog::log("HOST", Log::DEBUG, oss);
+
+        return -1;
+    }
+
+    vector<xmlrpc_c::value> values =
+                    xmlrpc_c::value_array(result).vectorValueValue();
+
+    bool   success = xmlrpc_c::value_boolean( values[0] );
+    string message = xmlrpc_c::value_string(  values[1] );
+
+    if ( !success || update_from_str(message) != 0 )
+    {
+        ostringstream oss;
+
+        oss << "Cannot get host pool changes, loading the pool: " << message;
+
+        NebulaLog::log("HOST", Log::DEBUG, oss);
+
+        return -1;
+    }
+
+    // -------------------------------------------------------------------------
+    // Hosts updated by the last cycle (dispatched VMs) are reloaded
+    // -------------------------------------------------------------------------
+    for (it = objects.begin(); it != objects.end(); it++)
+    {
+        if ( static_cast<HostXML *>(it->second)->dispatched() > 0 )
+        {
+            stale.push_back(it->first);
+        }
+    }
+
+    xpath(full, "/HOST_POOL_CHANGES/FULL", "1");
+
+    if ( full != "0" )
+    {
+        flush();
+
+        stale.clear();
+    }
+    else
+    {
+        xpaths(ids, "/HOST_POOL_CHANGES/HOST_POOL/HOST/ID");
+        xpaths(ids, "/HOST_POOL_CHANGES/DELETED/ID");
+
+        for (id_it = ids.begin(); id_it != ids.end(); id_it++)
+        {
+            remove(*id_it);
+        }
+    }
+
+    get_nodes("/HOST_POOL_CHANGES/HOST_POOL/HOST[STATE=1 or STATE=2]", nodes);
+
+    for (unsigned int i = 0 ; i < nodes.size(); i++)
+    {
+        add_object(nodes[i]);
+    }
+
+    free_nodes(nodes);
+
+    for (id_it = stale.begin(); id_it != stale.end(); id_it++)
+    {
+        HostXML * host = get(*id_it);
+
+        if ( host == 0 || host->dispatched() == 0 )
+        {
+            continue; //Removed or updated with the changes
+        }
+
+        if ( reload(*id_it) != 0 )
+        {
+            return -1;
+        }
+    }
+
+    xpath(revision, "/HOST_POOL_CHANGES/REVISION", "");
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+
+int HostPoolXML::reload(int oid)
+{
+    xmlrpc_c::value result;
+
+    try
+    {
+        client->call("one.host.info", "i", &result, oid);
+    }
+    catch (exception const& e)
+    {
+        return -1;
+    }
+
+    vector<xmlrpc_c::value> values =
+                    xmlrpc_c::value_array(result).vectorValueValue();
+
+    bool   success = xmlrpc_c::value_boolean( values[0] );
+    string message = xmlrpc_c::value_string(  values[1] );
+
+    remove(oid);
+
+    if ( !success )
+    {
+        return 0; //Host no longer exists
+    }
+
+    HostXML * host = new HostXML(message);
+
+    int state;
+
+    host->xpath(state, "/HOST/STATE", -1);
+
+    if ( state == 1 || state == 2 )
+    {
+        objects.insert(pair<int,ObjectXML*>(oid, host));
+    }
+    else
+    {
+        delete host;
+    }
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
 void HostPoolXML::add_object(xmlNodePtr node)
 {
     if ( node == 0 || node->children == 0 )
@@ -110,6 +271,8 @@ void HostPoolXML::merge_clusters(ClusterPoolXML * clpool)
 
         cluster = clpool->get(cluster_id);
 
+        host->remove_nodes("/HOST/CLUSTER_TEMPLATE");
+
         if(cluster != 0)
         {
             nodes.clear();
@@ -33,6 +33,11 @@ const char *HostXML::host_paths[] = {
     "/HOST/",
     "/HOST/CLUSTER_TEMPLATE/"};
 
+int HostXML::num_pseudo_attributes = 1;
+
+const char *HostXML::pseudo_attributes[] = {
+    "CURRENT_VMS"};
+
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
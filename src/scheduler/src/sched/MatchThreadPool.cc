@@ -0,0 +1,179 @@
+/* -------------------------------------------------------------------------- */
+/* Copyright 2002-2017, OpenNebula Project, OpenNebula Systems                */
+/*                                                                            */
+/* Licensed under the Apache License, Version 2.0 (the "License"); you may    */
+/* not use this file except in compliance with the License. You may obtain    */
+/* a copy of the License at                                                   */
+/*                                                                            */
+/* http://www.apache.org/licenses/LICENSE-2.0                                 */
+/*                                                                            */
+/* Unless required by applicable law or agreed to in writing, software        */
+/* distributed under the License is distributed on an "AS IS" BASIS,          */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   */
+/* See the License for the specific language governing permissions and        */
+/* limitations under the License.                                             */
+/* -------------------------------------------------------------------------- */
+
+
+#include "MatchThreadPool.h"
+#include "NebulaLog.h"
+
+#include <sstream>
+
+using namespace std;
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+extern "C" void * match_thread_loop(void *arg)
+{
+    MatchThreadPool * pool = static_cast<MatchThreadPool *>(arg);
+
+    pool->do_chunks();
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+MatchThreadPool::MatchThreadPool(unsigned int num_threads):job(0), num_chunks(0),
+    next_chunk(0), pending_chunks(0), finalize(false)
+{
+    pthread_attr_t pattr;
+
+    pthread_mutex_init(&mutex, 0);
+
+    pthread_cond_init(&job_cond, 0);
+    pthread_cond_init(&done_cond, 0);
+
+    pthread_attr_init(&pattr);
+    pthread_attr_setdetachstate(&pattr, PTHREAD_CREATE_JOINABLE);
+
+    for (unsigned int i = 1 ; i < num_threads ; i++)
+    {
+        pthread_t id;
+
+        if ( pthread_create(&id, &pattr, match_thread_loop, (void *) this) != 0 )
+        {
+            NebulaLog::log("SCHED", Log::ERROR, "Could not start match thread");
+            break;
+        }
+
+        threads.push_back(id);
+    }
+
+    pthread_attr_destroy(&pattr);
+
+    ostringstream oss;
+
+    oss << "Host matching will use " << size() << " threads";
+
+    NebulaLog::log("SCHED", Log::INFO, oss);
+}
+
+/* -------------------------------------------------------------------------- */
+
+MatchThreadPool::~MatchThreadPool()
+{
+    vector<pthread_t>::iterator it;
+
+    pthread_mutex_lock(&mutex);
+
+    finalize = true;
+
+    pthread_cond_broadcast(&job_cond);
+
+    pthread_mutex_unlock(&mutex);
+
+    for (it = threads.begin(); it != threads.end(); ++it)
+    {
+        pthread_join(*it, 0);
+    }
+
+    pthread_mutex_destroy(&mutex);
+
+    pthread_cond_destroy(&job_cond);
+    pthread_cond_destroy(&done_cond);
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+void MatchThreadPool::run(MatchJob * _job, int _num_chunks)
+{
+    if ( _num_chunks <= 0 )
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&mutex);
+
+    job            = _job;
+    num_chunks     = _num_chunks;
+    next_chunk     = 0;
+    pending_chunks = _num_chunks;
+
+    if ( _num_chunks > 1 )
+    {
+        pthread_cond_broadcast(&job_cond);
+    }
+
+    while ( next_chunk < num_chunks )
+    {
+        int chunk = next_chunk++;
+
+        pthread_mutex_unlock(&mutex);
+
+        job->execute(chunk);
+
+        pthread_mutex_lock(&mutex);
+
+        pending_chunks--;
+    }
+
+    while ( pending_chunks > 0 )
+    {
+        pthread_cond_wait(&done_cond, &mutex);
+    }
+
+    job = 0;
+
+    pthread_mutex_unlock(&mutex);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void MatchThreadPool::do_chunks()
+{
+    pthread_mutex_lock(&mutex);
+
+    while (true)
+    {
+        while ( !finalize && (job == 0 || next_chunk >= num_chunks) )
+        {
+            pthread_cond_wait(&job_cond, &mutex);
+        }
+
+        if ( finalize )
+        {
+            break;
+        }
+
+        MatchJob * the_job = job;
+        int        chunk   = next_chunk++;
+
+        pthread_mutex_unlock(&mutex);
+
+        the_job->execute(chunk);
+
+        pthread_mutex_lock(&mutex);
+
+        if ( --pending_chunks == 0 )
+        {
+            pthread_cond_signal(&done_cond);
+        }
+    }
+
+    pthread_mutex_unlock(&mutex);
+}
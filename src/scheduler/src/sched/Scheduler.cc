@@ -34,6 +34,8 @@
 #include "NebulaLog.h"
 #include "PoolObjectAuth.h"
 #include "NebulaUtil.h"
+#include "ExpressionProgram.h"
+#include "AttributeTable.h"
 
 using namespace std;
 
@@ -244,6 +246,22 @@ void Scheduler::start()
 
     xmlInitParser();
 
+    // -------------------------------------------------------------------------
+    // Threads to match hosts, 0 uses one per online CPU
+    // -------------------------------------------------------------------------
+    unsigned int match_threads;
+
+    conf.get("MATCH_THREADS", match_threads);
+
+    if ( match_threads == 0 )
+    {
+        long ncpus = sysconf(_SC_NPROCESSORS_ONLN);
+
+        match_threads = ncpus > 0 ? ncpus : 1;
+    }
+
+    match_pool = new MatchThreadPool(match_threads);
+
     // -------------------------------------------------------------------------
     // Get oned configuration, and init zone_id
     // -------------------------------------------------------------------------
@@ -500,17 +518,26 @@ int Scheduler::set_up_pools()
  *  @param vm_memory vm requirement
  *  @param vm_cpu vm requirement
  *  @param vm_pci vm requirement
+ *  @param reqs compiled SCHED_REQUIREMENTS of the vm
+ *  @param candidates hosts that fulfill the SCHED_REQUIREMENTS, evaluated
+ *  over the host attribute table. Empty to evaluate reqs on the host
  *  @param host to evaluate vm assgiment
+ *  @param hidx position of the host in the candidates bitmap
  *  @param n_auth number of hosts authorized for the user, incremented if needed
  *  @param n_error number of requirement errors, incremented if needed
  *  @param n_fits number of hosts with capacity that fits the VM requirements
  *  @param n_matched number of hosts that fullfil VM sched_requirements
  *  @param error, string describing why the host is not valid
  *  @return true for a positive match
+ *
+ *  This function is called concurrently from the match threads (see
+ *  HostMatchJob) so it must only read the VM, host, user and ACL objects.
  */
 static bool match_host(AclXML * acls, UserPoolXML * upool, VirtualMachineXML* vm,
-    int vmem, int vcpu, vector<VectorAttribute *>& vpci, HostXML * host,
-    int &n_auth, int& n_error, int &n_fits, int &n_matched, string &error)
+    int vmem, int vcpu, vector<VectorAttribute *>& vpci,
+    const ExpressionProgram& reqs, const vector<uint64_t>& candidates,
+    HostXML * host, size_t hidx, int &n_auth, int& n_error, int &n_fits,
+    int &n_matched, string &error)
 {
     // -------------------------------------------------------------------------
     // Filter current Hosts for resched VMs
@@ -578,7 +605,11 @@ static bool match_host(AclXML * acls, UserPoolXML * upool, VirtualMachineXML* vm
         char * estr;
         bool   matched;
 
-        if ( host->eval_bool(vm->get_requirements(), matched, &estr) != 0 )
+        if ( !candidates.empty() )
+        {
+            matched = ExpressionProgram::test(candidates, hidx);
+        }
+        else if ( reqs.eval_bool(host, matched, &estr) != 0 )
         {
             ostringstream oss;
 
@@ -587,8 +618,6 @@ static bool match_host(AclXML * acls, UserPoolXML * upool, VirtualMachineXML* vm
             oss << "Error in SCHED_REQUIREMENTS: '" << vm->get_requirements()
                 << "', error: " << estr;
 
-            vm->log(oss.str());
-
             error = oss.str();
 
             free(estr);
@@ -612,6 +641,168 @@ static bool match_host(AclXML * acls, UserPoolXML * upool, VirtualMachineXML* vm
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
+/**
+ *  Minimum number of hosts evaluated by a match thread at once
+ */
+static const size_t MIN_MATCH_CHUNK = 16;
+
+/**
+ *  @return true if the program uses a HostXML pseudo-attribute, they cannot be
+ *  evaluated from the host AttributeTable
+ */
+static bool uses_pseudo_attributes(const ExpressionProgram& prog)
+{
+    for (int i = 0; i < HostXML::num_pseudo_attributes; i++)
+    {
+        if ( prog.references(HostXML::pseudo_attributes[i]) )
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* -------------------------------------------------------------------------- */
+
+/**
+ *  Matches the hosts of a VM in chunks of consecutive hosts. Each host has its
+ *  own result slot so the chunks can be processed in any order and the results
+ *  are then merged in host order, as in a sequential evaluation.
+ */
+class HostMatchJob : public MatchJob
+{
+public:
+    /**
+     *  Result of match_host for a host, counters are 0 or 1
+     */
+    struct HostMatch
+    {
+        HostMatch():matched(false), n_auth(0), n_error(0), n_fits(0),
+            n_matched(0){};
+
+        bool   matched;
+
+        int    n_auth;
+        int    n_error;
+        int    n_fits;
+        int    n_matched;
+
+        string error;
+    };
+
+    HostMatchJob(AclXML * _acls, UserPoolXML * _upool, VirtualMachineXML* _vm,
+        int _vmem, int _vcpu, vector<VectorAttribute *>& _vpci,
+        const vector<HostXML *>& _hosts, AttributeTable& host_table,
+        unsigned int _chunk_size):
+        acls(_acls), upool(_upool), vm(_vm), vmem(_vmem), vcpu(_vcpu),
+        vpci(_vpci), hosts(_hosts), chunk_size(_chunk_size),
+        results(_hosts.size()), first_error(_hosts.size())
+    {
+        reqs = ExpressionProgram::get(vm->get_requirements(),
+                ExpressionProgram::BOOL, tmp_reqs);
+
+        // Invalid requirements are evaluated per host to report the error,
+        // and so are requirements using host pseudo-attributes
+        if ( !vm->get_requirements().empty() && reqs->error().empty() &&
+             !uses_pseudo_attributes(*reqs) )
+        {
+            char * estr;
+
+            reqs->eval_bool(host_table, candidates, &estr);
+
+            free(estr);
+        }
+    };
+
+    void execute(int chunk)
+    {
+        size_t begin = chunk * chunk_size;
+        size_t end   = begin + chunk_size;
+
+        if ( end > hosts.size() )
+        {
+            end = hosts.size();
+        }
+
+        for (size_t i = begin ; i < end ; i++)
+        {
+            // Results after a SCHED_REQUIREMENTS error are not merged
+            if ( i > __atomic_load_n(&first_error, __ATOMIC_RELAXED) )
+            {
+                break;
+            }
+
+            HostMatch& hm = results[i];
+
+            hm.matched = match_host(acls, upool, vm, vmem, vcpu, vpci, *reqs,
+                candidates, hosts[i], i, hm.n_auth, hm.n_error, hm.n_fits,
+                hm.n_matched, hm.error);
+
+            if ( hm.n_error > 0 )
+            {
+                size_t current = __atomic_load_n(&first_error, __ATOMIC_RELAXED);
+
+                while ( i < current && !__atomic_compare_exchange_n(
+                            &first_error, &current, i, false,
+                            __ATOMIC_RELAXED, __ATOMIC_RELAXED) );
+            }
+        }
+    };
+
+    /**
+     *  @return the number of chunks of the job
+     */
+    int num_chunks() const
+    {
+        return (hosts.size() + chunk_size - 1) / chunk_size;
+    };
+
+    /**
+     *  @return the match result of the i-th host
+     */
+    const HostMatch& result(size_t i) const
+    {
+        return results[i];
+    };
+
+private:
+    AclXML *            acls;
+    UserPoolXML *       upool;
+    VirtualMachineXML * vm;
+
+    int vmem;
+    int vcpu;
+
+    vector<VectorAttribute *>& vpci;
+
+    /**
+     *  SCHED_REQUIREMENTS of the VM, compiled once for all the hosts
+     */
+    const ExpressionProgram * reqs;
+
+    ExpressionProgram tmp_reqs;
+
+    /**
+     *  Hosts that fulfill the SCHED_REQUIREMENTS (bit i for hosts[i])
+     */
+    vector<uint64_t> candidates;
+
+    const vector<HostXML *>& hosts;
+
+    size_t chunk_size;
+
+    vector<HostMatch> results;
+
+    /**
+     *  Index of the first host with a SCHED_REQUIREMENTS error
+     */
+    size_t first_error;
+};
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
 /**
  *  Match system DS's for this VM that:
  *    1. Meet user/policy requirements
@@ -766,6 +957,32 @@ void Scheduler::match_schedule()
 
     time_t stime = time(0);
 
+    // -------------------------------------------------------------------------
+    // Hosts are matched in chunks, about 4 chunks per thread to balance the
+    // load across threads
+    // -------------------------------------------------------------------------
+    vector<HostXML *>   host_list;
+    vector<ObjectXML *> host_objects;
+
+    for (obj_it=hosts.begin(); obj_it != hosts.end(); obj_it++)
+    {
+        host_list.push_back(static_cast<HostXML *>(obj_it->second));
+        host_objects.push_back(obj_it->second);
+    }
+
+    // -------------------------------------------------------------------------
+    // Columns of the host attributes used in SCHED_REQUIREMENTS, they are
+    // built the first time an attribute is used in this cycle
+    // -------------------------------------------------------------------------
+    AttributeTable host_table(host_objects);
+
+    size_t chunk_size = host_list.size() / (4 * match_pool->size());
+
+    if ( chunk_size < MIN_MATCH_CHUNK )
+    {
+        chunk_size = MIN_MATCH_CHUNK;
+    }
+
     for (vm_it=pending_vms.begin(); vm_it != pending_vms.end(); vm_it++)
     {
         vm = static_cast<VirtualMachineXML*>(vm_it->second);
@@ -806,12 +1023,23 @@ void Scheduler::match_schedule()
         // ---------------------------------------------------------------------
         profile(true);
 
-        for (obj_it=hosts.begin(); obj_it != hosts.end(); obj_it++)
+        HostMatchJob match_job(acls, upool, vm, vm_memory, vm_cpu, vm_pci,
+                host_list, host_table, chunk_size);
+
+        match_pool->run(&match_job, match_job.num_chunks());
+
+        for (size_t i = 0; i < host_list.size(); i++)
         {
-            host = static_cast<HostXML *>(obj_it->second);
+            const HostMatchJob::HostMatch& hm = match_job.result(i);
 
-            if (match_host(acls, upool, vm, vm_memory, vm_cpu, vm_pci, host,
-                    n_auth, n_error, n_fits, n_matched, m_error))
+            host = host_list[i];
+
+            n_auth    += hm.n_auth;
+            n_error   += hm.n_error;
+            n_fits    += hm.n_fits;
+            n_matched += hm.n_matched;
+
+            if (hm.matched)
             {
                 vm->add_match_host(host->get_hid());
 
@@ -821,14 +1049,16 @@ void Scheduler::match_schedule()
             {
                 if ( n_error > 0 )
                 {
-                    log_match(vm->get_oid(), "Cannot schedule VM. " + m_error);
+                    vm->log(hm.error);
+
+                    log_match(vm->get_oid(), "Cannot schedule VM. " + hm.error);
                     break;
                 }
                 else if (NebulaLog::log_level() >= Log::DDEBUG)
                 {
                     ostringstream oss;
                     oss << "Host " << host->get_hid() << " discarded for VM "
-                        << vm->get_oid() << ". " << m_error;
+                        << vm->get_oid() << ". " << hm.error;
 
                     NebulaLog::log("SCHED", Log::DDEBUG, oss);
                 }
@@ -1544,6 +1774,9 @@ void Scheduler::timer_action(const ActionRequest& ar)
         return;
     }
 
+    // Requirement and rank programs not used in the last cycle are freed
+    ExpressionProgram::purge_cache();
+
     profile(true);
     rc = vmapool->set_up();
     profile(false,"Getting scheduled actions information.");
@@ -44,6 +44,7 @@ void SchedulerTemplate::set_conf_default()
 #  DEFAULT_SCHED
 #  DEFAULT_DS_SCHED
 #  LIVE_RESCHEDS
+#  MATCH_THREADS
 #  LOG
 #-------------------------------------------------------------------------------
 */
@@ -95,6 +96,12 @@ void SchedulerTemplate::set_conf_default()
     attribute = new SingleAttribute("LIVE_RESCHEDS",value);
     conf_default.insert(make_pair(attribute->name(),attribute));
 
+    //MATCH_THREADS
+    value = "1";
+
+    attribute = new SingleAttribute("MATCH_THREADS",value);
+    conf_default.insert(make_pair(attribute->name(),attribute));
+
     //DEFAULT_SCHED
     vvalue.clear();
     vvalue.insert(make_pair("POLICY","1"));
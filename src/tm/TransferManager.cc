@@ -2317,3 +2317,19 @@ int TransferManager::load_mads(int uid)
 
     return rc;
 }
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+const char * TMAction::trace_name() const
+{
+    static const char * names[] = {
+        "PROLOG", "PROLOG_MIGR", "PROLOG_RESUME", "PROLOG_ATTACH", "EPILOG",
+        "EPILOG_LOCAL", "EPILOG_STOP", "EPILOG_DELETE",
+        "EPILOG_DELETE_PREVIOUS", "EPILOG_DELETE_STOP", "EPILOG_DELETE_BOTH",
+        "EPILOG_DETACH", "CHECKPOINT", "DRIVER_CANCEL", "SAVEAS_HOT",
+        "SNAPSHOT_CREATE", "SNAPSHOT_REVERT", "SNAPSHOT_DELETE", "RESIZE"
+    };
+
+    return names[_action];
+}
@@ -19,6 +19,7 @@
 #include "LifeCycleManager.h"
 
 #include "Nebula.h"
+#include "Tracer.h"
 #include <sstream>
 
 /* ************************************************************************** */
@@ -33,6 +34,8 @@ void TransferManagerDriver::transfer (
 
     os << "TRANSFER " << oid << " " << xfr_file << endl;
 
+    Tracer::event(oid, "TM_DRIVER", "TRANSFER sent");
+
     write(os);
 };
 
@@ -87,6 +90,8 @@ void TransferManagerDriver::protocol(const string& message) const
     else
         return;
 
+    Tracer::event(id, "TM_DRIVER", action + " " + result);
+
     // Get the VM from the pool
     vm = vmpool->get(id,true);
 
@@ -255,3 +255,128 @@ const std::string& LoginToken::from_xml_node(const xmlNodePtr node)
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+/* SessionCache class                                                         */
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+const size_t SessionCache::MAX_SESSIONS = 1024;
+
+/* -------------------------------------------------------------------------- */
+
+SessionCache::SessionCache()
+{
+    for (unsigned int i = 0; i < NUM_STRIPES; i++)
+    {
+        pthread_mutex_init(&(stripes[i].mutex), 0);
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+SessionCache::~SessionCache()
+{
+    for (unsigned int i = 0; i < NUM_STRIPES; i++)
+    {
+        pthread_mutex_destroy(&(stripes[i].mutex));
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+bool SessionCache::is_valid(int uid, const string& utk, const string& fprint)
+{
+    map<pair<int, string>, Session>::iterator it;
+
+    bool   valid = false;
+    Stripe& st   = stripe(uid);
+
+    pair<int, string> key(uid, one_util::sha1_digest(utk));
+
+    pthread_mutex_lock(&st.mutex);
+
+    it = st.sessions.find(key);
+
+    if ( it != st.sessions.end() )
+    {
+        const Session& s = it->second;
+
+        valid = (s.fingerprint == fprint) && ((s.expiration_time == -1) ||
+                (time(0) < s.expiration_time));
+
+        if (!valid)
+        {
+            st.sessions.erase(it);
+        }
+    }
+
+    pthread_mutex_unlock(&st.mutex);
+
+    return valid;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void SessionCache::set(int uid, const string& utk, const string& fprint,
+        time_t valid)
+{
+    map<pair<int, string>, Session>::iterator it;
+
+    if ( valid == 0 || valid < -1 )
+    {
+        return;
+    }
+
+    Stripe& st  = stripe(uid);
+    time_t  now = time(0);
+
+    Session s;
+
+    s.expiration_time = (valid == -1) ? -1 : now + valid;
+    s.fingerprint     = fprint;
+
+    pair<int, string> key(uid, one_util::sha1_digest(utk));
+
+    pthread_mutex_lock(&st.mutex);
+
+    if ( st.sessions.size() >= MAX_SESSIONS ) // Expired session collector
+    {
+        for (it = st.sessions.begin(); it != st.sessions.end(); )
+        {
+            if ( it->second.expiration_time != -1 &&
+                 it->second.expiration_time <= now )
+            {
+                st.sessions.erase(it++);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+
+    st.sessions[key] = s;
+
+    pthread_mutex_unlock(&st.mutex);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void SessionCache::reset(int uid)
+{
+    map<pair<int, string>, Session>::iterator it;
+
+    Stripe& st = stripe(uid);
+
+    pthread_mutex_lock(&st.mutex);
+
+    it = st.sessions.lower_bound(make_pair(uid, string()));
+
+    while ( it != st.sessions.end() && it->first.first == uid )
+    {
+        st.sessions.erase(it++);
+    }
+
+    pthread_mutex_unlock(&st.mutex);
+}
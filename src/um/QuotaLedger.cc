@@ -0,0 +1,574 @@
+/* -------------------------------------------------------------------------- */
+/* Copyright 2002-2017, OpenNebula Project, OpenNebula Systems                */
+/*                                                                            */
+/* Licensed under the Apache License, Version 2.0 (the "License"); you may    */
+/* not use this file except in compliance with the License. You may obtain    */
+/* a copy of the License at                                                   */
+/*                                                                            */
+/* http://www.apache.org/licenses/LICENSE-2.0                                 */
+/*                                                                            */
+/* Unless required by applicable law or agreed to in writing, software        */
+/* distributed under the License is distributed on an "AS IS" BASIS,          */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   */
+/* See the License for the specific language governing permissions and        */
+/* limitations under the License.                                             */
+/* -------------------------------------------------------------------------- */
+
+#include <errno.h>
+
+#include "QuotaLedger.h"
+#include "PoolSQL.h"
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+extern "C" void * quota_ledger_thread(void *arg)
+{
+    QuotaLedger * ql;
+
+    if ( arg == 0 )
+    {
+        return 0;
+    }
+
+    ql = static_cast<QuotaLedger *>(arg);
+
+    ql->do_flush();
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+QuotaLedger::QuotaLedger(PoolSQL * _pool, SqlDB * _db, time_t _flush_period):
+    pool(_pool), db(_db), flush_period(_flush_period), running(false),
+    _finalize(false)
+{
+    pthread_mutex_init(&mutex, 0);
+
+    pthread_cond_init(&cond, 0);
+}
+
+/* -------------------------------------------------------------------------- */
+
+QuotaLedger::~QuotaLedger()
+{
+    map<int, Entry *>::iterator it;
+
+    finalize();
+
+    for (it = entries.begin(); it != entries.end(); it++)
+    {
+        delete it->second;
+    }
+
+    pthread_mutex_destroy(&mutex);
+
+    pthread_cond_destroy(&cond);
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+int QuotaLedger::start()
+{
+    pthread_attr_t pattr;
+
+    if ( flush_period <= 0 )
+    {
+        return 0;
+    }
+
+    pthread_attr_init(&pattr);
+    pthread_attr_setdetachstate(&pattr, PTHREAD_CREATE_JOINABLE);
+
+    int rc = pthread_create(&thread_id, &pattr, quota_ledger_thread,
+            (void *) this);
+
+    pthread_attr_destroy(&pattr);
+
+    if ( rc == 0 )
+    {
+        running = true;
+    }
+    else
+    {
+        flush_period = 0;
+    }
+
+    return rc;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void QuotaLedger::finalize()
+{
+    pthread_mutex_lock(&mutex);
+
+    _finalize = true;
+
+    pthread_cond_signal(&cond);
+
+    pthread_mutex_unlock(&mutex);
+
+    if ( running )
+    {
+        pthread_join(thread_id, 0);
+
+        running = false;
+    }
+
+    flush();
+}
+
+/* -------------------------------------------------------------------------- */
+
+void QuotaLedger::do_flush()
+{
+    while (true)
+    {
+        struct timespec timeout;
+
+        pthread_mutex_lock(&mutex);
+
+        timeout.tv_sec  = time(0) + flush_period;
+        timeout.tv_nsec = 0;
+
+        while ( !_finalize )
+        {
+            if (pthread_cond_timedwait(&cond, &mutex, &timeout) == ETIMEDOUT)
+            {
+                break;
+            }
+        }
+
+        bool end = _finalize;
+
+        pthread_mutex_unlock(&mutex);
+
+        if ( end )
+        {
+            return;
+        }
+
+        flush();
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+QuotaLedger::Entry * QuotaLedger::acquire(int oid)
+{
+    while (true)
+    {
+        QuotasSQL * quotas = 0;
+
+        pthread_mutex_lock(&mutex);
+
+        Entry *& slot = entries[oid];
+
+        if ( slot == 0 )
+        {
+            slot = new Entry;
+        }
+
+        Entry * entry = slot;
+
+        entry->refs++;
+
+        bool loaded = entry->quotas != 0;
+
+        pthread_mutex_unlock(&mutex);
+
+        // Quotas are loaded without the entry lock, as load() waits for the
+        // object lock (e.g. held while the object is dropped)
+        if ( !loaded )
+        {
+            quotas = load(oid);
+        }
+
+        pthread_mutex_lock(&entry->mutex);
+
+        // The entry was dropped while waiting for the lock, get a new one
+        if ( entry->removed )
+        {
+            delete quotas;
+
+            release(oid, entry);
+            continue;
+        }
+
+        if ( entry->quotas != 0 )
+        {
+            delete quotas;
+        }
+        else if ( quotas == 0 )
+        {
+            release(oid, entry);
+            return 0;
+        }
+        else
+        {
+            pthread_mutex_lock(&mutex);
+
+            entry->quotas = quotas;
+
+            pthread_mutex_unlock(&mutex);
+        }
+
+        return entry;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+void QuotaLedger::release(int oid, Entry * entry)
+{
+    pthread_mutex_unlock(&entry->mutex);
+
+    pthread_mutex_lock(&mutex);
+
+    entry->refs--;
+
+    if ( entry->refs == 0 &&
+            (entry->removed || entry->quotas == 0 || flush_period < 0) )
+    {
+        map<int, Entry *>::iterator it = entries.find(oid);
+
+        if ( it != entries.end() && it->second == entry )
+        {
+            entries.erase(it);
+        }
+
+        delete entry;
+    }
+
+    pthread_mutex_unlock(&mutex);
+}
+
+/* -------------------------------------------------------------------------- */
+
+bool QuotaLedger::write(int oid, Entry * entry)
+{
+    if ( !entry->dirty || entry->quotas == 0 )
+    {
+        return false;
+    }
+
+    entry->quotas->update(oid, db);
+
+    entry->dirty = false;
+
+    return true;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void QuotaLedger::changed(int oid, Entry * entry)
+{
+    entry->dirty = true;
+
+    if ( flush_period <= 0 )
+    {
+        write(oid, entry);
+        return;
+    }
+
+    pthread_mutex_lock(&mutex);
+
+    pending.insert(oid);
+
+    pthread_mutex_unlock(&mutex);
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+int QuotaLedger::check(int oid, Quotas::QuotaType type, Template * tmpl,
+        Quotas& default_quotas, string& error_str)
+{
+    Entry * entry = acquire(oid);
+
+    if ( entry == 0 )
+    {
+        return -2;
+    }
+
+    int rc = -1;
+
+    if ( entry->quotas->quota_check(type, tmpl, default_quotas, error_str) )
+    {
+        changed(oid, entry);
+
+        rc = 0;
+    }
+
+    release(oid, entry);
+
+    return rc;
+}
+
+/* -------------------------------------------------------------------------- */
+
+int QuotaLedger::update(int oid, Quotas::QuotaType type, Template * tmpl,
+        Quotas& default_quotas, string& error_str)
+{
+    Entry * entry = acquire(oid);
+
+    if ( entry == 0 )
+    {
+        return -2;
+    }
+
+    int rc = -1;
+
+    if ( entry->quotas->quota_update(type, tmpl, default_quotas, error_str) )
+    {
+        changed(oid, entry);
+
+        rc = 0;
+    }
+
+    release(oid, entry);
+
+    return rc;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void QuotaLedger::del(int oid, Quotas::QuotaType type, Template * tmpl)
+{
+    Entry * entry = acquire(oid);
+
+    if ( entry == 0 )
+    {
+        return;
+    }
+
+    entry->quotas->quota_del(type, tmpl);
+
+    changed(oid, entry);
+
+    release(oid, entry);
+}
+
+/* -------------------------------------------------------------------------- */
+
+int QuotaLedger::set(int oid, Template * tmpl, string& error_str)
+{
+    Entry * entry = acquire(oid);
+
+    if ( entry == 0 )
+    {
+        return -2;
+    }
+
+    int rc = entry->quotas->set(tmpl, error_str);
+
+    // Limits are always written to the DB, with any pending usage change
+    entry->dirty = true;
+
+    write(oid, entry);
+
+    release(oid, entry);
+
+    return rc;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+bool QuotaLedger::flush(int oid)
+{
+    if ( flush_period <= 0 )
+    {
+        return false;
+    }
+
+    pthread_mutex_lock(&mutex);
+
+    map<int, Entry *>::iterator it = entries.find(oid);
+
+    if ( pending.erase(oid) == 0 || it == entries.end() )
+    {
+        pthread_mutex_unlock(&mutex);
+        return false;
+    }
+
+    Entry * entry = it->second;
+
+    entry->refs++;
+
+    pthread_mutex_unlock(&mutex);
+
+    pthread_mutex_lock(&entry->mutex);
+
+    bool rc = write(oid, entry);
+
+    release(oid, entry);
+
+    return rc;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void QuotaLedger::flush()
+{
+    std::set<int> oids;
+    std::set<int>::iterator it;
+
+    pthread_mutex_lock(&mutex);
+
+    oids.swap(pending);
+
+    pthread_mutex_unlock(&mutex);
+
+    for (it = oids.begin(); it != oids.end(); it++)
+    {
+        pthread_mutex_lock(&mutex);
+
+        map<int, Entry *>::iterator e_it = entries.find(*it);
+
+        if ( e_it == entries.end() )
+        {
+            pthread_mutex_unlock(&mutex);
+            continue;
+        }
+
+        Entry * entry = e_it->second;
+
+        entry->refs++;
+
+        pthread_mutex_unlock(&mutex);
+
+        pthread_mutex_lock(&entry->mutex);
+
+        write(*it, entry);
+
+        release(*it, entry);
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+void QuotaLedger::drop(int oid)
+{
+    pthread_mutex_lock(&mutex);
+
+    map<int, Entry *>::iterator it = entries.find(oid);
+
+    if ( it == entries.end() )
+    {
+        pthread_mutex_unlock(&mutex);
+        return;
+    }
+
+    Entry * entry = it->second;
+
+    entry->refs++;
+
+    pthread_mutex_unlock(&mutex);
+
+    // Wait for any operation in progress and write its changes, so they
+    // are not written after the object is dropped
+    pthread_mutex_lock(&entry->mutex);
+
+    write(oid, entry);
+
+    pthread_mutex_lock(&mutex);
+
+    entry->removed = true;
+
+    it = entries.find(oid);
+
+    if ( it != entries.end() && it->second == entry )
+    {
+        entries.erase(it);
+    }
+
+    pending.erase(oid);
+
+    pthread_mutex_unlock(&mutex);
+
+    release(oid, entry);
+}
+
+/* -------------------------------------------------------------------------- */
+
+void QuotaLedger::clear()
+{
+    map<int, Entry *>::iterator it;
+
+    pthread_mutex_lock(&mutex);
+
+    for (it = entries.begin(); it != entries.end(); it++)
+    {
+        Entry * entry = it->second;
+
+        entry->removed = true;
+
+        if ( entry->refs == 0 )
+        {
+            delete entry;
+        }
+    }
+
+    entries.clear();
+
+    pending.clear();
+
+    pthread_mutex_unlock(&mutex);
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+QuotasSQL * UserQuotaLedger::load(int oid)
+{
+    // Check the user exists, the quotas of a missing user are empty
+    PoolObjectSQL * user = pool->get(oid, true);
+
+    if ( user == 0 )
+    {
+        return 0;
+    }
+
+    user->unlock();
+
+    UserQuotas * quotas = new UserQuotas();
+
+    if ( quotas->select(oid, db) != 0 )
+    {
+        delete quotas;
+        return 0;
+    }
+
+    return quotas;
+}
+
+/* -------------------------------------------------------------------------- */
+
+QuotasSQL * GroupQuotaLedger::load(int oid)
+{
+    // Check the group exists, the quotas of a missing group are empty
+    PoolObjectSQL * group = pool->get(oid, true);
+
+    if ( group == 0 )
+    {
+        return 0;
+    }
+
+    group->unlock();
+
+    GroupQuotas * quotas = new GroupQuotas();
+
+    if ( quotas->select(oid, db) != 0 )
+    {
+        delete quotas;
+        return 0;
+    }
+
+    return quotas;
+}
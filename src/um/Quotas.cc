@@ -260,35 +260,14 @@ void Quotas::quota_del(QuotaType type, int uid, int gid, Template * tmpl)
     UserPool *  upool = nd.get_upool();
     GroupPool * gpool = nd.get_gpool();
 
-    User *  user;
-    Group * group;
-
     if ( uid != UserPool::ONEADMIN_ID )
     {
-        user = upool->get(uid, true);
-
-        if ( user != 0 )
-        {
-            user->quota.quota_del(type, tmpl);
-
-            upool->update_quotas(user);
-
-            user->unlock();
-        }
+        upool->get_quota_ledger()->del(uid, type, tmpl);
     }
 
     if ( gid != GroupPool::ONEADMIN_ID )
     {
-        group = gpool->get(gid, true);
-
-        if ( group != 0 )
-        {
-            group->quota.quota_del(type, tmpl);
-
-            gpool->update_quotas(group);
-
-            group->unlock();
-        }
+        gpool->get_quota_ledger()->del(gid, type, tmpl);
     }
 }
 
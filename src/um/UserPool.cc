@@ -55,8 +55,11 @@ UserPool::UserPool(SqlDB * db,
                    time_t  __session_expiration_time,
                    vector<const VectorAttribute *> hook_mads,
                    const string&             remotes_location,
-                   bool                      is_federation_slave):
-                       PoolSQL(db, User::table, !is_federation_slave, true)
+                   bool                      is_federation_slave,
+                   time_t                    quota_flush_period):
+                       PoolSQL(db, User::table, !is_federation_slave, true),
+                       quota_ledger(new UserQuotaLedger(this, db,
+                               quota_flush_period))
 {
     int           one_uid    = -1;
     int           server_uid = -1;
@@ -76,6 +79,12 @@ UserPool::UserPool(SqlDB * db,
 
     _session_expiration_time = __session_expiration_time;
 
+    if ( quota_ledger->start() != 0 )
+    {
+        NebulaLog::log("ONE", Log::ERROR, "Could not start the quota ledger, "
+            "user quotas will be written as they change");
+    }
+
     User * oneadmin_user = get(0, true);
 
     //Slaves do not need to init the pool, just the oneadmin username
@@ -318,6 +327,7 @@ int UserPool::allocate (
     Nebula&     nd    = Nebula::instance();
 
     User *      user;
+    int         db_oid;
     GroupPool * gpool = nd.get_gpool();
 
     string auth_driver = auth;
@@ -357,9 +367,9 @@ int UserPool::allocate (
     }
 
     // Check for duplicates
-    user = get(uname,false);
+    db_oid = get_oid(uname, -1);
 
-    if ( user !=0 )
+    if ( db_oid != -1 )
     {
         goto error_duplicated;
     }
@@ -435,7 +445,7 @@ error_name:
     goto error_common;
 
 error_duplicated:
-    oss << "NAME is already taken by USER " << user->get_oid() << ".";
+    oss << "NAME is already taken by USER " << db_oid << ".";
     goto error_common;
 
 error_no_groups:
@@ -497,7 +507,16 @@ int UserPool::drop(PoolObjectSQL * objsql, string& error_msg)
         return -1;
     }
 
-    return PoolSQL::drop(objsql, error_msg);
+    quota_ledger->drop(objsql->get_oid());
+
+    int rc = PoolSQL::drop(objsql, error_msg);
+
+    if ( rc == 0 )
+    {
+        session_cache.reset(objsql->get_oid());
+    }
+
+    return rc;
 }
 
 /* -------------------------------------------------------------------------- */
@@ -520,9 +539,23 @@ int UserPool::update(PoolObjectSQL * objsql)
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
-int UserPool::update_quotas(User * user)
+string UserPool::session_fingerprint(User * user)
 {
-    return user->update_quotas(db);
+    ostringstream oss;
+
+    set<int> gids = user->get_groups();
+    set<int>::iterator it;
+
+    oss << user->enabled << ":" << user->auth_driver << ":" << user->gid << ":";
+
+    for (it = gids.begin(); it != gids.end(); ++it)
+    {
+        oss << *it << ",";
+    }
+
+    oss << ":" << user->password;
+
+    return oss.str();
 }
 
 /* -------------------------------------------------------------------------- */
@@ -607,6 +640,7 @@ bool UserPool::authenticate_internal(User *        user,
     string auth_driver;
     string username;
     string error_str;
+    string fingerprint;
 
     bool driver_managed_groups = false;
 
@@ -643,6 +677,8 @@ bool UserPool::authenticate_internal(User *        user,
 
     auth_driver = user->auth_driver;
 
+    fingerprint = session_fingerprint(user);
+
     if (nd.get_auth_conf_attribute(auth_driver, "DRIVER_MANAGED_GROUPS",
             driver_managed_groups) != 0)
     {
@@ -680,7 +716,7 @@ bool UserPool::authenticate_internal(User *        user,
 
         return true;
     }
-    else if (user->session.is_valid(token))
+    else if (session_cache.is_valid(user_id, token, fingerprint))
     {
         user->unlock();
         return true;
@@ -744,10 +780,11 @@ bool UserPool::authenticate_internal(User *        user,
         return false;
     }
 
-    user->session.set(token, _session_expiration_time);
-
     if ( !driver_managed_groups || new_gid == -1 || new_group_ids == group_ids )
     {
+        session_cache.set(user_id, token, session_fingerprint(user),
+                _session_expiration_time);
+
         user->unlock();
 
         return true;
@@ -792,6 +829,9 @@ bool UserPool::authenticate_internal(User *        user,
 
     update(user);
 
+    session_cache.set(user_id, token, session_fingerprint(user),
+            _session_expiration_time);
+
     user->unlock();
 
     // -------------------------------------------------------------------------
@@ -900,6 +940,8 @@ bool UserPool::authenticate_server(User *        user,
     string target_username;
     string second_token;
 
+    string server_fingerprint;
+
     Nebula& nd         = Nebula::instance();
     AuthManager* authm = nd.get_authm();
 
@@ -908,6 +950,8 @@ bool UserPool::authenticate_server(User *        user,
 
     auth_driver = user->auth_driver;
 
+    server_fingerprint = session_fingerprint(user);
+
     AuthRequest ar(user->oid, user->get_groups());
 
     user->unlock();
@@ -937,7 +981,8 @@ bool UserPool::authenticate_server(User *        user,
     uname  = user->name;
     gname  = user->gname;
 
-    result = user->session.is_valid(second_token);
+    result = session_cache.is_valid(user_id, second_token,
+            server_fingerprint + ":" + session_fingerprint(user));
 
     umask  = user->get_umask();
 
@@ -971,7 +1016,10 @@ bool UserPool::authenticate_server(User *        user,
 
     if (user != 0)
     {
-        user->session.set(second_token, _session_expiration_time);
+        session_cache.set(user_id, second_token,
+                server_fingerprint + ":" + session_fingerprint(user),
+                _session_expiration_time);
+
         user->unlock();
     }
 
@@ -1261,6 +1309,9 @@ int UserPool::dump(ostringstream& oss, const string& where, const string& limit)
 
     ostringstream cmd;
 
+    // Quotas are read from the DB, write the changes buffered by the ledger
+    quota_ledger->flush();
+
     cmd << "SELECT " << User::table << ".body, "
         << UserQuotas::db_table << ".body"<< " FROM " << User::table
         << " LEFT JOIN " << UserQuotas::db_table << " ON "
@@ -1548,14 +1548,10 @@ error_common:
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
-int VirtualMachine::update_monitoring(SqlDB * db)
+string& VirtualMachine::to_xml_monitoring(string& xml) const
 {
     ostringstream oss;
-    int           rc;
-
-    string xml_body;
-    string error_str;
-    char * sql_xml;
+    string        xml_body;
 
     float       cpu = 0;
     long long   memory = 0;
@@ -1573,7 +1569,24 @@ int VirtualMachine::update_monitoring(SqlDB * db)
         << "</TEMPLATE>"
         << "</VM>";
 
-    sql_xml = db->escape_str(oss.str().c_str());
+    xml = oss.str();
+
+    return xml;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+int VirtualMachine::update_monitoring(SqlDB * db)
+{
+    ostringstream oss;
+    int           rc;
+
+    string xml_body;
+    string error_str;
+    char * sql_xml;
+
+    sql_xml = db->escape_str(to_xml_monitoring(xml_body).c_str());
 
     if ( sql_xml == 0 )
     {
@@ -21,6 +21,7 @@
 #include "Nebula.h"
 
 #include <sstream>
+#include <algorithm>
 
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
@@ -43,14 +44,16 @@ VirtualMachinePool::VirtualMachinePool(
         const string&               remotes_location,
         vector<const SingleAttribute *>&  restricted_attrs,
         time_t                      expire_time,
+        time_t                      flush_period,
         bool                        on_hold,
         float                       default_cpu_cost,
         float                       default_mem_cost,
         float                       default_disk_cost)
     : PoolSQL(db, VirtualMachine::table, true, false),
-    _monitor_expiration(expire_time), _submit_on_hold(on_hold),
-    _default_cpu_cost(default_cpu_cost), _default_mem_cost(default_mem_cost),
-    _default_disk_cost(default_disk_cost)
+    _monitor_expiration(expire_time), monitor_writer(0), monitor_store(0),
+    _submit_on_hold(on_hold), _default_cpu_cost(default_cpu_cost),
+    _default_mem_cost(default_mem_cost), _default_disk_cost(default_disk_cost),
+    poll_wheel_loaded(false)
 {
 
     string name;
@@ -63,6 +66,21 @@ VirtualMachinePool::VirtualMachinePool(
     {
         clean_all_monitoring();
     }
+    else if ( flush_period > 0 )
+    {
+        monitor_writer = new MonitorWriter(db, VirtualMachine::monit_table,
+                VirtualMachine::monit_db_names, flush_period);
+
+        if ( monitor_writer->start() != 0 )
+        {
+            NebulaLog::log("VM", Log::ERROR, "Could not start the monitoring "
+                "writer, monitoring records will not be buffered");
+
+            delete monitor_writer;
+
+            monitor_writer = 0;
+        }
+    }
 
     for (unsigned int i = 0 ; i < hook_mads.size() ; i++ )
     {
@@ -343,6 +361,27 @@ int VirtualMachinePool::get_running(
     ostringstream   os;
     string          where;
 
+    RaftManager * raftm = Nebula::instance().get_raftm();
+
+    // Followers do not update the pool, the schedule is only used by the
+    // leader (or solo) server
+    if ( raftm->is_leader() || raftm->is_solo() )
+    {
+        if ( !poll_wheel_loaded )
+        {
+            if ( load_poll_wheel() != 0 )
+            {
+                return -1;
+            }
+        }
+
+        // VMs are kept in the wheel till they are updated, so VMs not polled
+        // are returned again
+        poll_wheel.expire(last_poll, vm_limit, oids, true);
+
+        return 0;
+    }
+
     os << "last_poll <= " << last_poll << " and"
        << " state = " << VirtualMachine::ACTIVE
        << " and ( lcm_state = " << VirtualMachine::RUNNING
@@ -354,6 +393,49 @@ int VirtualMachinePool::get_running(
     return PoolSQL::search(oids,VirtualMachine::table,where);
 };
 
+/* -------------------------------------------------------------------------- */
+
+int VirtualMachinePool::load_wheel_cb(void * _null, int num, char **values,
+        char **names)
+{
+    if ( (num < 2) || (values[0] == 0) || (values[1] == 0) )
+    {
+        return -1;
+    }
+
+    poll_wheel.schedule(atoi(values[0]), atol(values[1]));
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+
+int VirtualMachinePool::load_poll_wheel()
+{
+    ostringstream sql;
+    int           rc;
+
+    set_callback(static_cast<Callbackable::Callback>(
+                &VirtualMachinePool::load_wheel_cb));
+
+    sql << "SELECT oid, last_poll FROM " << VirtualMachine::table
+        << " WHERE state = " << VirtualMachine::ACTIVE
+        << " AND ( lcm_state = " << VirtualMachine::RUNNING
+        << " OR lcm_state = " << VirtualMachine::UNKNOWN << " )"
+        << " ORDER BY last_poll ASC";
+
+    rc = db->exec_rd(sql,this);
+
+    unset_callback();
+
+    if ( rc == 0 )
+    {
+        poll_wheel_loaded = true;
+    }
+
+    return rc;
+}
+
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
@@ -466,6 +548,13 @@ int VirtualMachinePool::clean_expired_monitoring()
 
     max_last_poll = time(0) - _monitor_expiration;
 
+    if ( monitor_store != 0 )
+    {
+        monitor_store->expire(max_last_poll);
+
+        return 0;
+    }
+
     oss << "DELETE FROM " << VirtualMachine::monit_table
         << " WHERE last_poll < " << max_last_poll;
 
@@ -492,12 +581,138 @@ int VirtualMachinePool::clean_all_monitoring()
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
+const char * VirtualMachinePool::monitor_metrics[] = {
+    "MONITORING/CPU",
+    "MONITORING/MEMORY",
+    "MONITORING/NETRX",
+    "MONITORING/NETTX",
+    "MONITORING/DISKRDBYTES",
+    "MONITORING/DISKWRBYTES",
+    "MONITORING/DISKRDIOPS",
+    "MONITORING/DISKWRIOPS",
+    "TEMPLATE/CPU",
+    "TEMPLATE/MEMORY",
+    0
+};
+
+int VirtualMachinePool::init_monitor_store(const string& file,
+        unsigned int samples,
+        const vector<pair<unsigned int, unsigned int> >& rollups,
+        string& error_str)
+{
+    vector<string> metrics;
+
+    for (int i = 0; monitor_metrics[i] != 0; i++)
+    {
+        metrics.push_back(monitor_metrics[i]);
+    }
+
+    MonitorStore * store = new MonitorStore(file, metrics, samples, rollups);
+
+    if ( store->init(error_str) != 0 )
+    {
+        delete store;
+
+        return -1;
+    }
+
+    monitor_store = store;
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+int VirtualMachinePool::update_monitoring(VirtualMachine * vm)
+{
+    if ( _monitor_expiration <= 0 )
+    {
+        return 0;
+    }
+
+    if ( monitor_store != 0 )
+    {
+        const vector<string>& metrics = monitor_store->get_metrics();
+        vector<double> values;
+
+        for (unsigned int i = 0; i < metrics.size(); i++)
+        {
+            const string& metric = metrics[i];
+
+            size_t pos   = metric.find('/');
+            double value = 0;
+
+            if ( metric.compare(0, pos, "MONITORING") == 0 )
+            {
+                vm->get_info().get(metric.substr(pos+1), value);
+            }
+            else
+            {
+                vm->get_template_attribute(metric.substr(pos+1).c_str(), value);
+            }
+
+            values.push_back(value);
+        }
+
+        return monitor_store->insert(vm->get_oid(), vm->get_last_poll(),
+                values);
+    }
+
+    if ( monitor_writer != 0 )
+    {
+        string xml;
+
+        monitor_writer->insert(vm->get_oid(), vm->get_last_poll(),
+                vm->to_xml_monitoring(xml));
+
+        return 0;
+    }
+
+    return vm->update_monitoring(db);
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
 int VirtualMachinePool::dump_monitoring(
         ostringstream& oss,
-        const string&  where)
+        const string&  where,
+        unsigned int   resolution)
 {
     ostringstream cmd;
 
+    if ( monitor_store != 0 )
+    {
+        vector<int> oids;
+        vector<int>::iterator it;
+
+        time_t start = 0;
+
+        // Rollup series keep their own retention, raw samples are filtered
+        // by the monitoring expiration time
+        if ( monitor_store->get_interval(resolution) == 0 )
+        {
+            start = time(0) - _monitor_expiration;
+        }
+
+        int rc = search(oids, where);
+
+        sort(oids.begin(), oids.end());
+
+        oss << "<MONITORING_DATA>";
+
+        for (it = oids.begin(); it != oids.end(); ++it)
+        {
+            monitor_store->to_xml(oss, *it, resolution, start, "VM",
+                "LAST_POLL");
+        }
+
+        oss << "</MONITORING_DATA>";
+
+        return rc;
+    }
+
     cmd << "SELECT " << VirtualMachine::monit_table << ".body FROM "
         << VirtualMachine::monit_table
         << " INNER JOIN " << VirtualMachine::table
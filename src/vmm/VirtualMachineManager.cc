@@ -34,12 +34,14 @@ VirtualMachineManager::VirtualMachineManager(
     time_t                          _poll_period,
     bool                            _do_vm_poll,
     int                             _vm_limit,
-    vector<const VectorAttribute*>&       _mads):
+    vector<const VectorAttribute*>&       _mads,
+    unsigned int                    workers):
         MadManager(_mads),
         timer_period(_timer_period),
         poll_period(_poll_period),
         do_vm_poll(_do_vm_poll),
-        vm_limit(_vm_limit)
+        vm_limit(_vm_limit),
+        am(workers, true)
 {
     Nebula& nd = Nebula::instance();
 
@@ -48,6 +50,8 @@ VirtualMachineManager::VirtualMachineManager(
     ds_pool = nd.get_dspool();
 
     am.addListener(this);
+
+    am.trace("VMM");
 };
 
 /* ************************************************************************** */
@@ -2557,3 +2561,25 @@ int VirtualMachineManager::load_mads(int uid)
 
     return 0;
 }
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+const char * VMMAction::trace_name() const
+{
+    static const char * names[] = {
+        "DEPLOY", "SAVE", "SHUTDOWN", "CANCEL", "CANCEL_PREVIOUS", "CLEANUP",
+        "CLEANUP_BOTH", "CLEANUP_PREVIOUS", "MIGRATE", "RESTORE", "REBOOT",
+        "RESET", "POLL", "DRIVER_CANCEL", "ATTACH", "DETACH", "ATTACH_NIC",
+        "DETACH_NIC", "SNAPSHOT_CREATE", "SNAPSHOT_REVERT", "SNAPSHOT_DELETE",
+        "DISK_SNAPSHOT_CREATE", "DISK_RESIZE"
+    };
+
+    // Polls are periodic, not part of an operation
+    if ( _action == POLL )
+    {
+        return 0;
+    }
+
+    return names[_action];
+}
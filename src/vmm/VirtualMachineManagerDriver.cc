@@ -20,6 +20,7 @@
 
 #include "Nebula.h"
 #include "NebulaUtil.h"
+#include "Tracer.h"
 #include <sstream>
 
 
@@ -267,6 +268,11 @@ void VirtualMachineManagerDriver::protocol(const string& message) const
         return;
     }
 
+    if ( action != "POLL" )
+    {
+        Tracer::event(id, "VMM_DRIVER", action + " " + result);
+    }
+
     // -------------------------------------------------------------------------
     // VMM actions not associated to a single VM: UPDATESG
     // -------------------------------------------------------------------------
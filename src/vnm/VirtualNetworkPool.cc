@@ -117,7 +117,7 @@ int VirtualNetworkPool::allocate (
         string&                     error_str)
 {
     VirtualNetwork * vn;
-    VirtualNetwork * vn_aux = 0;
+    int              vn_aux = -1;
 
     string name;
 
@@ -135,9 +135,9 @@ int VirtualNetworkPool::allocate (
     }
 
     // Check for duplicates
-    vn_aux = get(name,uid,false);
+    vn_aux = get_oid(name, uid);
 
-    if( vn_aux != 0 )
+    if( vn_aux != -1 )
     {
         goto error_duplicated;
     }
@@ -165,7 +165,7 @@ int VirtualNetworkPool::allocate (
 
 
 error_duplicated:
-    oss << "NAME is already taken by NET " << vn_aux->get_oid() << ".";
+    oss << "NAME is already taken by NET " << vn_aux << ".";
     error_str = oss.str();
 
 error_name:
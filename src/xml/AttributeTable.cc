@@ -0,0 +1,229 @@
+/* -------------------------------------------------------------------------- */
+/* Copyright 2002-2017, OpenNebula Project, OpenNebula Systems                */
+/*                                                                            */
+/* Licensed under the Apache License, Version 2.0 (the "License"); you may    */
+/* not use this file except in compliance with the License. You may obtain    */
+/* a copy of the License at                                                   */
+/*                                                                            */
+/* http://www.apache.org/licenses/LICENSE-2.0                                 */
+/*                                                                            */
+/* Unless required by applicable law or agreed to in writing, software        */
+/* distributed under the License is distributed on an "AS IS" BASIS,          */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   */
+/* See the License for the specific language governing permissions and        */
+/* limitations under the License.                                             */
+/* -------------------------------------------------------------------------- */
+
+
+#include "AttributeTable.h"
+#include "ObjectXML.h"
+
+using namespace std;
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+template<typename T>
+static void build_column(const vector<ObjectXML *>& objects, const string& name,
+        AttributeTable::Column<T>& column)
+{
+    column.values.resize(objects.size(), T());
+    column.found.resize(objects.size(), 0);
+
+    for (size_t i = 0; i < objects.size(); i++)
+    {
+        T val = T();
+
+        if ( objects[i]->search(name.c_str(), val) == 0 )
+        {
+            column.values[i] = val;
+            column.found[i]  = 1;
+        }
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+template<typename T>
+static void build_list_column(const vector<ObjectXML *>& objects,
+        const string& name, AttributeTable::ListColumn<T>& column)
+{
+    column.offsets.reserve(objects.size() + 1);
+
+    for (size_t i = 0; i < objects.size(); i++)
+    {
+        vector<T> vals;
+
+        column.offsets.push_back(column.values.size());
+
+        objects[i]->search(name.c_str(), vals);
+
+        column.values.insert(column.values.end(), vals.begin(), vals.end());
+    }
+
+    column.offsets.push_back(column.values.size());
+}
+
+/* -------------------------------------------------------------------------- */
+
+/**
+ *  @return the code of a string in the dictionary, adding it if needed
+ */
+static int encode(const string& value, map<string, int>& codes,
+        vector<string>& dictionary)
+{
+    map<string, int>::iterator it = codes.find(value);
+
+    if ( it != codes.end() )
+    {
+        return it->second;
+    }
+
+    int code = dictionary.size();
+
+    dictionary.push_back(value);
+
+    codes.insert(make_pair(value, code));
+
+    return code;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+const AttributeTable::Column<int>& AttributeTable::int_column(const string& name)
+{
+    map<string, Column<int> >::iterator it = int_columns.find(name);
+
+    if ( it == int_columns.end() )
+    {
+        it = int_columns.insert(make_pair(name, Column<int>())).first;
+
+        build_column(objects, name, it->second);
+    }
+
+    return it->second;
+}
+
+/* -------------------------------------------------------------------------- */
+
+const AttributeTable::Column<float>& AttributeTable::float_column(
+        const string& name)
+{
+    map<string, Column<float> >::iterator it = float_columns.find(name);
+
+    if ( it == float_columns.end() )
+    {
+        it = float_columns.insert(make_pair(name, Column<float>())).first;
+
+        build_column(objects, name, it->second);
+    }
+
+    return it->second;
+}
+
+/* -------------------------------------------------------------------------- */
+
+const AttributeTable::StringColumn& AttributeTable::string_column(
+        const string& name)
+{
+    map<string, StringColumn>::iterator it = string_columns.find(name);
+
+    if ( it != string_columns.end() )
+    {
+        return it->second;
+    }
+
+    it = string_columns.insert(make_pair(name, StringColumn())).first;
+
+    StringColumn& column = it->second;
+    map<string, int> codes;
+
+    column.codes.resize(objects.size(), -1);
+
+    for (size_t i = 0; i < objects.size(); i++)
+    {
+        string val;
+
+        if ( objects[i]->search(name.c_str(), val) == 0 )
+        {
+            column.codes[i] = encode(val, codes, column.dictionary);
+        }
+    }
+
+    return column;
+}
+
+/* -------------------------------------------------------------------------- */
+
+const AttributeTable::ListColumn<int>& AttributeTable::int_list_column(
+        const string& name)
+{
+    map<string, ListColumn<int> >::iterator it = int_list_columns.find(name);
+
+    if ( it == int_list_columns.end() )
+    {
+        it = int_list_columns.insert(make_pair(name, ListColumn<int>())).first;
+
+        build_list_column(objects, name, it->second);
+    }
+
+    return it->second;
+}
+
+/* -------------------------------------------------------------------------- */
+
+const AttributeTable::ListColumn<float>& AttributeTable::float_list_column(
+        const string& name)
+{
+    map<string, ListColumn<float> >::iterator it = float_list_columns.find(name);
+
+    if ( it == float_list_columns.end() )
+    {
+        it = float_list_columns.insert(
+                make_pair(name, ListColumn<float>())).first;
+
+        build_list_column(objects, name, it->second);
+    }
+
+    return it->second;
+}
+
+/* -------------------------------------------------------------------------- */
+
+const AttributeTable::StringListColumn& AttributeTable::string_list_column(
+        const string& name)
+{
+    map<string, StringListColumn>::iterator it = string_list_columns.find(name);
+
+    if ( it != string_list_columns.end() )
+    {
+        return it->second;
+    }
+
+    it = string_list_columns.insert(make_pair(name, StringListColumn())).first;
+
+    StringListColumn& column = it->second;
+    map<string, int> codes;
+
+    column.offsets.reserve(objects.size() + 1);
+
+    for (size_t i = 0; i < objects.size(); i++)
+    {
+        vector<string> vals;
+        vector<string>::iterator jt;
+
+        column.offsets.push_back(column.codes.size());
+
+        objects[i]->search(name.c_str(), vals);
+
+        for (jt = vals.begin(); jt != vals.end(); ++jt)
+        {
+            column.codes.push_back(encode(*jt, codes, column.dictionary));
+        }
+    }
+
+    column.offsets.push_back(column.codes.size());
+
+    return column;
+}
@@ -0,0 +1,880 @@
+/* -------------------------------------------------------------------------- */
+/* Copyright 2002-2017, OpenNebula Project, OpenNebula Systems                */
+/*                                                                            */
+/* Licensed under the Apache License, Version 2.0 (the "License"); you may    */
+/* not use this file except in compliance with the License. You may obtain    */
+/* a copy of the License at                                                   */
+/*                                                                            */
+/* http://www.apache.org/licenses/LICENSE-2.0                                 */
+/*                                                                            */
+/* Unless required by applicable law or agreed to in writing, software        */
+/* distributed under the License is distributed on an "AS IS" BASIS,          */
+/* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.   */
+/* See the License for the specific language governing permissions and        */
+/* limitations under the License.                                             */
+/* -------------------------------------------------------------------------- */
+
+
+#include "ExpressionProgram.h"
+#include "ObjectXML.h"
+#include "AttributeTable.h"
+
+#include <cstring>
+#include <cstdlib>
+#include <functional>
+#include <fnmatch.h>
+
+using namespace std;
+
+const size_t ExpressionProgram::MAX_CACHED_PROGRAMS = 4096;
+
+map<string, ExpressionProgram::CacheEntry> ExpressionProgram::programs[2];
+
+unsigned int ExpressionProgram::cache_period = 0;
+
+pthread_mutex_t ExpressionProgram::cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+pthread_mutex_t ExpressionProgram::lex_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* ************************************************************************** */
+/* Lex & bison parser interface                                               */
+/* ************************************************************************** */
+
+extern "C"
+{
+    typedef struct yy_buffer_state * YY_BUFFER_STATE;
+
+    int expr_bool_parse(ExpressionProgram& prog, char ** errmsg);
+
+    int expr_arith_parse(ExpressionProgram& prog, char ** errmsg);
+
+    int expr_lex_destroy();
+
+    YY_BUFFER_STATE expr__scan_string(const char * str);
+
+    void expr__delete_buffer(YY_BUFFER_STATE);
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+int ExpressionProgram::compile(const string& expr, ProgramType _type)
+{
+    YY_BUFFER_STATE str_buffer = 0;
+    char *          errmsg     = 0;
+    int             rc;
+
+    type     = _type;
+    root     = -1;
+    parse_rc = 0;
+
+    nodes.clear();
+    error_str.clear();
+
+    pthread_mutex_lock(&lex_mutex);
+
+    str_buffer = expr__scan_string(expr.c_str());
+
+    if (str_buffer == 0)
+    {
+        pthread_mutex_unlock(&lex_mutex);
+
+        error_str = "Error setting scan buffer";
+        parse_rc  = -1;
+
+        return -1;
+    }
+
+    if ( type == BOOL )
+    {
+        rc = expr_bool_parse(*this, &errmsg);
+    }
+    else
+    {
+        rc = expr_arith_parse(*this, &errmsg);
+    }
+
+    expr__delete_buffer(str_buffer);
+
+    expr_lex_destroy();
+
+    pthread_mutex_unlock(&lex_mutex);
+
+    if ( rc != 0 )
+    {
+        if ( errmsg != 0 )
+        {
+            error_str = errmsg;
+
+            free(errmsg);
+        }
+        else
+        {
+            error_str = "Error parsing expression";
+        }
+
+        nodes.clear();
+
+        root     = -1;
+        parse_rc = rc;
+
+        return -1;
+    }
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+
+bool ExpressionProgram::references(const string& attr) const
+{
+    vector<Node>::const_iterator it;
+
+    for (it = nodes.begin(); it != nodes.end(); ++it)
+    {
+        if ( it->attr == attr )
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* -------------------------------------------------------------------------- */
+
+const ExpressionProgram * ExpressionProgram::get(const string& expr,
+        ProgramType type, ExpressionProgram& tmp)
+{
+    ExpressionProgram * prog = 0;
+
+    map<string, CacheEntry>::iterator it;
+
+    pthread_mutex_lock(&cache_mutex);
+
+    it = programs[type].find(expr);
+
+    if ( it != programs[type].end() )
+    {
+        prog = it->second.program;
+
+        it->second.period = cache_period;
+    }
+    else if ( programs[BOOL].size() + programs[ARITH].size() <
+              MAX_CACHED_PROGRAMS )
+    {
+        prog = new ExpressionProgram();
+
+        prog->compile(expr, type);
+
+        CacheEntry entry = {prog, cache_period};
+
+        programs[type].insert(make_pair(expr, entry));
+    }
+
+    pthread_mutex_unlock(&cache_mutex);
+
+    if ( prog == 0 )
+    {
+        tmp.compile(expr, type);
+
+        prog = &tmp;
+    }
+
+    return prog;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void ExpressionProgram::purge_cache()
+{
+    map<string, CacheEntry>::iterator it;
+
+    pthread_mutex_lock(&cache_mutex);
+
+    for (int type = BOOL; type <= ARITH; type++)
+    {
+        for (it = programs[type].begin(); it != programs[type].end(); )
+        {
+            if ( it->second.period != cache_period )
+            {
+                delete it->second.program;
+
+                programs[type].erase(it++);
+            }
+            else
+            {
+                ++it;
+            }
+        }
+    }
+
+    cache_period++;
+
+    pthread_mutex_unlock(&cache_mutex);
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+int ExpressionProgram::add_compare(Operation op, const char * attr, int value)
+{
+    Node node;
+
+    node.op     = op;
+    node.vtype  = INTEGER;
+    node.attr   = attr != 0 ? attr : "";
+    node.ivalue = value;
+
+    nodes.push_back(node);
+
+    return nodes.size() - 1;
+}
+
+/* -------------------------------------------------------------------------- */
+
+int ExpressionProgram::add_compare(Operation op, const char * attr, float value)
+{
+    Node node;
+
+    node.op     = op;
+    node.vtype  = FLOAT;
+    node.attr   = attr != 0 ? attr : "";
+    node.fvalue = value;
+
+    nodes.push_back(node);
+
+    return nodes.size() - 1;
+}
+
+/* -------------------------------------------------------------------------- */
+
+int ExpressionProgram::add_compare(Operation op, const char * attr,
+        const char * value)
+{
+    Node node;
+
+    node.op    = op;
+    node.vtype = STRING;
+    node.attr  = attr != 0 ? attr : "";
+
+    if ( value == 0 )
+    {
+        node.null_svalue = true;
+    }
+    else
+    {
+        node.svalue = value;
+    }
+
+    nodes.push_back(node);
+
+    return nodes.size() - 1;
+}
+
+/* -------------------------------------------------------------------------- */
+
+int ExpressionProgram::add_attribute(const char * attr)
+{
+    Node node;
+
+    node.op   = ATTRIBUTE;
+    node.attr = attr != 0 ? attr : "";
+
+    nodes.push_back(node);
+
+    return nodes.size() - 1;
+}
+
+/* -------------------------------------------------------------------------- */
+
+int ExpressionProgram::add_constant(float value)
+{
+    Node node;
+
+    node.op     = CONSTANT;
+    node.vtype  = FLOAT;
+    node.fvalue = value;
+
+    nodes.push_back(node);
+
+    return nodes.size() - 1;
+}
+
+/* -------------------------------------------------------------------------- */
+
+int ExpressionProgram::add_operation(Operation op, int left, int right)
+{
+    Node node;
+
+    node.op    = op;
+    node.left  = left;
+    node.right = right;
+
+    nodes.push_back(node);
+
+    return nodes.size() - 1;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+int ExpressionProgram::eval_bool(ObjectXML * oxml, bool& result,
+        char **errmsg) const
+{
+    *errmsg = 0;
+
+    if ( !error_str.empty() )
+    {
+        *errmsg = strdup(error_str.c_str());
+        result  = false;
+
+        return parse_rc;
+    }
+
+    if ( root == -1 ) //TRUE BY DEFAULT, ON EMPTY STRINGS
+    {
+        result = true;
+        return 0;
+    }
+
+    result = eval_bool_node(root, oxml);
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+
+int ExpressionProgram::eval_arith(ObjectXML * oxml, int& result,
+        char **errmsg) const
+{
+    *errmsg = 0;
+
+    if ( !error_str.empty() )
+    {
+        *errmsg = strdup(error_str.c_str());
+
+        return parse_rc;
+    }
+
+    if ( root == -1 )
+    {
+        result = 0;
+        return 0;
+    }
+
+    result = static_cast<int>(eval_arith_node(root, oxml));
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+/**
+ *  Evaluates the @> operator, true if any of the attribute values is the
+ *  given one
+ */
+template<typename T>
+static bool contains(ObjectXML * oxml, const string& attr, const T& value)
+{
+    vector<T> values;
+
+    typename vector<T>::iterator it;
+
+    oxml->search(attr.c_str(), values);
+
+    for (it = values.begin(); it != values.end(); ++it)
+    {
+        if ( *it == value )
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* -------------------------------------------------------------------------- */
+
+/**
+ *  Evaluates =, !=, > and < for numbers, false if the attribute is not found.
+ *  The value is passed to search, pseudo-attributes (e.g. CURRENT_VMS in
+ *  HostXML) use it as the operand to look for.
+ */
+template<typename T>
+static bool compare(ObjectXML * oxml, ExpressionProgram::Operation op,
+        const string& attr, T value)
+{
+    T val = value;
+
+    if ( oxml->search(attr.c_str(), val) != 0 )
+    {
+        return false;
+    }
+
+    switch (op)
+    {
+        case ExpressionProgram::EQ: return val == value;
+        case ExpressionProgram::NE: return val != value;
+        case ExpressionProgram::GT: return val > value;
+        case ExpressionProgram::LT: return val < value;
+        default: return false;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+bool ExpressionProgram::eval_bool_node(int i, ObjectXML * oxml) const
+{
+    const Node& node = nodes[i];
+
+    if ( node.op >= EQ && node.op <= CONTAINS && node.attr.empty() )
+    {
+        return false;
+    }
+
+    switch (node.op)
+    {
+        case AND:
+            return eval_bool_node(node.left, oxml) &&
+                   eval_bool_node(node.right, oxml);
+
+        case OR:
+            return eval_bool_node(node.left, oxml) ||
+                   eval_bool_node(node.right, oxml);
+
+        case NOT:
+            return !eval_bool_node(node.left, oxml);
+
+        case EQ:
+        case NE:
+        case GT:
+        case LT:
+            if ( node.vtype == INTEGER )
+            {
+                return compare(oxml, node.op, node.attr, node.ivalue);
+            }
+            else if ( node.vtype == FLOAT )
+            {
+                return compare(oxml, node.op, node.attr, node.fvalue);
+            }
+            else
+            {
+                string val;
+
+                if ( node.null_svalue || oxml->search(node.attr.c_str(), val) != 0 )
+                {
+                    return false;
+                }
+
+                bool match = fnmatch(node.svalue.c_str(), val.c_str(), 0) == 0;
+
+                return node.op == EQ ? match : !match;
+            }
+
+        case CONTAINS:
+            if ( node.vtype == INTEGER )
+            {
+                return contains(oxml, node.attr, node.ivalue);
+            }
+            else if ( node.vtype == FLOAT )
+            {
+                return contains(oxml, node.attr, node.fvalue);
+            }
+            else
+            {
+                vector<string> values;
+                vector<string>::iterator it;
+
+                if ( node.null_svalue )
+                {
+                    return false;
+                }
+
+                oxml->search(node.attr.c_str(), values);
+
+                for (it = values.begin(); it != values.end(); ++it)
+                {
+                    if ( fnmatch(node.svalue.c_str(), (*it).c_str(), 0) == 0 )
+                    {
+                        return true;
+                    }
+                }
+
+                return false;
+            }
+
+        default:
+            return false;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+float ExpressionProgram::eval_arith_node(int i, ObjectXML * oxml) const
+{
+    const Node& node = nodes[i];
+
+    switch (node.op)
+    {
+        case ATTRIBUTE:
+        {
+            float val = 0;
+
+            if ( !node.attr.empty() )
+            {
+                oxml->search(node.attr.c_str(), val);
+            }
+
+            return val;
+        }
+
+        case CONSTANT:
+            return node.fvalue;
+
+        case ADD:
+            return eval_arith_node(node.left, oxml) +
+                   eval_arith_node(node.right, oxml);
+
+        case SUB:
+            return eval_arith_node(node.left, oxml) -
+                   eval_arith_node(node.right, oxml);
+
+        case MUL:
+            return eval_arith_node(node.left, oxml) *
+                   eval_arith_node(node.right, oxml);
+
+        case DIV:
+            return eval_arith_node(node.left, oxml) /
+                   eval_arith_node(node.right, oxml);
+
+        case NEG:
+            return - eval_arith_node(node.left, oxml);
+
+        default:
+            return 0;
+    }
+}
+
+/* ************************************************************************** */
+/* Evaluation over an AttributeTable                                          */
+/* ************************************************************************** */
+
+/**
+ *  Sets the bits of a bitmap for n objects with a predicate on the object
+ *  position. The tail of the last word is left to 0.
+ */
+template<typename P>
+static void pack(size_t n, const P& pred, vector<uint64_t>& bitmap)
+{
+    bitmap.assign((n + 63) / 64, 0);
+
+    for (size_t w = 0, base = 0; w < bitmap.size(); w++, base += 64)
+    {
+        size_t   end  = n - base < 64 ? n - base : 64;
+        uint64_t bits = 0;
+
+        for (size_t j = 0; j < end; j++)
+        {
+            bits |= static_cast<uint64_t>(pred(base + j)) << j;
+        }
+
+        bitmap[w] = bits;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+/**
+ *  Compares a numeric column with a value, false if the object has no value
+ */
+template<typename T, typename Cmp>
+class ColumnCompare
+{
+public:
+    ColumnCompare(const AttributeTable::Column<T>& c, T v):col(c), value(v){};
+
+    bool operator()(size_t i) const
+    {
+        return col.found[i] & cmp(col.values[i], value);
+    };
+
+private:
+    const AttributeTable::Column<T>& col;
+
+    T value;
+
+    Cmp cmp;
+};
+
+template<typename T>
+static void compare_column(ExpressionProgram::Operation op,
+        const AttributeTable::Column<T>& col, T value, vector<uint64_t>& bitmap)
+{
+    size_t n = col.values.size();
+
+    switch (op)
+    {
+        case ExpressionProgram::EQ:
+            pack(n, ColumnCompare<T, equal_to<T> >(col, value), bitmap);
+            break;
+
+        case ExpressionProgram::NE:
+            pack(n, ColumnCompare<T, not_equal_to<T> >(col, value), bitmap);
+            break;
+
+        case ExpressionProgram::GT:
+            pack(n, ColumnCompare<T, greater<T> >(col, value), bitmap);
+            break;
+
+        case ExpressionProgram::LT:
+            pack(n, ColumnCompare<T, less<T> >(col, value), bitmap);
+            break;
+
+        default:
+            bitmap.assign((n + 63) / 64, 0);
+            break;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+
+/**
+ *  True if any of the values of the object is the given one
+ */
+template<typename T>
+class ListContains
+{
+public:
+    ListContains(const AttributeTable::ListColumn<T>& c, T v):col(c), value(v){};
+
+    bool operator()(size_t i) const
+    {
+        for (size_t j = col.offsets[i]; j < col.offsets[i+1]; j++)
+        {
+            if ( col.values[j] == value )
+            {
+                return true;
+            }
+        }
+
+        return false;
+    };
+
+private:
+    const AttributeTable::ListColumn<T>& col;
+
+    T value;
+};
+
+/* -------------------------------------------------------------------------- */
+
+/**
+ *  Tests the dictionary code of an object, match has the result of the
+ *  comparison for each dictionary entry
+ */
+class CodeMatch
+{
+public:
+    CodeMatch(const vector<int>& c, const vector<unsigned char>& m):codes(c),
+        match(m){};
+
+    bool operator()(size_t i) const
+    {
+        return codes[i] >= 0 && match[codes[i]];
+    };
+
+private:
+    const vector<int>&           codes;
+    const vector<unsigned char>& match;
+};
+
+/**
+ *  True if any of the dictionary codes of the object matches
+ */
+class CodeListMatch
+{
+public:
+    CodeListMatch(const AttributeTable::StringListColumn& c,
+        const vector<unsigned char>& m):col(c), match(m){};
+
+    bool operator()(size_t i) const
+    {
+        for (size_t j = col.offsets[i]; j < col.offsets[i+1]; j++)
+        {
+            if ( match[col.codes[j]] )
+            {
+                return true;
+            }
+        }
+
+        return false;
+    };
+
+private:
+    const AttributeTable::StringListColumn& col;
+    const vector<unsigned char>&            match;
+};
+
+/**
+ *  Matches the pattern against each dictionary entry
+ *    @param negate true to set the entries that do not match (!=)
+ */
+static void match_dictionary(const vector<string>& dictionary,
+        const string& pattern, bool negate, vector<unsigned char>& match)
+{
+    match.resize(dictionary.size());
+
+    for (size_t i = 0; i < dictionary.size(); i++)
+    {
+        bool rc = fnmatch(pattern.c_str(), dictionary[i].c_str(), 0) == 0;
+
+        match[i] = negate ? !rc : rc;
+    }
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
+int ExpressionProgram::eval_bool(AttributeTable& table, vector<uint64_t>& bitmap,
+        char **errmsg) const
+{
+    size_t n = table.size();
+
+    *errmsg = 0;
+
+    if ( !error_str.empty() )
+    {
+        *errmsg = strdup(error_str.c_str());
+
+        bitmap.assign((n + 63) / 64, 0);
+
+        return parse_rc;
+    }
+
+    if ( root == -1 ) //TRUE BY DEFAULT, ON EMPTY STRINGS
+    {
+        bitmap.assign((n + 63) / 64, ~static_cast<uint64_t>(0));
+
+        if ( n % 64 != 0 )
+        {
+            bitmap.back() = (static_cast<uint64_t>(1) << (n % 64)) - 1;
+        }
+
+        return 0;
+    }
+
+    eval_bitmap_node(root, table, bitmap);
+
+    return 0;
+}
+
+/* -------------------------------------------------------------------------- */
+
+void ExpressionProgram::eval_bitmap_node(int i, AttributeTable& table,
+        vector<uint64_t>& bitmap) const
+{
+    const Node& node = nodes[i];
+
+    size_t n = table.size();
+
+    vector<unsigned char> match;
+    vector<uint64_t>      right;
+
+    if ( node.op >= EQ && node.op <= CONTAINS &&
+         (node.attr.empty() || (node.vtype == STRING && node.null_svalue)) )
+    {
+        bitmap.assign((n + 63) / 64, 0);
+        return;
+    }
+
+    switch (node.op)
+    {
+        case AND:
+            eval_bitmap_node(node.left, table, bitmap);
+            eval_bitmap_node(node.right, table, right);
+
+            for (size_t w = 0; w < bitmap.size(); w++)
+            {
+                bitmap[w] &= right[w];
+            }
+            break;
+
+        case OR:
+            eval_bitmap_node(node.left, table, bitmap);
+            eval_bitmap_node(node.right, table, right);
+
+            for (size_t w = 0; w < bitmap.size(); w++)
+            {
+                bitmap[w] |= right[w];
+            }
+            break;
+
+        case NOT:
+            eval_bitmap_node(node.left, table, bitmap);
+
+            for (size_t w = 0; w < bitmap.size(); w++)
+            {
+                bitmap[w] = ~bitmap[w];
+            }
+
+            if ( n % 64 != 0 )
+            {
+                bitmap.back() &= (static_cast<uint64_t>(1) << (n % 64)) - 1;
+            }
+            break;
+
+        case EQ:
+        case NE:
+        case GT:
+        case LT:
+            if ( node.vtype == INTEGER )
+            {
+                compare_column(node.op, table.int_column(node.attr),
+                        node.ivalue, bitmap);
+            }
+            else if ( node.vtype == FLOAT )
+            {
+                compare_column(node.op, table.float_column(node.attr),
+                        node.fvalue, bitmap);
+            }
+            else
+            {
+                const AttributeTable::StringColumn& col =
+                    table.string_column(node.attr);
+
+                match_dictionary(col.dictionary, node.svalue, node.op == NE,
+                        match);
+
+                pack(n, CodeMatch(col.codes, match), bitmap);
+            }
+            break;
+
+        case CONTAINS:
+            if ( node.vtype == INTEGER )
+            {
+                pack(n, ListContains<int>(table.int_list_column(node.attr),
+                        node.ivalue), bitmap);
+            }
+            else if ( node.vtype == FLOAT )
+            {
+                pack(n, ListContains<float>(table.float_list_column(node.attr),
+                        node.fvalue), bitmap);
+            }
+            else
+            {
+                const AttributeTable::StringListColumn& col =
+                    table.string_list_column(node.attr);
+
+                match_dictionary(col.dictionary, node.svalue, false, match);
+
+                pack(n, CodeListMatch(col, match), bitmap);
+            }
+            break;
+
+        default:
+            bitmap.assign((n + 63) / 64, 0);
+            break;
+    }
+}
@@ -15,6 +15,7 @@
 /* -------------------------------------------------------------------------- */
 
 #include <ObjectXML.h>
+#include "ExpressionProgram.h"
 #include <stdexcept>
 #include <cstring>
 #include <iostream>
@@ -307,6 +308,53 @@ int ObjectXML::add_node(
 /* -------------------------------------------------------------------------- */
 /* -------------------------------------------------------------------------- */
 
+int ObjectXML::remove_nodes(const char * xpath_expr)
+{
+    xmlXPathObjectPtr obj;
+
+    int removed = 0;
+
+    obj = xmlXPathEvalExpression(
+        reinterpret_cast<const xmlChar *>(xpath_expr), ctx);
+
+    if (obj == 0 || obj->nodesetval == 0)
+    {
+        if (obj != 0)
+        {
+            xmlXPathFreeObject(obj);
+        }
+
+        return 0;
+    }
+
+    xmlNodeSetPtr ns = obj->nodesetval;
+
+    for(int i = 0; i < ns->nodeNr; ++i)
+    {
+        xmlNodePtr cur = ns->nodeTab[i];
+
+        if ( cur == 0 || cur->type != XML_ELEMENT_NODE )
+        {
+            continue;
+        }
+
+        xmlUnlinkNode(cur);
+        xmlFreeNode(cur);
+
+        // The node set must not reference the freed node
+        ns->nodeTab[i] = 0;
+
+        removed++;
+    }
+
+    xmlXPathFreeObject(obj);
+
+    return removed;
+}
+
+/* -------------------------------------------------------------------------- */
+/* -------------------------------------------------------------------------- */
+
 int ObjectXML::update_from_str(const string &xml_doc)
 {
     if (xml != 0)
@@ -456,54 +504,14 @@ int ObjectXML::rename_nodes(const char * xpath_expr, const char * new_name)
 /* Host :: Parse functions to compute rank and evaluate requirements        */
 /* ************************************************************************ */
 
-extern "C"
-{
-    typedef struct yy_buffer_state * YY_BUFFER_STATE;
-
-    int expr_bool_parse(ObjectXML * oxml, bool& result, char ** errmsg);
-
-    int expr_arith_parse(ObjectXML * oxml, int& result, char ** errmsg);
-
-    int expr_lex_destroy();
-
-    YY_BUFFER_STATE expr__scan_string(const char * str);
-
-    void expr__delete_buffer(YY_BUFFER_STATE);
-}
-
-/* ------------------------------------------------------------------------ */
-/* ------------------------------------------------------------------------ */
-
 int ObjectXML::eval_bool(const string& expr, bool& result, char **errmsg)
 {
-    YY_BUFFER_STATE     str_buffer = 0;
-    const char *        str;
-    int                 rc;
-
-    *errmsg = 0;
-
-    str = expr.c_str();
-
-    str_buffer = expr__scan_string(str);
-
-    if (str_buffer == 0)
-    {
-        goto error_yy;
-    }
-
-    rc = expr_bool_parse(this,result,errmsg);
+    ExpressionProgram tmp;
 
-    expr__delete_buffer(str_buffer);
+    const ExpressionProgram * prog = ExpressionProgram::get(expr,
+            ExpressionProgram::BOOL, tmp);
 
-    expr_lex_destroy();
-
-    return rc;
-
-error_yy:
-
-    *errmsg=strdup("Error setting scan buffer");
-
-    return -1;
+    return prog->eval_bool(this, result, errmsg);
 }
 
 /* ------------------------------------------------------------------------ */
@@ -511,34 +519,12 @@ error_yy:
 
 int ObjectXML::eval_arith(const string& expr, int& result, char **errmsg)
 {
-    YY_BUFFER_STATE     str_buffer = 0;
-    const char *        str;
-    int                 rc;
-
-    *errmsg = 0;
-
-    str = expr.c_str();
-
-    str_buffer = expr__scan_string(str);
-
-    if (str_buffer == 0)
-    {
-        goto error_yy;
-    }
-
-    rc = expr_arith_parse(this,result,errmsg);
-
-    expr__delete_buffer(str_buffer);
-
-    expr_lex_destroy();
-
-    return rc;
-
-error_yy:
+    ExpressionProgram tmp;
 
-    *errmsg=strdup("Error setting scan buffer");
+    const ExpressionProgram * prog = ExpressionProgram::get(expr,
+            ExpressionProgram::ARITH, tmp);
 
-    return -1;
+    return prog->eval_arith(this, result, errmsg);
 }
 
 /* ------------------------------------------------------------------------ */
@@ -82,7 +82,7 @@
 #include <fnmatch.h>
 
 #include "expr_arith.h"
-#include "ObjectXML.h"
+#include "ExpressionProgram.h"
 
 #define YYERROR_VERBOSE
 #define expr_arith__lex expr_lex
@@ -92,28 +92,26 @@ extern "C"
     #include "mem_collector.h"
 
     void expr_arith__error(
-        YYLTYPE *       llocp,
-        mem_collector * mc,
-        ObjectXML *     oxml,
-        int&            result,
-        char **         error_msg,
-        const char *    str);
+        YYLTYPE *           llocp,
+        mem_collector *     mc,
+        ExpressionProgram&  prog,
+        char **             error_msg,
+        const char *        str);
 
     int expr_arith__lex (YYSTYPE *lvalp, YYLTYPE *llocp, mem_collector * mc);
 
-    int expr_arith__parse(mem_collector * mc,
-                          ObjectXML *     oxml,
-                          int&            result,
-                          char **         errmsg);
+    int expr_arith__parse(mem_collector *     mc,
+                          ExpressionProgram&  prog,
+                          char **             errmsg);
 
-    int expr_arith_parse(ObjectXML *oxml, int& result, char ** errmsg)
+    int expr_arith_parse(ExpressionProgram& prog, char ** errmsg)
     {
         mem_collector mc;
         int           rc;
 
         mem_collector_init(&mc);
 
-        rc = expr_arith__parse(&mc,oxml,result,errmsg);
+        rc = expr_arith__parse(&mc,prog,errmsg);
 
         mem_collector_cleanup(&mc);
 
@@ -122,7 +120,7 @@ extern "C"
 }
 
 
-#line 126 "expr_arith.cc" /* yacc.c:339  */
+#line 124 "expr_arith.cc" /* yacc.c:339  */
 
 # ifndef YY_NULLPTR
 #  if defined __cplusplus && 201103L <= __cplusplus
@@ -168,13 +166,13 @@ extern int expr_arith__debug;
 
 union YYSTYPE
 {
-#line 78 "expr_arith.y" /* yacc.c:355  */
+#line 75 "expr_arith.y" /* yacc.c:355  */
 
     char *  val_str;
     int     val_int;
     float   val_float;
 
-#line 178 "expr_arith.cc" /* yacc.c:355  */
+#line 176 "expr_arith.cc" /* yacc.c:355  */
 };
 
 typedef union YYSTYPE YYSTYPE;
@@ -198,13 +196,13 @@ struct YYLTYPE
 
 
 
-int expr_arith__parse (mem_collector * mc, ObjectXML * oxml, int&        result, char **     error_msg);
+int expr_arith__parse (mem_collector *     mc, ExpressionProgram&  prog, char **             error_msg);
 
 #endif /* !YY_EXPR_ARITH_EXPR_ARITH_HH_INCLUDED  */
 
 /* Copy the second part of user declarations.  */
 
-#line 208 "expr_arith.cc" /* yacc.c:358  */
+#line 206 "expr_arith.cc" /* yacc.c:358  */
 
 #ifdef short
 # undef short
@@ -504,8 +502,8 @@ static const yytype_uint8 yytranslate[] =
   /* YYRLINE[YYN] -- Source line where rule number YYN was defined.  */
 static const yytype_uint8 yyrline[] =
 {
-       0,   100,   100,   101,   104,   105,   106,   107,   108,   109,
-     110,   111,   112
+       0,    96,    96,    97,   100,   101,   102,   103,   104,   105,
+     106,   107,   108
 };
 #endif
 
@@ -632,7 +630,7 @@ do                                                              \
     }                                                           \
   else                                                          \
     {                                                           \
-      yyerror (&yylloc, mc, oxml, result, error_msg, YY_("syntax error: cannot back up")); \
+      yyerror (&yylloc, mc, prog, error_msg, YY_("syntax error: cannot back up")); \
       YYERROR;                                                  \
     }                                                           \
 while (0)
@@ -734,7 +732,7 @@ do {                                                                      \
     {                                                                     \
       YYFPRINTF (stderr, "%s ", Title);                                   \
       yy_symbol_print (stderr,                                            \
-                  Type, Value, Location, mc, oxml, result, error_msg); \
+                  Type, Value, Location, mc, prog, error_msg); \
       YYFPRINTF (stderr, "\n");                                           \
     }                                                                     \
 } while (0)
@@ -745,14 +743,13 @@ do {                                                                      \
 `----------------------------------------*/
 
 static void
-yy_symbol_value_print (FILE *yyoutput, int yytype, YYSTYPE const * const yyvaluep, YYLTYPE const * const yylocationp, mem_collector * mc, ObjectXML * oxml, int&        result, char **     error_msg)
+yy_symbol_value_print (FILE *yyoutput, int yytype, YYSTYPE const * const yyvaluep, YYLTYPE const * const yylocationp, mem_collector *     mc, ExpressionProgram&  prog, char **             error_msg)
 {
   FILE *yyo = yyoutput;
   YYUSE (yyo);
   YYUSE (yylocationp);
   YYUSE (mc);
-  YYUSE (oxml);
-  YYUSE (result);
+  YYUSE (prog);
   YYUSE (error_msg);
   if (!yyvaluep)
     return;
@@ -769,14 +766,14 @@ yy_symbol_value_print (FILE *yyoutput, int yytype, YYSTYPE const * const yyvalue
 `--------------------------------*/
 
 static void
-yy_symbol_print (FILE *yyoutput, int yytype, YYSTYPE const * const yyvaluep, YYLTYPE const * const yylocationp, mem_collector * mc, ObjectXML * oxml, int&        result, char **     error_msg)
+yy_symbol_print (FILE *yyoutput, int yytype, YYSTYPE const * const yyvaluep, YYLTYPE const * const yylocationp, mem_collector *     mc, ExpressionProgram&  prog, char **             error_msg)
 {
   YYFPRINTF (yyoutput, "%s %s (",
              yytype < YYNTOKENS ? "token" : "nterm", yytname[yytype]);
 
   YY_LOCATION_PRINT (yyoutput, *yylocationp);
   YYFPRINTF (yyoutput, ": ");
-  yy_symbol_value_print (yyoutput, yytype, yyvaluep, yylocationp, mc, oxml, result, error_msg);
+  yy_symbol_value_print (yyoutput, yytype, yyvaluep, yylocationp, mc, prog, error_msg);
   YYFPRINTF (yyoutput, ")");
 }
 
@@ -809,7 +806,7 @@ do {                                                            \
 `------------------------------------------------*/
 
 static void
-yy_reduce_print (yytype_int16 *yyssp, YYSTYPE *yyvsp, YYLTYPE *yylsp, int yyrule, mem_collector * mc, ObjectXML * oxml, int&        result, char **     error_msg)
+yy_reduce_print (yytype_int16 *yyssp, YYSTYPE *yyvsp, YYLTYPE *yylsp, int yyrule, mem_collector *     mc, ExpressionProgram&  prog, char **             error_msg)
 {
   unsigned long int yylno = yyrline[yyrule];
   int yynrhs = yyr2[yyrule];
@@ -823,7 +820,7 @@ yy_reduce_print (yytype_int16 *yyssp, YYSTYPE *yyvsp, YYLTYPE *yylsp, int yyrule
       yy_symbol_print (stderr,
                        yystos[yyssp[yyi + 1 - yynrhs]],
                        &(yyvsp[(yyi + 1) - (yynrhs)])
-                       , &(yylsp[(yyi + 1) - (yynrhs)])                       , mc, oxml, result, error_msg);
+                       , &(yylsp[(yyi + 1) - (yynrhs)])                       , mc, prog, error_msg);
       YYFPRINTF (stderr, "\n");
     }
 }
@@ -831,7 +828,7 @@ yy_reduce_print (yytype_int16 *yyssp, YYSTYPE *yyvsp, YYLTYPE *yylsp, int yyrule
 # define YY_REDUCE_PRINT(Rule)          \
 do {                                    \
   if (yydebug)                          \
-    yy_reduce_print (yyssp, yyvsp, yylsp, Rule, mc, oxml, result, error_msg); \
+    yy_reduce_print (yyssp, yyvsp, yylsp, Rule, mc, prog, error_msg); \
 } while (0)
 
 /* Nonzero means print parse trace.  It is left uninitialized so that
@@ -1089,13 +1086,12 @@ yysyntax_error (YYSIZE_T *yymsg_alloc, char **yymsg,
 `-----------------------------------------------*/
 
 static void
-yydestruct (const char *yymsg, int yytype, YYSTYPE *yyvaluep, YYLTYPE *yylocationp, mem_collector * mc, ObjectXML * oxml, int&        result, char **     error_msg)
+yydestruct (const char *yymsg, int yytype, YYSTYPE *yyvaluep, YYLTYPE *yylocationp, mem_collector *     mc, ExpressionProgram&  prog, char **             error_msg)
 {
   YYUSE (yyvaluep);
   YYUSE (yylocationp);
   YYUSE (mc);
-  YYUSE (oxml);
-  YYUSE (result);
+  YYUSE (prog);
   YYUSE (error_msg);
   if (!yymsg)
     yymsg = "Deleting";
@@ -1114,7 +1110,7 @@ yydestruct (const char *yymsg, int yytype, YYSTYPE *yyvaluep, YYLTYPE *yylocatio
 `----------*/
 
 int
-yyparse (mem_collector * mc, ObjectXML * oxml, int&        result, char **     error_msg)
+yyparse (mem_collector *     mc, ExpressionProgram&  prog, char **             error_msg)
 {
 /* The lookahead symbol.  */
 int yychar;
@@ -1388,73 +1384,73 @@ yyreduce:
   switch (yyn)
     {
         case 2:
-#line 100 "expr_arith.y" /* yacc.c:1646  */
-    { result = static_cast<int>((yyvsp[0].val_float));}
-#line 1394 "expr_arith.cc" /* yacc.c:1646  */
+#line 96 "expr_arith.y" /* yacc.c:1646  */
+    { prog.set_root((yyvsp[0].val_int)); }
+#line 1390 "expr_arith.cc" /* yacc.c:1646  */
     break;
 
   case 3:
-#line 101 "expr_arith.y" /* yacc.c:1646  */
-    { result = 0; }
-#line 1400 "expr_arith.cc" /* yacc.c:1646  */
+#line 97 "expr_arith.y" /* yacc.c:1646  */
+    { prog.set_root(-1); }
+#line 1396 "expr_arith.cc" /* yacc.c:1646  */
     break;
 
   case 4:
-#line 104 "expr_arith.y" /* yacc.c:1646  */
-    { float val; oxml->search((yyvsp[0].val_str), val); (yyval.val_float) = val; }
-#line 1406 "expr_arith.cc" /* yacc.c:1646  */
+#line 100 "expr_arith.y" /* yacc.c:1646  */
+    { (yyval.val_int) = prog.add_attribute((yyvsp[0].val_str)); }
+#line 1402 "expr_arith.cc" /* yacc.c:1646  */
     break;
 
   case 5:
-#line 105 "expr_arith.y" /* yacc.c:1646  */
-    { (yyval.val_float) = (yyvsp[0].val_float); }
-#line 1412 "expr_arith.cc" /* yacc.c:1646  */
+#line 101 "expr_arith.y" /* yacc.c:1646  */
+    { (yyval.val_int) = prog.add_constant((yyvsp[0].val_float)); }
+#line 1408 "expr_arith.cc" /* yacc.c:1646  */
     break;
 
   case 6:
-#line 106 "expr_arith.y" /* yacc.c:1646  */
-    { (yyval.val_float) = static_cast<float>((yyvsp[0].val_int)); }
-#line 1418 "expr_arith.cc" /* yacc.c:1646  */
+#line 102 "expr_arith.y" /* yacc.c:1646  */
+    { (yyval.val_int) = prog.add_constant(static_cast<float>((yyvsp[0].val_int))); }
+#line 1414 "expr_arith.cc" /* yacc.c:1646  */
     break;
 
   case 7:
-#line 107 "expr_arith.y" /* yacc.c:1646  */
-    { (yyval.val_float) = (yyvsp[-2].val_float) + (yyvsp[0].val_float);}
-#line 1424 "expr_arith.cc" /* yacc.c:1646  */
+#line 103 "expr_arith.y" /* yacc.c:1646  */
+    { (yyval.val_int) = prog.add_operation(ExpressionProgram::ADD,(yyvsp[-2].val_int),(yyvsp[0].val_int));}
+#line 1420 "expr_arith.cc" /* yacc.c:1646  */
     break;
 
   case 8:
-#line 108 "expr_arith.y" /* yacc.c:1646  */
-    { (yyval.val_float) = (yyvsp[-2].val_float) - (yyvsp[0].val_float);}
-#line 1430 "expr_arith.cc" /* yacc.c:1646  */
+#line 104 "expr_arith.y" /* yacc.c:1646  */
+    { (yyval.val_int) = prog.add_operation(ExpressionProgram::SUB,(yyvsp[-2].val_int),(yyvsp[0].val_int));}
+#line 1426 "expr_arith.cc" /* yacc.c:1646  */
     break;
 
   case 9:
-#line 109 "expr_arith.y" /* yacc.c:1646  */
-    { (yyval.val_float) = (yyvsp[-2].val_float) * (yyvsp[0].val_float);}
-#line 1436 "expr_arith.cc" /* yacc.c:1646  */
+#line 105 "expr_arith.y" /* yacc.c:1646  */
+    { (yyval.val_int) = prog.add_operation(ExpressionProgram::MUL,(yyvsp[-2].val_int),(yyvsp[0].val_int));}
+#line 1432 "expr_arith.cc" /* yacc.c:1646  */
     break;
 
   case 10:
-#line 110 "expr_arith.y" /* yacc.c:1646  */
-    { (yyval.val_float) = (yyvsp[-2].val_float) / (yyvsp[0].val_float);}
-#line 1442 "expr_arith.cc" /* yacc.c:1646  */
+#line 106 "expr_arith.y" /* yacc.c:1646  */
+    { (yyval.val_int) = prog.add_operation(ExpressionProgram::DIV,(yyvsp[-2].val_int),(yyvsp[0].val_int));}
+#line 1438 "expr_arith.cc" /* yacc.c:1646  */
     break;
 
   case 11:
-#line 111 "expr_arith.y" /* yacc.c:1646  */
-    { (yyval.val_float) = - (yyvsp[0].val_float);}
-#line 1448 "expr_arith.cc" /* yacc.c:1646  */
+#line 107 "expr_arith.y" /* yacc.c:1646  */
+    { (yyval.val_int) = prog.add_operation(ExpressionProgram::NEG,(yyvsp[0].val_int));}
+#line 1444 "expr_arith.cc" /* yacc.c:1646  */
     break;
 
   case 12:
-#line 112 "expr_arith.y" /* yacc.c:1646  */
-    { (yyval.val_float) = (yyvsp[-1].val_float);}
-#line 1454 "expr_arith.cc" /* yacc.c:1646  */
+#line 108 "expr_arith.y" /* yacc.c:1646  */
+    { (yyval.val_int) = (yyvsp[-1].val_int);}
+#line 1450 "expr_arith.cc" /* yacc.c:1646  */
     break;
 
 
-#line 1458 "expr_arith.cc" /* yacc.c:1646  */
+#line 1454 "expr_arith.cc" /* yacc.c:1646  */
       default: break;
     }
   /* User semantic actions sometimes alter yychar, and that requires
@@ -1505,7 +1501,7 @@ yyerrlab:
     {
       ++yynerrs;
 #if ! YYERROR_VERBOSE
-      yyerror (&yylloc, mc, oxml, result, error_msg, YY_("syntax error"));
+      yyerror (&yylloc, mc, prog, error_msg, YY_("syntax error"));
 #else
 # define YYSYNTAX_ERROR yysyntax_error (&yymsg_alloc, &yymsg, \
                                         yyssp, yytoken)
@@ -1532,7 +1528,7 @@ yyerrlab:
                 yymsgp = yymsg;
               }
           }
-        yyerror (&yylloc, mc, oxml, result, error_msg, yymsgp);
+        yyerror (&yylloc, mc, prog, error_msg, yymsgp);
         if (yysyntax_error_status == 2)
           goto yyexhaustedlab;
       }
@@ -1556,7 +1552,7 @@ yyerrlab:
       else
         {
           yydestruct ("Error: discarding",
-                      yytoken, &yylval, &yylloc, mc, oxml, result, error_msg);
+                      yytoken, &yylval, &yylloc, mc, prog, error_msg);
           yychar = YYEMPTY;
         }
     }
@@ -1613,7 +1609,7 @@ yyerrlab1:
 
       yyerror_range[1] = *yylsp;
       yydestruct ("Error: popping",
-                  yystos[yystate], yyvsp, yylsp, mc, oxml, result, error_msg);
+                  yystos[yystate], yyvsp, yylsp, mc, prog, error_msg);
       YYPOPSTACK (1);
       yystate = *yyssp;
       YY_STACK_PRINT (yyss, yyssp);
@@ -1655,7 +1651,7 @@ yyabortlab:
 | yyexhaustedlab -- memory exhaustion comes here.  |
 `-------------------------------------------------*/
 yyexhaustedlab:
-  yyerror (&yylloc, mc, oxml, result, error_msg, YY_("memory exhausted"));
+  yyerror (&yylloc, mc, prog, error_msg, YY_("memory exhausted"));
   yyresult = 2;
   /* Fall through.  */
 #endif
@@ -1667,7 +1663,7 @@ yyreturn:
          user semantic actions for why this is necessary.  */
       yytoken = YYTRANSLATE (yychar);
       yydestruct ("Cleanup: discarding lookahead",
-                  yytoken, &yylval, &yylloc, mc, oxml, result, error_msg);
+                  yytoken, &yylval, &yylloc, mc, prog, error_msg);
     }
   /* Do not reclaim the symbols of the rule whose action triggered
      this YYABORT or YYACCEPT.  */
@@ -1676,7 +1672,7 @@ yyreturn:
   while (yyssp != yyss)
     {
       yydestruct ("Cleanup: popping",
-                  yystos[*yyssp], yyvsp, yylsp, mc, oxml, result, error_msg);
+                  yystos[*yyssp], yyvsp, yylsp, mc, prog, error_msg);
       YYPOPSTACK (1);
     }
 #ifndef yyoverflow
@@ -1689,16 +1685,15 @@ yyreturn:
 #endif
   return yyresult;
 }
-#line 115 "expr_arith.y" /* yacc.c:1906  */
+#line 111 "expr_arith.y" /* yacc.c:1906  */
 
 
 extern "C" void expr_arith__error(
-    YYLTYPE *       llocp,
-    mem_collector * mc,
-    ObjectXML *     oxml,
-    int&            result,
-    char **         error_msg,
-    const char *    str)
+    YYLTYPE *           llocp,
+    mem_collector *     mc,
+    ExpressionProgram&  prog,
+    char **             error_msg,
+    const char *        str)
 {
     int length;
 
@@ -27,7 +27,7 @@
 #include <fnmatch.h>
 
 #include "expr_arith.h"
-#include "ObjectXML.h"
+#include "ExpressionProgram.h"
 
 #define YYERROR_VERBOSE
 #define expr_arith__lex expr_lex
@@ -37,28 +37,26 @@ extern "C"
     #include "mem_collector.h"
 
     void expr_arith__error(
-        YYLTYPE *       llocp,
-        mem_collector * mc,
-        ObjectXML *     oxml,
-        int&            result,
-        char **         error_msg,
-        const char *    str);
+        YYLTYPE *           llocp,
+        mem_collector *     mc,
+        ExpressionProgram&  prog,
+        char **             error_msg,
+        const char *        str);
 
     int expr_arith__lex (YYSTYPE *lvalp, YYLTYPE *llocp, mem_collector * mc);
 
-    int expr_arith__parse(mem_collector * mc,
-                          ObjectXML *     oxml,
-                          int&            result,
-                          char **         errmsg);
+    int expr_arith__parse(mem_collector *     mc,
+                          ExpressionProgram&  prog,
+                          char **             errmsg);
 
-    int expr_arith_parse(ObjectXML *oxml, int& result, char ** errmsg)
+    int expr_arith_parse(ExpressionProgram& prog, char ** errmsg)
     {
         mem_collector mc;
         int           rc;
 
         mem_collector_init(&mc);
 
-        rc = expr_arith__parse(&mc,oxml,result,errmsg);
+        rc = expr_arith__parse(&mc,prog,errmsg);
 
         mem_collector_cleanup(&mc);
 
@@ -68,10 +66,9 @@ extern "C"
 
 %}
 
-%parse-param {mem_collector * mc}
-%parse-param {ObjectXML * oxml}
-%parse-param {int&        result}
-%parse-param {char **     error_msg}
+%parse-param {mem_collector *     mc}
+%parse-param {ExpressionProgram&  prog}
+%parse-param {char **             error_msg}
 
 %lex-param {mem_collector * mc}
 
@@ -92,35 +89,33 @@ extern "C"
 %token <val_int>    INTEGER
 %token <val_str>    STRING
 %token <val_float>  FLOAT
-%type  <val_int>    stmt
-%type  <val_float>  expr
+%type  <val_int>    stmt expr
 
 %%
 
-stmt:   expr                { result = static_cast<int>($1);}
-        |                   { result = 0; }
+stmt:   expr                { prog.set_root($1); }
+        |                   { prog.set_root(-1); }
         ;
 
-expr:   STRING              { float val; oxml->search($1, val); $$ = val; }
-        | FLOAT             { $$ = $1; }
-        | INTEGER           { $$ = static_cast<float>($1); }
-        | expr '+' expr     { $$ = $1 + $3;}
-        | expr '-' expr     { $$ = $1 - $3;}
-        | expr '*' expr     { $$ = $1 * $3;}
-        | expr '/' expr     { $$ = $1 / $3;}
-        | '-' expr          { $$ = - $2;}
+expr:   STRING              { $$ = prog.add_attribute($1); }
+        | FLOAT             { $$ = prog.add_constant($1); }
+        | INTEGER           { $$ = prog.add_constant(static_cast<float>($1)); }
+        | expr '+' expr     { $$ = prog.add_operation(ExpressionProgram::ADD,$1,$3);}
+        | expr '-' expr     { $$ = prog.add_operation(ExpressionProgram::SUB,$1,$3);}
+        | expr '*' expr     { $$ = prog.add_operation(ExpressionProgram::MUL,$1,$3);}
+        | expr '/' expr     { $$ = prog.add_operation(ExpressionProgram::DIV,$1,$3);}
+        | '-' expr          { $$ = prog.add_operation(ExpressionProgram::NEG,$2);}
         | '(' expr ')'      { $$ = $2;}
         ;
 
 %%
 
 extern "C" void expr_arith__error(
-    YYLTYPE *       llocp,
-    mem_collector * mc,
-    ObjectXML *     oxml,
-    int&            result,
-    char **         error_msg,
-    const char *    str)
+    YYLTYPE *           llocp,
+    mem_collector *     mc,
+    ExpressionProgram&  prog,
+    char **             error_msg,
+    const char *        str)
 {
     int length;
 
@@ -82,7 +82,7 @@
 #include <fnmatch.h>
 
 #include "expr_bool.h"
-#include "ObjectXML.h"
+#include "ExpressionProgram.h"
 
 #define YYERROR_VERBOSE
 #define expr_bool__lex expr_lex
@@ -92,28 +92,26 @@ extern "C"
     #include "mem_collector.h"
 
     void expr_bool__error(
-        YYLTYPE *       llocp,
-        mem_collector * mc,
-        ObjectXML *     oxml,
-        bool&           result,
-        char **         error_msg,
-        const char *    str);
+        YYLTYPE *           llocp,
+        mem_collector *     mc,
+        ExpressionProgram&  prog,
+        char **             error_msg,
+        const char *        str);
 
     int expr_bool__lex (YYSTYPE *lvalp, YYLTYPE *llocp, mem_collector * mc);
 
-    int expr_bool__parse(mem_collector * mc,
-                         ObjectXML *     oxml,
-                         bool&           result,
-                         char **         errmsg);
+    int expr_bool__parse(mem_collector *     mc,
+                         ExpressionProgram&  prog,
+                         char **             errmsg);
 
-    int expr_bool_parse(ObjectXML *oxml, bool& result, char ** errmsg)
+    int expr_bool_parse(ExpressionProgram& prog, char ** errmsg)
     {
         mem_collector mc;
         int           rc;
 
         mem_collector_init(&mc);
 
-        rc = expr_bool__parse(&mc,oxml,result,errmsg);
+        rc = expr_bool__parse(&mc,prog,errmsg);
 
         mem_collector_cleanup(&mc);
 
@@ -121,7 +119,7 @@ extern "C"
     }
 }
 
-#line 125 "expr_bool.cc" /* yacc.c:339  */
+#line 123 "expr_bool.cc" /* yacc.c:339  */
 
 # ifndef YY_NULLPTR
 #  if defined __cplusplus && 201103L <= __cplusplus
@@ -167,13 +165,13 @@ extern int expr_bool__debug;
 
 union YYSTYPE
 {
-#line 77 "expr_bool.y" /* yacc.c:355  */
+#line 74 "expr_bool.y" /* yacc.c:355  */
 
     char *  val_str;
     int     val_int;
     float   val_float;
 
-#line 177 "expr_bool.cc" /* yacc.c:355  */
+#line 175 "expr_bool.cc" /* yacc.c:355  */
 };
 
 typedef union YYSTYPE YYSTYPE;
@@ -197,13 +195,13 @@ struct YYLTYPE
 
 
 
-int expr_bool__parse (mem_collector * mc, ObjectXML *     oxml, bool&           result, char **         error_msg);
+int expr_bool__parse (mem_collector *     mc, ExpressionProgram&  prog, char **             error_msg);
 
 #endif /* !YY_EXPR_BOOL_EXPR_BOOL_HH_INCLUDED  */
 
 /* Copy the second part of user declarations.  */
 
-#line 207 "expr_bool.cc" /* yacc.c:358  */
+#line 205 "expr_bool.cc" /* yacc.c:358  */
 
 #ifdef short
 # undef short
@@ -503,9 +501,9 @@ static const yytype_uint8 yytranslate[] =
   /* YYRLINE[YYN] -- Source line where rule number YYN was defined.  */
 static const yytype_uint8 yyrline[] =
 {
-       0,    97,    97,    98,   101,   110,   119,   126,   133,   151,
-     158,   165,   172,   179,   197,   205,   213,   234,   235,   236,
-     237
+       0,    94,    94,    95,    98,   102,   106,   110,   114,   118,
+     122,   126,   130,   134,   138,   142,   146,   150,   151,   152,
+     153
 };
 #endif
 
@@ -643,7 +641,7 @@ do                                                              \
     }                                                           \
   else                                                          \
     {                                                           \
-      yyerror (&yylloc, mc, oxml, result, error_msg, YY_("syntax error: cannot back up")); \
+      yyerror (&yylloc, mc, prog, error_msg, YY_("syntax error: cannot back up")); \
       YYERROR;                                                  \
     }                                                           \
 while (0)
@@ -745,7 +743,7 @@ do {                                                                      \
     {                                                                     \
       YYFPRINTF (stderr, "%s ", Title);                                   \
       yy_symbol_print (stderr,                                            \
-                  Type, Value, Location, mc, oxml, result, error_msg); \
+                  Type, Value, Location, mc, prog, error_msg); \
       YYFPRINTF (stderr, "\n");                                           \
     }                                                                     \
 } while (0)
@@ -756,14 +754,13 @@ do {                                                                      \
 `----------------------------------------*/
 
 static void
-yy_symbol_value_print (FILE *yyoutput, int yytype, YYSTYPE const * const yyvaluep, YYLTYPE const * const yylocationp, mem_collector * mc, ObjectXML *     oxml, bool&           result, char **         error_msg)
+yy_symbol_value_print (FILE *yyoutput, int yytype, YYSTYPE const * const yyvaluep, YYLTYPE const * const yylocationp, mem_collector *     mc, ExpressionProgram&  prog, char **             error_msg)
 {
   FILE *yyo = yyoutput;
   YYUSE (yyo);
   YYUSE (yylocationp);
   YYUSE (mc);
-  YYUSE (oxml);
-  YYUSE (result);
+  YYUSE (prog);
   YYUSE (error_msg);
   if (!yyvaluep)
     return;
@@ -780,14 +777,14 @@ yy_symbol_value_print (FILE *yyoutput, int yytype, YYSTYPE const * const yyvalue
 `--------------------------------*/
 
 static void
-yy_symbol_print (FILE *yyoutput, int yytype, YYSTYPE const * const yyvaluep, YYLTYPE const * const yylocationp, mem_collector * mc, ObjectXML *     oxml, bool&           result, char **         error_msg)
+yy_symbol_print (FILE *yyoutput, int yytype, YYSTYPE const * const yyvaluep, YYLTYPE const * const yylocationp, mem_collector *     mc, ExpressionProgram&  prog, char **             error_msg)
 {
   YYFPRINTF (yyoutput, "%s %s (",
              yytype < YYNTOKENS ? "token" : "nterm", yytname[yytype]);
 
   YY_LOCATION_PRINT (yyoutput, *yylocationp);
   YYFPRINTF (yyoutput, ": ");
-  yy_symbol_value_print (yyoutput, yytype, yyvaluep, yylocationp, mc, oxml, result, error_msg);
+  yy_symbol_value_print (yyoutput, yytype, yyvaluep, yylocationp, mc, prog, error_msg);
   YYFPRINTF (yyoutput, ")");
 }
 
@@ -820,7 +817,7 @@ do {                                                            \
 `------------------------------------------------*/
 
 static void
-yy_reduce_print (yytype_int16 *yyssp, YYSTYPE *yyvsp, YYLTYPE *yylsp, int yyrule, mem_collector * mc, ObjectXML *     oxml, bool&           result, char **         error_msg)
+yy_reduce_print (yytype_int16 *yyssp, YYSTYPE *yyvsp, YYLTYPE *yylsp, int yyrule, mem_collector *     mc, ExpressionProgram&  prog, char **             error_msg)
 {
   unsigned long int yylno = yyrline[yyrule];
   int yynrhs = yyr2[yyrule];
@@ -834,7 +831,7 @@ yy_reduce_print (yytype_int16 *yyssp, YYSTYPE *yyvsp, YYLTYPE *yylsp, int yyrule
       yy_symbol_print (stderr,
                        yystos[yyssp[yyi + 1 - yynrhs]],
                        &(yyvsp[(yyi + 1) - (yynrhs)])
-                       , &(yylsp[(yyi + 1) - (yynrhs)])                       , mc, oxml, result, error_msg);
+                       , &(yylsp[(yyi + 1) - (yynrhs)])                       , mc, prog, error_msg);
       YYFPRINTF (stderr, "\n");
     }
 }
@@ -842,7 +839,7 @@ yy_reduce_print (yytype_int16 *yyssp, YYSTYPE *yyvsp, YYLTYPE *yylsp, int yyrule
 # define YY_REDUCE_PRINT(Rule)          \
 do {                                    \
   if (yydebug)                          \
-    yy_reduce_print (yyssp, yyvsp, yylsp, Rule, mc, oxml, result, error_msg); \
+    yy_reduce_print (yyssp, yyvsp, yylsp, Rule, mc, prog, error_msg); \
 } while (0)
 
 /* Nonzero means print parse trace.  It is left uninitialized so that
@@ -1100,13 +1097,12 @@ yysyntax_error (YYSIZE_T *yymsg_alloc, char **yymsg,
 `-----------------------------------------------*/
 
 static void
-yydestruct (const char *yymsg, int yytype, YYSTYPE *yyvaluep, YYLTYPE *yylocationp, mem_collector * mc, ObjectXML *     oxml, bool&           result, char **         error_msg)
+yydestruct (const char *yymsg, int yytype, YYSTYPE *yyvaluep, YYLTYPE *yylocationp, mem_collector *     mc, ExpressionProgram&  prog, char **             error_msg)
 {
   YYUSE (yyvaluep);
   YYUSE (yylocationp);
   YYUSE (mc);
-  YYUSE (oxml);
-  YYUSE (result);
+  YYUSE (prog);
   YYUSE (error_msg);
   if (!yymsg)
     yymsg = "Deleting";
@@ -1125,7 +1121,7 @@ yydestruct (const char *yymsg, int yytype, YYSTYPE *yyvaluep, YYLTYPE *yylocatio
 `----------*/
 
 int
-yyparse (mem_collector * mc, ObjectXML *     oxml, bool&           result, char **         error_msg)
+yyparse (mem_collector *     mc, ExpressionProgram&  prog, char **             error_msg)
 {
 /* The lookahead symbol.  */
 int yychar;
@@ -1399,228 +1395,147 @@ yyreduce:
   switch (yyn)
     {
         case 2:
-#line 97 "expr_bool.y" /* yacc.c:1646  */
-    { result=(yyvsp[0].val_int);   }
-#line 1405 "expr_bool.cc" /* yacc.c:1646  */
+#line 94 "expr_bool.y" /* yacc.c:1646  */
+    { prog.set_root((yyvsp[0].val_int)); }
+#line 1401 "expr_bool.cc" /* yacc.c:1646  */
     break;
 
   case 3:
-#line 98 "expr_bool.y" /* yacc.c:1646  */
-    { result=true; }
-#line 1411 "expr_bool.cc" /* yacc.c:1646  */
+#line 95 "expr_bool.y" /* yacc.c:1646  */
+    { prog.set_root(-1); }
+#line 1407 "expr_bool.cc" /* yacc.c:1646  */
     break;
 
   case 4:
-#line 101 "expr_bool.y" /* yacc.c:1646  */
+#line 98 "expr_bool.y" /* yacc.c:1646  */
     {
-            int val = (yyvsp[0].val_int);
-            int rc;
-
-            rc = oxml->search((yyvsp[-2].val_str),val);
-
-            (yyval.val_int) = (rc == 0 && val == (yyvsp[0].val_int));
+            (yyval.val_int) = prog.add_compare(ExpressionProgram::EQ, (yyvsp[-2].val_str), (yyvsp[0].val_int));
         }
-#line 1424 "expr_bool.cc" /* yacc.c:1646  */
+#line 1415 "expr_bool.cc" /* yacc.c:1646  */
     break;
 
   case 5:
-#line 110 "expr_bool.y" /* yacc.c:1646  */
+#line 102 "expr_bool.y" /* yacc.c:1646  */
     {
-            int val = (yyvsp[0].val_int);
-            int rc;
-
-            rc = oxml->search((yyvsp[-3].val_str),val);
-
-            (yyval.val_int) = (rc == 0 && val != (yyvsp[0].val_int));
+            (yyval.val_int) = prog.add_compare(ExpressionProgram::NE, (yyvsp[-3].val_str), (yyvsp[0].val_int));
         }
-#line 1437 "expr_bool.cc" /* yacc.c:1646  */
+#line 1423 "expr_bool.cc" /* yacc.c:1646  */
     break;
 
   case 6:
-#line 119 "expr_bool.y" /* yacc.c:1646  */
+#line 106 "expr_bool.y" /* yacc.c:1646  */
     {
-            int val, rc;
-
-            rc = oxml->search((yyvsp[-2].val_str),val);
-            (yyval.val_int) = (rc == 0 && val > (yyvsp[0].val_int));
+            (yyval.val_int) = prog.add_compare(ExpressionProgram::GT, (yyvsp[-2].val_str), (yyvsp[0].val_int));
         }
-#line 1448 "expr_bool.cc" /* yacc.c:1646  */
+#line 1431 "expr_bool.cc" /* yacc.c:1646  */
     break;
 
   case 7:
-#line 126 "expr_bool.y" /* yacc.c:1646  */
+#line 110 "expr_bool.y" /* yacc.c:1646  */
     {
-            int val, rc;
-
-            rc = oxml->search((yyvsp[-2].val_str),val);
-            (yyval.val_int) = (rc == 0 && val < (yyvsp[0].val_int));
+            (yyval.val_int) = prog.add_compare(ExpressionProgram::LT, (yyvsp[-2].val_str), (yyvsp[0].val_int));
         }
-#line 1459 "expr_bool.cc" /* yacc.c:1646  */
+#line 1439 "expr_bool.cc" /* yacc.c:1646  */
     break;
 
   case 8:
-#line 133 "expr_bool.y" /* yacc.c:1646  */
+#line 114 "expr_bool.y" /* yacc.c:1646  */
     {
-            std::vector<int> val;
-            std::vector<int>::iterator it;
-
-            (yyval.val_int) = false;
-
-            oxml->search((yyvsp[-3].val_str),val);
-
-            for (it=val.begin(); it != val.end(); ++it)
-            {
-                if ((yyvsp[0].val_int) == *it)
-                {
-                    (yyval.val_int) = true;
-                    break;
-                }
-            }
+            (yyval.val_int) = prog.add_compare(ExpressionProgram::CONTAINS, (yyvsp[-3].val_str), (yyvsp[0].val_int));
         }
-#line 1481 "expr_bool.cc" /* yacc.c:1646  */
+#line 1447 "expr_bool.cc" /* yacc.c:1646  */
     break;
 
   case 9:
-#line 151 "expr_bool.y" /* yacc.c:1646  */
+#line 118 "expr_bool.y" /* yacc.c:1646  */
     {
-            float val, rc;
-
-            rc = oxml->search((yyvsp[-2].val_str),val);
-            (yyval.val_int) = (rc == 0 && val == (yyvsp[0].val_float));
+            (yyval.val_int) = prog.add_compare(ExpressionProgram::EQ, (yyvsp[-2].val_str), (yyvsp[0].val_float));
         }
-#line 1492 "expr_bool.cc" /* yacc.c:1646  */
+#line 1455 "expr_bool.cc" /* yacc.c:1646  */
     break;
 
   case 10:
-#line 158 "expr_bool.y" /* yacc.c:1646  */
+#line 122 "expr_bool.y" /* yacc.c:1646  */
     {
-            float val, rc;
-
-            rc = oxml->search((yyvsp[-3].val_str),val);
-            (yyval.val_int) = (rc == 0 && val != (yyvsp[0].val_float));
+            (yyval.val_int) = prog.add_compare(ExpressionProgram::NE, (yyvsp[-3].val_str), (yyvsp[0].val_float));
         }
-#line 1503 "expr_bool.cc" /* yacc.c:1646  */
+#line 1463 "expr_bool.cc" /* yacc.c:1646  */
     break;
 
   case 11:
-#line 165 "expr_bool.y" /* yacc.c:1646  */
+#line 126 "expr_bool.y" /* yacc.c:1646  */
     {
-            float val, rc;
-
-            rc = oxml->search((yyvsp[-2].val_str),val);
-            (yyval.val_int) = (rc == 0 && val > (yyvsp[0].val_float));
+            (yyval.val_int) = prog.add_compare(ExpressionProgram::GT, (yyvsp[-2].val_str), (yyvsp[0].val_float));
         }
-#line 1514 "expr_bool.cc" /* yacc.c:1646  */
+#line 1471 "expr_bool.cc" /* yacc.c:1646  */
     break;
 
   case 12:
-#line 172 "expr_bool.y" /* yacc.c:1646  */
+#line 130 "expr_bool.y" /* yacc.c:1646  */
     {
-            float val, rc;
-
-            rc = oxml->search((yyvsp[-2].val_str),val);
-            (yyval.val_int) = (rc == 0 && val < (yyvsp[0].val_float));
+            (yyval.val_int) = prog.add_compare(ExpressionProgram::LT, (yyvsp[-2].val_str), (yyvsp[0].val_float));
         }
-#line 1525 "expr_bool.cc" /* yacc.c:1646  */
+#line 1479 "expr_bool.cc" /* yacc.c:1646  */
     break;
 
   case 13:
-#line 179 "expr_bool.y" /* yacc.c:1646  */
+#line 134 "expr_bool.y" /* yacc.c:1646  */
     {
-            std::vector<float> val;
-            std::vector<float>::iterator it;
-
-            (yyval.val_int) = false;
-
-            oxml->search((yyvsp[-3].val_str),val);
-
-            for (it=val.begin(); it != val.end(); ++it)
-            {
-                if ((yyvsp[0].val_float) == *it)
-                {
-                    (yyval.val_int) = true;
-                    break;
-                }
-            }
+            (yyval.val_int) = prog.add_compare(ExpressionProgram::CONTAINS, (yyvsp[-3].val_str), (yyvsp[0].val_float));
         }
-#line 1547 "expr_bool.cc" /* yacc.c:1646  */
+#line 1487 "expr_bool.cc" /* yacc.c:1646  */
     break;
 
   case 14:
-#line 197 "expr_bool.y" /* yacc.c:1646  */
+#line 138 "expr_bool.y" /* yacc.c:1646  */
     {
-            std::string val;
-            int rc;
-
-            rc = oxml->search((yyvsp[-2].val_str),val);
-            (yyval.val_int) = (rc != 0 || (yyvsp[0].val_str)==0) ? false : fnmatch((yyvsp[0].val_str),val.c_str(),0)==0;
+            (yyval.val_int) = prog.add_compare(ExpressionProgram::EQ, (yyvsp[-2].val_str), (yyvsp[0].val_str));
         }
-#line 1559 "expr_bool.cc" /* yacc.c:1646  */
+#line 1495 "expr_bool.cc" /* yacc.c:1646  */
     break;
 
   case 15:
-#line 205 "expr_bool.y" /* yacc.c:1646  */
+#line 142 "expr_bool.y" /* yacc.c:1646  */
     {
-            std::string val;
-            int rc;
-
-            rc = oxml->search((yyvsp[-3].val_str),val);
-            (yyval.val_int) = (rc != 0 || (yyvsp[0].val_str)==0) ? false : fnmatch((yyvsp[0].val_str),val.c_str(),0)!=0;
+            (yyval.val_int) = prog.add_compare(ExpressionProgram::NE, (yyvsp[-3].val_str), (yyvsp[0].val_str));
         }
-#line 1571 "expr_bool.cc" /* yacc.c:1646  */
+#line 1503 "expr_bool.cc" /* yacc.c:1646  */
     break;
 
   case 16:
-#line 213 "expr_bool.y" /* yacc.c:1646  */
+#line 146 "expr_bool.y" /* yacc.c:1646  */
     {
-            std::vector<std::string> val;
-            std::vector<std::string>::iterator it;
-
-            (yyval.val_int) = false;
-
-            if ( (yyvsp[0].val_str) != 0 )
-            {
-                oxml->search((yyvsp[-3].val_str),val);
-
-                for (it=val.begin(); it != val.end(); ++it)
-                {
-                    if ( fnmatch((yyvsp[0].val_str), (*it).c_str(), 0) == 0 )
-                    {
-                        (yyval.val_int) = true;
-                        break;
-                    }
-                }
-            }
+            (yyval.val_int) = prog.add_compare(ExpressionProgram::CONTAINS, (yyvsp[-3].val_str), (yyvsp[0].val_str));
         }
-#line 1596 "expr_bool.cc" /* yacc.c:1646  */
+#line 1511 "expr_bool.cc" /* yacc.c:1646  */
     break;
 
   case 17:
-#line 234 "expr_bool.y" /* yacc.c:1646  */
-    { (yyval.val_int) = (yyvsp[-2].val_int) && (yyvsp[0].val_int); }
-#line 1602 "expr_bool.cc" /* yacc.c:1646  */
+#line 150 "expr_bool.y" /* yacc.c:1646  */
+    { (yyval.val_int) = prog.add_operation(ExpressionProgram::AND,(yyvsp[-2].val_int),(yyvsp[0].val_int));}
+#line 1517 "expr_bool.cc" /* yacc.c:1646  */
     break;
 
   case 18:
-#line 235 "expr_bool.y" /* yacc.c:1646  */
-    { (yyval.val_int) = (yyvsp[-2].val_int) || (yyvsp[0].val_int); }
-#line 1608 "expr_bool.cc" /* yacc.c:1646  */
+#line 151 "expr_bool.y" /* yacc.c:1646  */
+    { (yyval.val_int) = prog.add_operation(ExpressionProgram::OR,(yyvsp[-2].val_int),(yyvsp[0].val_int)); }
+#line 1523 "expr_bool.cc" /* yacc.c:1646  */
     break;
 
   case 19:
-#line 236 "expr_bool.y" /* yacc.c:1646  */
-    { (yyval.val_int) = ! (yyvsp[0].val_int); }
-#line 1614 "expr_bool.cc" /* yacc.c:1646  */
+#line 152 "expr_bool.y" /* yacc.c:1646  */
+    { (yyval.val_int) = prog.add_operation(ExpressionProgram::NOT,(yyvsp[0].val_int));   }
+#line 1529 "expr_bool.cc" /* yacc.c:1646  */
     break;
 
   case 20:
-#line 237 "expr_bool.y" /* yacc.c:1646  */
-    { (yyval.val_int) =   (yyvsp[-1].val_int); }
-#line 1620 "expr_bool.cc" /* yacc.c:1646  */
+#line 153 "expr_bool.y" /* yacc.c:1646  */
+    { (yyval.val_int) = (yyvsp[-1].val_int); }
+#line 1535 "expr_bool.cc" /* yacc.c:1646  */
     break;
 
 
-#line 1624 "expr_bool.cc" /* yacc.c:1646  */
+#line 1539 "expr_bool.cc" /* yacc.c:1646  */
       default: break;
     }
   /* User semantic actions sometimes alter yychar, and that requires
@@ -1671,7 +1586,7 @@ yyerrlab:
     {
       ++yynerrs;
 #if ! YYERROR_VERBOSE
-      yyerror (&yylloc, mc, oxml, result, error_msg, YY_("syntax error"));
+      yyerror (&yylloc, mc, prog, error_msg, YY_("syntax error"));
 #else
 # define YYSYNTAX_ERROR yysyntax_error (&yymsg_alloc, &yymsg, \
                                         yyssp, yytoken)
@@ -1698,7 +1613,7 @@ yyerrlab:
                 yymsgp = yymsg;
               }
           }
-        yyerror (&yylloc, mc, oxml, result, error_msg, yymsgp);
+        yyerror (&yylloc, mc, prog, error_msg, yymsgp);
         if (yysyntax_error_status == 2)
           goto yyexhaustedlab;
       }
@@ -1722,7 +1637,7 @@ yyerrlab:
       else
         {
           yydestruct ("Error: discarding",
-                      yytoken, &yylval, &yylloc, mc, oxml, result, error_msg);
+                      yytoken, &yylval, &yylloc, mc, prog, error_msg);
           yychar = YYEMPTY;
         }
     }
@@ -1779,7 +1694,7 @@ yyerrlab1:
 
       yyerror_range[1] = *yylsp;
       yydestruct ("Error: popping",
-                  yystos[yystate], yyvsp, yylsp, mc, oxml, result, error_msg);
+                  yystos[yystate], yyvsp, yylsp, mc, prog, error_msg);
       YYPOPSTACK (1);
       yystate = *yyssp;
       YY_STACK_PRINT (yyss, yyssp);
@@ -1821,7 +1736,7 @@ yyabortlab:
 | yyexhaustedlab -- memory exhaustion comes here.  |
 `-------------------------------------------------*/
 yyexhaustedlab:
-  yyerror (&yylloc, mc, oxml, result, error_msg, YY_("memory exhausted"));
+  yyerror (&yylloc, mc, prog, error_msg, YY_("memory exhausted"));
   yyresult = 2;
   /* Fall through.  */
 #endif
@@ -1833,7 +1748,7 @@ yyreturn:
          user semantic actions for why this is necessary.  */
       yytoken = YYTRANSLATE (yychar);
       yydestruct ("Cleanup: discarding lookahead",
-                  yytoken, &yylval, &yylloc, mc, oxml, result, error_msg);
+                  yytoken, &yylval, &yylloc, mc, prog, error_msg);
     }
   /* Do not reclaim the symbols of the rule whose action triggered
      this YYABORT or YYACCEPT.  */
@@ -1842,7 +1757,7 @@ yyreturn:
   while (yyssp != yyss)
     {
       yydestruct ("Cleanup: popping",
-                  yystos[*yyssp], yyvsp, yylsp, mc, oxml, result, error_msg);
+                  yystos[*yyssp], yyvsp, yylsp, mc, prog, error_msg);
       YYPOPSTACK (1);
     }
 #ifndef yyoverflow
@@ -1855,16 +1770,15 @@ yyreturn:
 #endif
   return yyresult;
 }
-#line 240 "expr_bool.y" /* yacc.c:1906  */
+#line 156 "expr_bool.y" /* yacc.c:1906  */
 
 
 extern "C" void expr_bool__error(
-    YYLTYPE *       llocp,
-    mem_collector * mc,
-    ObjectXML *     oxml,
-    bool&           result,
-    char **         error_msg,
-    const char *    str)
+    YYLTYPE *           llocp,
+    mem_collector *     mc,
+    ExpressionProgram&  prog,
+    char **             error_msg,
+    const char *        str)
 {
     int length;
 
@@ -1882,6 +1796,4 @@ extern "C" void expr_bool__error(
             llocp->first_column,
             llocp->last_column);
     }
-
-    result = false;
 }
@@ -56,7 +56,7 @@ extern int expr_bool__debug;
 
 union YYSTYPE
 {
-#line 77 "expr_bool.y" /* yacc.c:1909  */
+#line 74 "expr_bool.y" /* yacc.c:1909  */
 
     char *  val_str;
     int     val_int;
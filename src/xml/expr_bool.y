@@ -27,7 +27,7 @@
 #include <fnmatch.h>
 
 #include "expr_bool.h"
-#include "ObjectXML.h"
+#include "ExpressionProgram.h"
 
 #define YYERROR_VERBOSE
 #define expr_bool__lex expr_lex
@@ -37,28 +37,26 @@ extern "C"
     #include "mem_collector.h"
 
     void expr_bool__error(
-        YYLTYPE *       llocp,
-        mem_collector * mc,
-        ObjectXML *     oxml,
-        bool&           result,
-        char **         error_msg,
-        const char *    str);
+        YYLTYPE *           llocp,
+        mem_collector *     mc,
+        ExpressionProgram&  prog,
+        char **             error_msg,
+        const char *        str);
 
     int expr_bool__lex (YYSTYPE *lvalp, YYLTYPE *llocp, mem_collector * mc);
 
-    int expr_bool__parse(mem_collector * mc,
-                         ObjectXML *     oxml,
-                         bool&           result,
-                         char **         errmsg);
+    int expr_bool__parse(mem_collector *     mc,
+                         ExpressionProgram&  prog,
+                         char **             errmsg);
 
-    int expr_bool_parse(ObjectXML *oxml, bool& result, char ** errmsg)
+    int expr_bool_parse(ExpressionProgram& prog, char ** errmsg)
     {
         mem_collector mc;
         int           rc;
 
         mem_collector_init(&mc);
 
-        rc = expr_bool__parse(&mc,oxml,result,errmsg);
+        rc = expr_bool__parse(&mc,prog,errmsg);
 
         mem_collector_cleanup(&mc);
 
@@ -67,10 +65,9 @@ extern "C"
 }
 %}
 
-%parse-param {mem_collector * mc}
-%parse-param {ObjectXML *     oxml}
-%parse-param {bool&           result}
-%parse-param {char **         error_msg}
+%parse-param {mem_collector *     mc}
+%parse-param {ExpressionProgram&  prog}
+%parse-param {char **             error_msg}
 
 %lex-param {mem_collector * mc}
 
@@ -94,158 +91,76 @@ extern "C"
 
 %%
 
-stmt:   expr    { result=$1;   }
-        |       { result=true; } /* TRUE BY DEFAULT, ON EMPTY STRINGS */
+stmt:   expr    { prog.set_root($1); }
+        |       { prog.set_root(-1); } /* TRUE BY DEFAULT, ON EMPTY STRINGS */
         ;
 
 expr:   STRING '=' INTEGER {
-            int val = $3;
-            int rc;
-
-            rc = oxml->search($1,val);
-
-            $$ = (rc == 0 && val == $3);
+            $$ = prog.add_compare(ExpressionProgram::EQ, $1, $3);
         }
 
         | STRING '!' '=' INTEGER {
-            int val = $4;
-            int rc;
-
-            rc = oxml->search($1,val);
-
-            $$ = (rc == 0 && val != $4);
+            $$ = prog.add_compare(ExpressionProgram::NE, $1, $4);
         }
 
         | STRING '>' INTEGER {
-            int val, rc;
-
-            rc = oxml->search($1,val);
-            $$ = (rc == 0 && val > $3);
+            $$ = prog.add_compare(ExpressionProgram::GT, $1, $3);
         }
 
         | STRING '<' INTEGER {
-            int val, rc;
-
-            rc = oxml->search($1,val);
-            $$ = (rc == 0 && val < $3);
+            $$ = prog.add_compare(ExpressionProgram::LT, $1, $3);
         }
 
         | STRING '@''>' INTEGER {
-            std::vector<int> val;
-            std::vector<int>::iterator it;
-
-            $$ = false;
-
-            oxml->search($1,val);
-
-            for (it=val.begin(); it != val.end(); ++it)
-            {
-                if ($4 == *it)
-                {
-                    $$ = true;
-                    break;
-                }
-            }
+            $$ = prog.add_compare(ExpressionProgram::CONTAINS, $1, $4);
         }
 
         | STRING '=' FLOAT {
-            float val, rc;
-
-            rc = oxml->search($1,val);
-            $$ = (rc == 0 && val == $3);
+            $$ = prog.add_compare(ExpressionProgram::EQ, $1, $3);
         }
 
         | STRING '!' '=' FLOAT {
-            float val, rc;
-
-            rc = oxml->search($1,val);
-            $$ = (rc == 0 && val != $4);
+            $$ = prog.add_compare(ExpressionProgram::NE, $1, $4);
         }
 
         | STRING '>' FLOAT {
-            float val, rc;
-
-            rc = oxml->search($1,val);
-            $$ = (rc == 0 && val > $3);
+            $$ = prog.add_compare(ExpressionProgram::GT, $1, $3);
         }
 
         | STRING '<' FLOAT {
-            float val, rc;
-
-            rc = oxml->search($1,val);
-            $$ = (rc == 0 && val < $3);
+            $$ = prog.add_compare(ExpressionProgram::LT, $1, $3);
         }
 
         | STRING '@''>' FLOAT {
-            std::vector<float> val;
-            std::vector<float>::iterator it;
-
-            $$ = false;
-
-            oxml->search($1,val);
-
-            for (it=val.begin(); it != val.end(); ++it)
-            {
-                if ($4 == *it)
-                {
-                    $$ = true;
-                    break;
-                }
-            }
+            $$ = prog.add_compare(ExpressionProgram::CONTAINS, $1, $4);
         }
 
         | STRING '=' STRING {
-            std::string val;
-            int rc;
-
-            rc = oxml->search($1,val);
-            $$ = (rc != 0 || $3==0) ? false : fnmatch($3,val.c_str(),0)==0;
+            $$ = prog.add_compare(ExpressionProgram::EQ, $1, $3);
         }
 
         | STRING '!''=' STRING {
-            std::string val;
-            int rc;
-
-            rc = oxml->search($1,val);
-            $$ = (rc != 0 || $4==0) ? false : fnmatch($4,val.c_str(),0)!=0;
+            $$ = prog.add_compare(ExpressionProgram::NE, $1, $4);
         }
 
         | STRING '@''>' STRING {
-            std::vector<std::string> val;
-            std::vector<std::string>::iterator it;
-
-            $$ = false;
-
-            if ( $4 != 0 )
-            {
-                oxml->search($1,val);
-
-                for (it=val.begin(); it != val.end(); ++it)
-                {
-                    if ( fnmatch($4, (*it).c_str(), 0) == 0 )
-                    {
-                        $$ = true;
-                        break;
-                    }
-                }
-            }
+            $$ = prog.add_compare(ExpressionProgram::CONTAINS, $1, $4);
         }
 
-        | expr '&' expr { $$ = $1 && $3; }
-        | expr '|' expr { $$ = $1 || $3; }
-        | '!' expr      { $$ = ! $2; }
-        | '(' expr ')'  { $$ =   $2; }
+        | expr '&' expr { $$ = prog.add_operation(ExpressionProgram::AND,$1,$3);}
+        | expr '|' expr { $$ = prog.add_operation(ExpressionProgram::OR,$1,$3); }
+        | '!' expr      { $$ = prog.add_operation(ExpressionProgram::NOT,$2);   }
+        | '(' expr ')'  { $$ = $2; }
         ;
 
 %%
 
 extern "C" void expr_bool__error(
-    YYLTYPE *       llocp,
-    mem_collector * mc,
-    ObjectXML *     oxml,
-    bool&           result,
-    char **         error_msg,
-    const char *    str)
+    YYLTYPE *           llocp,
+    mem_collector *     mc,
+    ExpressionProgram&  prog,
+    char **             error_msg,
+    const char *        str)
 {
     int length;
 
@@ -263,6 +178,4 @@ extern "C" void expr_bool__error(
             llocp->first_column,
             llocp->last_column);
     }
-
-    result = false;
 }